@@ -51,6 +51,7 @@
 #include <QTextEdit>
 #include <QPlainTextEdit>
 #include <cmath>
+#include <limits>
 #include <algorithm>
 
 // Qt6兼容性处理
@@ -1487,7 +1488,7 @@ void DataCleaningDialog::setupUI()
     m_outlierThresholdSpin = new QSpinBox;
     m_outlierThresholdSpin->setRange(1, 5);
     m_outlierThresholdSpin->setValue(2);
-    m_outlierThresholdSpin->setSuffix(" 倍标准差");
+    m_outlierThresholdSpin->setSuffix(" 倍稳健标准差");
     outlierLayout->addWidget(m_outlierThresholdSpin);
     mainLayout->addLayout(outlierLayout);
 
@@ -1723,6 +1724,7 @@ void DataEditorWidget::setupConnections()
 {
     // 文件操作按钮
     connect(ui->btnOpenFile, &QPushButton::clicked, this, &DataEditorWidget::onOpenFile);
+    connect(ui->btnMultiGaugeImport, &QPushButton::clicked, this, &DataEditorWidget::onMultiGaugeImport);
     connect(ui->btnSave, &QPushButton::clicked, this, &DataEditorWidget::onSave);
     connect(ui->btnExport, &QPushButton::clicked, this, &DataEditorWidget::onExport);
 
@@ -1731,7 +1733,10 @@ void DataEditorWidget::setupConnections()
     connect(ui->btnTimeConvert, &QPushButton::clicked, this, &DataEditorWidget::onTimeConvert);
     connect(ui->btnPressureDropCalc, &QPushButton::clicked, this, &DataEditorWidget::onPressureDropCalc);
     connect(ui->btnPressureDerivativeCalc, &QPushButton::clicked, this, &DataEditorWidget::onPressureDerivativeCalc);
+    connect(ui->btnTimeTransformCalc, &QPushButton::clicked, this, &DataEditorWidget::onTimeTransformCalc);
+    connect(ui->btnFlowPeriodDetect, &QPushButton::clicked, this, &DataEditorWidget::onFlowPeriodDetect);
     connect(ui->btnDataClean, &QPushButton::clicked, this, &DataEditorWidget::onDataClean);
+    connect(ui->btnGaugeFilter, &QPushButton::clicked, this, &DataEditorWidget::onGaugeFilter);
     connect(ui->btnDataStatistics, &QPushButton::clicked, this, &DataEditorWidget::onDataStatistics);
 
     // 搜索功能
@@ -2515,6 +2520,53 @@ int DataEditorWidget::findTimeColumn() const
     return -1;
 }
 
+int DataEditorWidget::findFlowRateColumn() const
+{
+    if (!m_dataModel) {
+        return -1;
+    }
+
+    // 优先查找已定义为流量的列
+    for (int i = 0; i < m_columnDefinitions.size() && i < m_dataModel->columnCount(); ++i) {
+        if (m_columnDefinitions[i].type == WellTestColumnType::FlowRate) {
+            return i;
+        }
+    }
+
+    // 如果没有定义的流量列，尝试从列名推断
+    for (int col = 0; col < m_dataModel->columnCount(); ++col) {
+        QString headerText = m_dataModel->headerData(col, Qt::Horizontal).toString().toLower();
+        if (headerText.contains("rate") || headerText.contains("流量") ||
+            headerText.contains("产量") || headerText == "q") {
+            return col;
+        }
+    }
+
+    return -1;
+}
+
+RateSchedule DataEditorWidget::readRateSchedule(const QVector<double>& time) const
+{
+    int rateColumn = findFlowRateColumn();
+    if (rateColumn == -1) {
+        return RateSchedule();
+    }
+
+    // 无法解析的流量单元格视为缺测，沿用上一行的产量
+    int rowCount = qMin(m_dataModel->rowCount(), time.size());
+    QVector<double> rates(rowCount, std::numeric_limits<double>::quiet_NaN());
+    for (int row = 0; row < rowCount; ++row) {
+        QStandardItem* item = m_dataModel->item(row, rateColumn);
+        if (!item) continue;
+        bool ok = false;
+        double value = item->text().trimmed().toDouble(&ok);
+        if (ok) rates[row] = value;
+    }
+    // 计量产量带噪声时逐行比较会把每行都当作变化，改用变点检测划分流动段
+    FlowPeriodResult periods = FlowPeriodDetector::detect(time.mid(0, rowCount), QVector<double>(), rates);
+    return FlowPeriodDetector::toSchedule(periods);
+}
+
 QString DataEditorWidget::getPressureUnit() const
 {
     int pressureColumn = findPressureColumn();
@@ -2824,6 +2876,142 @@ void DataEditorWidget::onOpenFile()
     }
 }
 
+void DataEditorWidget::onMultiGaugeImport()
+{
+    if (m_dataModified && !checkDataModifiedAndPrompt()) {
+        return;
+    }
+
+    QStringList filePaths = QFileDialog::getOpenFileNames(this, "选择多个压力计数据文件", QString(),
+                                                          "文本数据文件 (*.csv *.txt *.dat *.asc);;所有文件 (*)");
+    if (filePaths.isEmpty()) {
+        return;
+    }
+    if (filePaths.size() < 2) {
+        showStyledMessageBox("多压力计导入", "请至少选择两个压力计文件", QMessageBox::Information);
+        return;
+    }
+
+    showAnimatedProgress("多压力计导入", "正在读取压力计文件...");
+    QVector<GaugeSeries> gauges;
+    QStringList errors;
+    for (int i = 0; i < filePaths.size(); ++i) {
+        updateProgress(i * 100 / filePaths.size(), QString("正在读取 %1").arg(QFileInfo(filePaths[i]).fileName()));
+        QApplication::processEvents();
+        GaugeSeries series;
+        QString errorMessage;
+        if (GaugeAlignment::readGaugeFile(filePaths[i], series, errorMessage)) {
+            gauges.append(series);
+        } else {
+            errors << QString("%1: %2").arg(QFileInfo(filePaths[i]).fileName(), errorMessage);
+        }
+    }
+    hideAnimatedProgress();
+
+    if (gauges.size() < 2) {
+        showStyledMessageBox("多压力计导入", "可用的压力计文件不足两个", QMessageBox::Warning, errors.join("\n"));
+        return;
+    }
+
+    // 日期时间格式的文件以所有压力计中最早的记录为时间零点；与数值时间的文件不能混用
+    int absoluteCount = 0;
+    for (const GaugeSeries& gauge : gauges) {
+        if (gauge.absoluteTime) ++absoluteCount;
+    }
+    if (absoluteCount > 0 && absoluteCount < gauges.size()) {
+        showStyledMessageBox("多压力计导入",
+                             "部分文件的时间为日期时间、部分为数值，无法统一时钟，请先统一时间格式",
+                             QMessageBox::Warning);
+        return;
+    }
+    if (absoluteCount > 0) {
+        double origin = gauges.first().time.first();
+        for (const GaugeSeries& gauge : gauges) origin = qMin(origin, gauge.time.first());
+        for (GaugeSeries& gauge : gauges) {
+            for (double& t : gauge.time) t -= origin;
+        }
+    }
+
+    GaugeAlignmentDialog dialog(gauges, this);
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+    const int reference = dialog.referenceGauge();
+    const QVector<double> shifts = dialog.shifts();
+
+    showAnimatedProgress("多压力计导入", "正在合并压力计数据...");
+    GaugeMergeResult merged = GaugeAlignment::merge(gauges, shifts, dialog.mergeTolerance());
+
+    clearData();
+    ui->filePathLineEdit->setText(filePaths.join("; "));
+
+    // 列顺序：时间、参考压力计、其余压力计；参考压力计的压力列作为主压力列
+    QVector<int> order{reference};
+    for (int g = 0; g < gauges.size(); ++g) {
+        if (g != reference) order.append(g);
+    }
+
+    ColumnDefinition timeDef;
+    timeDef.name = "时间\\h";
+    timeDef.type = WellTestColumnType::Time;
+    timeDef.unit = "h";
+    timeDef.description = QString("以“%1”的时钟为准的测试时间").arg(gauges[reference].name);
+    timeDef.decimalPlaces = 6;
+    m_columnDefinitions.append(timeDef);
+    for (int g : order) {
+        ColumnDefinition pressureDef;
+        pressureDef.name = QString("压力[%1]\\MPa").arg(gauges[g].name);
+        pressureDef.type = g == reference ? WellTestColumnType::Pressure : WellTestColumnType::Custom;
+        pressureDef.unit = "MPa";
+        pressureDef.description = QString("压力计“%1”的压力，时移 %2 h").arg(gauges[g].name).arg(shifts[g], 0, 'g', 8);
+        pressureDef.decimalPlaces = 6;
+        m_columnDefinitions.append(pressureDef);
+    }
+
+    const int rowCount = merged.time.size();
+    m_dataModel->setColumnCount(m_columnDefinitions.size());
+    m_dataModel->setRowCount(rowCount);
+    for (int c = 0; c < m_columnDefinitions.size(); ++c) {
+        m_dataModel->setHorizontalHeaderItem(c, new QStandardItem(m_columnDefinitions[c].name));
+    }
+    for (int row = 0; row < rowCount; ++row) {
+        QStandardItem* timeItem = new QStandardItem(QString::number(merged.time[row], 'g', 10));
+        timeItem->setForeground(QBrush(QColor("#2c3e50")));
+        m_dataModel->setItem(row, 0, timeItem);
+        for (int c = 0; c < order.size(); ++c) {
+            double value = merged.pressure[order[c]][row];
+            QStandardItem* item = new QStandardItem(std::isfinite(value) ? QString::number(value, 'g', 10) : QString());
+            item->setForeground(QBrush(QColor("#2c3e50")));
+            m_dataModel->setItem(row, c + 1, item);
+        }
+        if (row % 10000 == 0) {
+            updateProgress(row * 100 / rowCount, QString("已写入 %1 行").arg(row));
+            QApplication::processEvents();
+        }
+    }
+
+    hideAnimatedProgress();
+    setButtonsEnabled(true);
+    applyColumnStyles();
+    optimizeColumnWidths();
+    optimizeTableDisplay();
+    m_dataModified = true;
+    emit columnDefinitionsChanged();
+    emitDataChanged();
+    updateStatus(QString("多压力计合并完成 - %1行 × %2列").arg(rowCount).arg(m_dataModel->columnCount()), "success");
+
+    QStringList lines;
+    for (int g : order) {
+        lines << QString("%1：时移 %2 h，写入 %3 条记录").arg(gauges[g].name).arg(shifts[g], 0, 'g', 8)
+                     .arg(merged.samplesUsed[g]);
+    }
+    showStyledMessageBox("多压力计合并完成",
+                         QString("参考压力计：%1\n合并后共 %2 行\n\n%3")
+                             .arg(gauges[reference].name).arg(rowCount).arg(lines.join("\n")),
+                         QMessageBox::Information,
+                         errors.isEmpty() ? QString() : "未能读取的文件：\n" + errors.join("\n"));
+}
+
 void DataEditorWidget::loadData(const QString& filePath, const QString& fileType)
 {
     qDebug() << "开始加载文件:" << filePath << "类型:" << fileType;
@@ -3810,6 +3998,129 @@ void DataEditorWidget::onDataClean()
     }
 }
 
+// 压力计数据预处理：预览 Hampel 去野值、小波去噪与对数时间抽稀的效果后写入新列
+void DataEditorWidget::onGaugeFilter()
+{
+    if (!hasData()) {
+        showStyledMessageBox("数据预处理", "请先加载数据文件", QMessageBox::Information);
+        return;
+    }
+
+    // 选择要处理的列，默认压力列
+    QStringList columnNames;
+    for (int col = 0; col < m_dataModel->columnCount(); ++col) {
+        QString header = m_dataModel->headerData(col, Qt::Horizontal).toString();
+        columnNames << (header.isEmpty() ? QString("列 %1").arg(col + 1) : header);
+    }
+    bool ok = false;
+    QString columnName = QInputDialog::getItem(this, "数据预处理", "选择要处理的列:", columnNames,
+                                               qMax(0, findPressureColumn()), false, &ok);
+    if (!ok) return;
+    int sourceColumn = columnNames.indexOf(columnName);
+    if (sourceColumn < 0) return;
+
+    // 没有时间列时按行号处理（不抽稀到流动段）
+    int timeColumn = findTimeColumn();
+    int rowCount = m_dataModel->rowCount();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    QVector<double> time(rowCount, nan), value(rowCount, nan);
+    for (int row = 0; row < rowCount; ++row) {
+        if (timeColumn >= 0) {
+            QStandardItem* item = m_dataModel->item(row, timeColumn);
+            double t = item ? item->text().trimmed().toDouble(&ok) : 0.0;
+            if (item && ok) time[row] = t;
+        } else {
+            time[row] = row;
+        }
+        QStandardItem* item = m_dataModel->item(row, sourceColumn);
+        double v = item ? item->text().trimmed().toDouble(&ok) : 0.0;
+        if (item && ok) value[row] = v;
+    }
+    QVector<double> periodStarts;
+    if (timeColumn >= 0) periodStarts = readRateSchedule(time).startTime;
+
+    GaugeFilterDialog dialog(time, value, columnName, periodStarts, this);
+    if (dialog.exec() != QDialog::Accepted) return;
+    GaugeFilterConfig config = dialog.config();
+    GaugeFilterResult result = dialog.result();
+
+    showAnimatedProgress("数据预处理", "正在写入处理结果...");
+
+    // 新列紧跟原列并沿用原列的定义；原列改为自定义类型，此后压降、导数计算使用处理后的数据
+    int newColumnIndex = sourceColumn + 1;
+    QString newColumnName = QString("滤波%1").arg(columnName);
+    m_dataModel->insertColumn(newColumnIndex);
+    m_dataModel->setHorizontalHeaderItem(newColumnIndex, new QStandardItem(newColumnName));
+    for (int row = 0; row < rowCount; ++row) {
+        double v = result.values.value(row, nan);
+        QStandardItem* item = new QStandardItem(std::isfinite(v) ? QString::number(v, 'g', 10) : QString());
+        item->setForeground(QBrush(QColor("#2c3e50")));
+        m_dataModel->setItem(row, newColumnIndex, item);
+    }
+
+    ColumnDefinition newColumnDef;
+    if (sourceColumn < m_columnDefinitions.size()) {
+        newColumnDef = m_columnDefinitions[sourceColumn];
+        m_columnDefinitions[sourceColumn].type = WellTestColumnType::Custom;
+        m_columnDefinitions[sourceColumn].description = "预处理前的原始数据";
+    }
+    newColumnDef.name = newColumnName;
+    newColumnDef.description = "预处理后的数据";
+    if (newColumnIndex < m_columnDefinitions.size()) {
+        m_columnDefinitions.insert(newColumnIndex, newColumnDef);
+    } else {
+        m_columnDefinitions.append(newColumnDef);
+    }
+
+    // 抽稀：删除未保留的有效行，缺测行原样保留
+    int removedRows = 0;
+    if (config.decimate) {
+        QVector<bool> keep(rowCount, false);
+        for (int row = 0; row < rowCount; ++row)
+            keep[row] = !(std::isfinite(time[row]) && std::isfinite(value[row]));
+        for (int row : result.keptRows) keep[row] = true;
+        removedRows = int(std::count(keep.begin(), keep.end(), false));
+
+        // 逐行删除为 O(行数²)，改为取出保留行的单元格后整体重建
+        if (removedRows > 0) {
+            const int columnCount = m_dataModel->columnCount();
+            QVector<QList<QStandardItem*>> keptItems;
+            keptItems.reserve(rowCount - removedRows);
+            for (int row = 0; row < rowCount; ++row) {
+                if (!keep[row]) continue;
+                QList<QStandardItem*> items;
+                for (int col = 0; col < columnCount; ++col) items << m_dataModel->takeItem(row, col);
+                keptItems << items;
+            }
+            m_dataModel->removeRows(0, rowCount);
+            m_dataModel->setRowCount(keptItems.size());
+            for (int row = 0; row < keptItems.size(); ++row) {
+                for (int col = 0; col < columnCount; ++col) {
+                    if (keptItems[row][col]) m_dataModel->setItem(row, col, keptItems[row][col]);
+                }
+            }
+            // 已记录的行编辑按旧行号撤销，抽稀后不再适用
+            m_undoStack->clear();
+        }
+    }
+
+    hideAnimatedProgress();
+    optimizeColumnWidths();
+    m_dataModified = true;
+    emitDataChanged();
+    updateStatus(QString("数据预处理完成 - 已添加列: %1").arg(newColumnName), "success");
+
+    QString summary = QString("数据预处理完成！\n"
+                              "新增列：%1\n"
+                              "替换野值：%2 个\n"
+                              "估计噪声标准差：%3")
+                          .arg(newColumnName)
+                          .arg(result.outlierCount)
+                          .arg(result.noiseLevel, 0, 'g', 3);
+    if (config.decimate) summary += QString("\n抽稀删除：%1 行").arg(removedRows);
+    showStyledMessageBox("数据预处理完成", summary, QMessageBox::Information);
+}
+
 void DataEditorWidget::onDataStatistics()
 {
     if (!hasData()) {
@@ -4185,7 +4496,16 @@ void DataEditorWidget::removeOutliers(double threshold)
     if (!m_dataModel) return;
 
     for (int col = 0; col < m_dataModel->columnCount(); ++col) {
-        QList<double> values;
+        // 时间、序号类列单调变化，不做异常值判断
+        if (col < m_columnDefinitions.size()) {
+            WellTestColumnType type = m_columnDefinitions[col].type;
+            if (type == WellTestColumnType::Time || type == WellTestColumnType::Date ||
+                type == WellTestColumnType::TimeOfDay || type == WellTestColumnType::SerialNumber) {
+                continue;
+            }
+        }
+
+        QVector<double> values;
         QList<int> validRows;
 
         // 收集数值数据
@@ -4203,35 +4523,15 @@ void DataEditorWidget::removeOutliers(double threshold)
 
         if (values.size() < 3) continue; // 数据太少，跳过
 
-        // 计算平均值和标准差
-        double sum = 0;
-        for (double val : values) {
-            sum += val;
-        }
-        double mean = sum / values.size();
-
-        double variance = 0;
-        for (double val : values) {
-            variance += std::pow(val - mean, 2);
-        }
-        double stdDev = std::sqrt(variance / values.size());
+        // 以滑动中位数为基准判断（Hampel），趋势与开关井阶跃不会被当作异常值
+        QVector<double> filtered = GaugeDataFilter::hampel(values, 5, threshold);
 
-        // 标记异常值
-        QList<int> outlierRows;
+        // 清空异常值
         for (int i = 0; i < values.size(); ++i) {
-            if (std::abs(values[i] - mean) > threshold * stdDev) {
-                outlierRows.append(validRows[i]);
-            }
-        }
-
-        // 删除异常值（从后往前删除）
-        if (!outlierRows.isEmpty()) {
-            std::sort(outlierRows.begin(), outlierRows.end(), std::greater<int>());
-
-            for (int row : outlierRows) {
-                QStandardItem* item = m_dataModel->item(row, col);
+            if (filtered[i] != values[i]) {
+                QStandardItem* item = m_dataModel->item(validRows[i], col);
                 if (item) {
-                    item->setText(""); // 清空异常值
+                    item->setText("");
                 }
             }
         }
@@ -4878,7 +5178,10 @@ void DataEditorWidget::setButtonsEnabled(bool enabled)
     ui->btnTimeConvert->setEnabled(enabled);
     ui->btnPressureDropCalc->setEnabled(enabled);
     ui->btnPressureDerivativeCalc->setEnabled(enabled);
+    ui->btnTimeTransformCalc->setEnabled(enabled);
+    ui->btnFlowPeriodDetect->setEnabled(enabled);
     ui->btnDataClean->setEnabled(enabled);
+    ui->btnGaugeFilter->setEnabled(enabled);
     ui->btnDataStatistics->setEnabled(enabled);
 }
 
@@ -5251,13 +5554,23 @@ void DataEditorWidget::onPressureDerivativeCalc()
         }
     }
 
-    // 显示计算进度
-    showAnimatedProgress("压力导数计算", "正在计算压力导数...");
-
-    // 执行计算
-    PressureDerivativeResult result = m_pressureDerivativeCalculator->calculatePressureDerivative(m_dataModel, config);
+    // 读取数据后在对话框中预览各算法、各平滑程度的导数，只写入选中的一条
+    QVector<double> timeData, pressureDropData;
+    QString readError;
+    if (!m_pressureDerivativeCalculator->readSeries(m_dataModel, config, timeData, pressureDropData, &readError)) {
+        showStyledMessageBox("压力导数计算失败", readError, QMessageBox::Warning);
+        return;
+    }
+    // 有流量列且产量有变化时按叠加导数计算
+    RateSchedule schedule = readRateSchedule(timeData);
+    PressureDerivativeDialog dialog(timeData, pressureDropData, config.lSpacing, schedule, this);
+    if (dialog.exec() != QDialog::Accepted) return;
+    DerivativeOptions options = dialog.selectedOptions();
+    if (options.method == DerivativeMethod::Bourdet) config.lSpacing = options.lSpacing;
 
-    hideAnimatedProgress();
+    PressureDerivativeResult result = m_pressureDerivativeCalculator->insertDerivativeColumn(
+        m_dataModel, config, dialog.selectedDerivative());
+    if (result.success) emit pressureDerivativeCalculated(result);
 
     if (result.success) {
         updateStatus(QString("压力导数计算完成 - 已添加列: %1").arg(result.columnName), "success");
@@ -5284,8 +5597,11 @@ void DataEditorWidget::onPressureDerivativeCalc()
         showStyledMessageBox("压力导数计算完成",
                              QString("压力导数计算成功完成！\n"
                                      "新增列：%1\n"
-                                     "处理行数：%2")
+                                     "导数算法：%2 (%3)\n"
+                                     "处理行数：%4")
                                  .arg(result.columnName)
+                                 .arg(PressureDerivativeCalculator::methodName(options.method))
+                                 .arg(dialog.selectedDescription())
                                  .arg(result.processedRows),
                              QMessageBox::Information);
     } else {
@@ -5294,6 +5610,215 @@ void DataEditorWidget::onPressureDerivativeCalc()
     }
 }
 
+// 变产量时间变换：在时间列后插入段内时间、等效时间、叠加时间与 Horner 时间比
+void DataEditorWidget::onTimeTransformCalc()
+{
+    if (!hasData()) {
+        showStyledMessageBox("时间变换", "请先加载数据文件", QMessageBox::Information);
+        return;
+    }
+
+    int timeColumn = findTimeColumn();
+    if (timeColumn == -1) {
+        showStyledMessageBox("时间变换", "未找到时间列，请确保数据中包含时间数据列", QMessageBox::Warning);
+        return;
+    }
+    if (findFlowRateColumn() == -1) {
+        showStyledMessageBox("时间变换", "未找到流量列，请先在“定义列”中指定流量列", QMessageBox::Warning);
+        return;
+    }
+
+    int rowCount = m_dataModel->rowCount();
+    QVector<double> time(rowCount, std::numeric_limits<double>::quiet_NaN());
+    for (int row = 0; row < rowCount; ++row) {
+        QStandardItem* item = m_dataModel->item(row, timeColumn);
+        if (!item) continue;
+        bool ok = false;
+        double value = item->text().trimmed().toDouble(&ok);
+        if (ok) time[row] = value;
+    }
+
+    RateSchedule schedule = readRateSchedule(time);
+    int periodCount = TimeTransform::periodCount(schedule);
+    if (periodCount == 0) {
+        showStyledMessageBox("时间变换", "流量列中没有非零产量，无法划分流动段", QMessageBox::Warning);
+        return;
+    }
+
+    showAnimatedProgress("时间变换", "正在计算叠加时间...");
+    TimeTransformResult transform = TimeTransform::compute(time, schedule);
+
+    QString timeUnit = "h";
+    if (timeColumn < m_columnDefinitions.size() && !m_columnDefinitions[timeColumn].unit.isEmpty()) {
+        timeUnit = m_columnDefinitions[timeColumn].unit;
+    }
+
+    struct TransformColumn {
+        QString name;
+        QString unit;
+        QString description;
+        const QVector<double>* values;
+    };
+    const QVector<TransformColumn> columns = {
+        {QString("段内时间\\%1").arg(timeUnit), timeUnit, "当前流动段内的时间 Δt", &transform.elapsed},
+        {QString("等效时间\\%1").arg(timeUnit), timeUnit, "Agarwal 等效时间 Δte", &transform.equivalent},
+        {"叠加时间", "", "叠加时间 Σ(Δq_j/Δq_n)·ln(t − T_j)", &transform.superposition},
+        {"Horner时间比", "", "Horner 时间比 (tp + Δt)/Δt", &transform.horner}
+    };
+
+    // 依次插入到时间列之后；尚未生产或不适用的单元格留空
+    QStringList addedNames;
+    for (int k = 0; k < columns.size(); ++k) {
+        const TransformColumn& column = columns[k];
+        ColumnDefinition newColumnDef;
+        newColumnDef.name = column.name;
+        newColumnDef.type = WellTestColumnType::Custom;
+        newColumnDef.unit = column.unit;
+        newColumnDef.description = column.description;
+        newColumnDef.decimalPlaces = 6;
+        insertValueColumn(timeColumn + 1 + k, newColumnDef, *column.values);
+        addedNames << column.name;
+    }
+
+    hideAnimatedProgress();
+    optimizeColumnWidths();
+    m_dataModified = true;
+    emitDataChanged();
+    updateStatus(QString("时间变换完成 - %1 个流动段").arg(periodCount), "success");
+
+    showStyledMessageBox("时间变换完成",
+                         QString("时间变换计算完成！\n"
+                                 "流动段数：%1\n"
+                                 "新增列：%2")
+                             .arg(periodCount)
+                             .arg(addedNames.join("、")),
+                         QMessageBox::Information);
+}
+
+// 流动段识别：由流量列（没有时由压力变化率）划分开关井与变产量段，插入段号、段内时间与段内压差
+void DataEditorWidget::onFlowPeriodDetect()
+{
+    if (!hasData()) {
+        showStyledMessageBox("流动段识别", "请先加载数据文件", QMessageBox::Information);
+        return;
+    }
+
+    int timeColumn = findTimeColumn();
+    if (timeColumn == -1) {
+        showStyledMessageBox("流动段识别", "未找到时间列，请确保数据中包含时间数据列", QMessageBox::Warning);
+        return;
+    }
+    int pressureColumn = findPressureColumn();
+    int rateColumn = findFlowRateColumn();
+    if (pressureColumn == -1 && rateColumn == -1) {
+        showStyledMessageBox("流动段识别", "未找到流量列或压力列，无法识别流动段", QMessageBox::Warning);
+        return;
+    }
+
+    showAnimatedProgress("流动段识别", "正在识别开关井与变产量时刻...");
+
+    int rowCount = m_dataModel->rowCount();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    auto readColumn = [&](int col) {
+        QVector<double> values(rowCount, nan);
+        if (col < 0) return values;
+        for (int row = 0; row < rowCount; ++row) {
+            QStandardItem* item = m_dataModel->item(row, col);
+            if (!item) continue;
+            bool ok = false;
+            double value = item->text().trimmed().toDouble(&ok);
+            if (ok) values[row] = value;
+        }
+        return values;
+    };
+    QVector<double> time = readColumn(timeColumn);
+    QVector<double> pressure = readColumn(pressureColumn);
+    FlowPeriodResult detection = FlowPeriodDetector::detect(time, pressure, readColumn(rateColumn));
+    if (detection.periods.isEmpty()) {
+        hideAnimatedProgress();
+        showStyledMessageBox("流动段识别", "有效数据不足，无法识别流动段", QMessageBox::Warning);
+        return;
+    }
+
+    QVector<double> periodNumber(rowCount, nan);
+    for (int row = 0; row < rowCount; ++row)
+        if (detection.periodOfRow[row] >= 0) periodNumber[row] = detection.periodOfRow[row] + 1;
+
+    QString timeUnit = "h";
+    if (timeColumn < m_columnDefinitions.size() && !m_columnDefinitions[timeColumn].unit.isEmpty()) {
+        timeUnit = m_columnDefinitions[timeColumn].unit;
+    }
+    QString pressureUnit = getPressureUnit();
+    if (pressureUnit.isEmpty()) pressureUnit = "MPa";
+
+    ColumnDefinition periodDef;
+    periodDef.name = "流动段";
+    periodDef.description = "流动段序号（从 1 开始）";
+    periodDef.decimalPlaces = 0;
+    ColumnDefinition elapsedDef;
+    elapsedDef.name = QString("段内时间\\%1").arg(timeUnit);
+    elapsedDef.unit = timeUnit;
+    elapsedDef.description = "自流动段起点起算的时间 Δt";
+    elapsedDef.decimalPlaces = 6;
+    ColumnDefinition dropDef;
+    dropDef.name = QString("段内压差\\%1").arg(pressureUnit);
+    dropDef.unit = pressureUnit;
+    dropDef.description = "相对流动段起点压力的压差 Δp（压降段与恢复段均为正）";
+    dropDef.decimalPlaces = 6;
+
+    // 先插入靠右的列，靠左列的位置不受影响
+    bool hasPressure = pressureColumn >= 0;
+    if (hasPressure && pressureColumn > timeColumn)
+        insertValueColumn(pressureColumn + 1, dropDef, detection.pressureChange);
+    insertValueColumn(timeColumn + 1, periodDef, periodNumber);
+    insertValueColumn(timeColumn + 2, elapsedDef, detection.elapsed);
+    if (hasPressure && pressureColumn < timeColumn)
+        insertValueColumn(pressureColumn + 1, dropDef, detection.pressureChange);
+
+    hideAnimatedProgress();
+    optimizeColumnWidths();
+    m_dataModified = true;
+    emitDataChanged();
+    updateStatus(QString("流动段识别完成 - %1 个流动段").arg(detection.periods.size()), "success");
+
+    QStringList lines;
+    const int shown = qMin(detection.periods.size(), 20);
+    for (int k = 0; k < shown; ++k) {
+        const FlowPeriod& period = detection.periods[k];
+        QString kind = !detection.fromRates ? (period.pressureSign > 0 ? "压力上升" : "压力下降")
+                                            : (period.shutIn ? "关井" : QString("产量 %1").arg(period.rate, 0, 'g', 6));
+        lines << QString("第 %1 段：t = %2 %3 起，%4").arg(k + 1).arg(period.startTime, 0, 'g', 8).arg(timeUnit).arg(kind);
+    }
+    if (detection.periods.size() > shown) lines << QString("…… 共 %1 段").arg(detection.periods.size());
+
+    showStyledMessageBox("流动段识别完成",
+                         QString("识别依据：%1\n"
+                                 "流动段数：%2\n\n%3")
+                             .arg(detection.fromRates ? "流量列" : "压力变化率")
+                             .arg(detection.periods.size())
+                             .arg(lines.join("\n")),
+                         QMessageBox::Information);
+}
+
+void DataEditorWidget::insertValueColumn(int columnIndex, const ColumnDefinition& definition,
+                                         const QVector<double>& values)
+{
+    m_dataModel->insertColumn(columnIndex);
+    m_dataModel->setHorizontalHeaderItem(columnIndex, new QStandardItem(definition.name));
+    for (int row = 0; row < m_dataModel->rowCount(); ++row) {
+        double value = values.value(row, std::numeric_limits<double>::quiet_NaN());
+        QStandardItem* item = new QStandardItem(std::isfinite(value) ? QString::number(value, 'g', 8) : QString());
+        item->setForeground(QBrush(QColor("#2c3e50")));
+        m_dataModel->setItem(row, columnIndex, item);
+    }
+
+    if (columnIndex < m_columnDefinitions.size()) {
+        m_columnDefinitions.insert(columnIndex, definition);
+    } else {
+        m_columnDefinitions.append(definition);
+    }
+}
+
 // 使用配置计算压力导数
 PressureDerivativeResult DataEditorWidget::calculatePressureDerivativeWithConfig(const PressureDerivativeConfig& config)
 {
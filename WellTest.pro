@@ -23,9 +23,24 @@ win32: LIBS += -lm
 
 # Input
 HEADERS += dataeditorwidget.h \
+           cancellationtoken.h \
            chartsetting1.h \
+           fitcheckpoint.h \
+           fitjobqueue.h \
+           fittingengine.h \
            fittingpage.h \
            fittingwidget.h \
+           flowperioddetector.h \
+           flowregimeanalyzer.h \
+           gaugealignment.h \
+           gaugedatafilter.h \
+           laplacetransform.h \
+           batchfitrunner.h \
+           initialguessestimator.h \
+           modelcurveinterpolator.h \
+           modelsuperposition.h \
+           rateschedule.h \
+           timetransform.h \
            modelmanager.h \
            modelparameter.h \
            modelselect.h \
@@ -37,6 +52,7 @@ HEADERS += dataeditorwidget.h \
            modelwidget6.h \
            mousezoom.h \
            plottingwidget.h \
+           posteriorsampler.h \
            mainwindow.h \
            monitorbtn.h \
            monitorwidget.h \
@@ -44,6 +60,7 @@ HEADERS += dataeditorwidget.h \
            navbtn.h \
            newprojectdialog.h \
            pressurederivativecalculator.h \
+           pressuredeconvolution.h \
            settingswidget.h \
            qcustomplot.h
 
@@ -68,8 +85,21 @@ FORMS += dataeditorwidget.ui \
 
 SOURCES += DataEditorWidget.cpp \
            chartsetting1.cpp \
+           fitcheckpoint.cpp \
+           fitjobqueue.cpp \
+           fittingengine.cpp \
            fittingpage.cpp \
            fittingwidget.cpp \
+           flowperioddetector.cpp \
+           flowregimeanalyzer.cpp \
+           gaugealignment.cpp \
+           gaugedatafilter.cpp \
+           laplacetransform.cpp \
+           batchfitrunner.cpp \
+           initialguessestimator.cpp \
+           modelcurveinterpolator.cpp \
+           modelsuperposition.cpp \
+           timetransform.cpp \
            modelmanager.cpp \
            modelparameter.cpp \
            modelselect.cpp \
@@ -81,6 +111,7 @@ SOURCES += DataEditorWidget.cpp \
            modelwidget6.cpp \
            mousezoom.cpp \
            plottingwidget.cpp \
+           posteriorsampler.cpp \
            plotwindow.cpp \
            main.cpp \
            mainwindow.cpp \
@@ -90,6 +121,7 @@ SOURCES += DataEditorWidget.cpp \
            navbtn.cpp \
            newprojectdialog.cpp \
            pressurederivativecalculator.cpp \
+           pressuredeconvolution.cpp \
            settingswidget.cpp \
            qcustomplot.cpp
 
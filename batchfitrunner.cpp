@@ -0,0 +1,367 @@
+#include "batchfitrunner.h"
+#include "fittingwidget.h"
+#include "initialguessestimator.h"
+#include "pressurederivativecalculator.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+BatchFitRunner::BatchFitRunner(ModelManager* manager)
+    : m_manager(manager)
+{
+}
+
+bool BatchFitRunner::loadSpec(const QString& path, BatchFitSpec& spec, QString* error)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (error) *error = QString("无法打开任务文件: %1").arg(path);
+        return false;
+    }
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(f.readAll(), &parseError);
+    if (!doc.isObject()) {
+        if (error) *error = QString("任务文件不是有效的 JSON: %1").arg(parseError.errorString());
+        return false;
+    }
+    QJsonObject root = doc.object();
+
+    // 模型可用序号或名称指定
+    QJsonValue model = root.value("model");
+    if (model.isString()) {
+        bool found = false;
+        for (int k = ModelManager::Model_1; k <= ModelManager::Model_6; ++k) {
+            if (ModelManager::supportsTheoreticalCurve((ModelManager::ModelType)k)
+                && ModelManager::getModelTypeName((ModelManager::ModelType)k) == model.toString()) {
+                spec.modelType = (ModelManager::ModelType)k;
+                found = true;
+            }
+        }
+        if (!found) {
+            if (error) *error = QString("未知的模型: %1").arg(model.toString());
+            return false;
+        }
+    } else if (!model.isUndefined()) {
+        int k = model.toInt(-1);
+        if (k < ModelManager::Model_1 || k > ModelManager::Model_6) {
+            if (error) *error = QString("模型序号超出范围: %1").arg(k);
+            return false;
+        }
+        spec.modelType = (ModelManager::ModelType)k;
+    }
+    // 未接入理论曲线的模型只会得到空残差，在开始批量拟合前拒绝
+    if (!ModelManager::supportsTheoreticalCurve(spec.modelType)) {
+        QStringList supported;
+        for (int k = ModelManager::Model_1; k <= ModelManager::Model_6; ++k)
+            if (ModelManager::supportsTheoreticalCurve((ModelManager::ModelType)k)) supported << QString::number(k);
+        if (error) *error = QString("模型序号 %1 暂不支持理论曲线计算，批量拟合可用的模型序号: %2")
+                                .arg(int(spec.modelType)).arg(supported.join(", "));
+        return false;
+    }
+
+    spec.weight = qBound(0.0, root.value("weight").toDouble(spec.weight), 1.0);
+    spec.parameters = root.value("parameters").toObject();
+    spec.workers = qMax(0, root.value("workers").toInt(spec.workers));
+
+    QJsonObject opt = root.value("optimizer").toObject();
+    spec.autoGuess = opt.value("autoGuess").toBool(spec.autoGuess);
+    spec.autoFreeze = opt.value("autoFreeze").toBool(spec.autoFreeze);
+    spec.laplacePrefit = opt.value("laplacePrefit").toBool(spec.laplacePrefit);
+    spec.bootstrapSamples = qMax(0, opt.value("bootstrap").toInt(spec.bootstrapSamples));
+    QString loss = opt.value("loss").toString("leastSquares").toLower();
+    if (loss == "huber") spec.loss.type = FitLoss::Huber;
+    else if (loss == "cauchy") spec.loss.type = FitLoss::Cauchy;
+    else if (loss == "leastsquares") spec.loss.type = FitLoss::LeastSquares;
+    else {
+        if (error) *error = QString("未知的损失函数: %1").arg(loss);
+        return false;
+    }
+    spec.loss.scale = opt.value("lossScale").toDouble(spec.loss.scale);
+
+    QJsonObject data = root.value("data").toObject();
+    if (data.contains("pattern"))
+        spec.filePatterns = data.value("pattern").toString().split(QRegularExpression("[;\\s]+"), Qt::SkipEmptyParts);
+    spec.timeColumn = data.value("timeColumn").toInt(spec.timeColumn);
+    spec.pressureColumn = data.value("pressureColumn").toInt(spec.pressureColumn);
+    spec.derivativeColumn = data.value("derivativeColumn").toInt(spec.derivativeColumn);
+    spec.weightColumn = data.value("weightColumn").toInt(spec.weightColumn);
+    spec.skipRows = qMax(0, data.value("skipRows").toInt(spec.skipRows));
+    spec.pressureIsDelta = data.value("pressureType").toString("pressure") == "delta";
+    // 导数算法：data.derivative = {method, lSpacing, window, polyOrder, lambda}，旧格式的 data.lSpacing 仍有效
+    spec.derivative.lSpacing = data.value("lSpacing").toDouble(spec.derivative.lSpacing);
+    QJsonObject deriv = data.value("derivative").toObject();
+    QString method = deriv.value("method").toString("bourdet").toLower();
+    if (method == "bourdet") spec.derivative.method = DerivativeMethod::Bourdet;
+    else if (method == "savitzkygolay") spec.derivative.method = DerivativeMethod::SavitzkyGolay;
+    else if (method == "spline") spec.derivative.method = DerivativeMethod::SmoothingSpline;
+    else if (method == "tikhonov") spec.derivative.method = DerivativeMethod::Tikhonov;
+    else {
+        if (error) *error = QString("未知的导数算法: %1").arg(method);
+        return false;
+    }
+    spec.derivative.lSpacing = deriv.value("lSpacing").toDouble(spec.derivative.lSpacing);
+    spec.derivative.window = deriv.value("window").toDouble(spec.derivative.window);
+    spec.derivative.polyOrder = qBound(1, deriv.value("polyOrder").toInt(spec.derivative.polyOrder), 4);
+    spec.derivative.lambda = deriv.value("lambda").toDouble(spec.derivative.lambda);
+    if (spec.timeColumn < 0 || spec.pressureColumn < 0) {
+        if (error) *error = "时间列与压力列必须指定";
+        return false;
+    }
+    return true;
+}
+
+bool BatchFitRunner::readGaugeFile(const QString& path, const BatchFitSpec& spec, QVector<double>& t,
+                                   QVector<double>& p, QVector<double>& d, QVector<double>& weights, QString* error)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (error) *error = "无法打开数据文件";
+        return false;
+    }
+    // 与界面加载数据相同：跳过首行后按列读取，原始压力以首个压力为初始压力求压差
+    QTextStream in(&f);
+    int row = 0;
+    bool haveInitial = false;
+    double pInit = 0.0;
+    QVector<double> dCol;
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty()) continue;
+        if (row++ < spec.skipRows) continue;
+        QStringList cols = FittingWidget::parseLine(line);
+        if (spec.timeColumn >= cols.size() || spec.pressureColumn >= cols.size()) continue;
+        double tv = cols[spec.timeColumn].toDouble();
+        double val = cols[spec.pressureColumn].toDouble();
+        if (!spec.pressureIsDelta && !haveInitial) { pInit = val; haveInitial = true; }
+        if (!(tv > 0)) continue;
+        t << tv;
+        p << (spec.pressureIsDelta ? val : std::abs(val - pInit));
+        if (spec.derivativeColumn >= 0) dCol << (spec.derivativeColumn < cols.size() ? cols[spec.derivativeColumn].toDouble() : 0.0);
+        if (spec.weightColumn >= 0) {
+            // 与界面相同：0 剔除该点，负值与非数值按 1 处理
+            bool ok = false;
+            double wv = spec.weightColumn < cols.size() ? cols[spec.weightColumn].toDouble(&ok) : 0.0;
+            weights << ((ok && wv >= 0) ? wv : 1.0);
+        }
+    }
+    if (t.size() < 3) {
+        if (error) *error = "有效数据点不足";
+        return false;
+    }
+    d = (spec.derivativeColumn >= 0) ? dCol : PressureDerivativeCalculator::calculateDerivative(t, p, spec.derivative);
+    return true;
+}
+
+QList<FitParameter> BatchFitRunner::buildParameters(const BatchFitSpec& spec) const
+{
+    QList<FitParameter> params = FittingWidget::defaultParameters(m_manager, spec.modelType);
+    for (FitParameter& p : params) {
+        if (!spec.parameters.contains(p.name)) continue;
+        QJsonValue v = spec.parameters.value(p.name);
+        // 只给数值时视为固定参数的取值
+        if (v.isDouble()) { p.value = v.toDouble(); continue; }
+        QJsonObject o = v.toObject();
+        p.value = o.value("value").toDouble(p.value);
+        p.isFit = o.value("fit").toBool(p.isFit);
+        p.min = o.value("min").toDouble(p.min);
+        p.max = o.value("max").toDouble(p.max);
+    }
+    return params;
+}
+
+BatchWellResult BatchFitRunner::fitWell(const QString& path, const BatchFitSpec& spec, const QString& outDir,
+                                        QThreadPool* pool)
+{
+    BatchWellResult r;
+    QFileInfo info(path);
+    r.well = info.completeBaseName();
+    r.file = info.fileName();
+    QElapsedTimer clock;
+    clock.start();
+
+    QVector<double> t, p, d, w;
+    if (!readGaugeFile(path, spec, t, p, d, w, &r.error)) { r.elapsedMs = clock.elapsed(); return r; }
+    r.points = t.size();
+
+    r.params = buildParameters(spec);
+    if (spec.autoGuess) {
+        QMap<QString, double> current;
+        for (const FitParameter& fp : r.params) current[fp.name] = fp.value;
+        InitialGuessResult guess = InitialGuessEstimator::estimate(t, p, d, current);
+        for (FitParameter& fp : r.params) {
+            if (!fp.isFit || !guess.values.contains(fp.name)) continue;
+            double v = guess.values.value(fp.name);
+            if (std::isfinite(v)) fp.value = qBound(fp.min, v, fp.max);
+        }
+    }
+
+    FittingEngine engine;
+    engine.setModelManager(m_manager);
+    // Bootstrap 重拟合与各井共用 workers 个线程
+    engine.setThreadPool(pool);
+    engine.setObservedData(t, p, d);
+    engine.setPointWeights(w);
+    engine.setAutoFreeze(spec.autoFreeze);
+    engine.setLaplacePrefit(spec.laplacePrefit);
+    engine.setLoss(spec.loss);
+    engine.setBootstrapSamples(spec.bootstrapSamples);
+    engine.runLevenbergMarquardt(spec.modelType, r.params, spec.weight);
+
+    FitSnapshotPtr snap = engine.latestSnapshot();
+    FitCostStats cost = engine.costStats();
+    r.modelEvaluations = cost.modelEvaluations;
+    r.modelPoints = cost.modelPoints;
+    r.iterations = engine.iterationCount();
+    if (!snap || !snap->finished || snap->params.isEmpty()) {
+        r.error = "模型计算失败（模型未初始化或没有勾选拟合参数）";
+        r.elapsedMs = clock.elapsed();
+        return r;
+    }
+    for (FitParameter& fp : r.params) fp.value = snap->params.value(fp.name, fp.value);
+    r.objective = snap->error;
+    r.uncertainty = engine.uncertainty();
+
+    QJsonObject state = FittingWidget::stateToJson(spec.modelType, r.params, t, p, d, w, &engine);
+    state["sourceFile"] = info.absoluteFilePath();
+    QSaveFile out(QDir(outDir).filePath(r.well + ".json"));
+    if (!out.open(QIODevice::WriteOnly) || out.write(QJsonDocument(state).toJson()) < 0 || !out.commit()) {
+        r.error = "无法写入结果文件";
+        r.elapsedMs = clock.elapsed();
+        return r;
+    }
+    r.success = true;
+    r.elapsedMs = clock.elapsed();
+    return r;
+}
+
+bool BatchFitRunner::writeSummary(const QString& path, const QList<BatchWellResult>& results, const QStringList& fitNames) const
+{
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    QTextStream out(&f);
+    QStringList header = {"well", "file", "status", "points", "iterations", "objective", "elapsed_ms", "model_evaluations"};
+    for (const QString& name : fitNames) header << name << name + "_ci_lower" << name + "_ci_upper";
+    header << "error";
+    out << header.join(",") << "\n";
+    auto num = [](double v) { return std::isfinite(v) ? QString::number(v, 'g', 8) : QString(); };
+    for (const BatchWellResult& r : results) {
+        QStringList row = {r.well, r.file, r.success ? "ok" : "failed", QString::number(r.points),
+                           QString::number(r.iterations), r.success ? num(r.objective) : QString(),
+                           QString::number(r.elapsedMs), QString::number(r.modelEvaluations)};
+        for (const QString& name : fitNames) {
+            double value = std::numeric_limits<double>::quiet_NaN();
+            for (const FitParameter& fp : r.params) if (fp.name == name) value = fp.value;
+            int k = r.uncertainty.valid ? r.uncertainty.names.indexOf(name) : -1;
+            row << (r.success ? num(value) : QString())
+                << (k >= 0 ? num(r.uncertainty.ciLower[k]) : QString())
+                << (k >= 0 ? num(r.uncertainty.ciUpper[k]) : QString());
+        }
+        QString err = r.error;
+        row << (err.isEmpty() ? QString() : "\"" + err.replace("\"", "\"\"") + "\"");
+        out << row.join(",") << "\n";
+    }
+    out.flush();
+    return f.commit();
+}
+
+void BatchFitRunner::print(const QString& line)
+{
+    QMutexLocker locker(&m_printMutex);
+    QTextStream(stdout) << line << Qt::endl;
+}
+
+int BatchFitRunner::run(const QString& dataDir, const QString& outDir, const BatchFitSpec& spec)
+{
+    QDir dir(dataDir);
+    if (!dir.exists()) { print(QString("数据目录不存在: %1").arg(dataDir)); return 2; }
+    QStringList files;
+    for (const QString& name : dir.entryList(spec.filePatterns, QDir::Files, QDir::Name))
+        files << dir.absoluteFilePath(name);
+    if (files.isEmpty()) { print(QString("数据目录中没有匹配 %1 的文件").arg(spec.filePatterns.join(" "))); return 2; }
+    if (!QDir().mkpath(outDir)) { print(QString("无法创建输出目录: %1").arg(outDir)); return 2; }
+
+    QStringList fitNames;
+    for (const FitParameter& fp : buildParameters(spec)) if (fp.isFit) fitNames << fp.name;
+    if (fitNames.isEmpty()) { print("任务规格中没有勾选拟合的参数"); return 2; }
+
+    int workers = spec.workers > 0 ? spec.workers : qMax(1, QThread::idealThreadCount());
+    print(QString("批量拟合: %1 口井, 模型 %2, 拟合参数 %3, 并行 %4")
+              .arg(files.size()).arg(ModelManager::getModelTypeName(spec.modelType))
+              .arg(fitNames.join("/")).arg(workers));
+
+    QElapsedTimer wall;
+    wall.start();
+    std::atomic<int> done(0);
+    const int total = files.size();
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    auto task = [&](const QString& path) {
+        BatchWellResult r = fitWell(path, spec, outDir, &pool);
+        int k = ++done;
+        if (r.success)
+            print(QString("[%1/%2] %3: %4 点, %5 次迭代, 目标函数 %6, %7 s")
+                      .arg(k).arg(total).arg(r.well).arg(r.points).arg(r.iterations)
+                      .arg(r.objective, 0, 'g', 4).arg(r.elapsedMs / 1000.0, 0, 'f', 1));
+        else
+            print(QString("[%1/%2] %3: 失败 - %4").arg(k).arg(total).arg(r.well, r.error));
+        return r;
+    };
+    QList<BatchWellResult> results = QtConcurrent::blockingMapped<QList<BatchWellResult>>(&pool, files, task);
+    qint64 wallMs = qMax<qint64>(1, wall.elapsed());
+
+    QString summaryPath = QDir(outDir).filePath("summary.csv");
+    if (!writeSummary(summaryPath, results, fitNames)) print(QString("无法写入汇总文件: %1").arg(summaryPath));
+
+    // 吞吐量：并行效率 = 各井耗时之和 / (总耗时 × 并行数)
+    int ok = 0;
+    qint64 busyMs = 0, evals = 0, points = 0;
+    for (const BatchWellResult& r : results) {
+        if (r.success) ++ok;
+        busyMs += r.elapsedMs; evals += r.modelEvaluations; points += r.modelPoints;
+    }
+    print(QString("完成 %1/%2 口井, 总耗时 %3 s, 吞吐量 %4 井/分钟, 平均单井 %5 s")
+              .arg(ok).arg(total).arg(wallMs / 1000.0, 0, 'f', 1)
+              .arg(total * 60000.0 / wallMs, 0, 'f', 2).arg(busyMs / 1000.0 / total, 0, 'f', 1));
+    print(QString("模型计算 %1 次 (%2 点), 并行效率 %3%, 结果目录 %4")
+              .arg(evals).arg(points).arg(100.0 * busyMs / (wallMs * (double)qMin(workers, total)), 0, 'f', 0)
+              .arg(QDir(outDir).absolutePath()));
+    return ok == total ? 0 : 1;
+}
+
+int BatchFitRunner::runFromCommandLine(const QStringList& args, ModelManager* manager)
+{
+    QString dataDir, jobPath, outDir;
+    int workers = -1;
+    for (int i = 1; i < args.size(); ++i) {
+        const QString& a = args[i];
+        bool hasValue = i + 1 < args.size();
+        if (a == "--batch" && hasValue) dataDir = args[++i];
+        else if (a == "--job" && hasValue) jobPath = args[++i];
+        else if (a == "--out" && hasValue) outDir = args[++i];
+        else if (a == "--workers" && hasValue) workers = args[++i].toInt();
+    }
+    BatchFitRunner runner(manager);
+    if (dataDir.isEmpty() || jobPath.isEmpty()) {
+        runner.print("用法: WellTest --batch <数据目录> --job <任务.json> [--out <输出目录>] [--workers N]");
+        return 2;
+    }
+    BatchFitSpec spec;
+    QString error;
+    if (!loadSpec(jobPath, spec, &error)) { runner.print(error); return 2; }
+    if (workers >= 0) spec.workers = workers;
+    if (outDir.isEmpty()) outDir = QDir(dataDir).filePath("fit_results");
+    return runner.run(dataDir, outDir, spec);
+}
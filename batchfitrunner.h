@@ -0,0 +1,115 @@
+#ifndef BATCHFITRUNNER_H
+#define BATCHFITRUNNER_H
+
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+#include <QMutex>
+#include <QVector>
+#include <QThreadPool>
+#include "modelmanager.h"
+#include "fittingengine.h"
+#include "pressurederivativecalculator.h"
+
+// 批量拟合任务规格（由 JSON 文件读入）
+struct BatchFitSpec {
+    ModelManager::ModelType modelType;
+    double weight;                  // 压力与导数的权重，同界面滑块
+    QJsonObject parameters;         // 参数名 → {value, fit, min, max}，未列出的参数取默认值
+    bool autoGuess;                 // 拟合前按流动段估计勾选参数的初值
+    bool autoFreeze;
+    bool laplacePrefit;
+    FitLoss loss;
+    int bootstrapSamples;
+    int workers;                    // 并行拟合的井数，0 表示按 CPU 核数
+
+    // 数据文件解析
+    QStringList filePatterns;
+    int timeColumn;
+    int pressureColumn;
+    int derivativeColumn;           // -1 表示按 derivative 指定的算法计算
+    int weightColumn;               // 逐点权重列，-1 表示等权重
+    int skipRows;
+    bool pressureIsDelta;           // false 时为原始压力，压差取 |P - P首点|
+    DerivativeOptions derivative;
+
+    BatchFitSpec() :
+        modelType(ModelManager::Model_1),
+        weight(0.5),
+        autoGuess(true),
+        autoFreeze(true),
+        laplacePrefit(true),
+        bootstrapSamples(0),
+        workers(0),
+        filePatterns({"*.txt", "*.csv"}),
+        timeColumn(0),
+        pressureColumn(1),
+        derivativeColumn(-1),
+        weightColumn(-1),
+        skipRows(1),
+        pressureIsDelta(false) {}
+};
+
+// 单口井的批量拟合结果
+struct BatchWellResult {
+    QString well;
+    QString file;
+    bool success;
+    QString error;
+    int points;
+    int iterations;
+    double objective;
+    qint64 elapsedMs;
+    int modelEvaluations;
+    qint64 modelPoints;
+    QList<FitParameter> params;
+    FitUncertainty uncertainty;
+
+    BatchWellResult() :
+        success(false),
+        points(0),
+        iterations(0),
+        objective(0.0),
+        elapsedMs(0),
+        modelEvaluations(0),
+        modelPoints(0) {}
+};
+
+/**
+ * @brief 无界面批量拟合
+ *
+ * 对目录中的每个压力计数据文件按同一任务规格拟合，多口井在线程池中并行，
+ * 每口井使用独立的 FittingEngine（与界面相同的拟合流程）。
+ * 每口井输出与 FittingWidget::getJsonState 格式一致的 JSON，另写汇总 CSV，
+ * 并在标准输出打印逐井进度与吞吐量统计。
+ *
+ * 命令行：WellTest --batch <数据目录> --job <任务.json> [--out <输出目录>] [--workers N]
+ */
+class BatchFitRunner
+{
+public:
+    explicit BatchFitRunner(ModelManager* manager);
+
+    static bool loadSpec(const QString& path, BatchFitSpec& spec, QString* error = nullptr);
+    static bool readGaugeFile(const QString& path, const BatchFitSpec& spec, QVector<double>& t,
+                              QVector<double>& p, QVector<double>& d, QVector<double>& weights,
+                              QString* error = nullptr);
+
+    // 返回进程退出码：0 全部成功，1 有井拟合失败，2 参数或任务规格错误
+    int run(const QString& dataDir, const QString& outDir, const BatchFitSpec& spec);
+
+    // 解析命令行参数（含 --batch）后运行
+    static int runFromCommandLine(const QStringList& args, ModelManager* manager);
+
+private:
+    BatchWellResult fitWell(const QString& path, const BatchFitSpec& spec, const QString& outDir,
+                            QThreadPool* pool);
+    QList<FitParameter> buildParameters(const BatchFitSpec& spec) const;
+    bool writeSummary(const QString& path, const QList<BatchWellResult>& results, const QStringList& fitNames) const;
+    void print(const QString& line);
+
+    ModelManager* m_manager;
+    QMutex m_printMutex;
+};
+
+#endif // BATCHFITRUNNER_H
@@ -0,0 +1,34 @@
+#ifndef CANCELLATIONTOKEN_H
+#define CANCELLATIONTOKEN_H
+
+#include <atomic>
+
+/**
+ * @brief 协作式取消标志
+ *
+ * 由发起计算的一方持有并调用 cancel()，以只读指针形式逐层传入理论曲线计算
+ * （Stehfest 反演循环、裂缝积分），在廉价的检查点读取。被取消的计算立即返回，
+ * 已算出的结果保持不变、其余点补零，调用方应丢弃这次的结果。
+ * 可指定父标志：父标志取消时本标志同样视为已取消（用于派生的子任务）。
+ */
+class CancellationToken
+{
+public:
+    CancellationToken() : m_cancelled(false), m_parent(nullptr) {}
+
+    void cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+    void reset() { m_cancelled.store(false, std::memory_order_relaxed); }
+    bool isCancelled() const {
+        return m_cancelled.load(std::memory_order_relaxed) || (m_parent && m_parent->isCancelled());
+    }
+    void setParent(const CancellationToken* parent) { m_parent = parent; }
+
+    // 空指针表示不可取消
+    static bool isCancelled(const CancellationToken* token) { return token && token->isCancelled(); }
+
+private:
+    std::atomic<bool> m_cancelled;
+    const CancellationToken* m_parent;
+};
+
+#endif // CANCELLATIONTOKEN_H
@@ -63,6 +63,10 @@
 
 // 新增：压力导数计算器头文件
 #include "PressureDerivativeCalculator.h"
+#include "timetransform.h"
+#include "gaugealignment.h"
+#include "gaugedatafilter.h"
+#include "flowperioddetector.h"
 
 namespace Ui {
 class DataEditorWidget;
@@ -480,6 +484,8 @@ signals:
 private slots:
     // 文件操作槽函数
     void onOpenFile();
+    // 导入多个压力计文件，估计时钟偏差后合并为一张表
+    void onMultiGaugeImport();
     void onSave();
     void onExport();
 
@@ -487,12 +493,19 @@ private slots:
     void onDefineColumns();
     void onTimeConvert();
     void onDataClean();
+    void onGaugeFilter();
     void onDataStatistics();
     void onPressureDropCalc();
 
     // 新增：压力导数计算槽函数
     void onPressureDerivativeCalc();
 
+    // 变产量试井时间变换（段内时间、等效时间、叠加时间、Horner 时间比）
+    void onTimeTransformCalc();
+
+    // 开关井、变产量时刻识别，按流动段插入段内时间与压差
+    void onFlowPeriodDetect();
+
     // 搜索槽函数
     void onSearchTextChanged();
     void onSearchData();
@@ -602,9 +615,15 @@ private:
     // 压降计算相关方法 - 优化的压降计算
     int findPressureColumn() const;
     int findTimeColumn() const;
+    int findFlowRateColumn() const;
     QString getPressureUnit() const;
     bool isValidPressureData(const QString& data) const;
 
+    // 由流量列逐行读取产量历史（time 与表格行一一对应）；没有流量列时返回空
+    RateSchedule readRateSchedule(const QVector<double>& time) const;
+    // 在 columnIndex 处插入一列数值（非有限值留空）并登记列定义
+    void insertValueColumn(int columnIndex, const ColumnDefinition& definition, const QVector<double>& values);
+
     // 新增：压力导数计算相关方法
     // （自动检测列，无需配置对话框）
 
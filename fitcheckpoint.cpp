@@ -0,0 +1,376 @@
+#include "fitcheckpoint.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QDateTime>
+#include <cmath>
+#include <limits>
+
+namespace {
+const char* kFormat = "WellTestFitCheckpoint";
+// 版本 2 起保存目标函数设置（产量历史、损失函数、逐点权重、自动冻结）
+const int kVersion = 2;
+
+QJsonValue number(double v) { return std::isfinite(v) ? QJsonValue(v) : QJsonValue(); }
+double toNumber(const QJsonValue& v) { return v.isDouble() ? v.toDouble() : std::numeric_limits<double>::quiet_NaN(); }
+
+QJsonArray vectorToJson(const QVector<double>& v)
+{
+    QJsonArray a;
+    for (double x : v) a.append(number(x));
+    return a;
+}
+
+QVector<double> vectorFromJson(const QJsonValue& value)
+{
+    QJsonArray a = value.toArray();
+    QVector<double> v;
+    v.reserve(a.size());
+    for (const QJsonValue& x : a) v.append(toNumber(x));
+    return v;
+}
+
+QJsonArray matrixToJson(const QVector<QVector<double>>& m)
+{
+    QJsonArray a;
+    for (const auto& row : m) a.append(vectorToJson(row));
+    return a;
+}
+
+QVector<QVector<double>> matrixFromJson(const QJsonValue& value)
+{
+    QVector<QVector<double>> m;
+    for (const QJsonValue& row : value.toArray()) m.append(vectorFromJson(row));
+    return m;
+}
+
+QJsonArray samplesToJson(const QVector<SurrogateSample>& samples)
+{
+    QJsonArray a;
+    for (const auto& s : samples) {
+        QJsonObject o;
+        o["x"] = vectorToJson(s.x);
+        o["residuals"] = vectorToJson(s.residuals);
+        a.append(o);
+    }
+    return a;
+}
+
+QVector<SurrogateSample> samplesFromJson(const QJsonValue& value)
+{
+    QVector<SurrogateSample> samples;
+    for (const QJsonValue& v : value.toArray()) {
+        QJsonObject o = v.toObject();
+        SurrogateSample s;
+        s.x = vectorFromJson(o["x"]);
+        s.residuals = vectorFromJson(o["residuals"]);
+        samples.append(s);
+    }
+    return samples;
+}
+
+QJsonArray boolsToJson(const QVector<bool>& v)
+{
+    QJsonArray a;
+    for (bool b : v) a.append(b);
+    return a;
+}
+
+QVector<bool> boolsFromJson(const QJsonValue& value)
+{
+    QVector<bool> v;
+    for (const QJsonValue& b : value.toArray()) v.append(b.toBool());
+    return v;
+}
+}
+
+QString FitCheckpointFile::defaultPath(const QString& projectDir, const QString& analysisName)
+{
+    QString dir = projectDir.isEmpty() ? QString(".") : projectDir;
+    QString name = analysisName.trimmed();
+    if (name.isEmpty()) name = "fit";
+    // 分析名用作文件名，替换路径中不允许的字符
+    static const QString invalid = "\\/:*?\"<>|";
+    for (QChar& c : name) if (invalid.contains(c)) c = '_';
+    return QDir(dir).filePath("checkpoints/" + name + ".fitckpt");
+}
+
+QJsonObject FitCheckpointFile::toJson(const FitCheckpoint& c)
+{
+    QJsonObject root;
+    root["format"] = kFormat;
+    root["version"] = kVersion;
+    root["savedAt"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    root["kind"] = (c.kind == FitCheckpoint::LevenbergMarquardt) ? "lm" : "posterior";
+    root["modelType"] = (int)c.modelType;
+    root["modelName"] = ModelManager::getModelTypeName(c.modelType);
+    root["weight"] = c.weight;
+
+    QJsonArray paramsArray;
+    for (const auto& p : c.params) {
+        QJsonObject o;
+        o["name"] = p.name;
+        o["displayName"] = p.displayName;
+        o["symbol"] = p.symbol;
+        o["unit"] = p.unit;
+        o["value"] = number(p.value);
+        o["isFit"] = p.isFit;
+        o["min"] = number(p.min);
+        o["max"] = number(p.max);
+        paramsArray.append(o);
+    }
+    root["parameters"] = paramsArray;
+
+    QJsonObject obs;
+    obs["time"] = vectorToJson(c.obsTime);
+    obs["pressure"] = vectorToJson(c.obsPressure);
+    obs["derivative"] = vectorToJson(c.obsDerivative);
+    root["observedData"] = obs;
+
+    QJsonObject objective;
+    QJsonObject rates;
+    rates["startTime"] = vectorToJson(c.rateSchedule.startTime);
+    rates["rate"] = vectorToJson(c.rateSchedule.rate);
+    objective["rateSchedule"] = rates;
+    QJsonObject loss;
+    loss["type"] = (c.loss.type == FitLoss::Huber) ? "huber" : (c.loss.type == FitLoss::Cauchy) ? "cauchy" : "leastSquares";
+    loss["scale"] = number(c.loss.scale);
+    objective["loss"] = loss;
+    objective["pointWeights"] = vectorToJson(c.pointWeights);
+    objective["autoFreeze"] = c.autoFreeze;
+    root["objective"] = objective;
+
+    if (c.kind == FitCheckpoint::LevenbergMarquardt) {
+        QJsonObject lm;
+        lm["iteration"] = c.iteration;
+        lm["fidelityLevel"] = c.fidelityLevel;
+        lm["lambda"] = number(c.lambda);
+        QJsonObject values;
+        for (const QString& key : c.values.keys()) values[key] = number(c.values.value(key));
+        lm["values"] = values;
+        lm["jacobian"] = matrixToJson(c.jacobian);
+        QJsonArray logArr;
+        for (const auto& rec : c.iterationLog) {
+            QJsonObject r;
+            r["iter"] = rec.iteration;
+            r["fidelity"] = rec.fidelityLevel;
+            r["stehfestN"] = rec.stehfestN;
+            r["sse"] = number(rec.sse);
+            r["lambda"] = number(rec.lambda);
+            if (!rec.frozen.isEmpty()) r["frozen"] = QJsonArray::fromStringList(rec.frozen);
+            logArr.append(r);
+        }
+        lm["iterationLog"] = logArr;
+        root["levenbergMarquardt"] = lm;
+    } else {
+        QJsonObject post;
+        const PosteriorConfig& cfg = c.posteriorConfig;
+        QJsonObject config;
+        config["walkers"] = cfg.walkers;
+        config["steps"] = cfg.steps;
+        config["burnIn"] = cfg.burnIn;
+        config["thin"] = cfg.thin;
+        config["checkInterval"] = cfg.checkInterval;
+        config["checkTol"] = cfg.checkTol;
+        config["maxNodes"] = cfg.maxNodes;
+        config["checkpointInterval"] = cfg.checkpointInterval;
+        post["config"] = config;
+
+        const PosteriorProblem& pb = c.posteriorProblem;
+        QJsonObject problem;
+        QJsonArray names;
+        for (const QString& n : pb.names) names.append(n);
+        problem["names"] = names;
+        problem["isLog"] = boolsToJson(pb.isLog);
+        problem["best"] = vectorToJson(pb.best);
+        problem["scale"] = vectorToJson(pb.scale);
+        problem["lower"] = vectorToJson(pb.lower);
+        problem["upper"] = vectorToJson(pb.upper);
+        problem["sigma2"] = number(pb.sigma2);
+        post["problem"] = problem;
+
+        const PosteriorSamplerState& st = c.samplerState;
+        QJsonObject state;
+        state["step"] = st.step;
+        state["walkers"] = matrixToJson(st.walkers);
+        QJsonArray rngs;
+        for (const QString& r : st.walkerRng) rngs.append(r);
+        state["walkerRng"] = rngs;
+        state["masterRng"] = st.masterRng;
+        state["pool"] = samplesToJson(st.pool);
+        state["nodes"] = samplesToJson(st.nodes);
+        state["samples"] = matrixToJson(st.samples);
+        state["accepted"] = (double)st.accepted;
+        state["proposals"] = (double)st.proposals;
+        state["modelChecks"] = st.modelChecks;
+        state["surrogateRefits"] = st.surrogateRefits;
+        state["maxCheckError"] = number(st.maxCheckError);
+        post["state"] = state;
+        root["posterior"] = post;
+    }
+    return root;
+}
+
+bool FitCheckpointFile::fromJson(const QJsonObject& root, FitCheckpoint& c, QString* error)
+{
+    auto fail = [error](const QString& message) { if (error) *error = message; return false; };
+    if (root["format"].toString() != kFormat) return fail("不是拟合检查点文件。");
+    if (root["version"].toInt() > kVersion) return fail("检查点由更新版本的程序生成，无法读取。");
+
+    QString kind = root["kind"].toString();
+    if (kind == "lm") c.kind = FitCheckpoint::LevenbergMarquardt;
+    else if (kind == "posterior") c.kind = FitCheckpoint::PosteriorSampling;
+    else return fail("未知的检查点类型: " + kind);
+    c.sequence = 0;
+    c.modelType = (ModelManager::ModelType)root["modelType"].toInt();
+    c.weight = root["weight"].toDouble(0.5);
+
+    c.params.clear();
+    for (const QJsonValue& v : root["parameters"].toArray()) {
+        QJsonObject o = v.toObject();
+        FitParameter p;
+        p.name = o["name"].toString();
+        p.displayName = o["displayName"].toString();
+        p.symbol = o["symbol"].toString();
+        p.unit = o["unit"].toString();
+        p.value = toNumber(o["value"]);
+        p.isFit = o["isFit"].toBool();
+        p.min = toNumber(o["min"]);
+        p.max = toNumber(o["max"]);
+        c.params.append(p);
+    }
+    if (c.params.isEmpty()) return fail("检查点中没有参数表。");
+
+    QJsonObject obs = root["observedData"].toObject();
+    c.obsTime = vectorFromJson(obs["time"]);
+    c.obsPressure = vectorFromJson(obs["pressure"]);
+    c.obsDerivative = vectorFromJson(obs["derivative"]);
+    if (c.obsTime.isEmpty()) return fail("检查点中没有观测数据。");
+
+    // 版本 1 的检查点没有目标函数设置，按定产量、最小二乘、等权重、自动冻结恢复
+    QJsonObject objective = root["objective"].toObject();
+    QJsonObject rates = objective["rateSchedule"].toObject();
+    c.rateSchedule.startTime = vectorFromJson(rates["startTime"]);
+    c.rateSchedule.rate = vectorFromJson(rates["rate"]);
+    if (c.rateSchedule.startTime.size() != c.rateSchedule.rate.size()) return fail("检查点中的产量历史不完整。");
+    QJsonObject loss = objective["loss"].toObject();
+    QString lossType = loss["type"].toString("leastSquares");
+    if (lossType == "huber") c.loss.type = FitLoss::Huber;
+    else if (lossType == "cauchy") c.loss.type = FitLoss::Cauchy;
+    else if (lossType == "leastSquares") c.loss.type = FitLoss::LeastSquares;
+    else return fail("未知的损失函数: " + lossType);
+    c.loss.scale = loss["scale"].toDouble(FitLoss().scale);
+    c.pointWeights = vectorFromJson(objective["pointWeights"]);
+    c.autoFreeze = objective["autoFreeze"].toBool(true);
+
+    c.iteration = 0;
+    c.fidelityLevel = 0;
+    c.lambda = 0.0;
+    c.values.clear();
+    c.jacobian.clear();
+    c.iterationLog.clear();
+    c.posteriorConfig = PosteriorSampler::defaultConfig();
+    c.posteriorProblem = PosteriorProblem();
+    c.posteriorProblem.sigma2 = 0.0;
+    c.samplerState = PosteriorSamplerState();
+    c.samplerState.valid = false;
+
+    if (c.kind == FitCheckpoint::LevenbergMarquardt) {
+        QJsonObject lm = root["levenbergMarquardt"].toObject();
+        c.iteration = lm["iteration"].toInt();
+        c.fidelityLevel = lm["fidelityLevel"].toInt();
+        c.lambda = lm["lambda"].toDouble(0.01);
+        QJsonObject values = lm["values"].toObject();
+        for (const QString& key : values.keys()) c.values[key] = toNumber(values[key]);
+        c.jacobian = matrixFromJson(lm["jacobian"]);
+        for (const QJsonValue& v : lm["iterationLog"].toArray()) {
+            QJsonObject r = v.toObject();
+            QStringList frozen;
+            for (const QJsonValue& n : r["frozen"].toArray()) frozen.append(n.toString());
+            c.iterationLog.append({r["iter"].toInt(), r["fidelity"].toInt(), r["stehfestN"].toInt(),
+                                   toNumber(r["sse"]), toNumber(r["lambda"]), frozen});
+        }
+        if (c.values.isEmpty()) return fail("检查点中没有优化器状态。");
+        return true;
+    }
+
+    QJsonObject post = root["posterior"].toObject();
+    QJsonObject config = post["config"].toObject();
+    PosteriorConfig& cfg = c.posteriorConfig;
+    cfg.walkers = config["walkers"].toInt(cfg.walkers);
+    cfg.steps = config["steps"].toInt(cfg.steps);
+    cfg.burnIn = config["burnIn"].toInt(cfg.burnIn);
+    cfg.thin = config["thin"].toInt(cfg.thin);
+    cfg.checkInterval = config["checkInterval"].toInt(cfg.checkInterval);
+    cfg.checkTol = config["checkTol"].toDouble(cfg.checkTol);
+    cfg.maxNodes = config["maxNodes"].toInt(cfg.maxNodes);
+    cfg.checkpointInterval = config["checkpointInterval"].toInt(cfg.checkpointInterval);
+
+    QJsonObject problem = post["problem"].toObject();
+    PosteriorProblem& pb = c.posteriorProblem;
+    for (const QJsonValue& n : problem["names"].toArray()) pb.names.append(n.toString());
+    pb.isLog = boolsFromJson(problem["isLog"]);
+    pb.best = vectorFromJson(problem["best"]);
+    pb.scale = vectorFromJson(problem["scale"]);
+    pb.lower = vectorFromJson(problem["lower"]);
+    pb.upper = vectorFromJson(problem["upper"]);
+    pb.sigma2 = toNumber(problem["sigma2"]);
+    int d = pb.names.size();
+    if (d == 0 || pb.isLog.size() != d || pb.best.size() != d || pb.scale.size() != d
+        || pb.lower.size() != d || pb.upper.size() != d || !(pb.sigma2 > 0))
+        return fail("检查点中的后验采样问题不完整。");
+
+    QJsonObject state = post["state"].toObject();
+    PosteriorSamplerState& st = c.samplerState;
+    st.step = state["step"].toInt();
+    st.walkers = matrixFromJson(state["walkers"]);
+    for (const QJsonValue& r : state["walkerRng"].toArray()) st.walkerRng.append(r.toString());
+    st.masterRng = state["masterRng"].toString();
+    st.pool = samplesFromJson(state["pool"]);
+    st.nodes = samplesFromJson(state["nodes"]);
+    st.samples = matrixFromJson(state["samples"]);
+    st.accepted = (qint64)state["accepted"].toDouble();
+    st.proposals = (qint64)state["proposals"].toDouble();
+    st.modelChecks = state["modelChecks"].toInt();
+    st.surrogateRefits = state["surrogateRefits"].toInt();
+    st.maxCheckError = state["maxCheckError"].toDouble();
+    st.valid = !st.walkers.isEmpty() && st.walkerRng.size() == st.walkers.size() && !st.nodes.isEmpty();
+    if (!st.valid) return fail("检查点中的采样器状态不完整。");
+    return true;
+}
+
+bool FitCheckpointFile::save(const QString& path, const FitCheckpoint& checkpoint, QString* error)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(toJson(checkpoint)).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool FitCheckpointFile::load(const QString& path, FitCheckpoint& checkpoint, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        if (error) *error = "检查点文件格式错误: " + parseError.errorString();
+        return false;
+    }
+    return fromJson(doc.object(), checkpoint, error);
+}
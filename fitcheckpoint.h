@@ -0,0 +1,28 @@
+#ifndef FITCHECKPOINT_H
+#define FITCHECKPOINT_H
+
+#include <QString>
+#include <QJsonObject>
+#include "fittingengine.h"
+
+/**
+ * @brief 拟合检查点文件读写
+ *
+ * 检查点以 JSON 保存（观测数据、参数表、优化器状态、后验采样的游走者与随机数状态），
+ * 先写临时文件再替换，写入中途崩溃不会损坏上一次的检查点。
+ * 非有限值（如采样器中的 -∞ 对数后验）以 null 保存。
+ */
+class FitCheckpointFile
+{
+public:
+    // 默认位置：<项目目录>/checkpoints/<分析名>.fitckpt
+    static QString defaultPath(const QString& projectDir, const QString& analysisName);
+
+    static bool save(const QString& path, const FitCheckpoint& checkpoint, QString* error = nullptr);
+    static bool load(const QString& path, FitCheckpoint& checkpoint, QString* error = nullptr);
+
+    static QJsonObject toJson(const FitCheckpoint& checkpoint);
+    static bool fromJson(const QJsonObject& root, FitCheckpoint& checkpoint, QString* error = nullptr);
+};
+
+#endif // FITCHECKPOINT_H
@@ -0,0 +1,208 @@
+#include "fitjobqueue.h"
+
+#include <QtConcurrent>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QSpinBox>
+#include <QLabel>
+#include <QPushButton>
+#include <QProgressBar>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QTimer>
+#include <QThread>
+
+// ===========================================================================
+// FitJobQueue 实现
+// ===========================================================================
+
+FitJobQueue::FitJobQueue(QObject *parent)
+    : QObject(parent), m_nextId(1)
+{
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+}
+
+FitJobQueue::~FitJobQueue()
+{
+    // 通知所有未结束的任务停止，并等待线程池清空
+    for (const FitJobInfo& job : m_jobs) {
+        if (job.engine && (job.status == FitJobStatus::Queued || job.status == FitJobStatus::Running))
+            job.engine->requestStop();
+    }
+    m_pool.waitForDone();
+}
+
+QFuture<void> FitJobQueue::submit(const QString& analysisName, const QString& modelName,
+                                  FittingEngine* engine, std::function<void()> task)
+{
+    FitJobInfo info;
+    info.id = m_nextId++;
+    info.analysisName = analysisName;
+    info.modelName = modelName;
+    info.status = FitJobStatus::Queued;
+    info.submitTime = QDateTime::currentDateTime();
+    info.engine = engine;
+    info.finalCost = FitCostStats{0, 0, 0};
+    info.finalProgress = 0;
+    info.claimed.reset(new std::atomic<bool>(false));
+    // 任务内部的并行子任务（Bootstrap、后验采样）也在本线程池中执行，共用同一线程预算
+    if (engine) engine->setThreadPool(&m_pool);
+    m_jobs.append(info);
+    emit jobsChanged();
+
+    int id = info.id;
+    QPointer<FittingEngine> enginePtr(engine);
+    QSharedPointer<std::atomic<bool>> claimed = info.claimed;
+    return QtConcurrent::run(&m_pool, [this, id, enginePtr, task, claimed]() {
+        // 排队期间已被取消：不执行任务，也不再访问引擎（其所有者可能已释放）
+        if (claimed->exchange(true)) return;
+        QMetaObject::invokeMethod(this, [this, id]() { setJobStatus(id, FitJobStatus::Running); }, Qt::QueuedConnection);
+        task();
+        bool stopped = enginePtr && enginePtr->isStopRequested();
+        QMetaObject::invokeMethod(this, [this, id, stopped]() {
+            setJobStatus(id, stopped ? FitJobStatus::Stopped : FitJobStatus::Finished);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void FitJobQueue::setJobStatus(int id, FitJobStatus status)
+{
+    for (FitJobInfo& job : m_jobs) {
+        if (job.id != id) continue;
+        job.status = status;
+        if ((status == FitJobStatus::Finished || status == FitJobStatus::Stopped) && job.engine) {
+            job.finalCost = job.engine->costStats();
+            job.finalProgress = job.engine->progress();
+        }
+        break;
+    }
+    emit jobsChanged();
+}
+
+bool FitJobQueue::cancelQueued(FittingEngine* engine)
+{
+    for (FitJobInfo& job : m_jobs) {
+        if (job.engine != engine || job.status != FitJobStatus::Queued) continue;
+        if (job.claimed->exchange(true)) return false;
+        job.status = FitJobStatus::Stopped;
+        job.finalCost = engine->costStats();
+        job.finalProgress = 0;
+        emit jobsChanged();
+        return true;
+    }
+    return false;
+}
+
+void FitJobQueue::setThreadBudget(int threads)
+{
+    m_pool.setMaxThreadCount(qMax(1, threads));
+}
+
+int FitJobQueue::threadBudget() const
+{
+    return m_pool.maxThreadCount();
+}
+
+void FitJobQueue::clearFinished()
+{
+    for (int i = m_jobs.size() - 1; i >= 0; --i) {
+        if (m_jobs[i].status == FitJobStatus::Finished || m_jobs[i].status == FitJobStatus::Stopped)
+            m_jobs.removeAt(i);
+    }
+    emit jobsChanged();
+}
+
+QString FitJobQueue::statusText(FitJobStatus status)
+{
+    switch (status) {
+    case FitJobStatus::Queued: return "排队中";
+    case FitJobStatus::Running: return "运行中";
+    case FitJobStatus::Finished: return "完成";
+    case FitJobStatus::Stopped: return "已停止";
+    }
+    return "";
+}
+
+// ===========================================================================
+// FitQueueDialog 实现
+// ===========================================================================
+
+FitQueueDialog::FitQueueDialog(FitJobQueue* queue, QWidget *parent)
+    : QDialog(parent), m_queue(queue)
+{
+    setWindowTitle("拟合任务队列");
+    resize(760, 360);
+    setStyleSheet(
+        "QDialog { background-color: #ffffff; color: #000000; font-family: 'Microsoft YaHei'; }"
+        "QLabel, QSpinBox, QTableWidget { color: #000000; }"
+        "QTableWidget { gridline-color: #d0d0d0; border: 1px solid #c0c0c0; }"
+        "QHeaderView::section { background-color: #f0f0f0; border: 1px solid #d0d0d0; color: #000000; }"
+        "QPushButton { background-color: #ffffff; border: 1px solid #c0c0c0; border-radius: 4px; padding: 5px 15px; color: #333333; }"
+        "QPushButton:hover { background-color: #f2f2f2; border-color: #a0a0a0; color: #000000; }"
+        );
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+
+    QHBoxLayout* top = new QHBoxLayout;
+    top->addWidget(new QLabel("并发拟合线程数:", this));
+    m_spinBudget = new QSpinBox(this);
+    m_spinBudget->setRange(1, qMax(1, QThread::idealThreadCount() * 2));
+    m_spinBudget->setValue(m_queue ? m_queue->threadBudget() : 1);
+    top->addWidget(m_spinBudget);
+    top->addStretch();
+    QPushButton* btnClear = new QPushButton("清除已结束", this);
+    top->addWidget(btnClear);
+    layout->addLayout(top);
+
+    m_table = new QTableWidget(this);
+    m_table->setColumnCount(7);
+    m_table->setHorizontalHeaderLabels({"分析", "模型", "状态", "进度", "模型计算次数", "计算点数", "耗时 (s)"});
+    m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_table->verticalHeader()->setVisible(false);
+    layout->addWidget(m_table);
+
+    connect(m_spinBudget, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int v) {
+        if (m_queue) m_queue->setThreadBudget(v);
+    });
+    connect(btnClear, &QPushButton::clicked, this, [this]() { if (m_queue) m_queue->clearFinished(); });
+    if (m_queue) connect(m_queue, &FitJobQueue::jobsChanged, this, &FitQueueDialog::refresh);
+
+    // 运行中任务的进度与成本通过定时轮询刷新
+    m_timer = new QTimer(this);
+    connect(m_timer, &QTimer::timeout, this, &FitQueueDialog::refresh);
+    m_timer->start(500);
+
+    refresh();
+}
+
+void FitQueueDialog::refresh()
+{
+    if (!m_queue) return;
+    QList<FitJobInfo> jobs = m_queue->jobs();
+    m_table->setRowCount(jobs.size());
+    for (int i = 0; i < jobs.size(); ++i) {
+        const FitJobInfo& job = jobs[i];
+        bool live = job.engine && (job.status == FitJobStatus::Running);
+        FitCostStats cost = live ? job.engine->costStats() : job.finalCost;
+        int progress = live ? job.engine->progress() : job.finalProgress;
+        if (job.status == FitJobStatus::Queued) progress = 0;
+
+        m_table->setItem(i, 0, new QTableWidgetItem(job.analysisName));
+        m_table->setItem(i, 1, new QTableWidgetItem(job.modelName));
+        m_table->setItem(i, 2, new QTableWidgetItem(FitJobQueue::statusText(job.status)));
+
+        QProgressBar* bar = qobject_cast<QProgressBar*>(m_table->cellWidget(i, 3));
+        if (!bar) {
+            bar = new QProgressBar(m_table);
+            bar->setRange(0, 100);
+            m_table->setCellWidget(i, 3, bar);
+        }
+        bar->setValue(progress);
+
+        m_table->setItem(i, 4, new QTableWidgetItem(QString::number(cost.modelEvaluations)));
+        m_table->setItem(i, 5, new QTableWidgetItem(QString::number(cost.modelPoints)));
+        m_table->setItem(i, 6, new QTableWidgetItem(QString::number(cost.elapsedMs / 1000.0, 'f', 1)));
+    }
+}
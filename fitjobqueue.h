@@ -0,0 +1,100 @@
+#ifndef FITJOBQUEUE_H
+#define FITJOBQUEUE_H
+
+#include <QObject>
+#include <QDialog>
+#include <QThreadPool>
+#include <QFuture>
+#include <QPointer>
+#include <QDateTime>
+#include <QSharedPointer>
+#include <atomic>
+#include <functional>
+#include "fittingengine.h"
+
+class QTableWidget;
+class QSpinBox;
+class QTimer;
+
+// 拟合任务状态
+enum class FitJobStatus {
+    Queued,     // 排队中
+    Running,    // 运行中
+    Finished,   // 完成
+    Stopped     // 已停止
+};
+
+// 队列中单个拟合任务的信息
+struct FitJobInfo {
+    int id;
+    QString analysisName;
+    QString modelName;
+    FitJobStatus status;
+    QDateTime submitTime;
+    QPointer<FittingEngine> engine;
+    FitCostStats finalCost;     // 任务结束时的成本快照
+    int finalProgress;
+    // 任务被工作线程领取或在排队中被取消时置位（先到者生效）
+    QSharedPointer<std::atomic<bool>> claimed;
+};
+
+/**
+ * @brief 拟合任务队列
+ *
+ * 所有分析页签的拟合任务共享同一个线程池，线程数即并发拟合的预算。
+ * 超出预算的任务排队等待；状态变化在主线程中更新并通过 jobsChanged() 通知界面。
+ */
+class FitJobQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FitJobQueue(QObject *parent = nullptr);
+    ~FitJobQueue();
+
+    // 提交任务，返回可用于 QFutureWatcher 的 future
+    QFuture<void> submit(const QString& analysisName, const QString& modelName,
+                         FittingEngine* engine, std::function<void()> task);
+
+    void setThreadBudget(int threads);
+    int threadBudget() const;
+
+    QList<FitJobInfo> jobs() const { return m_jobs; }
+    static QString statusText(FitJobStatus status);
+
+    // 取消仍在排队的任务（不会再执行）。返回 false 表示任务已开始或不存在
+    bool cancelQueued(FittingEngine* engine);
+
+    // 移除已结束的任务记录
+    void clearFinished();
+
+signals:
+    void jobsChanged();
+
+private:
+    void setJobStatus(int id, FitJobStatus status);
+
+    QThreadPool m_pool;
+    QList<FitJobInfo> m_jobs;
+    int m_nextId;
+};
+
+// 拟合队列视图：显示各任务状态、进度与计算成本
+class FitQueueDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit FitQueueDialog(FitJobQueue* queue, QWidget *parent = nullptr);
+
+private slots:
+    void refresh();
+
+private:
+    FitJobQueue* m_queue;
+    QTableWidget* m_table;
+    QSpinBox* m_spinBudget;
+    QTimer* m_timer;
+};
+
+#endif // FITJOBQUEUE_H
@@ -0,0 +1,1236 @@
+#include "fittingengine.h"
+
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <algorithm>
+#include <Eigen/Dense>
+#include <boost/math/distributions/students_t.hpp>
+
+namespace {
+// 列归一化雅可比矩阵的 最小/最大 奇异值 低于此值时冻结（约对应两列夹角余弦 > 0.9998）
+const double kFreezeRatio = 0.02;
+// 列范数低于最大列范数的此比例时，参数几乎不影响残差，直接冻结
+const double kMinSensitivity = 1e-6;
+// 冻结后每隔若干次迭代全部释放，重新计算所有列后再判断
+const int kReleaseInterval = 5;
+
+// 残差向量的只读视图（不复制）
+Eigen::Map<const Eigen::VectorXd> asVector(const QVector<double>& v)
+{
+    return Eigen::Map<const Eigen::VectorXd>(v.constData(), v.size());
+}
+
+// 检查点以行数组保存雅可比矩阵
+QVector<QVector<double>> toRows(const Eigen::MatrixXd& m)
+{
+    QVector<QVector<double>> rows((int)m.rows(), QVector<double>((int)m.cols()));
+    for(int k=0; k<m.rows(); ++k) for(int i=0; i<m.cols(); ++i) rows[k][i] = m(k, i);
+    return rows;
+}
+
+Eigen::MatrixXd fromRows(const QVector<QVector<double>>& rows)
+{
+    int cols = rows.isEmpty() ? 0 : rows.first().size();
+    Eigen::MatrixXd m(rows.size(), cols);
+    for(int k=0; k<rows.size(); ++k) for(int i=0; i<cols; ++i) m(k, i) = rows[k].value(i);
+    return m;
+}
+
+// 阻尼最小二乘 min ‖√W(r + Jδ)‖² + λ‖Dδ‖²，D² = 1 + diag(JᵀWJ)（Marquardt 缩放）。
+// 列缩放后的 √W·J·D⁻¹ 只做一次 SVD，不形成 JᵀJ（避免条件数平方）；
+// 同一次迭代中不同 λ 的试探步 δ = -D⁻¹·V·diag(σ/(σ²+λ))·Uᵀ√W·r 只需 O(p²) 运算
+class DampedLeastSquares
+{
+public:
+    DampedLeastSquares(const Eigen::MatrixXd& J, const Eigen::Ref<const Eigen::VectorXd>& r,
+                       const Eigen::VectorXd& rowWeights)
+    {
+        Eigen::VectorXd sw = rowWeights.cwiseSqrt();
+        Eigen::MatrixXd Jw = sw.asDiagonal() * J;
+        Eigen::VectorXd rw = sw.cwiseProduct(r);
+        m_gradient = Jw.transpose() * rw;
+        m_colScale = (Jw.colwise().squaredNorm().transpose().array() + 1.0).sqrt();
+        Jw = Jw * m_colScale.cwiseInverse().asDiagonal();
+        Eigen::JacobiSVD<Eigen::MatrixXd> svd(Jw, Eigen::ComputeThinU | Eigen::ComputeThinV);
+        m_sigma = svd.singularValues();
+        m_V = svd.matrixV();
+        m_Utr = svd.matrixU().transpose() * rw;
+    }
+
+    Eigen::VectorXd solve(double lambda) const
+    {
+        Eigen::VectorXd f(m_sigma.size());
+        for(int i=0; i<m_sigma.size(); ++i) {
+            double den = m_sigma(i) * m_sigma(i) + lambda;
+            f(i) = den > 0 ? m_sigma(i) / den : 0.0;
+        }
+        return -(m_V * f.cwiseProduct(m_Utr)).cwiseQuotient(m_colScale);
+    }
+
+    // 加权梯度 JᵀWr
+    const Eigen::VectorXd& gradient() const { return m_gradient; }
+
+private:
+    Eigen::VectorXd m_gradient;
+    Eigen::VectorXd m_colScale;
+    Eigen::VectorXd m_sigma;
+    Eigen::MatrixXd m_V;
+    Eigen::VectorXd m_Utr;
+};
+
+QVector<double> toQVector(const Eigen::VectorXd& v)
+{
+    return QVector<double>(v.data(), v.data() + v.size());
+}
+}
+
+FittingEngine::FittingEngine(QObject *parent)
+    : QObject(parent)
+    , m_modelManager(nullptr)
+    , m_threadPool(nullptr)
+    , m_progress(0)
+    , m_modelEvaluations(0)
+    , m_modelPoints(0)
+    , m_startMs(-1)
+    , m_endMs(-1)
+    , m_snapshotSequence(0)
+    , m_checkpointSequence(0)
+{
+    m_uncertainty.valid = false;
+    m_warm.valid = false;
+    m_bootstrapSamples = 0;
+    m_autoFreeze = true;
+    m_laplacePrefit = true;
+    m_archiveEnabled = false;
+    m_posterior.valid = false;
+    m_clock.start();
+}
+
+void FittingEngine::setObservedData(const QVector<double>& t, const QVector<double>& p, const QVector<double>& d)
+{
+    m_obsTime = t;
+    m_obsPressure = p;
+    m_obsDerivative = d;
+}
+
+FitCostStats FittingEngine::costStats() const
+{
+    FitCostStats s;
+    s.modelEvaluations = m_modelEvaluations;
+    s.modelPoints = m_modelPoints;
+    qint64 start = m_startMs, end = m_endMs;
+    if(start < 0) s.elapsedMs = 0;
+    else s.elapsedMs = (end >= 0 ? end : m_clock.elapsed()) - start;
+    return s;
+}
+
+FitSnapshotPtr FittingEngine::latestSnapshot() const
+{
+    QMutexLocker locker(&m_snapshotMutex);
+    return m_latestSnapshot;
+}
+
+void FittingEngine::publishSnapshot(int iteration, double error, bool finished, bool stopped,
+                                    const QMap<QString, double>& params, const ModelCurveData& curve)
+{
+    // 快照在锁外构造，锁内只替换指针；QVector 隐式共享，不复制曲线数据
+    QSharedPointer<FitIterationSnapshot> snap(new FitIterationSnapshot);
+    snap->iteration = iteration;
+    snap->error = error;
+    snap->finished = finished;
+    snap->stopped = stopped;
+    snap->params = params;
+    snap->t = std::get<0>(curve);
+    snap->p = std::get<1>(curve);
+    snap->d = std::get<2>(curve);
+    QMutexLocker locker(&m_snapshotMutex);
+    snap->sequence = ++m_snapshotSequence;
+    m_latestSnapshot = snap;
+}
+
+FitCheckpointPtr FittingEngine::latestCheckpoint() const
+{
+    QMutexLocker locker(&m_checkpointMutex);
+    return m_latestCheckpoint;
+}
+
+QSharedPointer<FitCheckpoint> FittingEngine::newCheckpoint(FitCheckpoint::Kind kind, ModelManager::ModelType modelType,
+                                                           const QList<FitParameter>& params, double weight) const
+{
+    QSharedPointer<FitCheckpoint> c(new FitCheckpoint);
+    c->kind = kind;
+    c->sequence = 0;
+    c->modelType = modelType;
+    c->weight = weight;
+    c->params = params;
+    c->obsTime = m_obsTime;
+    c->obsPressure = m_obsPressure;
+    c->obsDerivative = m_obsDerivative;
+    c->rateSchedule = m_rateSchedule;
+    c->loss = m_loss;
+    c->pointWeights = m_pointWeights;
+    c->autoFreeze = m_autoFreeze;
+    c->iteration = 0;
+    c->fidelityLevel = 0;
+    c->lambda = 0.0;
+    c->posteriorConfig = PosteriorSampler::defaultConfig();
+    c->posteriorProblem.sigma2 = 0.0;
+    c->samplerState.valid = false;
+    return c;
+}
+
+void FittingEngine::publishCheckpoint(const QSharedPointer<FitCheckpoint>& checkpoint)
+{
+    QMutexLocker locker(&m_checkpointMutex);
+    checkpoint->sequence = ++m_checkpointSequence;
+    m_latestCheckpoint = checkpoint;
+}
+
+void FittingEngine::clearCheckpoint()
+{
+    QMutexLocker locker(&m_checkpointMutex);
+    m_latestCheckpoint.reset();
+}
+
+void FittingEngine::resumeFromCheckpoint(const FitCheckpoint& checkpoint)
+{
+    setObservedData(checkpoint.obsTime, checkpoint.obsPressure, checkpoint.obsDerivative);
+    setRateSchedule(checkpoint.rateSchedule);
+    setLoss(checkpoint.loss);
+    setPointWeights(checkpoint.pointWeights);
+    setAutoFreeze(checkpoint.autoFreeze);
+    if(checkpoint.kind == FitCheckpoint::LevenbergMarquardt) {
+        fitLevenbergMarquardt(checkpoint.modelType, checkpoint.params, checkpoint.weight, &checkpoint);
+        return;
+    }
+    m_posterior = PosteriorResult();
+    m_posterior.valid = false;
+    m_modelEvaluations = 0; m_modelPoints = 0; m_progress = 0;
+    m_startMs = m_clock.elapsed(); m_endMs = -1;
+    clearCheckpoint();
+    if(!m_modelManager || isStopRequested()) { m_endMs = m_clock.elapsed(); return; }
+    samplePosterior(checkpoint.modelType, checkpoint.params, checkpoint.weight, checkpoint.posteriorProblem,
+                    checkpoint.posteriorConfig, &checkpoint.samplerState);
+}
+
+ModelCurveData FittingEngine::evaluateModel(ModelManager::ModelType modelType, const QMap<QString, double>& params, const QVector<double>& providedTime)
+{
+    if(!m_rateSchedule.isEmpty() && !providedTime.isEmpty()) {
+        auto evaluator = [this, modelType, &params](const QVector<double>& tau) {
+            ++m_modelEvaluations;
+            m_modelPoints += tau.size();
+            return m_modelManager->calculateTheoreticalCurve(modelType, params, tau, &m_cancel);
+        };
+        QSharedPointer<const SuperpositionPlan> plan = superpositionPlan(providedTime);
+        return ModelSuperposition::evaluate(evaluator, params.value("q", 5.0), *plan);
+    }
+    ++m_modelEvaluations;
+    m_modelPoints += providedTime.isEmpty() ? 100 : providedTime.size();
+    return m_modelManager->calculateTheoreticalCurve(modelType, params, providedTime, &m_cancel);
+}
+
+void FittingEngine::setRateSchedule(const RateSchedule& schedule)
+{
+    m_rateSchedule = schedule;
+    QMutexLocker locker(&m_planMutex);
+    m_superpositionPlan.reset();
+}
+
+QSharedPointer<const SuperpositionPlan> FittingEngine::superpositionPlan(const QVector<double>& time)
+{
+    // ln(t_i − T_j) 与网格位置只取决于观测时刻、产量历史与网格密度，模型参数变化时不必重算；
+    // 同一份观测数据的 QVector 共享存储，比较为 O(1)
+    QMutexLocker locker(&m_planMutex);
+    const SuperpositionPlan* plan = m_superpositionPlan.data();
+    if(!plan || plan->pointsPerDecade != m_gridConfig.pointsPerDecade || plan->time != time)
+        m_superpositionPlan.reset(new SuperpositionPlan(ModelSuperposition::plan(m_rateSchedule, time, m_gridConfig.pointsPerDecade)));
+    return m_superpositionPlan;
+}
+
+QVector<FitFidelityLevel> FittingEngine::fidelitySchedule() {
+    // 低精度起步，步长/梯度收敛后逐级提高；最后一级与最终理论曲线的计算精度一致
+    QVector<FitFidelityLevel> levels;
+    levels.append({4, 1e-3, 8, 0.05, 1e-3});
+    levels.append({6, 1e-4, 12, 0.01, 1e-4});
+    levels.append({8, 1e-5, 16, 1e-5, 0.0});
+    return levels;
+}
+
+void FittingEngine::runLevenbergMarquardt(ModelManager::ModelType modelType, QList<FitParameter> params, double weight) {
+    fitLevenbergMarquardt(modelType, params, weight, nullptr);
+}
+
+void FittingEngine::fitLevenbergMarquardt(ModelManager::ModelType modelType, QList<FitParameter> params, double weight,
+                                          const FitCheckpoint* resume) {
+    clearCheckpoint();
+    m_warm.valid = false;
+    resetResults();
+    m_posterior = PosteriorResult();
+    m_posterior.valid = false;
+    m_evalArchive.clear();
+    m_archiveEnabled = false;
+    m_modelEvaluations = 0; m_modelPoints = 0; m_progress = 0;
+    m_startMs = m_clock.elapsed(); m_endMs = -1;
+    if(!m_modelManager || isStopRequested()) { m_endMs = m_clock.elapsed(); return; }
+    QVector<int> fitIndices;
+    for(int i=0; i<params.size(); ++i) if(params[i].isFit) fitIndices.append(i);
+    int nParams = fitIndices.size();
+    if(nParams == 0) { m_endMs = m_clock.elapsed(); return; }
+    m_archiveNames.clear(); m_archiveIsLog.clear();
+    for(int idx : fitIndices) {
+        m_archiveNames.append(params[idx].name);
+        m_archiveIsLog.append(params[idx].value > 1e-12 && params[idx].name != "S" && params[idx].name != "nf");
+    }
+    double lambda = 0.01; int maxIter = 50; double currentSSE = 1e15;
+    QMap<QString, double> currentParamMap;
+    for(const auto& p : params) currentParamMap.insert(p.name, p.value);
+    int firstIter = 0;
+    if(resume) {
+        // 从检查点继续：参数、阻尼系数、迭代序号与迭代记录取自检查点
+        for(const QString& key : resume->values.keys()) currentParamMap[key] = resume->values.value(key);
+        lambda = resume->lambda;
+        firstIter = resume->iteration;
+        QMutexLocker locker(&m_snapshotMutex);
+        m_iterationLog = resume->iterationLog;
+    }
+    if(currentParamMap.contains("L") && currentParamMap.contains("Lf") && currentParamMap["L"] > 1e-9)
+        currentParamMap["LfD"] = currentParamMap["Lf"] / currentParamMap["L"];
+
+    const QVector<FitFidelityLevel> schedule = fidelitySchedule();
+    const int finalLevel = schedule.size() - 1;
+    int level = 0;
+    QVector<double> residuals;
+    ModelCurveData currentCurve;
+    // 最近一次计算的雅可比矩阵，拟合结束后用于不确定性分析
+    Eigen::MatrixXd lastJ;
+    int lastJLevel = -1;
+    // 不可辨识参数的临时冻结：被冻结的列不重新差分、不参与步长求解，参数保持不变。
+    // fullJ 保存全部拟合参数的列（冻结列为冻结前的值），切换精度、定期以及收敛前全部释放
+    QVector<bool> frozen(nParams, false);
+    int freezeIter = -1;
+    bool finalRelease = false;
+    Eigen::MatrixXd fullJ;
+    auto releaseAll = [&]() { frozen.fill(false); freezeIter = -1; };
+    // 切换精度等级：精度参数随参数表传入模型，网格与目标函数同时更新。
+    // 计算中途被停止时返回 false，当前状态保持为上一次完整计算的结果
+    auto applyFidelity = [&](int lv) -> bool {
+        currentParamMap["N"] = schedule[lv].stehfestN;
+        currentParamMap["quadEps"] = schedule[lv].quadEps;
+        m_gridConfig.pointsPerDecade = schedule[lv].pointsPerDecade;
+        m_gridConfig.maxPointsPerDecade = 2 * schedule[lv].pointsPerDecade;
+        buildModelTimeGrid(currentParamMap, modelType);
+        // 只记录最高精度下的计算（网格变化后旧记录与新残差不可比）
+        m_evalArchive.clear();
+        m_archiveEnabled = (lv == finalLevel);
+        ModelCurveData curve;
+        QVector<double> res = calculateResiduals(currentParamMap, modelType, weight, &curve);
+        if(isStopRequested()) return false;
+        level = lv; residuals = res; currentCurve = curve;
+        currentSSE = calculateObjective(residuals);
+        return true;
+    };
+    int startLevel = resume ? qBound(0, resume->fidelityLevel, finalLevel) : 0;
+    QMap<QString, double> initialParamMap = currentParamMap;
+    bool prefitted = !resume && m_laplacePrefit && m_rateSchedule.isEmpty() && laplacePrefit(modelType, params, fitIndices, weight, currentParamMap);
+    if(isStopRequested()) { m_endMs = m_clock.elapsed(); return; }
+    if(!applyFidelity(startLevel)) { m_modelTimeGrid.clear(); m_endMs = m_clock.elapsed(); return; }
+    if(prefitted) {
+        // 拉普拉斯域的最优点受数据外推与压敏修正的影响，时间域目标函数反而变差时退回初值
+        initialParamMap["N"] = currentParamMap["N"];
+        initialParamMap["quadEps"] = currentParamMap["quadEps"];
+        ModelCurveData curve;
+        QVector<double> res = calculateResiduals(initialParamMap, modelType, weight, &curve);
+        if(isStopRequested()) { m_modelTimeGrid.clear(); m_endMs = m_clock.elapsed(); return; }
+        double sse = calculateObjective(res);
+        if(sse < currentSSE) { currentParamMap = initialParamMap; residuals = res; currentCurve = curve; currentSSE = sse; }
+    }
+    publishSnapshot(-1, currentSSE/qMax(1, residuals.size()), false, false, currentParamMap, currentCurve);
+    for(int iter = firstIter; iter < maxIter; ++iter) {
+        if(isStopRequested()) break;
+        setProgress(iter * 100 / maxIter);
+        int nRes = residuals.size();
+        if(freezeIter >= 0 && iter - freezeIter >= kReleaseInterval) releaseAll();
+        if(fullJ.rows() != nRes) releaseAll();
+        QVector<int> active;
+        for(int i=0; i<nParams; ++i) if(!frozen[i]) active.append(i);
+        // 检查点中的雅可比矩阵就是在当前参数处计算的，恢复后的第一次迭代直接使用
+        bool reuseJ = resume && iter == firstIter && resume->jacobian.size() == nRes
+                      && nRes > 0 && resume->jacobian.first().size() == nParams;
+        if(reuseJ) {
+            fullJ = fromRows(resume->jacobian);
+        } else if(active.size() == nParams) {
+            fullJ = computeJacobian(currentParamMap, residuals, fitIndices, modelType, params, weight);
+        } else {
+            QVector<int> activeIndices;
+            for(int c : active) activeIndices.append(fitIndices[c]);
+            Eigen::MatrixXd Ja = computeJacobian(currentParamMap, residuals, activeIndices, modelType, params, weight);
+            for(int c=0; c<active.size(); ++c) fullJ.col(active[c]) = Ja.col(c);
+        }
+        if(isStopRequested()) break;
+        lastJ = fullJ; lastJLevel = level;
+        // 只在全部列都是新计算的时候做可辨识性分析
+        if(m_autoFreeze && active.size() == nParams && nParams > 1) {
+            QVector<int> toFreeze = unidentifiableColumns(fullJ, active);
+            if(!toFreeze.isEmpty() && toFreeze.size() < nParams) {
+                for(int c : toFreeze) frozen[c] = true;
+                freezeIter = iter;
+                active.clear();
+                for(int i=0; i<nParams; ++i) if(!frozen[i]) active.append(i);
+            }
+        }
+        QStringList frozenNames;
+        for(int i=0; i<nParams; ++i) if(frozen[i]) frozenNames.append(params[fitIndices[i]].name);
+        const int nA = active.size();
+        {
+            QSharedPointer<FitCheckpoint> ckpt = newCheckpoint(FitCheckpoint::LevenbergMarquardt, modelType, params, weight);
+            ckpt->iteration = iter;
+            ckpt->fidelityLevel = level;
+            ckpt->lambda = lambda;
+            ckpt->values = currentParamMap;
+            ckpt->jacobian = toRows(fullJ);
+            ckpt->iterationLog = m_iterationLog;
+            publishCheckpoint(ckpt);
+        }
+        // 阻尼最小二乘只含未冻结的列；分解在本次迭代的各个 λ 试探步间复用
+        Eigen::MatrixXd Ja(nRes, nA);
+        for(int c=0; c<nA; ++c) Ja.col(c) = fullJ.col(active[c]);
+        DampedLeastSquares dls(Ja, asVector(residuals), robustWeights(residuals));
+        double gradNorm = nA > 0 ? dls.gradient().cwiseAbs().maxCoeff() / qMax(1, nRes) : 0.0;
+        bool stepAccepted = false; double stepNorm = 0.0;
+        for(int tryIter=0; tryIter<5; ++tryIter) {
+            Eigen::VectorXd deltaActive = dls.solve(lambda);
+            QVector<double> delta(nParams, 0.0);
+            for(int i=0; i<nA; ++i) delta[active[i]] = deltaActive(i);
+            QMap<QString, double> trialMap = stepParameters(currentParamMap, delta, fitIndices, params);
+            ModelCurveData trialCurve;
+            QVector<double> newRes = calculateResiduals(trialMap, modelType, weight, &trialCurve);
+            // 被取消的试探步结果不完整，不参与比较
+            if(isStopRequested()) break;
+            double newSSE = calculateObjective(newRes);
+            if(newSSE < currentSSE) {
+                for(int i=0; i<nParams; ++i) stepNorm = qMax(stepNorm, std::abs(delta[i]));
+                currentSSE = newSSE; currentParamMap = trialMap; residuals = newRes; currentCurve = trialCurve; lambda /= 10.0; stepAccepted = true;
+                // 直接复用残差计算得到的模型曲线，不再额外计算一次理论曲线
+                publishSnapshot(iter, currentSSE/nRes, false, false, currentParamMap, currentCurve);
+                break;
+            } else { lambda *= 10.0; }
+        }
+        if(isStopRequested()) break;
+        appendIterationRecord({iter, level, schedule[level].stehfestN, currentSSE, lambda, frozenNames});
+
+        // 当前精度下已收敛（步长/梯度足够小，或已无法下降）时提高精度；
+        // 最后若干次迭代保留给最高精度，保证报告结果与最终曲线一致
+        if(level < finalLevel) {
+            bool levelConverged = stepAccepted ? (stepNorm < schedule[level].stepTol || gradNorm < schedule[level].gradTol)
+                                               : (lambda > 1e6);
+            bool reserveFinal = (iter >= maxIter - 10);
+            if(levelConverged || reserveFinal) {
+                if(!applyFidelity(reserveFinal ? finalLevel : level + 1)) break;
+                lambda = qMax(lambda, 1e-3);
+                if(lambda > 1e6) lambda = 0.01;
+                releaseAll();
+                continue;
+            }
+        } else {
+            bool converged = (!stepAccepted && lambda > 1e10) || (stepAccepted && stepNorm < schedule[level].stepTol);
+            if(converged && freezeIter >= 0 && !finalRelease && iter + 1 < maxIter) {
+                // 收敛前释放冻结参数再迭代，确认它们在最优点附近仍不可辨识
+                finalRelease = true;
+                releaseAll();
+                if(lambda > 1e6) lambda = 1e-3;
+                continue;
+            }
+            if(converged) break;
+        }
+        // 定期校验网格插值精度，网格重建后目标函数随之更新
+        if(stepAccepted && (iter + 1) % 5 == 0 && !validateModelTimeGrid(currentParamMap, modelType)) {
+            ModelCurveData curve;
+            QVector<double> res = calculateResiduals(currentParamMap, modelType, weight, &curve);
+            if(isStopRequested()) break;
+            residuals = res; currentCurve = curve;
+            currentSSE = calculateObjective(residuals);
+        }
+    }
+    // 提前收敛时在最高精度下重新评估目标函数；用户停止时直接返回最后一次接受的结果
+    bool stopped = isStopRequested();
+    if(!stopped && level < finalLevel) stopped = !applyFidelity(finalLevel);
+    m_archiveEnabled = false;
+    // 结束时仍被冻结的列是旧值，不确定性分析前在最终参数处重新计算
+    if(!stopped && freezeIter >= 0 && lastJ.rows() == residuals.size()) {
+        QVector<int> frozenCols, frozenIndices;
+        for(int i=0; i<nParams; ++i) if(frozen[i]) { frozenCols.append(i); frozenIndices.append(fitIndices[i]); }
+        Eigen::MatrixXd Jf = computeJacobian(currentParamMap, residuals, frozenIndices, modelType, params, weight);
+        stopped = isStopRequested();
+        if(!stopped) for(int c=0; c<frozenCols.size(); ++c) lastJ.col(frozenCols[c]) = Jf.col(c);
+    }
+    if(!stopped && lastJ.rows() == residuals.size())
+        saveWarmState(modelType, weight, fitIndices, params, currentParamMap, currentCurve, lastJ, lambda);
+    m_modelTimeGrid.clear();
+    if(currentParamMap.contains("L") && currentParamMap.contains("Lf") && currentParamMap["L"] > 1e-9)
+        currentParamMap["LfD"] = currentParamMap["Lf"] / currentParamMap["L"];
+
+    // 线性化不确定性直接使用最后一次迭代的雅可比矩阵，不增加模型计算
+    if(!stopped && lastJ.rows() == residuals.size()) {
+        FitUncertainty u = computeUncertainty(lastJ, residuals, fitIndices, params, currentParamMap);
+        u.jacobianFidelity = lastJLevel;
+        publishUncertainty(u);
+        if(m_bootstrapSamples > 0 && u.valid) {
+            setProgress(90);
+            runBootstrap(modelType, params, currentParamMap, residuals, weight);
+        }
+    }
+    publishSnapshot(iterationCount(), currentSSE/qMax(1, residuals.size()), true, stopped, currentParamMap, currentCurve);
+    m_endMs = m_clock.elapsed();
+    setProgress(100);
+}
+
+bool FittingEngine::laplacePrefit(ModelManager::ModelType modelType, const QList<FitParameter>& params,
+                                  const QVector<int>& fitIndices, double weight, QMap<QString, double>& values) {
+    double tMin = 0.0, tMax = 0.0;
+    for(double t : m_obsTime) {
+        if(t <= 0) continue;
+        if(tMin <= 0 || t < tMin) tMin = t;
+        tMax = qMax(tMax, t);
+    }
+    QVector<double> s = LaplaceDataTransform::sampleVariables(tMin, tMax);
+    LaplaceSampledData data = LaplaceDataTransform::transform(m_obsTime, m_obsPressure, m_obsDerivative, s);
+    if(data.s.size() < 4) return false;
+
+    // 预拟合只用于给出起点，裂缝积分取最低精度
+    QMap<QString, double> current = values;
+    current["quadEps"] = fidelitySchedule().first().quadEps;
+    QVector<double> residuals = laplaceResiduals(data, current, modelType, weight);
+    if(isStopRequested() || residuals.isEmpty()) return false;
+    const double startSSE = calculateObjective(residuals);
+    double sse = startSSE;
+    double lambda = 0.01;
+    const int maxIter = 30;
+    int nP = fitIndices.size(); int nRes = residuals.size();
+    for(int iter=0; iter<maxIter; ++iter) {
+        // 中心差分雅可比矩阵，步长与时间域一致
+        Eigen::MatrixXd J = Eigen::MatrixXd::Zero(nRes, nP);
+        for(int j=0; j<nP; ++j) {
+            QVector<double> delta(nP, 0.0);
+            QString pName = params[fitIndices[j]].name; double val = current.value(pName);
+            double h = (val > 1e-12 && pName != "S" && pName != "nf") ? 0.01 : 1e-4;
+            delta[j] = h;
+            QVector<double> rPlus = laplaceResiduals(data, stepParameters(current, delta, fitIndices, params), modelType, weight);
+            delta[j] = -h;
+            QVector<double> rMinus = laplaceResiduals(data, stepParameters(current, delta, fitIndices, params), modelType, weight);
+            if(isStopRequested()) return false;
+            if(rPlus.size() == nRes && rMinus.size() == nRes)
+                J.col(j) = (asVector(rPlus) - asVector(rMinus)) / (2.0 * h);
+        }
+        DampedLeastSquares dls(J, asVector(residuals), robustWeights(residuals));
+        bool stepAccepted = false; double stepNorm = 0.0;
+        for(int tryIter=0; tryIter<5; ++tryIter) {
+            QVector<double> delta = toQVector(dls.solve(lambda));
+            QMap<QString, double> trialMap = stepParameters(current, delta, fitIndices, params);
+            QVector<double> newRes = laplaceResiduals(data, trialMap, modelType, weight);
+            if(isStopRequested()) return false;
+            double newSSE = calculateObjective(newRes);
+            if(newRes.size() == nRes && newSSE < sse) {
+                for(int i=0; i<nP; ++i) stepNorm = qMax(stepNorm, std::abs(delta[i]));
+                sse = newSSE; current = trialMap; residuals = newRes; lambda /= 10.0; stepAccepted = true;
+                break;
+            } else { lambda *= 10.0; }
+        }
+        appendIterationRecord({iter, -1, 0, sse, lambda, QStringList()});
+        if((!stepAccepted && lambda > 1e8) || (stepAccepted && stepNorm < 1e-3)) break;
+    }
+    if(!(sse < startSSE)) return false;
+    for(int idx : fitIndices) values[params[idx].name] = current.value(params[idx].name);
+    if(values.contains("L") && values.contains("Lf") && values["L"] > 1e-9) values["LfD"] = values["Lf"] / values["L"];
+    return true;
+}
+
+QVector<double> FittingEngine::laplaceResiduals(const LaplaceSampledData& data, const QMap<QString, double>& params,
+                                                ModelManager::ModelType modelType, double weight) {
+    ++m_modelEvaluations;
+    m_modelPoints += data.s.size();
+    QVector<double> model = m_modelManager->calculateLaplaceTransform(modelType, params, data.s, &m_cancel);
+    if(model.size() != data.s.size()) return QVector<double>();
+    QVector<double> modelD = LaplaceDataTransform::logDerivative(data.s, model);
+    // 与时间域相同的对数残差与压力/导数权重；外推部分占比大的点（s 两端）降权
+    QVector<double> r; double wp = weight; double wd = 1.0 - weight;
+    int n = data.s.size();
+    for(int i=0; i<n; ++i) {
+        double w = 1.0 - data.extrapolated[i];
+        if(data.value[i] > 1e-30 && model[i] > 1e-30) r.append((log(data.value[i]) - log(model[i])) * wp * w); else r.append(0.0);
+    }
+    for(int i=0; i<n; ++i) {
+        double w = 1.0 - data.extrapolated[i];
+        if(data.derivative[i] > 1e-10 && modelD[i] > 1e-10) r.append((log(data.derivative[i]) - log(modelD[i])) * wd * w); else r.append(0.0);
+    }
+    return r;
+}
+
+void FittingEngine::saveWarmState(ModelManager::ModelType modelType, double weight, const QVector<int>& fitIndices,
+                                  const QList<FitParameter>& params, const QMap<QString, double>& values,
+                                  const ModelCurveData& curve, const Eigen::MatrixXd& J, double lambda) {
+    m_warm.valid = true;
+    m_warm.modelType = modelType;
+    m_warm.weight = weight;
+    m_warm.fitNames.clear();
+    for(int idx : fitIndices) m_warm.fitNames.append(params[idx].name);
+    m_warm.params = values;
+    m_warm.onGrid = !m_modelTimeGrid.isEmpty();
+    m_warm.modelCurve = curve;
+    m_warm.jacobian = J;
+    m_warm.obsCount = m_obsTime.size();
+    m_warm.lambda = lambda;
+}
+
+void FittingEngine::runIncrementalUpdate(ModelManager::ModelType modelType, QList<FitParameter> params, double weight, int maxIter) {
+    QVector<int> fitIndices;
+    for(int i=0; i<params.size(); ++i) if(params[i].isFit) fitIndices.append(i);
+    int nParams = fitIndices.size();
+
+    // 热启动条件：模型、权重、拟合参数和固定参数都未改变，观测数据只在末尾追加
+    bool canWarm = m_warm.valid && m_modelManager && m_warm.modelType == modelType
+                   && std::abs(m_warm.weight - weight) < 1e-12 && nParams > 0
+                   && nParams == m_warm.fitNames.size() && m_obsTime.size() > m_warm.obsCount;
+    QMap<QString, double> currentParamMap = m_warm.params;
+    if(canWarm) {
+        for(int i=0; i<nParams; ++i) if(params[fitIndices[i]].name != m_warm.fitNames[i]) canWarm = false;
+        for(const auto& p : params) {
+            if(p.isFit) continue;
+            if(!currentParamMap.contains(p.name) || std::abs(currentParamMap[p.name] - p.value) > 1e-12 * qMax(1.0, std::abs(p.value)))
+                canWarm = false;
+        }
+    }
+    if(!canWarm) { runLevenbergMarquardt(modelType, params, weight); return; }
+
+    resetResults();
+    m_posterior = PosteriorResult();
+    m_posterior.valid = false;
+    // 残差长度已改变，旧的计算记录不能再作为代理模型训练数据
+    m_evalArchive.clear();
+    m_archiveEnabled = false;
+    m_modelEvaluations = 0; m_modelPoints = 0; m_progress = 0;
+    m_startMs = m_clock.elapsed(); m_endMs = -1;
+    if(isStopRequested()) { m_endMs = m_clock.elapsed(); return; }
+
+    const QVector<FitFidelityLevel> schedule = fidelitySchedule();
+    const int finalLevel = schedule.size() - 1;
+    const FitFidelityLevel& top = schedule[finalLevel];
+    const int nOld = m_warm.obsCount, nNew = m_obsTime.size();
+    const QVector<double>& oldT = std::get<0>(m_warm.modelCurve);
+    double tOldMax = oldT.isEmpty() ? 0.0 : oldT.last();
+    double tNewMax = 0.0;
+    for(int i=nOld; i<nNew; ++i) tNewMax = qMax(tNewMax, m_obsTime[i]);
+
+    // 1. 新增时段的模型计算时刻：网格模式按最高精度密度向后延伸网格，否则为新的观测时刻。
+    //    再向前带上约 0.3 个对数周期的旧时刻，使新旧曲线衔接处的导数不受端点影响
+    QVector<double> extTimes;
+    if(m_warm.onGrid) {
+        if(tNewMax > tOldMax) {
+            QVector<double> g = ModelCurveInterpolator::buildLogGrid(tOldMax, tNewMax, top.pointsPerDecade);
+            for(int i=1; i<g.size(); ++i) extTimes.append(g[i]);
+        }
+    } else {
+        for(int i=nOld; i<nNew; ++i) extTimes.append(m_obsTime[i]);
+    }
+    const double overlapDecades = 0.3;
+    int overlapStart = oldT.size();
+    while(overlapStart > 0 && oldT[overlapStart - 1] >= tOldMax * pow(10.0, -overlapDecades)) --overlapStart;
+    QVector<double> evalTimes = oldT.mid(overlapStart);
+    evalTimes.append(extTimes);
+    const double replaceFrom = tOldMax * pow(10.0, -overlapDecades / 2);
+    // 新增时段的计算结果接到缓存曲线之后；重叠区后半段（旧曲线受端点影响的部分）一并替换
+    auto splice = [&](const ModelCurveData& ext) {
+        QVector<double> t = oldT, p = std::get<1>(m_warm.modelCurve), d = std::get<2>(m_warm.modelCurve);
+        const QVector<double>& et = std::get<0>(ext);
+        const QVector<double>& ep = std::get<1>(ext);
+        const QVector<double>& ed = std::get<2>(ext);
+        for(int k=0; k<et.size(); ++k) {
+            int idx = overlapStart + k;
+            if(idx < t.size()) { if(et[k] >= replaceFrom) { p[idx] = ep[k]; d[idx] = ed[k]; } }
+            else { t.append(et[k]); p.append(ep[k]); d.append(ed[k]); }
+        }
+        return ModelCurveData(t, p, d);
+    };
+
+    currentParamMap["N"] = top.stehfestN;
+    currentParamMap["quadEps"] = top.quadEps;
+    ModelCurveData baseExt = evaluateModel(modelType, currentParamMap, evalTimes);
+    if(isStopRequested()) { m_endMs = m_clock.elapsed(); return; }
+    ModelCurveData currentCurve = splice(baseExt);
+    if(m_warm.onGrid) m_modelTimeGrid = std::get<0>(currentCurve);
+    else m_modelTimeGrid.clear();
+    QVector<double> residuals = residualsFromCurve(
+        m_warm.onGrid ? ModelCurveInterpolator::interpolateCurve(currentCurve, m_obsTime) : currentCurve, weight);
+    double currentSSE = calculateObjective(residuals);
+    int nRes = residuals.size();
+    publishSnapshot(-1, currentSSE/qMax(1, nRes), false, false, currentParamMap, currentCurve);
+
+    // 2. 雅可比矩阵：旧观测点的行直接复用（最优点未变），新观测点的行只在新增时段上做差分
+    int count = qMin(m_obsPressure.size(), nNew);
+    const Eigen::MatrixXd& oldJ = m_warm.jacobian;
+    int dOld = oldJ.rows() - nOld;
+    Eigen::MatrixXd J = Eigen::MatrixXd::Zero(nRes, nParams);
+    QVector<int> newRows;
+    for(int k=0; k<nRes; ++k) {
+        int oldRow = -1;
+        if(k < count) { if(k < nOld) oldRow = k; }
+        else if(k - count < dOld) oldRow = nOld + (k - count);
+        if(oldRow >= 0 && oldRow < oldJ.rows() && oldJ.cols() == nParams) J.row(k) = oldJ.row(oldRow);
+        else newRows.append(k);
+    }
+    QVector<double> newTimes;
+    bool inExtension = true;
+    for(int k : newRows) {
+        double t = m_obsTime[k < count ? k : k - count];
+        if(evalTimes.isEmpty() || t < evalTimes.first()) inExtension = false;
+        newTimes.append(t);
+    }
+    if(!inExtension) {
+        // 新增行落在已计算时段之外（导数列补齐等），整体重新计算
+        J = computeJacobian(currentParamMap, residuals, fitIndices, modelType, params, weight);
+    } else if(!newRows.isEmpty()) {
+        auto logResidual = [](double obs, double model, double w) {
+            return (obs > 1e-10 && model > 1e-10) ? (log(obs) - log(model)) * w : 0.0;
+        };
+        for(int j=0; j<nParams; ++j) {
+            if(isStopRequested()) break;
+            QString pName = params[fitIndices[j]].name;
+            double val = currentParamMap.value(pName);
+            bool isLog = (val > 1e-12 && pName != "S" && pName != "nf");
+            double h = isLog ? 0.01 : 1e-4;
+            QMap<QString, double> pPlus = currentParamMap, pMinus = currentParamMap;
+            if(isLog) { pPlus[pName] = pow(10.0, log10(val) + h); pMinus[pName] = pow(10.0, log10(val) - h); }
+            else { pPlus[pName] = val + h; pMinus[pName] = val - h; }
+            for(QMap<QString, double>* m : {&pPlus, &pMinus})
+                if(m->contains("L") && m->contains("Lf") && (*m)["L"] > 1e-9) (*m)["LfD"] = (*m)["Lf"] / (*m)["L"];
+            ModelCurveData cPlus = ModelCurveInterpolator::interpolateCurve(evaluateModel(modelType, pPlus, evalTimes), newTimes);
+            ModelCurveData cMinus = ModelCurveInterpolator::interpolateCurve(evaluateModel(modelType, pMinus, evalTimes), newTimes);
+            for(int r=0; r<newRows.size(); ++r) {
+                int k = newRows[r];
+                bool isPressure = k < count;
+                int i = isPressure ? k : k - count;
+                double obs = isPressure ? m_obsPressure[i] : m_obsDerivative[i];
+                double w = (isPressure ? weight : 1.0 - weight) * pointWeightFactor(i);
+                const QVector<double>& yPlus = isPressure ? std::get<1>(cPlus) : std::get<2>(cPlus);
+                const QVector<double>& yMinus = isPressure ? std::get<1>(cMinus) : std::get<2>(cMinus);
+                J(k, j) = (logResidual(obs, yPlus[r], w) - logResidual(obs, yMinus[r], w)) / (2.0 * h);
+            }
+        }
+    }
+
+    // 3. 少量 LM 迭代；接受步长后用 Broyden 秩一修正更新雅可比矩阵，不再做差分
+    double lambda = qMax(m_warm.lambda, 1e-3);
+    for(int iter = 0; iter < maxIter; ++iter) {
+        if(isStopRequested()) break;
+        setProgress(iter * 90 / maxIter);
+        DampedLeastSquares dls(J, asVector(residuals), robustWeights(residuals));
+        bool stepAccepted = false; double stepNorm = 0.0;
+        for(int tryIter=0; tryIter<5; ++tryIter) {
+            QVector<double> delta = toQVector(dls.solve(lambda));
+            QMap<QString, double> trialMap = stepParameters(currentParamMap, delta, fitIndices, params);
+            ModelCurveData trialCurve;
+            QVector<double> newRes = calculateResiduals(trialMap, modelType, weight, &trialCurve);
+            if(isStopRequested()) break;
+            double newSSE = calculateObjective(newRes);
+            if(newSSE < currentSSE && newRes.size() == nRes) {
+                // 实际步长（已裁剪到参数范围）
+                Eigen::VectorXd dx(nParams);
+                for(int i=0; i<nParams; ++i) {
+                    QString pName = params[fitIndices[i]].name;
+                    double oldVal = currentParamMap[pName], newVal = trialMap[pName];
+                    bool isLog = (oldVal > 1e-12 && pName != "S" && pName != "nf");
+                    dx(i) = isLog ? log10(newVal) - log10(oldVal) : newVal - oldVal;
+                    stepNorm = qMax(stepNorm, std::abs(dx(i)));
+                }
+                double dxx = dx.squaredNorm();
+                if(dxx > 0) J += ((asVector(newRes) - asVector(residuals)) - J * dx) * dx.transpose() / dxx;
+                currentSSE = newSSE; currentParamMap = trialMap; residuals = newRes; currentCurve = trialCurve; lambda /= 10.0; stepAccepted = true;
+                publishSnapshot(iter, currentSSE/nRes, false, false, currentParamMap, currentCurve);
+                break;
+            } else { lambda *= 10.0; }
+        }
+        if(isStopRequested()) break;
+        appendIterationRecord({iter, finalLevel, top.stehfestN, currentSSE, lambda, QStringList()});
+        if(!stepAccepted || stepNorm < top.stepTol) break;
+    }
+
+    bool stopped = isStopRequested();
+    if(!stopped) {
+        FitUncertainty u = computeUncertainty(J, residuals, fitIndices, params, currentParamMap);
+        u.jacobianFidelity = finalLevel;
+        publishUncertainty(u);
+        saveWarmState(modelType, weight, fitIndices, params, currentParamMap, currentCurve, J, lambda);
+    }
+    m_modelTimeGrid.clear();
+    publishSnapshot(iterationCount(), currentSSE/qMax(1, nRes), true, stopped, currentParamMap, currentCurve);
+    m_endMs = m_clock.elapsed();
+    setProgress(100);
+}
+
+QMap<QString, double> FittingEngine::stepParameters(const QMap<QString, double>& current, const QVector<double>& delta,
+                                                    const QVector<int>& fitIndices, const QList<FitParameter>& params) const {
+    QMap<QString, double> trialMap = current;
+    for(int i=0; i<fitIndices.size(); ++i) {
+        int pIdx = fitIndices[i]; QString pName = params[pIdx].name; double oldVal = current.value(pName);
+        bool isLog = (oldVal > 1e-12 && pName != "S" && pName != "nf");
+        double newVal; if(isLog) { double logVal = log10(oldVal) + delta[i]; newVal = pow(10.0, logVal); } else { newVal = oldVal + delta[i]; }
+        newVal = qMax(params[pIdx].min, qMin(newVal, params[pIdx].max));
+        trialMap[pName] = newVal;
+    }
+    if(trialMap.contains("L") && trialMap.contains("Lf") && trialMap["L"] > 1e-9) trialMap["LfD"] = trialMap["Lf"] / trialMap["L"];
+    return trialMap;
+}
+
+FitUncertainty FittingEngine::computeUncertainty(const Eigen::MatrixXd& J, const QVector<double>& residuals,
+                                                 const QVector<int>& fitIndices, const QList<FitParameter>& params,
+                                                 const QMap<QString, double>& values)
+{
+    FitUncertainty u;
+    u.valid = false; u.dof = 0; u.sigma2 = 0.0; u.tQuantile = 0.0; u.conditionNumber = 0.0;
+    u.jacobianFidelity = -1; u.bootstrapSamples = 0;
+    u.robustWeighted = (m_loss.type != FitLoss::LeastSquares);
+    int nRes = residuals.size(); int nP = fitIndices.size();
+    for(int i=0; i<nP; ++i) {
+        QString name = params[fitIndices[i]].name; double v = values.value(name);
+        u.names.append(name); u.values.append(v);
+        u.isLog.append(v > 1e-12 && name != "S" && name != "nf");
+    }
+    if(nP == 0 || J.rows() != nRes || J.cols() != nP || nRes <= nP) return u;
+
+    // 稳健损失时以最终的 IRLS 权重为条件：J 与残差按 √w 加权。
+    // 权重为零或整行不含信息（无效点、逐点权重为零）的残差不计入自由度，否则 σ² 与区间偏小
+    Eigen::VectorXd w = robustWeights(residuals);
+    Eigen::MatrixXd Jw = J;
+    double sse = 0.0;
+    int nEff = 0;
+    for(int k=0; k<nRes; ++k) {
+        Jw.row(k) *= std::sqrt(w(k));
+        if(w(k) > 0 && (residuals[k] != 0.0 || J.row(k).squaredNorm() > 0)) {
+            ++nEff;
+            sse += w(k) * residuals[k] * residuals[k];
+        }
+    }
+    if(nEff <= nP) return u;
+
+    // 参数与 LM 迭代相同的变换空间（对数参数取 log10），J 即残差对变换参数的导数
+    Eigen::JacobiSVD<Eigen::MatrixXd> svd(Jw, Eigen::ComputeThinV);
+    Eigen::VectorXd sv = svd.singularValues();
+    Eigen::MatrixXd V = svd.matrixV();
+    double smax = sv(0), smin = sv(nP - 1);
+    if(smax <= 0) return u;
+    u.conditionNumber = smin > 0 ? smax / smin : std::numeric_limits<double>::infinity();
+    for(int k=0; k<nP; ++k) u.singularValues.append(sv(k));
+
+    u.dof = nEff - nP;
+    u.sigma2 = sse / u.dof;
+    boost::math::students_t dist(u.dof);
+    u.tQuantile = boost::math::quantile(boost::math::complement(dist, 0.025));
+
+    // 协方差 C = σ² V Σ⁻² Vᵀ；奇异值过小的方向数据无法约束，相关参数的误差视为无穷大
+    double tol = smax * 1e-8;
+    Eigen::VectorXd inv2(nP);
+    QVector<bool> unresolved(nP, false);
+    for(int k=0; k<nP; ++k) {
+        if(sv(k) > tol) { inv2(k) = 1.0 / (sv(k) * sv(k)); continue; }
+        inv2(k) = 0.0;
+        for(int i=0; i<nP; ++i) if(std::abs(V(i, k)) > 0.1) unresolved[i] = true;
+    }
+    Eigen::MatrixXd C = u.sigma2 * V * inv2.asDiagonal() * V.transpose();
+
+    const double inf = std::numeric_limits<double>::infinity();
+    u.covariance.resize(nP); u.correlation.resize(nP);
+    for(int i=0; i<nP; ++i) {
+        u.covariance[i].resize(nP); u.correlation[i].resize(nP);
+        for(int j=0; j<nP; ++j) {
+            u.covariance[i][j] = C(i, j);
+            double den = std::sqrt(std::max(0.0, C(i, i)) * std::max(0.0, C(j, j)));
+            u.correlation[i][j] = (i == j) ? 1.0 : (den > 0 ? C(i, j) / den : 0.0);
+        }
+    }
+    for(int i=0; i<nP; ++i) {
+        double se = unresolved[i] ? inf : std::sqrt(std::max(0.0, C(i, i)));
+        double half = u.tQuantile * se; double v = u.values[i];
+        u.stdErrors.append(se);
+        if(u.isLog[i]) { u.ciLower.append(v * std::pow(10.0, -half)); u.ciUpper.append(v * std::pow(10.0, half)); }
+        else { u.ciLower.append(v - half); u.ciUpper.append(v + half); }
+        // 可辨识：区间有限且足够窄（对数参数半宽小于半个数量级），且与其他参数不强相关
+        double maxCorr = 0.0;
+        for(int j=0; j<nP; ++j) if(j != i) maxCorr = qMax(maxCorr, std::abs(u.correlation[i][j]));
+        u.identifiable.append(std::isfinite(half) && half < (u.isLog[i] ? 0.5 : 1.0) && maxCorr < 0.95);
+    }
+    u.valid = true;
+    return u;
+}
+
+QVector<FitIterationRecord> FittingEngine::iterationLog() const
+{
+    QMutexLocker locker(&m_snapshotMutex);
+    return m_iterationLog;
+}
+
+FitUncertainty FittingEngine::uncertainty() const
+{
+    QMutexLocker locker(&m_snapshotMutex);
+    return m_uncertainty;
+}
+
+void FittingEngine::appendIterationRecord(const FitIterationRecord& record)
+{
+    QMutexLocker locker(&m_snapshotMutex);
+    m_iterationLog.append(record);
+}
+
+void FittingEngine::publishUncertainty(const FitUncertainty& uncertainty)
+{
+    QMutexLocker locker(&m_snapshotMutex);
+    m_uncertainty = uncertainty;
+}
+
+// 新一次拟合开始：清除上次的快照、迭代记录与不确定性
+void FittingEngine::resetResults()
+{
+    QMutexLocker locker(&m_snapshotMutex);
+    m_latestSnapshot.reset();
+    m_iterationLog.clear();
+    m_uncertainty = FitUncertainty();
+    m_uncertainty.valid = false;
+}
+
+int FittingEngine::iterationCount() const
+{
+    QMutexLocker locker(&m_snapshotMutex);
+    int count = 0;
+    for(const auto& rec : m_iterationLog) if(rec.fidelityLevel >= 0) ++count;
+    return count;
+}
+
+QThreadPool* FittingEngine::workerPool() const
+{
+    return m_threadPool ? m_threadPool : QThreadPool::globalInstance();
+}
+
+void FittingEngine::runBootstrap(ModelManager::ModelType modelType, const QList<FitParameter>& params,
+                                 const QMap<QString, double>& bestValues, const QVector<double>& residuals, double weight)
+{
+    // 残差布局与 calculateResiduals 一致：先压力段，后导数段
+    int count = qMin(m_obsPressure.size(), m_obsTime.size());
+    int dCount = qMin(m_obsDerivative.size(), count);
+    if(residuals.size() != count + dCount) return;
+    QVector<int> validP, validD;
+    for(int i=0; i<count; ++i) if(m_obsPressure[i] > 1e-10 && residuals[i] != 0.0 && pointWeightFactor(i) > 0) validP.append(i);
+    for(int i=0; i<dCount; ++i) if(m_obsDerivative[i] > 1e-10 && residuals[count + i] != 0.0 && pointWeightFactor(i) > 0) validD.append(i);
+    double wp = weight, wd = 1.0 - weight;
+
+    QList<FitParameter> startParams = params;
+    for(auto& p : startParams) p.value = bestValues.value(p.name, p.value);
+
+    const QVector<double> obsT = m_obsTime, obsP = m_obsPressure, obsD = m_obsDerivative;
+    std::atomic<int> done(0);
+    int total = m_bootstrapSamples;
+    // 单个样本：将残差随机重排后叠加到最优拟合曲线上得到合成数据，从最优参数出发重新拟合。
+    // 合成数据由残差反推（p* = p_obs·exp((r_k - r_i)/w)），不需要额外计算模型曲线
+    auto refit = [&](int seed) -> QMap<QString, double> {
+        QMap<QString, double> result;
+        if(isStopRequested()) return result;
+        std::mt19937 rng(seed);
+        QVector<double> p = obsP, d = obsD;
+        // 逐点权重先从残差中除去，重排的是原始对数残差
+        auto raw = [&](int row, int i, double w) { return residuals[row] / (w * pointWeightFactor(i)); };
+        if(wp > 1e-12 && !validP.isEmpty()) {
+            std::uniform_int_distribution<int> pick(0, validP.size() - 1);
+            for(int i : validP) { int k = validP[pick(rng)]; p[i] = obsP[i] * std::exp(raw(k, k, wp) - raw(i, i, wp)); }
+        }
+        if(wd > 1e-12 && !validD.isEmpty()) {
+            std::uniform_int_distribution<int> pick(0, validD.size() - 1);
+            for(int i : validD) { int k = validD[pick(rng)]; d[i] = obsD[i] * std::exp(raw(count + k, k, wd) - raw(count + i, i, wd)); }
+        }
+        FittingEngine child;
+        child.setModelManager(m_modelManager);
+        child.setThreadPool(m_threadPool);
+        child.setObservedData(obsT, p, d);
+        child.setRateSchedule(m_rateSchedule);
+        child.setLoss(m_loss);
+        child.setPointWeights(m_pointWeights);
+        child.setAutoFreeze(m_autoFreeze);
+        // 从最优参数出发，不需要预拟合
+        child.setLaplacePrefit(false);
+        child.m_cancel.setParent(&m_cancel);
+        child.runLevenbergMarquardt(modelType, startParams, weight);
+        FitCostStats cost = child.costStats();
+        m_modelEvaluations += cost.modelEvaluations;
+        m_modelPoints += cost.modelPoints;
+        FitSnapshotPtr snap = child.latestSnapshot();
+        if(snap && !snap->stopped) result = snap->params;
+        setProgress(90 + 10 * (++done) / qMax(1, total));
+        return result;
+    };
+    QList<int> seeds;
+    for(int b=0; b<total; ++b) seeds.append(b + 1);
+    // 在调用方的线程池中并行：并发拟合的总线程数不超过任务队列（或批量拟合）的预算
+    QList<QMap<QString, double>> fits = QtConcurrent::blockingMapped<QList<QMap<QString, double>>>(workerPool(), seeds, refit);
+    if(isStopRequested()) return;
+
+    // 变换参数空间中的 2.5%/97.5% 分位数，算完后整体发布
+    FitUncertainty u = m_uncertainty;
+    int valid = 0;
+    for(const auto& f : fits) if(!f.isEmpty()) ++valid;
+    if(valid < 10) return;
+    for(int i=0; i<u.names.size(); ++i) {
+        QVector<double> xs;
+        for(const auto& f : fits) {
+            if(f.isEmpty()) continue;
+            double v = f.value(u.names[i]);
+            if(u.isLog[i]) { if(v > 1e-300) xs.append(std::log10(v)); } else xs.append(v);
+        }
+        if(xs.isEmpty()) { u.bootLower.append(u.ciLower[i]); u.bootUpper.append(u.ciUpper[i]); continue; }
+        std::sort(xs.begin(), xs.end());
+        double lo = xs[(int)std::floor(0.025 * (xs.size() - 1))];
+        double hi = xs[(int)std::ceil(0.975 * (xs.size() - 1))];
+        u.bootLower.append(u.isLog[i] ? std::pow(10.0, lo) : lo);
+        u.bootUpper.append(u.isLog[i] ? std::pow(10.0, hi) : hi);
+    }
+    u.bootstrapSamples = valid;
+    publishUncertainty(u);
+}
+
+void FittingEngine::buildModelTimeGrid(const QMap<QString, double>& params, ModelManager::ModelType modelType) {
+    m_modelTimeGrid.clear();
+    if(!m_modelManager || m_obsTime.isEmpty() || !m_rateSchedule.isEmpty()) return;
+    auto evaluator = [this, &params, modelType](const QVector<double>& t) {
+        return evaluateModel(modelType, params, t);
+    };
+    m_modelTimeGrid = ModelCurveInterpolator::buildAdaptiveGrid(m_obsTime, evaluator, m_gridConfig);
+}
+
+bool FittingEngine::validateModelTimeGrid(const QMap<QString, double>& params, ModelManager::ModelType modelType) {
+    if(m_modelTimeGrid.isEmpty()) return true;
+    auto evaluator = [this, &params, modelType](const QVector<double>& t) {
+        return evaluateModel(modelType, params, t);
+    };
+    ModelCurveData gridCurve = evaluator(m_modelTimeGrid);
+    double err = ModelCurveInterpolator::checkGridError(m_obsTime, gridCurve, evaluator, m_gridConfig.checkPoints);
+    if(err <= m_gridConfig.checkTol) return true;
+    // 参数移动后曲线特征位置改变，按当前参数重建网格
+    buildModelTimeGrid(params, modelType);
+    return false;
+}
+
+QVector<double> FittingEngine::calculateResiduals(const QMap<QString, double>& params, ModelManager::ModelType modelType, double weight,
+                                                  ModelCurveData* outCurve) {
+    if(!m_modelManager || m_obsTime.isEmpty()) return QVector<double>();
+    ModelCurveData res;
+    if(!m_modelTimeGrid.isEmpty()) {
+        ModelCurveData gridCurve = evaluateModel(modelType, params, m_modelTimeGrid);
+        res = ModelCurveInterpolator::interpolateCurve(gridCurve, m_obsTime);
+        // 网格点数远少于观测点数，绘图使用网格曲线即可
+        if(outCurve) *outCurve = gridCurve;
+    } else {
+        res = evaluateModel(modelType, params, m_obsTime);
+        if(outCurve) *outCurve = res;
+    }
+    QVector<double> r = residualsFromCurve(res, weight);
+    if(m_archiveEnabled && !isStopRequested()) archiveEvaluation(params, r);
+    return r;
+}
+
+QVector<double> FittingEngine::residualsFromCurve(const ModelCurveData& curve, double weight) const {
+    const QVector<double>& pCal = std::get<1>(curve); const QVector<double>& dpCal = std::get<2>(curve);
+    QVector<double> r; double wp = weight; double wd = 1.0 - weight;
+    int count = qMin(m_obsPressure.size(), pCal.size());
+    for(int i=0; i<count; ++i) {
+        if(m_obsPressure[i] > 1e-10 && pCal[i] > 1e-10) r.append( (log(m_obsPressure[i]) - log(pCal[i])) * wp * pointWeightFactor(i) ); else r.append(0.0);
+    }
+    int dCount = qMin(m_obsDerivative.size(), dpCal.size()); dCount = qMin(dCount, count);
+    for(int i=0; i<dCount; ++i) {
+        if(m_obsDerivative[i] > 1e-10 && dpCal[i] > 1e-10) r.append( (log(m_obsDerivative[i]) - log(dpCal[i])) * wd * pointWeightFactor(i) ); else r.append(0.0);
+    }
+    return r;
+}
+
+double FittingEngine::pointWeightFactor(int i) const {
+    if(i < 0 || i >= m_pointWeights.size()) return 1.0;
+    return std::sqrt(qMax(0.0, m_pointWeights[i]));
+}
+
+void FittingEngine::archiveEvaluation(const QMap<QString, double>& params, const QVector<double>& residuals) {
+    SurrogateSample s;
+    for(int i=0; i<m_archiveNames.size(); ++i) {
+        double v = params.value(m_archiveNames[i]);
+        if(m_archiveIsLog[i] && v <= 0) return;
+        s.x.append(m_archiveIsLog[i] ? log10(v) : v);
+    }
+    s.residuals = residuals;
+    // 残差向量可能很长，只保留最近的计算
+    const int maxArchive = 150;
+    if(m_evalArchive.size() >= maxArchive) m_evalArchive.removeFirst();
+    m_evalArchive.append(s);
+}
+
+void FittingEngine::runPosteriorSampling(ModelManager::ModelType modelType, QList<FitParameter> params, double weight,
+                                         const PosteriorConfig& config) {
+    m_posterior = PosteriorResult();
+    m_posterior.valid = false;
+    m_modelEvaluations = 0; m_modelPoints = 0; m_progress = 0;
+    m_startMs = m_clock.elapsed(); m_endMs = -1;
+    clearCheckpoint();
+    const FitUncertainty& u = m_uncertainty;
+    if(!m_modelManager || isStopRequested() || !u.valid || u.names != m_archiveNames) { m_endMs = m_clock.elapsed(); return; }
+
+    // 采样问题：变换参数空间，尺度取线性化标准误差，先验为参数上下限
+    PosteriorProblem problem;
+    problem.names = u.names;
+    problem.isLog = m_archiveIsLog;
+    problem.sigma2 = u.sigma2;
+    problem.archive = m_evalArchive;
+    for(int i=0; i<u.names.size(); ++i) {
+        bool isLog = m_archiveIsLog[i];
+        double v = u.values[i];
+        double x = isLog ? log10(v) : v;
+        double se = u.stdErrors[i];
+        if(!std::isfinite(se) || se <= 0) se = isLog ? 0.3 : qMax(0.1, 0.1 * std::abs(v));
+        problem.best.append(x);
+        problem.scale.append(qMax(se, 1e-4));
+        double lo = -1e300, hi = 1e300;
+        for(const auto& p : params) {
+            if(p.name != u.names[i]) continue;
+            lo = isLog ? (p.min > 0 ? log10(p.min) : x - 6.0) : p.min;
+            hi = isLog ? (p.max > 0 ? log10(p.max) : x + 6.0) : p.max;
+        }
+        problem.lower.append(lo); problem.upper.append(hi);
+    }
+
+    samplePosterior(modelType, params, weight, problem, config, nullptr);
+}
+
+void FittingEngine::samplePosterior(ModelManager::ModelType modelType, const QList<FitParameter>& params, double weight,
+                                    const PosteriorProblem& problem, const PosteriorConfig& config,
+                                    const PosteriorSamplerState* resume) {
+    QMap<QString, double> baseMap;
+    for(const auto& p : params) baseMap.insert(p.name, p.value);
+    for(int i=0; i<problem.names.size(); ++i)
+        baseMap[problem.names[i]] = problem.isLog[i] ? pow(10.0, problem.best[i]) : problem.best[i];
+
+    // 真实模型在最高精度与其网格下计算，与拟合结束时的目标函数一致
+    const FitFidelityLevel top = fidelitySchedule().last();
+    baseMap["N"] = top.stehfestN;
+    baseMap["quadEps"] = top.quadEps;
+    if(baseMap.contains("L") && baseMap.contains("Lf") && baseMap["L"] > 1e-9) baseMap["LfD"] = baseMap["Lf"] / baseMap["L"];
+    m_gridConfig.pointsPerDecade = top.pointsPerDecade;
+    m_gridConfig.maxPointsPerDecade = 2 * top.pointsPerDecade;
+    buildModelTimeGrid(baseMap, modelType);
+
+    auto trueResiduals = [&](const QVector<double>& x) {
+        QMap<QString, double> map = baseMap;
+        for(int i=0; i<x.size(); ++i) map[problem.names[i]] = problem.isLog[i] ? pow(10.0, x[i]) : x[i];
+        if(map.contains("L") && map.contains("Lf") && map["L"] > 1e-9) map["LfD"] = map["Lf"] / map["L"];
+        return calculateResiduals(map, modelType, weight);
+    };
+    // 检查点不保存拟合阶段的计算记录，采样器的训练点池已包含用到的部分
+    PosteriorProblem stored = problem;
+    stored.archive.clear();
+    auto checkpoint = [&](const PosteriorSamplerState& state) {
+        QSharedPointer<FitCheckpoint> ckpt = newCheckpoint(FitCheckpoint::PosteriorSampling, modelType, params, weight);
+        ckpt->posteriorConfig = config;
+        ckpt->posteriorProblem = stored;
+        ckpt->samplerState = state;
+        publishCheckpoint(ckpt);
+    };
+    PosteriorSampler sampler(config);
+    sampler.setThreadPool(workerPool());
+    m_posterior = sampler.run(problem, trueResiduals, &m_cancel, [this](int percent) { setProgress(percent); },
+                              checkpoint, resume);
+    m_modelTimeGrid.clear();
+    m_endMs = m_clock.elapsed();
+    setProgress(100);
+}
+
+Eigen::MatrixXd FittingEngine::computeJacobian(const QMap<QString, double>& params, const QVector<double>& baseResiduals, const QVector<int>& fitIndices, ModelManager::ModelType modelType, const QList<FitParameter>& currentFitParams, double weight) {
+    int nRes = baseResiduals.size(); int nParams = fitIndices.size();
+    // 列主序连续存储，每一列（一个参数的差分）整体写入
+    Eigen::MatrixXd J = Eigen::MatrixXd::Zero(nRes, nParams);
+    for(int j = 0; j < nParams; ++j) {
+        if(isStopRequested()) break;
+        int idx = fitIndices[j]; QString pName = currentFitParams[idx].name;
+        double val = params.value(pName); bool isLog = (val > 1e-12 && pName != "S" && pName != "nf");
+        double h; QMap<QString, double> pPlus = params; QMap<QString, double> pMinus = params;
+        if(isLog) { h = 0.01; double valLog = log10(val); pPlus[pName] = pow(10.0, valLog + h); pMinus[pName] = pow(10.0, valLog - h); }
+        else { h = 1e-4; pPlus[pName] = val + h; pMinus[pName] = val - h; }
+        auto updateDeps = [](QMap<QString,double>& map) { if(map.contains("L") && map.contains("Lf") && map["L"] > 1e-9) map["LfD"] = map["Lf"] / map["L"]; };
+        if(pName == "L" || pName == "Lf") { updateDeps(pPlus); updateDeps(pMinus); }
+        QVector<double> rPlus = calculateResiduals(pPlus, modelType, weight);
+        QVector<double> rMinus = calculateResiduals(pMinus, modelType, weight);
+        if(rPlus.size() == nRes && rMinus.size() == nRes)
+            J.col(j) = (asVector(rPlus) - asVector(rMinus)) / (2.0 * h);
+    }
+    return J;
+}
+
+QVector<int> FittingEngine::unidentifiableColumns(const Eigen::MatrixXd& J, const QVector<int>& columns) const
+{
+    // 列归一化后做 SVD：最小奇异值过小说明存在几个参数相互抵消的方向（如 ω 与 λ），
+    // 冻结该方向上分量最大的参数后重新分析，直到剩余参数的条件数可以接受
+    QVector<int> active = columns, frozen;
+    int nRes = J.rows();
+    if(nRes == 0) return frozen;
+    while(active.size() > 1) {
+        int n = active.size();
+        QVector<double> norms(n, 0.0);
+        double maxNorm = 0.0;
+        int weakest = 0;
+        for(int c=0; c<n; ++c) {
+            norms[c] = J.col(active[c]).norm();
+            maxNorm = qMax(maxNorm, norms[c]);
+            if(norms[c] < norms[weakest]) weakest = c;
+        }
+        if(maxNorm <= 0) break;
+        if(norms[weakest] < kMinSensitivity * maxNorm) {
+            frozen.append(active[weakest]);
+            active.remove(weakest);
+            continue;
+        }
+        Eigen::MatrixXd Js(nRes, n);
+        for(int c=0; c<n; ++c) Js.col(c) = J.col(active[c]) / norms[c];
+        Eigen::JacobiSVD<Eigen::MatrixXd> svd(Js, Eigen::ComputeThinV);
+        Eigen::VectorXd sv = svd.singularValues();
+        if(sv(n - 1) >= kFreezeRatio * sv(0)) break;
+        Eigen::VectorXd v = svd.matrixV().col(n - 1);
+        int worst = 0;
+        for(int c=1; c<n; ++c) if(std::abs(v(c)) > std::abs(v(worst))) worst = c;
+        frozen.append(active[worst]);
+        active.remove(worst);
+    }
+    return frozen;
+}
+
+double FittingEngine::calculateSumSquaredError(const QVector<double>& residuals) {
+    double sse = 0.0; for(double v : residuals) sse += v*v; return sse;
+}
+
+double FittingEngine::calculateObjective(const QVector<double>& residuals) const {
+    // ρ(s), s = r²：Huber 在 |r| > c 后为 2c|r| - c²，Cauchy 为 c²·ln(1 + r²/c²)
+    const double c = qMax(1e-12, m_loss.scale), c2 = c * c;
+    double f = 0.0;
+    for(double v : residuals) {
+        double s = v * v;
+        switch(m_loss.type) {
+        case FitLoss::Huber: f += (s <= c2) ? s : 2.0 * c * std::sqrt(s) - c2; break;
+        case FitLoss::Cauchy: f += c2 * std::log1p(s / c2); break;
+        default: f += s; break;
+        }
+    }
+    return f;
+}
+
+Eigen::VectorXd FittingEngine::robustWeights(const QVector<double>& residuals) const {
+    const double c = qMax(1e-12, m_loss.scale), c2 = c * c;
+    Eigen::VectorXd w = Eigen::VectorXd::Ones(residuals.size());
+    if(m_loss.type == FitLoss::LeastSquares) return w;
+    for(int k=0; k<residuals.size(); ++k) {
+        double a = std::abs(residuals[k]);
+        if(m_loss.type == FitLoss::Huber) w(k) = (a <= c) ? 1.0 : c / a;
+        else w(k) = 1.0 / (1.0 + a * a / c2);
+    }
+    return w;
+}
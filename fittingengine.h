@@ -0,0 +1,350 @@
+#ifndef FITTINGENGINE_H
+#define FITTINGENGINE_H
+
+#include <QObject>
+#include <QMap>
+#include <QVector>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QSharedPointer>
+#include <atomic>
+#include <Eigen/Dense>
+#include "cancellationtoken.h"
+#include "modelmanager.h"
+#include "modelcurveinterpolator.h"
+#include "modelsuperposition.h"
+#include "posteriorsampler.h"
+#include "laplacetransform.h"
+
+class QThreadPool;
+
+struct FitParameter {
+    QString name;
+    QString displayName;
+    QString symbol;
+    QString unit;
+    double value;
+    bool isFit;
+    double min;
+    double max;
+};
+
+// 多精度拟合的精度等级
+struct FitFidelityLevel {
+    int stehfestN;          // Stehfest 反演阶数
+    double quadEps;         // 裂缝积分容差
+    int pointsPerDecade;    // 模型时间网格密度
+    double stepTol;         // 步长收敛阈值（对数参数空间）
+    double gradTol;         // 梯度收敛阈值
+};
+
+// 稳健损失函数：残差绝对值超过 scale 后 Huber 按线性、Cauchy 按对数增长，降低离群点的影响
+struct FitLoss {
+    enum Type { LeastSquares, Huber, Cauchy };
+    Type type;
+    double scale;       // 加权对数残差的尺度（0.1 约对应 10% 的误差）
+
+    FitLoss() :
+        type(LeastSquares),
+        scale(0.1) {}
+};
+
+// 单次迭代记录
+struct FitIterationRecord {
+    int iteration;
+    int fidelityLevel;      // -1 为拉普拉斯域预拟合
+    int stehfestN;
+    double sse;             // 目标函数（最小二乘时为残差平方和）
+    double lambda;
+    QStringList frozen;     // 本次迭代因不可辨识而临时冻结的参数
+};
+
+// 单次拟合的计算成本统计
+struct FitCostStats {
+    int modelEvaluations;   // 理论曲线计算次数
+    qint64 modelPoints;     // 累计计算的时间点数
+    qint64 elapsedMs;       // 已用时间 (ms)
+};
+
+// 参数不确定性分析结果（由最终雅可比矩阵计算；可选残差重采样 Bootstrap）
+// 对数参数的标准误差以 log10 为单位，线性参数 (S, nf) 以参数本身单位
+struct FitUncertainty {
+    bool valid;
+    int dof;                                // 自由度 = 有效残差个数（权重非零）- 拟合参数个数
+    double sigma2;                          // 残差方差估计 SSE / dof（稳健损失时为加权 SSE）
+    bool robustWeighted;                    // 区间以稳健损失最终的 IRLS 权重为条件
+    double tQuantile;                       // t 分布 97.5% 分位数
+    double conditionNumber;                 // J 的条件数 (最大/最小奇异值)
+    int jacobianFidelity;                   // 所用雅可比矩阵对应的精度等级
+    QStringList names;
+    QVector<double> values;
+    QVector<bool> isLog;
+    QVector<double> stdErrors;
+    QVector<double> ciLower;                // 95% 置信区间（物理单位）
+    QVector<double> ciUpper;
+    QVector<bool> identifiable;
+    QVector<QVector<double>> covariance;    // 变换参数空间中的协方差
+    QVector<QVector<double>> correlation;
+    QVector<double> singularValues;
+    int bootstrapSamples;                   // 有效 Bootstrap 样本数（0 表示未进行）
+    QVector<double> bootLower;              // Bootstrap 2.5%/97.5% 分位数
+    QVector<double> bootUpper;
+};
+
+// 迭代快照：发布后不再修改，界面线程与工作线程共享同一份数据
+struct FitIterationSnapshot {
+    quint64 sequence;               // 发布序号，单调递增
+    int iteration;                  // 迭代次数（-1 表示初始值）
+    double error;                   // 目标函数 (MSE)
+    bool finished;                  // 是否为拟合结束时的最终结果
+    bool stopped;                   // 拟合被停止（参数为停止前最后一次接受的结果）
+    QMap<QString, double> params;
+    QVector<double> t;              // 模型曲线（取自残差计算时的网格曲线）
+    QVector<double> p;
+    QVector<double> d;
+};
+typedef QSharedPointer<const FitIterationSnapshot> FitSnapshotPtr;
+
+// 热启动状态：最近一次拟合（或增量更新）结束时的最优点、雅可比矩阵和模型曲线
+struct FitWarmState {
+    bool valid;
+    ModelManager::ModelType modelType;
+    double weight;
+    QStringList fitNames;                   // 拟合参数，与雅可比矩阵的列对应
+    QMap<QString, double> params;           // 最优参数（含最高精度设置）
+    bool onGrid;                            // 模型在时间网格上计算（否则直接在观测时刻计算）
+    ModelCurveData modelCurve;              // 最优参数下的理论曲线（网格或观测时刻）
+    Eigen::MatrixXd jacobian;               // 最优点处的雅可比矩阵，行布局与残差一致
+    int obsCount;                           // 对应的观测点数
+    double lambda;
+};
+
+// 拟合检查点：从中断处继续所需的全部状态。包含观测数据与参数表，可在另一台机器上恢复
+struct FitCheckpoint {
+    enum Kind { LevenbergMarquardt, PosteriorSampling };
+    Kind kind;
+    quint64 sequence;                       // 发布序号，单调递增
+    ModelManager::ModelType modelType;
+    double weight;
+    QList<FitParameter> params;             // 参数表（初值、范围与拟合勾选）
+    QVector<double> obsTime;
+    QVector<double> obsPressure;
+    QVector<double> obsDerivative;
+
+    // 目标函数设置：恢复时取自检查点，不取当前界面
+    RateSchedule rateSchedule;
+    FitLoss loss;
+    QVector<double> pointWeights;
+    bool autoFreeze;
+
+    // Levenberg-Marquardt：下一次迭代开始时的状态
+    int iteration;
+    int fidelityLevel;
+    double lambda;
+    QMap<QString, double> values;           // 当前参数（含精度设置）
+    QVector<QVector<double>> jacobian;      // 在 values 处计算的雅可比矩阵
+    QVector<FitIterationRecord> iterationLog;
+
+    // 后验采样
+    PosteriorConfig posteriorConfig;
+    PosteriorProblem posteriorProblem;      // 不含 archive（训练点保存在 samplerState.pool）
+    PosteriorSamplerState samplerState;
+};
+typedef QSharedPointer<const FitCheckpoint> FitCheckpointPtr;
+
+/**
+ * @brief 拟合计算引擎
+ *
+ * 每个拟合任务独立持有一个引擎实例（观测数据、模型时间网格、迭代记录、停止标志和成本统计），
+ * 模型精度设置通过参数表传入 ModelWidget，因此不同页签的拟合可以在线程池中同时运行。
+ * runLevenbergMarquardt() 为阻塞调用，应在工作线程中执行。迭代结果以只读快照形式写入
+ * “最新值”槽位，界面按自身刷新频率读取，中间未被读取的快照直接丢弃。
+ * 检查点同样按“最新值”方式发布：LM 每次迭代算完雅可比矩阵后、后验采样每隔若干步，
+ * 由界面定时写入项目目录，resumeFromCheckpoint() 从中断处继续。
+ */
+class FittingEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FittingEngine(QObject *parent = nullptr);
+
+    void setModelManager(ModelManager* m) { m_modelManager = m; }
+    void setObservedData(const QVector<double>& t, const QVector<double>& p, const QVector<double>& d);
+
+    // 执行 Levenberg-Marquardt 拟合（阻塞）
+    void runLevenbergMarquardt(ModelManager::ModelType modelType, QList<FitParameter> params, double weight);
+
+    // 观测数据追加后的增量拟合（阻塞）：从上次最优点出发，复用其雅可比矩阵与模型曲线，
+    // 只对新增时段计算模型，少量 LM 迭代（雅可比矩阵用 Broyden 秩一修正）后更新参数与置信区间。
+    // 没有可用的热启动状态（模型、权重、拟合参数或固定参数已改变）时退回完整拟合
+    void runIncrementalUpdate(ModelManager::ModelType modelType, QList<FitParameter> params, double weight,
+                              int maxIter = 5);
+    bool hasWarmStart() const { return m_warm.valid; }
+    void clearWarmStart() { m_warm.valid = false; }
+
+    // 迭代中按雅可比矩阵的奇异值自动冻结不可辨识的参数组合（默认开启）
+    void setAutoFreeze(bool enabled) { m_autoFreeze = enabled; }
+
+    // 时间域迭代前先在拉普拉斯域预拟合（默认开启）：观测压差只做一次拉普拉斯变换，
+    // 之后每次计算只需模型在几十个 s 上的解析解，不做 Stehfest 反演
+    void setLaplacePrefit(bool enabled) { m_laplacePrefit = enabled; }
+
+    // 变产量历史（观测时间与其同一时钟）：非空时模型只在单位响应网格上计算一次，
+    // 再按产量历史叠加到观测时刻，参数 q 仅用于换算单位响应；
+    // 叠加后的曲线在产量变化处不光滑，此时不使用自适应时间网格与拉普拉斯域预拟合
+    void setRateSchedule(const RateSchedule& schedule);
+
+    // 稳健损失函数（迭代重加权，与阻尼步长在同一次求解中完成）
+    void setLoss(const FitLoss& loss) { m_loss = loss; }
+    // 逐点权重，与观测时刻一一对应，同时作用于该点的压力与导数残差；为空或缺少的点按 1 处理
+    void setPointWeights(const QVector<double>& weights) { m_pointWeights = weights; }
+
+    // 并行子任务（Bootstrap 重拟合、后验采样）使用的线程池，与调用方共享线程预算；为空时用全局线程池。
+    // 阻塞等待期间调用线程本身也参与计算，池中没有空闲线程时不会额外开线程，也不会死锁
+    void setThreadPool(QThreadPool* pool) { m_threadPool = pool; }
+
+    // 停止控制（线程安全）：取消标志传入模型计算内部，正在进行的曲线计算也会尽快返回
+    void requestStop() { m_cancel.cancel(); }
+    void clearStopRequest() { m_cancel.reset(); }
+    bool isStopRequested() const { return m_cancel.isCancelled(); }
+
+    // 运行状态（线程安全，供任务队列轮询）
+    int progress() const { return m_progress; }
+    FitCostStats costStats() const;
+
+    // 最新迭代快照（线程安全；尚无结果时为空指针）
+    FitSnapshotPtr latestSnapshot() const;
+
+    // 最近一次拟合的迭代记录（线程安全，拟合进行中返回到目前为止的记录）
+    QVector<FitIterationRecord> iterationLog() const;
+    // 时间域 LM 迭代次数（不含拉普拉斯域预拟合的记录）
+    int iterationCount() const;
+
+    // 拟合结束后的参数不确定性（线程安全，拟合进行中为上一阶段发布的结果或无效）
+    FitUncertainty uncertainty() const;
+    // Bootstrap 重采样拟合次数，0 表示只做线性化分析（不增加模型计算）
+    void setBootstrapSamples(int n) { m_bootstrapSamples = qMax(0, n); }
+
+    // 在最近一次拟合结果附近进行后验采样（阻塞）；需要拟合已给出有效的不确定性分析
+    void runPosteriorSampling(ModelManager::ModelType modelType, QList<FitParameter> params, double weight,
+                              const PosteriorConfig& config = PosteriorSampler::defaultConfig());
+    PosteriorResult posterior() const { return m_posterior; }
+
+    // 最新检查点（线程安全；本次运行尚未发布时为空指针）
+    FitCheckpointPtr latestCheckpoint() const;
+    // 从检查点继续拟合或后验采样（阻塞），观测数据、产量历史、损失函数、逐点权重与自动冻结设置均取自检查点
+    void resumeFromCheckpoint(const FitCheckpoint& checkpoint);
+
+    static QVector<FitFidelityLevel> fidelitySchedule();
+
+private:
+    void fitLevenbergMarquardt(ModelManager::ModelType modelType, QList<FitParameter> params, double weight,
+                               const FitCheckpoint* resume);
+    void samplePosterior(ModelManager::ModelType modelType, const QList<FitParameter>& params, double weight,
+                         const PosteriorProblem& problem, const PosteriorConfig& config,
+                         const PosteriorSamplerState* resume);
+    QSharedPointer<FitCheckpoint> newCheckpoint(FitCheckpoint::Kind kind, ModelManager::ModelType modelType,
+                                                const QList<FitParameter>& params, double weight) const;
+    void publishCheckpoint(const QSharedPointer<FitCheckpoint>& checkpoint);
+    void clearCheckpoint();
+    ModelCurveData evaluateModel(ModelManager::ModelType modelType, const QMap<QString, double>& params,
+                                 const QVector<double>& providedTime = QVector<double>());
+    void setProgress(int value) { m_progress = value; }
+    void archiveEvaluation(const QMap<QString, double>& params, const QVector<double>& residuals);
+    void publishSnapshot(int iteration, double error, bool finished, bool stopped,
+                         const QMap<QString, double>& params, const ModelCurveData& curve);
+    // 迭代记录与不确定性只由工作线程写入，写入时持快照锁，界面线程通过 getter 在锁内复制
+    void appendIterationRecord(const FitIterationRecord& record);
+    void publishUncertainty(const FitUncertainty& uncertainty);
+    void resetResults();
+
+    void buildModelTimeGrid(const QMap<QString, double>& params, ModelManager::ModelType modelType);
+    bool validateModelTimeGrid(const QMap<QString, double>& params, ModelManager::ModelType modelType);
+    QVector<double> calculateResiduals(const QMap<QString, double>& params, ModelManager::ModelType modelType, double weight,
+                                       ModelCurveData* outCurve = nullptr);
+    // 由观测时刻上的理论曲线计算残差（先压力段，后导数段）
+    QVector<double> residualsFromCurve(const ModelCurveData& curve, double weight) const;
+    void saveWarmState(ModelManager::ModelType modelType, double weight, const QVector<int>& fitIndices,
+                       const QList<FitParameter>& params, const QMap<QString, double>& values,
+                       const ModelCurveData& curve, const Eigen::MatrixXd& J, double lambda);
+    // 第 i 个观测点残差的权重系数（逐点权重的平方根）
+    double pointWeightFactor(int i) const;
+    QThreadPool* workerPool() const;
+    // 当前产量历史下 time 的叠加计划（线程安全；观测时刻、网格密度不变时复用）
+    QSharedPointer<const SuperpositionPlan> superpositionPlan(const QVector<double>& time);
+    Eigen::MatrixXd computeJacobian(const QMap<QString, double>& params, const QVector<double>& residuals, const QVector<int>& fitIndices, ModelManager::ModelType modelType, const QList<FitParameter>& currentFitParams, double weight);
+    // 拉普拉斯域预拟合：目标函数下降时把拟合参数写回 values 并返回 true
+    bool laplacePrefit(ModelManager::ModelType modelType, const QList<FitParameter>& params,
+                       const QVector<int>& fitIndices, double weight, QMap<QString, double>& values);
+    QVector<double> laplaceResiduals(const LaplaceSampledData& data, const QMap<QString, double>& params,
+                                     ModelManager::ModelType modelType, double weight);
+    // 在 columns 所列的雅可比矩阵列中找出应冻结的列（列归一化 SVD 的子集选择）
+    QVector<int> unidentifiableColumns(const Eigen::MatrixXd& J, const QVector<int>& columns) const;
+    // 在变换参数空间中走一步并裁剪到参数范围
+    QMap<QString, double> stepParameters(const QMap<QString, double>& current, const QVector<double>& delta,
+                                         const QVector<int>& fitIndices, const QList<FitParameter>& params) const;
+    FitUncertainty computeUncertainty(const Eigen::MatrixXd& J, const QVector<double>& residuals,
+                                      const QVector<int>& fitIndices, const QList<FitParameter>& params,
+                                      const QMap<QString, double>& values);
+    void runBootstrap(ModelManager::ModelType modelType, const QList<FitParameter>& params,
+                      const QMap<QString, double>& bestValues, const QVector<double>& residuals, double weight);
+    double calculateSumSquaredError(const QVector<double>& residuals);
+    // 迭代的目标函数 Σρ(r²)：最小二乘时即残差平方和
+    double calculateObjective(const QVector<double>& residuals) const;
+    // 迭代重加权的行权重 ρ'(r²)
+    Eigen::VectorXd robustWeights(const QVector<double>& residuals) const;
+
+    ModelManager* m_modelManager;
+    QThreadPool* m_threadPool;
+
+    QVector<double> m_obsTime;
+    QVector<double> m_obsPressure;
+    QVector<double> m_obsDerivative;
+
+    // 拟合期间模型计算使用的自适应对数时间网格（为空表示直接在观测时刻计算）
+    QVector<double> m_modelTimeGrid;
+    ModelGridConfig m_gridConfig;
+
+    QVector<FitIterationRecord> m_iterationLog;
+    bool m_autoFreeze;
+    bool m_laplacePrefit;
+    RateSchedule m_rateSchedule;
+    FitLoss m_loss;
+    QVector<double> m_pointWeights;
+    FitWarmState m_warm;
+    FitUncertainty m_uncertainty;
+    int m_bootstrapSamples;
+
+    // 最高精度下已完成的残差计算，作为后验采样代理模型的训练数据
+    QVector<SurrogateSample> m_evalArchive;
+    bool m_archiveEnabled;
+    QStringList m_archiveNames;
+    QVector<bool> m_archiveIsLog;
+    PosteriorResult m_posterior;
+
+    CancellationToken m_cancel;
+    std::atomic<int> m_progress;
+    std::atomic<int> m_modelEvaluations;
+    std::atomic<qint64> m_modelPoints;
+    std::atomic<qint64> m_startMs;
+    std::atomic<qint64> m_endMs;
+    QElapsedTimer m_clock;
+
+    // 最新值通道：只保存最近一次发布的快照；同时保护 m_iterationLog 与 m_uncertainty 的写入
+    mutable QMutex m_snapshotMutex;
+    FitSnapshotPtr m_latestSnapshot;
+    quint64 m_snapshotSequence;
+
+    mutable QMutex m_checkpointMutex;
+    FitCheckpointPtr m_latestCheckpoint;
+    quint64 m_checkpointSequence;
+
+    QMutex m_planMutex;
+    QSharedPointer<const SuperpositionPlan> m_superpositionPlan;
+};
+
+#endif // FITTINGENGINE_H
@@ -1,6 +1,7 @@
 #include "fittingpage.h"
 #include "ui_fittingpage.h"
 #include "fittingwidget.h"
+#include "fitjobqueue.h"
 #include "modelparameter.h"
 #include <QInputDialog>
 #include <QMessageBox>
@@ -10,7 +11,8 @@
 FittingPage::FittingPage(QWidget *parent) :
     QWidget(parent),
     ui(new Ui::FittingPage),
-    m_modelManager(nullptr)
+    m_modelManager(nullptr),
+    m_jobQueue(new FitJobQueue(this))
 {
     ui->setupUi(this);
 
@@ -19,6 +21,12 @@ FittingPage::FittingPage(QWidget *parent) :
 
 FittingPage::~FittingPage()
 {
+    // 先关闭各页签（停止并等待其拟合任务），再释放队列
+    while (ui->tabWidget->count() > 0) {
+        QWidget* w = ui->tabWidget->widget(0);
+        ui->tabWidget->removeTab(0);
+        delete w;
+    }
     delete ui;
 }
 
@@ -55,6 +63,8 @@ FittingWidget* FittingPage::createNewTab(const QString &name, const QJsonObject
 {
     FittingWidget* w = new FittingWidget(this);
     if(m_modelManager) w->setModelManager(m_modelManager);
+    w->setJobQueue(m_jobQueue);
+    w->setAnalysisName(name);
 
     connect(w, &FittingWidget::sigRequestSave, this, &FittingPage::onChildRequestSave);
 
@@ -125,6 +135,8 @@ void FittingPage::on_btnRenameAnalysis_clicked()
     QString newName = QInputDialog::getText(this, "重命名", "请输入新的分析名称:", QLineEdit::Normal, oldName, &ok);
     if(ok && !newName.isEmpty()) {
         ui->tabWidget->setTabText(idx, newName);
+        FittingWidget* w = qobject_cast<FittingWidget*>(ui->tabWidget->widget(idx));
+        if(w) w->setAnalysisName(newName);
     }
 }
 
@@ -145,6 +157,13 @@ void FittingPage::on_btnDeleteAnalysis_clicked()
     }
 }
 
+void FittingPage::on_btnFitQueue_clicked()
+{
+    FitQueueDialog* dlg = new FitQueueDialog(m_jobQueue, this);
+    dlg->setAttribute(Qt::WA_DeleteOnClose);
+    dlg->show();
+}
+
 void FittingPage::saveAllFittingStates()
 {
     QJsonArray analysesArray;
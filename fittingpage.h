@@ -8,6 +8,7 @@
 
 // 前置声明
 class FittingWidget;
+class FitJobQueue;
 
 namespace Ui {
 class FittingPage;
@@ -43,6 +44,8 @@ private slots:
     void on_btnRenameAnalysis_clicked();
     // 删除当前页签
     void on_btnDeleteAnalysis_clicked();
+    // 显示拟合任务队列
+    void on_btnFitQueue_clicked();
 
     // 响应子页面发出的保存请求
     void onChildRequestSave();
@@ -51,6 +54,9 @@ private:
     Ui::FittingPage *ui;
     ModelManager* m_modelManager;
 
+    // 所有页签共享的拟合任务队列（线程池预算）
+    FitJobQueue* m_jobQueue;
+
     // 创建一个新的拟合页的内部函数
     // name: 页签名称
     // initData: 初始状态数据（如果是复制或加载存档，否则为空）
@@ -1,15 +1,24 @@
 #include "fittingwidget.h"
+#include "initialguessestimator.h"
 #include "ui_fittingwidget.h"
 #include "pressurederivativecalculator.h"
 #include "modelparameter.h"
 #include "modelselect.h"
+#include "fitjobqueue.h"
+#include "fitcheckpoint.h"
+#include "posteriorsampler.h"
+#include "pressuredeconvolution.h"
+#include "timetransform.h"
 
 #include <QtConcurrent>
 #include <QMessageBox>
 #include <QDebug>
 #include <cmath>
+#include <limits>
 #include <QFileDialog>
 #include <QFile>
+#include <QFileInfo>
+#include <QApplication>
 #include <QTextStream>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -22,7 +31,8 @@
 #include <QJsonArray>
 #include <QDateTime>
 #include <QBuffer>
-#include <Eigen/Dense>
+#include <QTimer>
+#include <QProgressDialog>
 
 // ===========================================================================
 // FittingDataLoadDialog 实现
@@ -67,6 +77,7 @@ FittingDataLoadDialog::FittingDataLoadDialog(const QList<QStringList>& previewDa
     grid->addWidget(new QLabel("导数列:",this), 1, 0); m_comboDeriv = new QComboBox(this); m_comboDeriv->addItem("自动计算 (Bourdet)",-1); m_comboDeriv->addItems(opts); grid->addWidget(m_comboDeriv, 1, 1);
     grid->addWidget(new QLabel("跳过首行数:",this), 1, 2); m_comboSkipRows = new QComboBox(this); for(int i=0;i<=20;++i) m_comboSkipRows->addItem(QString::number(i),i); m_comboSkipRows->setCurrentIndex(1); grid->addWidget(m_comboSkipRows, 1, 3);
     grid->addWidget(new QLabel("压力数据类型:",this), 2, 0); m_comboPressureType = new QComboBox(this); m_comboPressureType->addItem("原始压力 (自动计算压差 |P-Pi|)", 0); m_comboPressureType->addItem("压差数据 (直接使用 ΔP)", 1); grid->addWidget(m_comboPressureType, 2, 1, 1, 3);
+    grid->addWidget(new QLabel("权重列:",this), 3, 0); m_comboWeight = new QComboBox(this); m_comboWeight->addItem("不使用 (等权重)",-1); m_comboWeight->addItems(opts); m_comboWeight->setToolTip("逐点权重，同时作用于该点的压力与导数残差；0 表示剔除该点，负值与非数值按 1 处理"); grid->addWidget(m_comboWeight, 3, 1, 1, 3);
 
     layout->addWidget(grp);
     QHBoxLayout* btns = new QHBoxLayout; QPushButton* ok = new QPushButton("确定",this); QPushButton* cancel = new QPushButton("取消",this);
@@ -77,9 +88,73 @@ void FittingDataLoadDialog::validateSelection() { if(m_comboTime->currentIndex()
 int FittingDataLoadDialog::getTimeColumnIndex() const { return m_comboTime->currentIndex(); }
 int FittingDataLoadDialog::getPressureColumnIndex() const { return m_comboPressure->currentIndex()-1; }
 int FittingDataLoadDialog::getDerivativeColumnIndex() const { return m_comboDeriv->currentIndex()-1; }
+int FittingDataLoadDialog::getWeightColumnIndex() const { return m_comboWeight->currentIndex()-1; }
 int FittingDataLoadDialog::getSkipRows() const { return m_comboSkipRows->currentData().toInt(); }
 int FittingDataLoadDialog::getPressureDataType() const { return m_comboPressureType->currentData().toInt(); }
 
+// ===========================================================================
+// ParameterUncertaintyDialog 实现
+// ===========================================================================
+static QString formatBound(double v) { return std::isfinite(v) ? QString::number(v, 'g', 4) : QString("∞"); }
+static QJsonValue finiteOrNull(double v) { return std::isfinite(v) ? QJsonValue(v) : QJsonValue(); }
+
+ParameterUncertaintyDialog::ParameterUncertaintyDialog(const FitUncertainty& u, const QStringList& displayNames, QWidget *parent) : QDialog(parent) {
+    setWindowTitle("参数不确定性分析"); resize(820, 560);
+    this->setStyleSheet(
+        "QDialog { background-color: #ffffff; color: #000000; font-family: 'Microsoft YaHei'; }"
+        "QLabel, QTableWidget { color: #000000; }"
+        "QTableWidget { gridline-color: #d0d0d0; border: 1px solid #c0c0c0; }"
+        "QHeaderView::section { background-color: #f0f0f0; border: 1px solid #d0d0d0; color: #000000; }"
+        "QPushButton { background-color: #ffffff; border: 1px solid #c0c0c0; border-radius: 4px; padding: 5px 15px; color: #333333; }"
+        "QPushButton:hover { background-color: #f2f2f2; border-color: #a0a0a0; color: #000000; }"
+        );
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    int n = u.names.size();
+    layout->addWidget(new QLabel(QString("自由度: %1    残差方差 σ²: %2    t(0.975): %3    条件数: %4%5")
+                                     .arg(u.dof).arg(u.sigma2, 0, 'e', 3).arg(u.tQuantile, 0, 'f', 3)
+                                     .arg(formatBound(u.conditionNumber))
+                                     .arg(u.bootstrapSamples > 0 ? QString("    Bootstrap 样本: %1").arg(u.bootstrapSamples) : QString()), this));
+
+    bool boot = u.bootstrapSamples > 0 && u.bootLower.size() == n;
+    QTableWidget* table = new QTableWidget(n, boot ? 7 : 6, this);
+    QStringList headers = {"参数", "拟合值", "标准误差", "95% 下限", "95% 上限", "可辨识"};
+    if(boot) headers.insert(5, "Bootstrap 区间");
+    table->setHorizontalHeaderLabels(headers);
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    for(int i=0; i<n; ++i) {
+        int c = 0;
+        table->setItem(i, c++, new QTableWidgetItem(displayNames.value(i, u.names[i])));
+        table->setItem(i, c++, new QTableWidgetItem(QString::number(u.values[i], 'g', 5)));
+        table->setItem(i, c++, new QTableWidgetItem(formatBound(u.stdErrors[i]) + (u.isLog[i] ? " (log10)" : "")));
+        table->setItem(i, c++, new QTableWidgetItem(formatBound(u.ciLower[i])));
+        table->setItem(i, c++, new QTableWidgetItem(formatBound(u.ciUpper[i])));
+        if(boot) table->setItem(i, c++, new QTableWidgetItem(QString("[%1, %2]").arg(formatBound(u.bootLower[i]), formatBound(u.bootUpper[i]))));
+        QTableWidgetItem* idItem = new QTableWidgetItem(u.identifiable[i] ? "是" : "否");
+        if(!u.identifiable[i]) idItem->setForeground(QColor(200, 0, 0));
+        table->setItem(i, c++, idItem);
+    }
+    layout->addWidget(table);
+
+    layout->addWidget(new QLabel("相关系数矩阵 (|r| ≥ 0.95 标红):", this));
+    QTableWidget* corr = new QTableWidget(n, n, this);
+    QStringList corrHeaders; for(int i=0; i<n; ++i) corrHeaders << displayNames.value(i, u.names[i]);
+    corr->setHorizontalHeaderLabels(corrHeaders); corr->setVerticalHeaderLabels(corrHeaders);
+    corr->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    corr->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    for(int i=0; i<n; ++i) for(int j=0; j<n; ++j) {
+        double r = u.correlation[i][j];
+        QTableWidgetItem* item = new QTableWidgetItem(QString::number(r, 'f', 3));
+        if(i != j && std::abs(r) >= 0.95) item->setForeground(QColor(200, 0, 0));
+        corr->setItem(i, j, item);
+    }
+    layout->addWidget(corr);
+
+    QHBoxLayout* btns = new QHBoxLayout; QPushButton* ok = new QPushButton("关闭", this);
+    connect(ok, &QPushButton::clicked, this, &QDialog::accept);
+    btns->addStretch(); btns->addWidget(ok); layout->addLayout(btns);
+}
+
 
 // ===========================================================================
 // FittingWidget 实现
@@ -91,7 +166,17 @@ FittingWidget::FittingWidget(QWidget *parent) :
     m_modelManager(nullptr),
     m_plotTitle(nullptr),
     m_currentModelType(ModelManager::Model_1),
-    m_isFitting(false)
+    m_engine(new FittingEngine(this)),
+    m_initialPressure(std::numeric_limits<double>::quiet_NaN()),
+    m_superpositionDerivative(false),
+    m_jobQueue(nullptr),
+    m_isFitting(false),
+    m_incrementalRun(false),
+    m_pendingIncremental(false),
+    m_uiTimer(new QTimer(this)),
+    m_lastSnapshotSequence(0),
+    m_checkpointTimer(new QTimer(this)),
+    m_lastCheckpointSequence(0)
 {
     ui->setupUi(this);
 
@@ -109,9 +194,14 @@ FittingWidget::FittingWidget(QWidget *parent) :
     qRegisterMetaType<ModelManager::ModelType>("ModelManager::ModelType");
     qRegisterMetaType<QVector<double>>("QVector<double>");
 
-    connect(this, &FittingWidget::sigIterationUpdated, this, &FittingWidget::onIterationUpdate, Qt::QueuedConnection);
+    // 工作线程只写入最新快照，界面按固定频率拉取，迭代再快也不会堆积事件
+    m_uiTimer->setInterval(1000 / kMaxUiFps);
+    connect(m_uiTimer, &QTimer::timeout, this, &FittingWidget::onUiRefreshTimer);
+    m_checkpointTimer->setInterval(kCheckpointIntervalMs);
+    connect(m_checkpointTimer, &QTimer::timeout, this, &FittingWidget::onCheckpointTimer);
     connect(this, &FittingWidget::sigProgress, ui->progressBar, &QProgressBar::setValue);
     connect(&m_watcher, &QFutureWatcher<void>::finished, this, &FittingWidget::onFitFinished);
+    connect(&m_samplingWatcher, &QFutureWatcher<void>::finished, this, &FittingWidget::onSamplingFinished);
 
     connect(ui->sliderWeight, &QSlider::valueChanged, this, [this](int val){
         ui->spinWeight->blockSignals(true);
@@ -125,10 +215,21 @@ FittingWidget::FittingWidget(QWidget *parent) :
     });
 }
 
-FittingWidget::~FittingWidget() { delete ui; }
+FittingWidget::~FittingWidget() {
+    // 页签关闭时停止本页拟合。仍在排队的任务直接撤销；已开始的任务在模型计算的取消检查点返回，
+    // 等待工作线程退出后再释放引擎。关闭前写入最新检查点，下次可从中断处继续
+    if(m_isFitting) saveCheckpoint();
+    m_engine->requestStop();
+    if(!(m_jobQueue && m_jobQueue->cancelQueued(m_engine))) {
+        m_watcher.waitForFinished();
+        m_samplingWatcher.waitForFinished();
+    }
+    delete ui;
+}
 
 void FittingWidget::setModelManager(ModelManager *m) {
     m_modelManager = m;
+    m_engine->setModelManager(m);
     initializeDefaultModel();
 }
 
@@ -145,13 +246,19 @@ void FittingWidget::initializeDefaultModel() {
 QJsonObject FittingWidget::getJsonState() const
 {
     const_cast<FittingWidget*>(this)->updateParamsFromTable();
+    return stateToJson(m_currentModelType, m_parameters, m_obsTime, m_obsPressure, m_obsDerivative, m_obsWeights, m_engine);
+}
 
+QJsonObject FittingWidget::stateToJson(ModelManager::ModelType type, const QList<FitParameter>& params,
+                                       const QVector<double>& obsT, const QVector<double>& obsP, const QVector<double>& obsD,
+                                       const QVector<double>& obsW, const FittingEngine* engine)
+{
     QJsonObject root;
-    root["modelType"] = (int)m_currentModelType;
-    root["modelName"] = ModelManager::getModelTypeName(m_currentModelType);
+    root["modelType"] = (int)type;
+    root["modelName"] = ModelManager::getModelTypeName(type);
 
     QJsonArray paramsArray;
-    for(const auto& p : m_parameters) {
+    for(const auto& p : params) {
         QJsonObject pObj;
         pObj["name"] = p.name;
         pObj["value"] = p.value;
@@ -163,16 +270,70 @@ QJsonObject FittingWidget::getJsonState() const
     root["parameters"] = paramsArray;
 
     QJsonArray timeArr, pressArr, derivArr;
-    for(double v : m_obsTime) timeArr.append(v);
-    for(double v : m_obsPressure) pressArr.append(v);
-    for(double v : m_obsDerivative) derivArr.append(v);
+    for(double v : obsT) timeArr.append(v);
+    for(double v : obsP) pressArr.append(v);
+    for(double v : obsD) derivArr.append(v);
 
     QJsonObject obsData;
     obsData["time"] = timeArr;
     obsData["pressure"] = pressArr;
     obsData["derivative"] = derivArr;
+    if(!obsW.isEmpty()) {
+        QJsonArray weightArr;
+        for(double v : obsW) weightArr.append(v);
+        obsData["weight"] = weightArr;
+    }
     root["observedData"] = obsData;
 
+    if(!engine) return root;
+
+    // 最近一次拟合每次迭代使用的精度等级
+    QJsonArray logArr;
+    for(const auto& rec : engine->iterationLog()) {
+        QJsonObject r;
+        r["iter"] = rec.iteration;
+        r["fidelity"] = rec.fidelityLevel;
+        r["stehfestN"] = rec.stehfestN;
+        r["sse"] = rec.sse;
+        r["lambda"] = rec.lambda;
+        if(!rec.frozen.isEmpty()) r["frozen"] = QJsonArray::fromStringList(rec.frozen);
+        logArr.append(r);
+    }
+    root["iterationLog"] = logArr;
+
+    // 最近一次拟合的参数不确定性
+    FitUncertainty u = engine->uncertainty();
+    if(u.valid) {
+        QJsonObject uObj;
+        uObj["dof"] = u.dof;
+        uObj["sigma2"] = u.sigma2;
+        uObj["tQuantile"] = u.tQuantile;
+        uObj["conditionNumber"] = finiteOrNull(u.conditionNumber);
+        uObj["jacobianFidelity"] = u.jacobianFidelity;
+        uObj["bootstrapSamples"] = u.bootstrapSamples;
+        QJsonArray pArr, corrArr;
+        for(int i=0; i<u.names.size(); ++i) {
+            QJsonObject p;
+            p["name"] = u.names[i];
+            p["value"] = u.values[i];
+            p["logScale"] = u.isLog[i];
+            p["stdError"] = finiteOrNull(u.stdErrors[i]);
+            p["ciLower"] = finiteOrNull(u.ciLower[i]);
+            p["ciUpper"] = finiteOrNull(u.ciUpper[i]);
+            p["identifiable"] = u.identifiable[i];
+            if(u.bootstrapSamples > 0 && i < u.bootLower.size()) {
+                p["bootLower"] = u.bootLower[i];
+                p["bootUpper"] = u.bootUpper[i];
+            }
+            pArr.append(p);
+            QJsonArray row; for(double r : u.correlation[i]) row.append(r);
+            corrArr.append(row);
+        }
+        uObj["parameters"] = pArr;
+        uObj["correlation"] = corrArr;
+        root["uncertainty"] = uObj;
+    }
+
     return root;
 }
 
@@ -219,12 +380,13 @@ void FittingWidget::loadFittingState(const QJsonObject& root)
         QJsonArray pArr = obs["pressure"].toArray();
         QJsonArray dArr = obs["derivative"].toArray();
 
-        QVector<double> t, p, d;
+        QVector<double> t, p, d, w;
         for(auto v : tArr) t.append(v.toDouble());
         for(auto v : pArr) p.append(v.toDouble());
         for(auto v : dArr) d.append(v.toDouble());
+        for(auto v : obs["weight"].toArray()) w.append(v.toDouble(1.0));
 
-        setObservedData(t, p, d);
+        setObservedData(t, p, d, w);
     }
 
     updateModelCurve();
@@ -232,6 +394,8 @@ void FittingWidget::loadFittingState(const QJsonObject& root)
 
 void FittingWidget::on_btnExportReport_clicked()
 {
+    // 拟合进行中参数表与不确定性分属不同迭代，报告只在拟合结束后导出
+    if(m_isFitting) { QMessageBox::warning(this, "提示", "拟合进行中，请结束后再导出报告。"); return; }
     updateParamsFromTable();
 
     QString defaultDir = ModelParameter::instance()->getProjectPath();
@@ -297,7 +461,41 @@ void FittingWidget::on_btnExportReport_clicked()
     }
     html += "</table>";
 
-    html += "<h2>5. 拟合曲线图</h2>";
+    FitUncertainty u = m_engine->uncertainty();
+    if(u.valid) {
+        QStringList names = uncertaintyDisplayNames(u);
+        bool boot = u.bootstrapSamples > 0 && u.bootLower.size() == u.names.size();
+        html += "<h2>5. 参数不确定性分析</h2>";
+        html += "<p>由最终雅可比矩阵线性化估计：自由度 " + QString::number(u.dof) + "，t(0.975) = " + QString::number(u.tQuantile, 'f', 3)
+                + "，条件数 " + formatBound(u.conditionNumber)
+                + (boot ? "；Bootstrap 样本 " + QString::number(u.bootstrapSamples) + " 个" : QString()) + "。"
+                + (u.robustWeighted ? "采用稳健损失函数，区间以最终迭代的稳健权重为条件（离群点的降权视为已知），未计入权重本身的不确定性。" : QString())
+                + "</p>";
+        html += "<table>";
+        html += "<tr><th>参数</th><th>拟合值</th><th>95% 置信区间</th>" + QString(boot ? "<th>Bootstrap 区间</th>" : "") + "<th>可辨识</th></tr>";
+        for(int i=0; i<u.names.size(); ++i) {
+            html += "<tr><td>" + names[i] + "</td><td>" + QString::number(u.values[i], 'g', 6) + "</td>";
+            html += "<td>[" + formatBound(u.ciLower[i]) + ", " + formatBound(u.ciUpper[i]) + "]</td>";
+            if(boot) html += "<td>[" + formatBound(u.bootLower[i]) + ", " + formatBound(u.bootUpper[i]) + "]</td>";
+            html += "<td>" + QString(u.identifiable[i] ? "是" : "<span style='color:#c00;'>否</span>") + "</td></tr>";
+        }
+        html += "</table>";
+        html += "<p><strong>相关系数矩阵</strong></p><table><tr><th></th>";
+        for(const QString& nm : names) html += "<th>" + nm + "</th>";
+        html += "</tr>";
+        for(int i=0; i<u.names.size(); ++i) {
+            html += "<tr><th>" + names[i] + "</th>";
+            for(int j=0; j<u.names.size(); ++j) {
+                double r = u.correlation[i][j];
+                bool strong = (i != j && std::abs(r) >= 0.95);
+                html += "<td" + QString(strong ? " style='color:#c00;'" : "") + ">" + QString::number(r, 'f', 3) + "</td>";
+            }
+            html += "</tr>";
+        }
+        html += "</table>";
+    }
+
+    html += "<h2>" + QString(u.valid ? "6" : "5") + ". 拟合曲线图</h2>";
     QString imgBase64 = getPlotImageBase64();
     if(!imgBase64.isEmpty()) {
         html += "<div style='text-align:center;'><img src='data:image/png;base64," + imgBase64 + "' width='600' /></div>";
@@ -320,6 +518,28 @@ void FittingWidget::on_btnExportReport_clicked()
     }
 }
 
+QStringList FittingWidget::uncertaintyDisplayNames(const FitUncertainty& u) const
+{
+    QStringList names;
+    for(const QString& key : u.names) {
+        QString name = key;
+        for(const auto& p : m_parameters) if(p.name == key) { name = p.displayName; break; }
+        names << name;
+    }
+    return names;
+}
+
+void FittingWidget::on_btnUncertainty_clicked()
+{
+    FitUncertainty u = m_engine->uncertainty();
+    if(m_isFitting || !u.valid) {
+        QMessageBox::information(this, "提示", "请先完成一次自动拟合（不确定性由最终迭代的雅可比矩阵计算）。");
+        return;
+    }
+    ParameterUncertaintyDialog dlg(u, uncertaintyDisplayNames(u), this);
+    dlg.exec();
+}
+
 QString FittingWidget::getPlotImageBase64()
 {
     if(!m_plot) return "";
@@ -414,8 +634,65 @@ void FittingWidget::setupPlot() {
     m_plot->legend->setVisible(true); m_plot->legend->setFont(QFont("Arial", 9)); m_plot->legend->setBrush(QBrush(QColor(255, 255, 255, 200)));
 }
 
-void FittingWidget::setObservedData(const QVector<double>& t, const QVector<double>& p, const QVector<double>& d) {
-    m_obsTime = t; m_obsPressure = p; m_obsDerivative = d;
+void FittingWidget::setObservedData(const QVector<double>& t, const QVector<double>& p, const QVector<double>& d,
+                                    const QVector<double>& weights) {
+    m_obsTime = t; m_obsPressure = p; m_obsDerivative = d; m_obsWeights = weights;
+    m_derivativeStream.reset();
+    m_superpositionDerivative = false;
+    m_initialPressure = std::numeric_limits<double>::quiet_NaN();
+    // 换了一组数据，上次拟合的结果不能再作为增量拟合的起点
+    m_engine->clearWarmStart();
+    m_pendingIncremental = false;
+    plotObservedData();
+}
+
+void FittingWidget::appendObservedData(const QVector<double>& t, const QVector<double>& p, const QVector<double>& d,
+                                       const QVector<double>& weights) {
+    // 只接受晚于已有数据的点
+    double tLast = m_obsTime.isEmpty() ? 0.0 : m_obsTime.last();
+    const int oldCount = m_obsTime.size();
+    int added = 0;
+    bool hasDerivative = d.size() >= t.size();
+    // 已有数据或新数据带权重时，缺少权重的点按 1 补齐
+    bool weighted = !weights.isEmpty() || !m_obsWeights.isEmpty();
+    if(weighted) while(m_obsWeights.size() < oldCount) m_obsWeights.append(1.0);
+    for(int i=0; i<t.size() && i<p.size(); ++i) {
+        if(t[i] <= tLast) continue;
+        m_obsTime.append(t[i]); m_obsPressure.append(p[i]);
+        if(hasDerivative) m_obsDerivative.append(d[i]);
+        if(weighted) m_obsWeights.append(i < weights.size() ? weights[i] : 1.0);
+        tLast = t[i]; ++added;
+    }
+    if(added == 0) return;
+    // 导数为中心差分，只有末尾一个 L-Spacing 窗口内旧点的导数随新数据变化：
+    // 流式计算只处理新点，已确定的导数保留，窗口内的点取暂定值（与整体重算结果相同）。
+    // 叠加导数的横轴依赖全部流动段、其他导数算法的平滑依赖全部数据，整体重算
+    if((m_superpositionDerivative || m_derivativeOptions.method != DerivativeMethod::Bourdet) && !hasDerivative) {
+        recomputeObservedDerivative();
+    } else if(!hasDerivative || m_obsDerivative.size() != m_obsTime.size()) {
+        QVector<StreamingDerivativePoint> done;
+        if(m_derivativeStream.sampleCount() != oldCount || m_derivativeStream.rejectedCount() > 0) {
+            m_derivativeStream.reset();
+            m_obsDerivative.clear();
+            done = m_derivativeStream.append(m_obsTime, m_obsPressure);
+        } else {
+            m_obsDerivative.resize(int(m_derivativeStream.emittedCount()));
+            done = m_derivativeStream.append(m_obsTime.mid(oldCount), m_obsPressure.mid(oldCount));
+        }
+        for(const StreamingDerivativePoint& point : done) m_obsDerivative.append(point.d);
+        m_obsDerivative += m_derivativeStream.provisional();
+    }
+    plotObservedData();
+
+    if(!ui->chkIncremental->isChecked() || !m_engine->hasWarmStart()) return;
+    if(m_isFitting) { m_pendingIncremental = true; return; }
+    startIncrementalFit();
+}
+
+void FittingWidget::plotObservedData() {
+    const QVector<double>& t = m_obsTime;
+    const QVector<double>& p = m_obsPressure;
+    const QVector<double>& d = m_obsDerivative;
 
     QVector<double> vt, vp, vd;
     for(int i=0; i<t.size(); ++i) {
@@ -485,11 +762,8 @@ QStringList FittingWidget::getParamOrder(ModelManager::ModelType type) {
     return order;
 }
 
-void FittingWidget::on_btnResetParams_clicked() {
-    if(!m_modelManager) return;
-
-    ModelManager::ModelType type = m_currentModelType;
-    QMap<QString,double> defs = m_modelManager->getDefaultParameters(type);
+QList<FitParameter> FittingWidget::defaultParameters(ModelManager* manager, ModelManager::ModelType type) {
+    QMap<QString,double> defs = manager ? manager->getDefaultParameters(type) : QMap<QString,double>();
 
     if(!defs.contains("phi")) defs["phi"] = 0.05;
     if(!defs.contains("h")) defs["h"] = 20.0;
@@ -500,7 +774,7 @@ void FittingWidget::on_btnResetParams_clicked() {
     if(!defs.contains("nf")) defs["nf"] = 4.0;
     if(!defs.contains("gamaD")) defs["gamaD"] = 0.02;
 
-    m_parameters.clear();
+    QList<FitParameter> params;
     QStringList orderedKeys = getParamOrder(type);
 
     for(const QString& key : orderedKeys) {
@@ -533,9 +807,15 @@ void FittingWidget::on_btnResetParams_clicked() {
                 else if (p.value == 0) { p.min = 0.0; p.max = 100.0; }
                 else { p.min = -100.0; p.max = 100.0; }
             }
-            m_parameters.append(p);
+            params.append(p);
         }
     }
+    return params;
+}
+
+void FittingWidget::on_btnResetParams_clicked() {
+    if(!m_modelManager) return;
+    m_parameters = defaultParameters(m_modelManager, m_currentModelType);
     loadParamsToTable();
 
     if(m_plot->graphCount() > 3) {
@@ -545,6 +825,41 @@ void FittingWidget::on_btnResetParams_clicked() {
     }
 }
 
+void FittingWidget::on_btnAutoGuess_clicked() {
+    if(m_obsTime.isEmpty()) { QMessageBox::warning(this,"错误","请先加载观测数据。"); return; }
+    updateParamsFromTable();
+    QStringList notes = applyInitialGuess(false);
+    if(notes.isEmpty()) {
+        QMessageBox::information(this, "自动初值", "未能从观测曲线中识别出可用于估计初值的流动段。");
+        return;
+    }
+    loadParamsToTable();
+    updateModelCurve();
+    QMessageBox::information(this, "自动初值", "已根据流动段估计初值：\n" + notes.join("\n"));
+}
+
+QStringList FittingWidget::applyInitialGuess(bool onlyFitted) {
+    QMap<QString,double> current;
+    for(const FitParameter& p : m_parameters) current[p.name] = p.value;
+    InitialGuessResult guess = InitialGuessEstimator::estimate(m_obsTime, m_obsPressure, m_obsDerivative, current);
+
+    QStringList applied = guess.notes;
+    QStringList skipped;
+    for(auto it = guess.values.constBegin(); it != guess.values.constEnd(); ++it) {
+        for(FitParameter& p : m_parameters) {
+            if(p.name != it.key()) continue;
+            if(onlyFitted && !p.isFit) { skipped << p.name; break; }
+            double v = it.value();
+            if(!std::isfinite(v)) break;
+            p.value = qBound(p.min, v, p.max);
+            break;
+        }
+    }
+    if(guess.values.isEmpty()) return QStringList();
+    if(!skipped.isEmpty()) applied << QString("未勾选拟合、保持原值: %1").arg(skipped.join(", "));
+    return applied;
+}
+
 void FittingWidget::loadParamsToTable() {
     ui->tableParams->setRowCount(0);
     ui->tableParams->blockSignals(true);
@@ -599,7 +914,30 @@ void FittingWidget::updateParamsFromTable() {
 QStringList FittingWidget::parseLine(const QString& line) { return line.split(QRegularExpression("[,\\s\\t]+"), Qt::SkipEmptyParts); }
 
 void FittingWidget::on_btnLoadData_clicked() {
-    QString path = QFileDialog::getOpenFileName(this, "加载试井数据", "", "文本文件 (*.txt *.csv)");
+    QVector<double> t, p, d, w;
+    double p_init = std::numeric_limits<double>::quiet_NaN();
+    if(!readDataFile("加载试井数据", t, p, d, w, p_init)) return;
+    if(d.isEmpty()) d = PressureDerivativeCalculator::calculateDerivative(t, p, m_derivativeOptions);
+    setObservedData(t, p, d, w);
+    m_initialPressure = p_init;
+    setRateSchedule(RateSchedule());
+}
+
+void FittingWidget::on_btnAppendData_clicked() {
+    if(m_obsTime.isEmpty()) { QMessageBox::warning(this,"错误","请先加载观测数据。"); return; }
+    QVector<double> t, p, d, w;
+    double p_init = m_initialPressure;
+    if(!readDataFile("追加试井数据", t, p, d, w, p_init)) return;
+    int before = m_obsTime.size();
+    appendObservedData(t, p, d, w);
+    if(m_obsTime.size() == before)
+        QMessageBox::warning(this, "提示", "文件中没有晚于已有数据的时间点。");
+}
+
+// 反褶积：压力历史（原始压力）+ 产量历史（每行“起始时间 产量”），结果按最大产量换算后作为观测数据
+void FittingWidget::on_btnDeconvolution_clicked() {
+    if(m_isFitting) { QMessageBox::warning(this, "提示", "拟合进行中，请结束后再做反褶积。"); return; }
+    QString path = QFileDialog::getOpenFileName(this, "选择压力历史", "", "文本文件 (*.txt *.csv)");
     if(path.isEmpty()) return;
     QFile f(path); if(!f.open(QIODevice::ReadOnly)) return;
     QTextStream in(&f); QList<QStringList> data;
@@ -607,15 +945,161 @@ void FittingWidget::on_btnLoadData_clicked() {
     f.close();
     FittingDataLoadDialog dlg(data, this);
     if(dlg.exec()!=QDialog::Accepted) return;
+    int tCol=dlg.getTimeColumnIndex(), pCol=dlg.getPressureColumnIndex();
+    if(pCol < 0) { QMessageBox::warning(this, "错误", "请指定压力列。"); return; }
+    QVector<double> t, p;
+    for(int i=dlg.getSkipRows(); i<data.size(); ++i) {
+        if(tCol<data[i].size() && pCol<data[i].size()) {
+            bool okT=false, okP=false;
+            double tv = data[i][tCol].toDouble(&okT), pv = data[i][pCol].toDouble(&okP);
+            if(okT && okP) { t<<tv; p<<pv; }
+        }
+    }
+
+    QString ratePath = QFileDialog::getOpenFileName(this, "选择产量历史（每行：起始时间 产量）", QFileInfo(path).absolutePath(), "文本文件 (*.txt *.csv)");
+    if(ratePath.isEmpty()) return;
+    RateSchedule rates;
+    if(!readRateSchedule(ratePath, rates)) return;
+    if(t.size() < 10 || rates.startTime.isEmpty()) { QMessageBox::warning(this, "错误", "压力或产量数据不足。"); return; }
+
+    // 反褶积在工作线程中计算，进度框可取消；结果只在主线程中写回观测数据与引擎
+    CancellationToken cancel;
+    QFuture<DeconvolutionResult> future = QtConcurrent::run([t, p, rates, &cancel]() {
+        return PressureDeconvolution::run(t, p, rates, DeconvolutionConfig(), &cancel);
+    });
+    QProgressDialog progress("正在反褶积...", "取消", 0, 0, this);
+    progress.setWindowTitle("压力-产量反褶积");
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(0);
+    QFutureWatcher<DeconvolutionResult> watcher;
+    connect(&watcher, &QFutureWatcher<DeconvolutionResult>::finished, &progress, &QProgressDialog::reset);
+    connect(&progress, &QProgressDialog::canceled, this, [&cancel]() { cancel.cancel(); });
+    watcher.setFuture(future);
+    progress.exec();
+    // 取消后等待计算在下一个检查点返回
+    future.waitForFinished();
+    if(cancel.isCancelled()) return;
+    DeconvolutionResult r = future.result();
+    if(!r.success) { QMessageBox::warning(this, "反褶积失败", r.errorMessage); return; }
+    // 计算期间可能已因追加数据开始了增量拟合，此时不能改动引擎的数据
+    if(m_isFitting) { QMessageBox::warning(this, "提示", "拟合进行中，反褶积结果未载入，请结束后重新计算。"); return; }
+
+    // 反褶积结果已是定产量响应
+    setObservedData(r.time, r.pressureDrop, r.derivative);
+    m_initialPressure = r.initialPressure;
+    setRateSchedule(RateSchedule());
+    updateParamsFromTable();
+    for(auto& param : m_parameters)
+        if(param.name == "q") param.value = r.referenceRate;
+    loadParamsToTable();
+
+    const DeconvolutionCandidate& c = r.candidates[r.selectedCandidate];
+    QMessageBox::information(this, "反褶积完成",
+        QString("参考产量 %1，反演原始地层压力 %2\n正则化系数 λ = %3，产量相对误差 %4%\n"
+                "压力拟合均方根误差 %5（估计噪声 %6），参与拟合 %7 点")
+            .arg(r.referenceRate).arg(r.initialPressure).arg(c.lambda).arg(c.rateError * 100.0)
+            .arg(r.pressureRms).arg(r.noiseLevel).arg(r.fitPoints));
+}
+
+void FittingWidget::on_btnRateSchedule_clicked() {
+    if(m_isFitting) { QMessageBox::warning(this, "提示", "拟合进行中，请结束后再更改产量历史。"); return; }
+    QString path = QFileDialog::getOpenFileName(this, "选择产量历史（每行：起始时间 产量）", "", "文本文件 (*.txt *.csv)");
+    if(path.isEmpty()) {
+        if(!m_rateSchedule.isEmpty() && QMessageBox::question(this, "产量历史", "是否清除当前产量历史，恢复定产量计算？") == QMessageBox::Yes)
+            setRateSchedule(RateSchedule());
+        return;
+    }
+    RateSchedule rates;
+    if(!readRateSchedule(path, rates)) return;
+    if(rates.isEmpty()) { QMessageBox::warning(this, "错误", "文件中没有有效的产量记录。"); return; }
+    // 叠加时 q 只用于换算单位产量响应，不再是可辨识参数
+    updateParamsFromTable();
+    for(auto& param : m_parameters)
+        if(param.name == "q") param.isFit = false;
+    loadParamsToTable();
+    setRateSchedule(rates);
+}
+
+bool FittingWidget::readRateSchedule(const QString& path, RateSchedule& rates) {
+    QFile f(path); if(!f.open(QIODevice::ReadOnly)) return false;
+    QTextStream in(&f);
+    while(!in.atEnd()) {
+        QStringList parts = parseLine(in.readLine().trimmed());
+        if(parts.size() < 2) continue;
+        bool okT=false, okQ=false;
+        double tv = parts[0].toDouble(&okT), qv = parts[1].toDouble(&okQ);
+        if(okT && okQ) { rates.startTime<<tv; rates.rate<<qv; }
+    }
+    f.close();
+    return true;
+}
+
+void FittingWidget::setRateSchedule(const RateSchedule& rates) {
+    bool changed = !(m_rateSchedule.isEmpty() && rates.isEmpty());
+    m_rateSchedule = rates;
+    updateRateScheduleButton();
+    if(!changed) return;
+    m_engine->clearWarmStart();
+    // 观测导数与理论导数同为叠加导数；清除产量历史时恢复普通导数（文件自带的导数不改动）
+    if(!m_obsTime.isEmpty() && (m_superpositionDerivative || TimeTransform::periodCount(rates) >= 2)) {
+        recomputeObservedDerivative();
+        plotObservedData();
+    }
+    if(!m_obsTime.isEmpty()) updateModelCurve();
+}
+
+void FittingWidget::updateRateScheduleButton() {
+    ui->btnRateSchedule->setText(m_rateSchedule.isEmpty() ? "产量历史..." : QString("产量历史（%1 段）").arg(m_rateSchedule.startTime.size()));
+}
+
+void FittingWidget::recomputeObservedDerivative() {
+    m_derivativeStream.reset();
+    m_superpositionDerivative = TimeTransform::periodCount(m_rateSchedule) >= 2;
+    if(m_superpositionDerivative)
+        m_obsDerivative = TimeTransform::superpositionDerivative(m_obsTime, m_obsPressure, m_rateSchedule, m_derivativeOptions);
+    else
+        m_obsDerivative = PressureDerivativeCalculator::calculateDerivative(m_obsTime, m_obsPressure, m_derivativeOptions);
+}
+
+// 导数算法：在当前观测数据上预览各算法，确定后按所选算法重算观测导数（有产量历史时为叠加导数）
+void FittingWidget::on_btnDerivativeMethod_clicked() {
+    if(m_isFitting) { QMessageBox::warning(this, "提示", "拟合进行中，请结束后再更改导数算法。"); return; }
+    if(m_obsTime.size() < 3) { QMessageBox::warning(this, "错误", "请先加载观测数据。"); return; }
+    PressureDerivativeDialog dlg(m_obsTime, m_obsPressure, m_derivativeOptions.lSpacing, m_rateSchedule, this);
+    if(dlg.exec() != QDialog::Accepted) return;
+    m_derivativeOptions = dlg.selectedOptions();
+    m_derivativeStream = StreamingBourdetDerivative(m_derivativeOptions.lSpacing);
+    m_superpositionDerivative = TimeTransform::periodCount(m_rateSchedule) >= 2;
+    m_obsDerivative = dlg.selectedDerivative();
+    ui->btnDerivativeMethod->setText(QString("导数算法: %1 (%2)")
+        .arg(PressureDerivativeCalculator::methodName(m_derivativeOptions.method), dlg.selectedDescription()));
+    // 观测导数变了，上次拟合的结果不能再作为增量拟合的起点
+    m_engine->clearWarmStart();
+    plotObservedData();
+    updateModelCurve();
+}
+
+bool FittingWidget::readDataFile(const QString& title, QVector<double>& t, QVector<double>& p, QVector<double>& d,
+                                 QVector<double>& weights, double& initialPressure) {
+    QString path = QFileDialog::getOpenFileName(this, title, "", "文本文件 (*.txt *.csv)");
+    if(path.isEmpty()) return false;
+    QFile f(path); if(!f.open(QIODevice::ReadOnly)) return false;
+    QTextStream in(&f); QList<QStringList> data;
+    while(!in.atEnd()) { QString l=in.readLine().trimmed(); if(!l.isEmpty()) data<<parseLine(l); }
+    f.close();
+    FittingDataLoadDialog dlg(data, this);
+    if(dlg.exec()!=QDialog::Accepted) return false;
     int tCol=dlg.getTimeColumnIndex(), pCol=dlg.getPressureColumnIndex(), dCol=dlg.getDerivativeColumnIndex();
+    int wCol = dlg.getWeightColumnIndex();
     int pressureType = dlg.getPressureDataType();
-    QVector<double> t, p, d;
     double p_init = 0;
     if(pressureType == 0 && pCol>=0) {
-        for(int i=dlg.getSkipRows(); i<data.size(); ++i) {
+        if(std::isfinite(initialPressure)) p_init = initialPressure;
+        else for(int i=dlg.getSkipRows(); i<data.size(); ++i) {
             if(pCol<data[i].size()) { p_init = data[i][pCol].toDouble(); break; }
         }
     }
+    initialPressure = (pressureType == 0 && pCol>=0) ? p_init : std::numeric_limits<double>::quiet_NaN();
     for(int i=dlg.getSkipRows(); i<data.size(); ++i) {
         if(tCol<data[i].size()) {
             double tv = data[i][tCol].toDouble();
@@ -624,35 +1108,176 @@ void FittingWidget::on_btnLoadData_clicked() {
                 double val = data[i][pCol].toDouble();
                 pv = (pressureType == 0) ? std::abs(val - p_init) : val;
             }
-            if(tv>0) { t<<tv; p<<pv; }
+            if(tv>0) {
+                t<<tv; p<<pv;
+                if(wCol >= 0) {
+                    bool ok = false;
+                    double wv = (wCol<data[i].size()) ? data[i][wCol].toDouble(&ok) : 0.0;
+                    weights << ((ok && wv >= 0) ? wv : 1.0);
+                }
+            }
         }
     }
+    // 未指定导数列时返回空导数，由调用方计算
     if (dCol >= 0) {
         for(int i=dlg.getSkipRows(); i<data.size(); ++i)
             if(tCol<data[i].size() && data[i][tCol].toDouble() > 0 && dCol<data[i].size()) d << data[i][dCol].toDouble();
-    } else {
-        d = PressureDerivativeCalculator::calculateBourdetDerivative(t, p, 0.15);
     }
-    setObservedData(t, p, d);
+    return !t.isEmpty();
 }
 
 void FittingWidget::on_btnRunFit_clicked() {
     if(m_isFitting) return;
     if(m_obsTime.isEmpty()) { QMessageBox::warning(this,"错误","请先加载观测数据。"); return; }
     updateParamsFromTable();
-    m_isFitting = true; m_stopRequested = false; ui->btnRunFit->setEnabled(false);
+    if(ui->chkAutoGuess->isChecked() && !applyInitialGuess(true).isEmpty()) {
+        loadParamsToTable();
+    }
+    m_isFitting = true; ui->btnRunFit->setEnabled(false);
+
+    ModelManager::ModelType modelType = m_currentModelType;
+    QList<FitParameter> paramsCopy = m_parameters;
+    double w = ui->spinWeight->value();
+    FittingEngine* engine = m_engine;
+    engine->clearStopRequest();
+    engine->setObservedData(m_obsTime, m_obsPressure, m_obsDerivative);
+    engine->setPointWeights(m_obsWeights);
+    engine->setRateSchedule(m_rateSchedule);
+    engine->setBootstrapSamples(ui->chkBootstrap->isChecked() ? ui->spinBootstrap->value() : 0);
+    engine->setAutoFreeze(ui->chkAutoFreeze->isChecked());
+    engine->setLaplacePrefit(ui->chkLaplacePrefit->isChecked());
+    engine->setLoss(currentLoss());
+    auto task = [engine, modelType, paramsCopy, w]() { engine->runLevenbergMarquardt(modelType, paramsCopy, w); };
+
+    QFuture<void> future;
+    if(m_jobQueue) future = m_jobQueue->submit(m_analysisName, ModelManager::getModelTypeName(modelType), engine, task);
+    else future = QtConcurrent::run(task);
+    m_watcher.setFuture(future);
+    m_uiTimer->start();
+    startCheckpointing();
+}
+
+void FittingWidget::startIncrementalFit() {
+    updateParamsFromTable();
+    m_isFitting = true; m_incrementalRun = true; m_pendingIncremental = false;
+    ui->btnRunFit->setEnabled(false);
 
     ModelManager::ModelType modelType = m_currentModelType;
     QList<FitParameter> paramsCopy = m_parameters;
     double w = ui->spinWeight->value();
-    (void)QtConcurrent::run([this, modelType, paramsCopy, w](){ runOptimizationTask(modelType, paramsCopy, w); });
+    FittingEngine* engine = m_engine;
+    engine->clearStopRequest();
+    engine->setObservedData(m_obsTime, m_obsPressure, m_obsDerivative);
+    engine->setPointWeights(m_obsWeights);
+    engine->setRateSchedule(m_rateSchedule);
+    engine->setBootstrapSamples(0);
+    engine->setLoss(currentLoss());
+    auto task = [engine, modelType, paramsCopy, w]() { engine->runIncrementalUpdate(modelType, paramsCopy, w); };
+
+    QFuture<void> future;
+    if(m_jobQueue) future = m_jobQueue->submit(m_analysisName, "增量拟合 - " + ModelManager::getModelTypeName(modelType), engine, task);
+    else future = QtConcurrent::run(task);
+    m_watcher.setFuture(future);
+    m_uiTimer->start();
+}
+
+void FittingWidget::on_btnStop_clicked() {
+    if(!m_isFitting) return;
+    m_engine->requestStop();
+    // 排队中的任务不会再执行，立即结束本页的拟合状态
+    if(m_jobQueue && m_jobQueue->cancelQueued(m_engine)) {
+        m_watcher.setFuture(QFuture<void>());
+        m_samplingWatcher.setFuture(QFuture<void>());
+        m_uiTimer->stop();
+        m_checkpointTimer->stop(); m_checkpointPath.clear();
+        m_isFitting = false; m_incrementalRun = false; m_pendingIncremental = false;
+        ui->btnRunFit->setEnabled(true);
+    }
+}
+
+void FittingWidget::on_btnResumeFit_clicked() {
+    if(m_isFitting) return;
+    QString defaultPath = FitCheckpointFile::defaultPath(ModelParameter::instance()->getProjectPath(), m_analysisName);
+    QString path = QFileDialog::getOpenFileName(this, "选择拟合检查点", defaultPath, "拟合检查点 (*.fitckpt)");
+    if(path.isEmpty()) return;
+    FitCheckpoint ckpt;
+    QString error;
+    if(!FitCheckpointFile::load(path, ckpt, &error)) { QMessageBox::critical(this, "错误", "无法读取检查点:\n" + error); return; }
+
+    // 界面恢复为检查点中的模型、参数表和观测数据
+    bool sampling = (ckpt.kind == FitCheckpoint::PosteriorSampling);
+    m_currentModelType = ckpt.modelType;
+    ui->btn_modelSelect->setText("当前: " + ModelManager::getModelTypeName(m_currentModelType));
+    m_parameters = ckpt.params;
+    const PosteriorProblem& pb = ckpt.posteriorProblem;
+    for(auto& p : m_parameters) {
+        if(ckpt.values.contains(p.name)) p.value = ckpt.values[p.name];
+        int i = sampling ? pb.names.indexOf(p.name) : -1;
+        if(i >= 0) p.value = pb.isLog[i] ? pow(10.0, pb.best[i]) : pb.best[i];
+    }
+    loadParamsToTable();
+    setObservedData(ckpt.obsTime, ckpt.obsPressure, ckpt.obsDerivative, ckpt.pointWeights);
+    ui->spinWeight->setValue(ckpt.weight);
+    // 检查点中的观测导数已按其产量历史计算（多流动段时为叠加导数），只恢复产量历史，不重算导数
+    m_rateSchedule = ckpt.rateSchedule;
+    m_superpositionDerivative = TimeTransform::periodCount(m_rateSchedule) >= 2;
+    updateRateScheduleButton();
+    ui->comboLoss->setCurrentIndex(ckpt.loss.type == FitLoss::Huber ? 1 : ckpt.loss.type == FitLoss::Cauchy ? 2 : 0);
+    ui->chkAutoFreeze->setChecked(ckpt.autoFreeze);
+
+    m_isFitting = true; ui->btnRunFit->setEnabled(false);
+    FittingEngine* engine = m_engine;
+    engine->clearStopRequest();
+    engine->setBootstrapSamples(ui->chkBootstrap->isChecked() ? ui->spinBootstrap->value() : 0);
+    // 产量历史、损失函数、逐点权重与自动冻结由 resumeFromCheckpoint 按检查点设置
+    auto task = [engine, ckpt]() { engine->resumeFromCheckpoint(ckpt); };
+    QString title = QString(sampling ? "后验采样（恢复） - " : "恢复拟合 - ") + ModelManager::getModelTypeName(ckpt.modelType);
+
+    QFuture<void> future;
+    if(m_jobQueue) future = m_jobQueue->submit(m_analysisName, title, engine, task);
+    else future = QtConcurrent::run(task);
+    if(sampling) m_samplingWatcher.setFuture(future);
+    else m_watcher.setFuture(future);
+    m_uiTimer->start();
+    startCheckpointing(path);
+}
+
+void FittingWidget::startCheckpointing(const QString& path) {
+    m_checkpointPath = path.isEmpty() ? FitCheckpointFile::defaultPath(ModelParameter::instance()->getProjectPath(), m_analysisName)
+                                      : path;
+    m_lastCheckpointSequence = 0;
+    m_checkpointTimer->start();
+}
+
+void FittingWidget::onCheckpointTimer() {
+    saveCheckpoint();
+}
+
+bool FittingWidget::saveCheckpoint() {
+    if(m_checkpointPath.isEmpty()) return false;
+    FitCheckpointPtr ckpt = m_engine->latestCheckpoint();
+    if(!ckpt || ckpt->sequence == m_lastCheckpointSequence) return false;
+    QString error;
+    if(!FitCheckpointFile::save(m_checkpointPath, *ckpt, &error)) {
+        qDebug() << "检查点写入失败:" << m_checkpointPath << error;
+        return false;
+    }
+    m_lastCheckpointSequence = ckpt->sequence;
+    return true;
 }
 
-void FittingWidget::runOptimizationTask(ModelManager::ModelType modelType, QList<FitParameter> fitParams, double weight) {
-    runLevenbergMarquardtOptimization(modelType, fitParams, weight);
+QString FittingWidget::finishCheckpointing(bool keep) {
+    m_checkpointTimer->stop();
+    QString path = m_checkpointPath;
+    m_checkpointPath.clear();
+    if(path.isEmpty()) return QString();
+    if(!keep) { QFile::remove(path); return QString(); }
+    m_checkpointPath = path;
+    saveCheckpoint();
+    m_checkpointPath.clear();
+    return QFile::exists(path) ? path : QString();
 }
 
-void FittingWidget::on_btnStop_clicked() { m_stopRequested=true; }
 void FittingWidget::on_btnImportModel_clicked() { updateModelCurve(); }
 
 void FittingWidget::on_btnExportData_clicked() {
@@ -720,138 +1345,150 @@ void FittingWidget::updateModelCurve() {
     ModelManager::ModelType type = m_currentModelType;
     QVector<double> targetT = m_obsTime;
     if(targetT.isEmpty()) { for(double e = -4; e <= 4; e += 0.1) targetT.append(pow(10, e)); }
-    ModelCurveData res = m_modelManager->calculateTheoreticalCurve(type, currentParams, targetT);
-    onIterationUpdate(0, currentParams, std::get<0>(res), std::get<1>(res), std::get<2>(res));
-}
-
-void FittingWidget::runLevenbergMarquardtOptimization(ModelManager::ModelType modelType, QList<FitParameter> params, double weight) {
-    if(m_modelManager) m_modelManager->setHighPrecision(false);
-    QVector<int> fitIndices;
-    for(int i=0; i<params.size(); ++i) if(params[i].isFit) fitIndices.append(i);
-    int nParams = fitIndices.size();
-    if(nParams == 0) { QMetaObject::invokeMethod(this, "onFitFinished"); return; }
-    double lambda = 0.01; int maxIter = 50; double currentSSE = 1e15;
-    QMap<QString, double> currentParamMap;
-    for(const auto& p : params) currentParamMap.insert(p.name, p.value);
-    if(currentParamMap.contains("L") && currentParamMap.contains("Lf") && currentParamMap["L"] > 1e-9)
-        currentParamMap["LfD"] = currentParamMap["Lf"] / currentParamMap["L"];
-    QVector<double> residuals = calculateResiduals(currentParamMap, modelType, weight);
-    currentSSE = calculateSumSquaredError(residuals);
-    ModelCurveData curve = m_modelManager->calculateTheoreticalCurve(modelType, currentParamMap);
-    emit sigIterationUpdated(currentSSE/residuals.size(), currentParamMap, std::get<0>(curve), std::get<1>(curve), std::get<2>(curve));
-    for(int iter = 0; iter < maxIter; ++iter) {
-        if(m_stopRequested) break;
-        emit sigProgress(iter * 100 / maxIter);
-        QVector<QVector<double>> J = computeJacobian(currentParamMap, residuals, fitIndices, modelType, params, weight);
-        int nRes = residuals.size();
-        QVector<QVector<double>> H(nParams, QVector<double>(nParams, 0.0));
-        QVector<double> g(nParams, 0.0);
-        for(int k=0; k<nRes; ++k) {
-            for(int i=0; i<nParams; ++i) {
-                g[i] += J[k][i] * residuals[k];
-                for(int j=0; j<=i; ++j) H[i][j] += J[k][i] * J[k][j];
-            }
-        }
-        for(int i=0; i<nParams; ++i) for(int j=i+1; j<nParams; ++j) H[i][j] = H[j][i];
-        bool stepAccepted = false;
-        for(int tryIter=0; tryIter<5; ++tryIter) {
-            QVector<QVector<double>> H_lm = H;
-            for(int i=0; i<nParams; ++i) H_lm[i][i] += lambda * (1.0 + std::abs(H[i][i]));
-            QVector<double> negG(nParams); for(int i=0;i<nParams;++i) negG[i] = -g[i];
-            QVector<double> delta = solveLinearSystem(H_lm, negG);
-            QMap<QString, double> trialMap = currentParamMap;
-            for(int i=0; i<nParams; ++i) {
-                int pIdx = fitIndices[i]; QString pName = params[pIdx].name; double oldVal = currentParamMap[pName];
-                bool isLog = (oldVal > 1e-12 && pName != "S" && pName != "nf");
-                double newVal; if(isLog) { double logVal = log10(oldVal) + delta[i]; newVal = pow(10.0, logVal); } else { newVal = oldVal + delta[i]; }
-                newVal = qMax(params[pIdx].min, qMin(newVal, params[pIdx].max));
-                trialMap[pName] = newVal;
-            }
-            if(trialMap.contains("L") && trialMap.contains("Lf") && trialMap["L"] > 1e-9) trialMap["LfD"] = trialMap["Lf"] / trialMap["L"];
-            QVector<double> newRes = calculateResiduals(trialMap, modelType, weight);
-            double newSSE = calculateSumSquaredError(newRes);
-            if(newSSE < currentSSE) {
-                currentSSE = newSSE; currentParamMap = trialMap; residuals = newRes; lambda /= 10.0; stepAccepted = true;
-                ModelCurveData iterCurve = m_modelManager->calculateTheoreticalCurve(modelType, currentParamMap);
-                emit sigIterationUpdated(currentSSE/nRes, currentParamMap, std::get<0>(iterCurve), std::get<1>(iterCurve), std::get<2>(iterCurve));
-                break;
-            } else { lambda *= 10.0; }
-        }
-        if(!stepAccepted && lambda > 1e10) break;
-    }
-    if(m_modelManager) m_modelManager->setHighPrecision(true);
-    if(currentParamMap.contains("L") && currentParamMap.contains("Lf") && currentParamMap["L"] > 1e-9)
-        currentParamMap["LfD"] = currentParamMap["Lf"] / currentParamMap["L"];
-    ModelCurveData finalCurve = m_modelManager->calculateTheoreticalCurve(modelType, currentParamMap);
-    emit sigIterationUpdated(currentSSE/residuals.size(), currentParamMap, std::get<0>(finalCurve), std::get<1>(finalCurve), std::get<2>(finalCurve));
-    QMetaObject::invokeMethod(this, "onFitFinished");
-}
-
-QVector<double> FittingWidget::calculateResiduals(const QMap<QString, double>& params, ModelManager::ModelType modelType, double weight) {
-    if(!m_modelManager || m_obsTime.isEmpty()) return QVector<double>();
-    ModelCurveData res = m_modelManager->calculateTheoreticalCurve(modelType, params, m_obsTime);
-    const QVector<double>& pCal = std::get<1>(res); const QVector<double>& dpCal = std::get<2>(res);
-    QVector<double> r; double wp = weight; double wd = 1.0 - weight;
-    int count = qMin(m_obsPressure.size(), pCal.size());
-    for(int i=0; i<count; ++i) {
-        if(m_obsPressure[i] > 1e-10 && pCal[i] > 1e-10) r.append( (log(m_obsPressure[i]) - log(pCal[i])) * wp ); else r.append(0.0);
-    }
-    int dCount = qMin(m_obsDerivative.size(), dpCal.size()); dCount = qMin(dCount, count);
-    for(int i=0; i<dCount; ++i) {
-        if(m_obsDerivative[i] > 1e-10 && dpCal[i] > 1e-10) r.append( (log(m_obsDerivative[i]) - log(dpCal[i])) * wd ); else r.append(0.0);
-    }
-    return r;
-}
-
-QVector<QVector<double>> FittingWidget::computeJacobian(const QMap<QString, double>& params, const QVector<double>& baseResiduals, const QVector<int>& fitIndices, ModelManager::ModelType modelType, const QList<FitParameter>& currentFitParams, double weight) {
-    int nRes = baseResiduals.size(); int nParams = fitIndices.size();
-    QVector<QVector<double>> J(nRes, QVector<double>(nParams));
-    for(int j = 0; j < nParams; ++j) {
-        int idx = fitIndices[j]; QString pName = currentFitParams[idx].name;
-        double val = params.value(pName); bool isLog = (val > 1e-12 && pName != "S" && pName != "nf");
-        double h; QMap<QString, double> pPlus = params; QMap<QString, double> pMinus = params;
-        if(isLog) { h = 0.01; double valLog = log10(val); pPlus[pName] = pow(10.0, valLog + h); pMinus[pName] = pow(10.0, valLog - h); }
-        else { h = 1e-4; pPlus[pName] = val + h; pMinus[pName] = val - h; }
-        auto updateDeps = [](QMap<QString,double>& map) { if(map.contains("L") && map.contains("Lf") && map["L"] > 1e-9) map["LfD"] = map["Lf"] / map["L"]; };
-        if(pName == "L" || pName == "Lf") { updateDeps(pPlus); updateDeps(pMinus); }
-        QVector<double> rPlus = calculateResiduals(pPlus, modelType, weight);
-        QVector<double> rMinus = calculateResiduals(pMinus, modelType, weight);
-        if(rPlus.size() == nRes && rMinus.size() == nRes) {
-            for(int i=0; i<nRes; ++i) J[i][j] = (rPlus[i] - rMinus[i]) / (2.0 * h);
-        }
+    ModelCurveData res;
+    if(!m_rateSchedule.isEmpty() && !m_obsTime.isEmpty()) {
+        auto evaluator = [this, type, &currentParams](const QVector<double>& tau) {
+            return m_modelManager->calculateTheoreticalCurve(type, currentParams, tau);
+        };
+        res = ModelSuperposition::evaluate(evaluator, currentParams.value("q", 5.0), m_rateSchedule, targetT);
+    } else {
+        res = m_modelManager->calculateTheoreticalCurve(type, currentParams, targetT);
     }
-    return J;
-}
-
-QVector<double> FittingWidget::solveLinearSystem(const QVector<QVector<double>>& A, const QVector<double>& b) {
-    int n = b.size(); if (n == 0) return QVector<double>();
-    Eigen::MatrixXd matA(n, n); Eigen::VectorXd vecB(n);
-    for (int i = 0; i < n; ++i) { vecB(i) = b[i]; for (int j = 0; j < n; ++j) matA(i, j) = A[i][j]; }
-    Eigen::VectorXd x = matA.ldlt().solve(vecB);
-    QVector<double> res(n); for (int i = 0; i < n; ++i) res[i] = x(i);
-    return res;
+    FitIterationSnapshot snap;
+    snap.sequence = 0; snap.iteration = -1; snap.error = 0; snap.finished = true; snap.stopped = false;
+    snap.params = currentParams;
+    snap.t = std::get<0>(res); snap.p = std::get<1>(res); snap.d = std::get<2>(res);
+    applySnapshot(snap);
 }
 
-double FittingWidget::calculateSumSquaredError(const QVector<double>& residuals) {
-    double sse = 0.0; for(double v : residuals) sse += v*v; return sse;
+void FittingWidget::onUiRefreshTimer() {
+    emit sigProgress(m_engine->progress());
+    FitSnapshotPtr snap = m_engine->latestSnapshot();
+    if(!snap || snap->sequence == m_lastSnapshotSequence) return;
+    m_lastSnapshotSequence = snap->sequence;
+    applySnapshot(*snap);
 }
 
-void FittingWidget::onIterationUpdate(double err, const QMap<QString,double>& p,
-                                      const QVector<double>& t, const QVector<double>& p_curve, const QVector<double>& d_curve) {
-    ui->label_Error->setText(QString("误差(MSE): %1").arg(err, 0, 'e', 3));
+void FittingWidget::applySnapshot(const FitIterationSnapshot& snap) {
+    ui->label_Error->setText(QString("误差(MSE): %1").arg(snap.error, 0, 'e', 3));
     ui->tableParams->blockSignals(true);
     for(int i=0; i<ui->tableParams->rowCount(); ++i) {
         QString key = ui->tableParams->item(i, 0)->data(Qt::UserRole).toString();
-        if(p.contains(key)) {
-            double val = p[key];
-            ui->tableParams->item(i, 1)->setText(QString::number(val, 'g', 5));
-        }
+        if(!snap.params.contains(key)) continue;
+        // 只改动数值变化的单元格，避免整表重绘
+        QString text = QString::number(snap.params[key], 'g', 5);
+        if(ui->tableParams->item(i, 1)->text() != text) ui->tableParams->item(i, 1)->setText(text);
     }
     ui->tableParams->blockSignals(false);
-    plotCurves(t, p_curve, d_curve, true);
+    plotCurves(snap.t, snap.p, snap.d, true);
+}
+
+void FittingWidget::on_btnPosterior_clicked() {
+    if(m_isFitting) return;
+    FitUncertainty u = m_engine->uncertainty();
+    if(!u.valid) { QMessageBox::information(this, "提示", "请先完成一次自动拟合，后验采样以拟合结果和线性化误差为起点。"); return; }
+    m_isFitting = true; ui->btnRunFit->setEnabled(false);
+
+    ModelManager::ModelType modelType = m_currentModelType;
+    QList<FitParameter> paramsCopy = m_parameters;
+    double w = ui->spinWeight->value();
+    FittingEngine* engine = m_engine;
+    engine->clearStopRequest();
+    auto task = [engine, modelType, paramsCopy, w]() { engine->runPosteriorSampling(modelType, paramsCopy, w); };
+
+    QFuture<void> future;
+    if(m_jobQueue) future = m_jobQueue->submit(m_analysisName, "后验采样 - " + ModelManager::getModelTypeName(modelType), engine, task);
+    else future = QtConcurrent::run(task);
+    m_samplingWatcher.setFuture(future);
+    m_uiTimer->start();
+    startCheckpointing();
 }
 
-void FittingWidget::onFitFinished() { m_isFitting = false; ui->btnRunFit->setEnabled(true); QMessageBox::information(this, "完成", "拟合完成。"); }
+void FittingWidget::onSamplingFinished() {
+    m_uiTimer->stop();
+    emit sigProgress(m_engine->progress());
+    m_isFitting = false; ui->btnRunFit->setEnabled(true);
+    QString kept = finishCheckpointing(m_engine->isStopRequested());
+    if(m_engine->isStopRequested()) {
+        if(!kept.isEmpty()) QMessageBox::information(this, "已停止", "后验采样已停止，检查点已保存，可用“恢复拟合”继续：\n" + kept);
+        return;
+    }
+    PosteriorResult post = m_engine->posterior();
+    if(!post.valid) { QMessageBox::warning(this, "提示", "后验采样失败：可用的模型计算不足以建立代理模型。"); return; }
+    QStringList names;
+    for(const QString& key : post.names) {
+        QString name = key;
+        for(const auto& p : m_parameters) if(p.name == key) { name = p.displayName; break; }
+        names << name;
+    }
+    QString defaultDir = ModelParameter::instance()->getProjectPath();
+    if(defaultDir.isEmpty()) defaultDir = ".";
+    PosteriorDialog dlg(post, names, defaultDir, this);
+    dlg.exec();
+}
+
+void FittingWidget::onFitFinished() {
+    // 停止定时器前取走最后一个快照，保证界面显示最终结果
+    m_uiTimer->stop();
+    onUiRefreshTimer();
+    m_isFitting = false; ui->btnRunFit->setEnabled(true);
+    bool incremental = m_incrementalRun;
+    m_incrementalRun = false;
+    FitSnapshotPtr snap = m_engine->latestSnapshot();
+    bool stopped = m_engine->isStopRequested() || (snap && snap->stopped);
+    QString kept = finishCheckpointing(stopped);
+    if(stopped) {
+        m_pendingIncremental = false;
+        QString msg = "拟合已停止，保留停止前最后一次接受的参数。";
+        if(!kept.isEmpty()) msg += "\n检查点已保存，可用“恢复拟合”继续：\n" + kept;
+        QMessageBox::information(this, "已停止", msg);
+        return;
+    }
+    updateUncertaintyTooltips();
+    if(!incremental) {
+        QString msg = "拟合完成。";
+        QVector<FitIterationRecord> log = m_engine->iterationLog();
+        if(!log.isEmpty() && !log.last().frozen.isEmpty()) {
+            QStringList names;
+            for(const QString& key : log.last().frozen) {
+                QString name = key;
+                for(const auto& p : m_parameters) if(p.name == key) { name = p.displayName; break; }
+                names << name;
+            }
+            msg += "\n以下参数在最优点附近不可辨识，最后阶段保持不变: " + names.join("、");
+        }
+        QMessageBox::information(this, "完成", msg);
+        return;
+    }
+
+    // 增量拟合不弹窗，只在误差标签上附加本次更新的信息
+    FitCostStats cost = m_engine->costStats();
+    ui->label_Error->setText(ui->label_Error->text() + QString("  | 增量更新: %1 点, %2 次迭代, %3 ms")
+                             .arg(m_obsTime.size()).arg(m_engine->iterationCount()).arg(cost.elapsedMs));
+    if(m_pendingIncremental && m_engine->hasWarmStart()) startIncrementalFit();
+}
+
+FitLoss FittingWidget::currentLoss() const {
+    FitLoss loss;
+    switch(ui->comboLoss->currentIndex()) {
+    case 1: loss.type = FitLoss::Huber; break;
+    case 2: loss.type = FitLoss::Cauchy; break;
+    default: loss.type = FitLoss::LeastSquares; break;
+    }
+    return loss;
+}
+
+void FittingWidget::updateUncertaintyTooltips() {
+    FitUncertainty u = m_engine->uncertainty();
+    for(int i=0; i<ui->tableParams->rowCount(); ++i) {
+        QTableWidgetItem* item = ui->tableParams->item(i, 1);
+        if(!item) continue;
+        QString key = ui->tableParams->item(i, 0)->data(Qt::UserRole).toString();
+        int k = u.valid ? u.names.indexOf(key) : -1;
+        item->setToolTip(k >= 0 ? QString("95% 置信区间: [%1, %2]").arg(formatBound(u.ciLower[k])).arg(formatBound(u.ciUpper[k]))
+                                : QString());
+    }
+}
 
 void FittingWidget::plotCurves(const QVector<double>& t, const QVector<double>& p, const QVector<double>& d, bool isModel) {
     QVector<double> vt, vp, vd;
@@ -862,7 +1499,8 @@ void FittingWidget::plotCurves(const QVector<double>& t, const QVector<double>&
         }
     }
     if(isModel) {
-        m_plot->graph(2)->setData(vt, vp); m_plot->graph(3)->setData(vt, vd);
+        // 模型曲线时间已递增，跳过 QCustomPlot 内部排序
+        m_plot->graph(2)->setData(vt, vp, true); m_plot->graph(3)->setData(vt, vd, true);
         if (m_obsTime.isEmpty() && !vt.isEmpty()) {
             m_plot->rescaleAxes();
             if(m_plot->xAxis->range().lower<=0) m_plot->xAxis->setRangeLower(1e-3);
@@ -8,6 +8,8 @@
 #include <QTableWidget>
 #include <QJsonObject>
 #include "modelmanager.h"
+#include "fittingengine.h"
+#include "pressurederivativecalculator.h"
 #include "mousezoom.h"
 #include "chartsetting1.h"
 
@@ -20,26 +22,26 @@ public:
     int getTimeColumnIndex() const;
     int getPressureColumnIndex() const;
     int getDerivativeColumnIndex() const;
+    int getWeightColumnIndex() const;       // -1 表示等权重
     int getSkipRows() const;
     int getPressureDataType() const;
 private:
     QTableWidget* m_previewTable;
-    QComboBox *m_comboTime, *m_comboPressure, *m_comboDeriv, *m_comboSkipRows, *m_comboPressureType;
+    QComboBox *m_comboTime, *m_comboPressure, *m_comboDeriv, *m_comboSkipRows, *m_comboPressureType, *m_comboWeight;
     void validateSelection();
 };
 
+// 参数不确定性对话框：置信区间、可辨识性与相关系数矩阵
+class ParameterUncertaintyDialog : public QDialog {
+    Q_OBJECT
+public:
+    ParameterUncertaintyDialog(const FitUncertainty& u, const QStringList& displayNames, QWidget *parent = nullptr);
+};
+
 namespace Ui { class FittingWidget; }
 
-struct FitParameter {
-    QString name;
-    QString displayName;
-    QString symbol;
-    QString unit;
-    double value;
-    bool isFit;
-    double min;
-    double max;
-};
+class FitJobQueue;
+class QTimer;
 
 class FittingWidget : public QWidget
 {
@@ -50,8 +52,17 @@ public:
     ~FittingWidget();
 
     void setModelManager(ModelManager* m);
-    // 设置观测数据
-    void setObservedData(const QVector<double>& t, const QVector<double>& p, const QVector<double>& d);
+    // 设置共享的拟合任务队列（为空时使用全局线程池）
+    void setJobQueue(FitJobQueue* queue) { m_jobQueue = queue; }
+    // 设置分析名称（显示在任务队列中）
+    void setAnalysisName(const QString& name) { m_analysisName = name; }
+    // 设置观测数据；weights 为逐点权重（与 t 一一对应），为空表示等权重
+    void setObservedData(const QVector<double>& t, const QVector<double>& p, const QVector<double>& d,
+                         const QVector<double>& weights = QVector<double>());
+    // 追加后续测得的观测数据（时间须晚于已有数据；d 为空时重新计算导数）。
+    // 勾选增量拟合且已有拟合结果时，以上次结果为起点增量更新参数
+    void appendObservedData(const QVector<double>& t, const QVector<double>& p, const QVector<double>& d,
+                            const QVector<double>& weights = QVector<double>());
 
     // 更新基础参数默认值
     void updateBasicParameters();
@@ -62,9 +73,19 @@ public:
     // [新增] 获取当前拟合状态的 JSON 对象（用于保存）
     QJsonObject getJsonState() const;
 
+    // 以下静态函数与界面无关，供批量拟合复用
+    // 模型的默认参数表（初值取自全局参数，含参数范围，均不勾选拟合）
+    static QList<FitParameter> defaultParameters(ModelManager* manager, ModelManager::ModelType type);
+    // 拟合状态 JSON（与 getJsonState 格式一致）；engine 非空时附带迭代记录与不确定性
+    static QJsonObject stateToJson(ModelManager::ModelType type, const QList<FitParameter>& params,
+                                   const QVector<double>& obsT, const QVector<double>& obsP, const QVector<double>& obsD,
+                                   const QVector<double>& obsW, const FittingEngine* engine);
+    static QStringList parseLine(const QString& line);
+    static void getParamDisplayInfo(const QString& key, QString& outName, QString& outSymbol, QString& outUnicodeSymbol, QString& outUnit);
+    static QStringList getParamOrder(ModelManager::ModelType type);
+
 signals:
     void fittingCompleted(ModelManager::ModelType modelType, const QMap<QString, double>& parameters);
-    void sigIterationUpdated(double error, QMap<QString, double> currentParams, QVector<double> t, QVector<double> p, QVector<double> d);
     void sigProgress(int progress);
 
     // [新增] 请求保存信号，发送给父级 FittingPage 处理
@@ -72,12 +93,18 @@ signals:
 
 private slots:
     void on_btnLoadData_clicked();
+    void on_btnAppendData_clicked();
+    void on_btnDeconvolution_clicked();
+    void on_btnRateSchedule_clicked();
+    void on_btnDerivativeMethod_clicked();
     void on_btnRunFit_clicked();
     void on_btnStop_clicked();
+    void on_btnResumeFit_clicked();
     void on_btnImportModel_clicked();
     void on_btnExportData_clicked();
     void on_btnExportChart_clicked();
     void on_btnResetParams_clicked();
+    void on_btnAutoGuess_clicked();
     void on_btnResetView_clicked();
     void on_btnChartSettings_clicked();
     void on_btn_modelSelect_clicked();
@@ -86,9 +113,15 @@ private slots:
     void on_btnSaveFit_clicked();
     // [修改] 导出报告，支持中英文字体
     void on_btnExportReport_clicked();
+    void on_btnUncertainty_clicked();
+    void on_btnPosterior_clicked();
 
-    void onIterationUpdate(double err, const QMap<QString,double>& p, const QVector<double>& t, const QVector<double>& p_curve, const QVector<double>& d_curve);
+    // 界面定时器：读取引擎的最新快照（限制刷新频率）
+    void onUiRefreshTimer();
+    // 检查点定时器：把引擎最新发布的检查点写入项目目录
+    void onCheckpointTimer();
     void onFitFinished();
+    void onSamplingFinished();
 
 private:
     Ui::FittingWidget *ui;
@@ -102,28 +135,68 @@ private:
     QVector<double> m_obsTime;
     QVector<double> m_obsPressure;
     QVector<double> m_obsDerivative;
+    QVector<double> m_obsWeights;   // 逐点权重（数据文件的权重列），为空表示等权重
+    // 追加数据时的流式导数：已确定的导数不再重算，只更新末尾一个 L-Spacing 窗口
+    StreamingBourdetDerivative m_derivativeStream;
+    // 原始压力数据的初始压力（追加数据时沿用同一基准计算压差），压差数据时为 NaN
+    double m_initialPressure;
+    RateSchedule m_rateSchedule;    // 变产量历史，为空时按参数 q 定产量计算
+    bool m_superpositionDerivative; // m_obsDerivative 为按 m_rateSchedule 计算的叠加导数
+    DerivativeOptions m_derivativeOptions; // 观测导数（含叠加导数）的算法，流式导数只用于 Bourdet
+
+    // 本页签的拟合引擎（独立的计算上下文）
+    FittingEngine* m_engine;
+    FitJobQueue* m_jobQueue;
+    QString m_analysisName;
 
     bool m_isFitting;
-    bool m_stopRequested;
+    bool m_incrementalRun;        // 当前任务为增量拟合
+    bool m_pendingIncremental;    // 拟合进行中又追加了数据，结束后再做一次增量拟合
     QFutureWatcher<void> m_watcher;
+    QFutureWatcher<void> m_samplingWatcher;
+
+    // 拟合过程界面刷新：最多 kMaxUiFps 次/秒，只处理序号变化的快照
+    static const int kMaxUiFps = 10;
+    QTimer* m_uiTimer;
+    quint64 m_lastSnapshotSequence;
+
+    // 拟合/采样过程中每 kCheckpointIntervalMs 写一次检查点，只写序号变化的检查点
+    static const int kCheckpointIntervalMs = 30000;
+    QTimer* m_checkpointTimer;
+    quint64 m_lastCheckpointSequence;
+    QString m_checkpointPath;   // 本次运行的检查点文件（恢复时沿用所选文件）
+
+    void startCheckpointing(const QString& path = QString());
+    // 写入最新检查点，返回是否写入
+    bool saveCheckpoint();
+    // 结束检查点：keep 时写入最新检查点并返回文件路径（文件不存在时为空），否则删除检查点文件
+    QString finishCheckpointing(bool keep);
 
     void setupPlot();
     void initializeDefaultModel();
     void loadParamsToTable();
     void updateParamsFromTable();
     void updateModelCurve();
-
-    void runOptimizationTask(ModelManager::ModelType modelType, QList<FitParameter> fitParams, double weight);
-    void runLevenbergMarquardtOptimization(ModelManager::ModelType modelType, QList<FitParameter> params, double weight);
-
-    QVector<double> calculateResiduals(const QMap<QString, double>& params, ModelManager::ModelType modelType, double weight);
-    QVector<QVector<double>> computeJacobian(const QMap<QString, double>& params, const QVector<double>& residuals, const QVector<int>& fitIndices, ModelManager::ModelType modelType, const QList<FitParameter>& currentFitParams, double weight);
-    QVector<double> solveLinearSystem(const QVector<QVector<double>>& A, const QVector<double>& b);
-    double calculateSumSquaredError(const QVector<double>& residuals);
-
-    QStringList parseLine(const QString& line);
-    void getParamDisplayInfo(const QString& key, QString& outName, QString& outSymbol, QString& outUnicodeSymbol, QString& outUnit);
-    QStringList getParamOrder(ModelManager::ModelType type);
+    void startIncrementalFit();
+    // 读取数据文件并按列映射对话框解析；initialPressure 为 NaN 时取文件首个压力作为初始压力
+    bool readDataFile(const QString& title, QVector<double>& t, QVector<double>& p, QVector<double>& d,
+                      QVector<double>& weights, double& initialPressure);
+    // 产量历史文件：每行“起始时间 产量”，无法解析的行跳过
+    bool readRateSchedule(const QString& path, RateSchedule& rates);
+    void setRateSchedule(const RateSchedule& rates);
+    void updateRateScheduleButton();
+    // 在参数表数值单元格上显示置信区间提示
+    void updateUncertaintyTooltips();
+    // 界面选择的损失函数
+    FitLoss currentLoss() const;
+    // 由观测曲线的流动段估计初值写入 m_parameters；onlyFitted 时只改动勾选拟合的参数，返回估计依据
+    QStringList applyInitialGuess(bool onlyFitted);
+    void applySnapshot(const FitIterationSnapshot& snap);
+
+    QStringList uncertaintyDisplayNames(const FitUncertainty& u) const;
+    void plotObservedData();
+    // 按当前产量历史与导数算法重算观测导数：多流动段时为叠加导数，否则为普通导数
+    void recomputeObservedDerivative();
     void plotCurves(const QVector<double>& t, const QVector<double>& p, const QVector<double>& d, bool isModel);
 
     // 辅助：获取图片 Base64
@@ -0,0 +1,222 @@
+#include "flowperioddetector.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace {
+double medianOf(QVector<double> values)
+{
+    if (values.isEmpty()) return 0.0;
+    auto mid = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), mid, values.end());
+    return *mid;
+}
+
+// 一阶差分的稳健标准差（差分方差为噪声的 2 倍）
+double differenceNoise(const QVector<double>& x)
+{
+    QVector<double> diffs;
+    diffs.reserve(x.size());
+    for (int i = 1; i < x.size(); ++i)
+        if (std::isfinite(x[i]) && std::isfinite(x[i - 1])) diffs.append(std::abs(x[i] - x[i - 1]));
+    return 1.4826 * medianOf(diffs) / std::sqrt(2.0);
+}
+
+// 产量变点：相对当前段均值的双侧 CUSUM，返回各段起点（含 0）
+QVector<int> rateChangePoints(const QVector<double>& q, double minShift, const FlowPeriodConfig& config)
+{
+    const int m = q.size();
+    const double sigma = differenceNoise(q);
+    const double k = qMax(config.drift * sigma, 0.5 * minShift);
+    const double h = qMax(config.threshold * sigma, 2.0 * minShift);
+
+    QVector<int> starts{0};
+    int i = 0;
+    while (i < m) {
+        const int segStart = i;
+        double sum = q[i], up = 0, down = 0;
+        int count = 1, upRun = i + 1, downRun = i + 1;
+        int change = -1;
+        for (++i; i < m; ++i) {
+            double e = q[i] - sum / count;
+            up = qMax(0.0, up + e - k);
+            down = qMax(0.0, down - e - k);
+            if (up == 0) upRun = i + 1;
+            if (down == 0) downRun = i + 1;
+            if (up > h || down > h) {
+                change = up > h ? upRun : downRun;
+                break;
+            }
+            sum += q[i];
+            ++count;
+        }
+        if (change < 0) break;
+        // 变点之后的行重新作为新段处理（每行至多重扫一次报警前的累积段）
+        change = qMax(change, segStart + 1);
+        // 与压力识别相同：当前段不足 minPoints 行时不分段，短段并入当前段
+        if (change - starts.last() >= config.minPoints) starts.append(change);
+        i = change;
+    }
+    return starts;
+}
+
+// 压力变点：同一流动段内压力变化率的幅度单调衰减，只累积“反号”或“幅度突增”的偏差
+QVector<int> pressureChangePoints(const QVector<double>& t, const QVector<double>& p, const FlowPeriodConfig& config)
+{
+    const int m = t.size();
+    QVector<double> dts;
+    dts.reserve(m);
+    for (int i = 1; i < m; ++i)
+        if (t[i] > t[i - 1]) dts.append(t[i] - t[i - 1]);
+    const double dtRef = medianOf(dts);
+
+    // y_i：第 i−1 行到第 i 行的压力变化，按典型采样间隔归一
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    QVector<double> y(m, nan);
+    for (int i = 1; i < m; ++i) {
+        double dt = t[i] - t[i - 1];
+        if (dt > 0 && std::isfinite(p[i]) && std::isfinite(p[i - 1])) y[i] = (p[i] - p[i - 1]) * dtRef / dt;
+    }
+    double sigma = differenceNoise(y);
+    if (!(sigma > 0)) {
+        // 压力完全光滑（如理论曲线）时按变化率幅度的很小比例取噪声
+        double sum = 0;
+        int count = 0;
+        for (double v : y) if (std::isfinite(v)) { sum += std::abs(v); ++count; }
+        sigma = count > 0 ? 1e-6 * sum / count : 0.0;
+    }
+    QVector<int> starts{0};
+    if (!(sigma > 0)) return starts;
+    const double k = config.drift * sigma;
+    const double h = config.threshold * sigma;
+    const double alpha = qBound(1e-4, config.smoothing, 1.0);
+
+    double ref = nan, score = 0;
+    int run = 1, segStart = 0;
+    for (int i = 1; i < m; ++i) {
+        if (!std::isfinite(y[i])) continue;
+        if (!std::isfinite(ref)) { ref = y[i]; run = i + 1; continue; }
+        double s = ref >= 0 ? 1.0 : -1.0;
+        double deviation = qMax(s * y[i] - std::abs(ref), -s * y[i]);
+        score = qMax(0.0, score + deviation - k);
+        if (score == 0) run = i + 1;
+        if (score > h) {
+            // 变化发生在第 run−1 行与第 run 行之间，新段从第 run 行开始
+            if (run - segStart >= config.minPoints && run < m) {
+                starts.append(run);
+                segStart = run;
+            }
+            score = 0;
+            ref = y[i];
+            run = i + 1;
+            continue;
+        }
+        ref += alpha * (y[i] - ref);
+    }
+    return starts;
+}
+}
+
+FlowPeriodResult FlowPeriodDetector::detect(const QVector<double>& time, const QVector<double>& pressure,
+                                            const QVector<double>& rate, const FlowPeriodConfig& config)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const int n = time.size();
+    FlowPeriodResult result;
+    result.periodOfRow.fill(-1, n);
+    result.elapsed.fill(nan, n);
+    result.pressureChange.fill(nan, n);
+
+    auto valueAt = [](const QVector<double>& v, int i) { return i < v.size() ? v[i] : std::numeric_limits<double>::quiet_NaN(); };
+    bool useRates = false;
+    for (int i = 0; i < n && !useRates; ++i) useRates = std::isfinite(valueAt(rate, i));
+    result.fromRates = useRates;
+
+    // 有效行按时间排序（数据通常已排序，此时不做排序）
+    QVector<int> order;
+    order.reserve(n);
+    bool sorted = true;
+    for (int i = 0; i < n; ++i) {
+        double v = useRates ? valueAt(rate, i) : valueAt(pressure, i);
+        if (!std::isfinite(time[i]) || !std::isfinite(v)) continue;
+        if (!order.isEmpty() && time[i] < time[order.last()]) sorted = false;
+        order.append(i);
+    }
+    if (!sorted) std::stable_sort(order.begin(), order.end(), [&time](int a, int b) { return time[a] < time[b]; });
+    const int m = order.size();
+    if (m < 2) return result;
+
+    QVector<double> t(m), p(m), q(m);
+    for (int k = 0; k < m; ++k) {
+        t[k] = time[order[k]];
+        p[k] = valueAt(pressure, order[k]);
+        q[k] = valueAt(rate, order[k]);
+    }
+
+    double scale = 0;
+    for (double v : q) if (std::isfinite(v)) scale = qMax(scale, std::abs(v));
+    const double minShift = config.rateTolerance * scale;
+    QVector<int> starts = useRates ? rateChangePoints(q, minShift, config) : pressureChangePoints(t, p, config);
+    starts.append(m);
+
+    // 各段均值；产量识别时合并均值相差不足 minShift 的相邻段
+    QVector<int> bounds{0};
+    QVector<double> means;
+    for (int s = 0; s + 1 < starts.size(); ++s) {
+        double mean = nan;
+        if (useRates) {
+            double sum = 0;
+            for (int k = starts[s]; k < starts[s + 1]; ++k) sum += q[k];
+            mean = sum / (starts[s + 1] - starts[s]);
+        }
+        if (useRates && !means.isEmpty() && std::abs(mean - means.last()) < minShift) {
+            int a = bounds[bounds.size() - 2], b = bounds.last();
+            means.last() = (means.last() * (b - a) + mean * (starts[s + 1] - starts[s])) / (starts[s + 1] - a);
+            bounds.last() = starts[s + 1];
+            continue;
+        }
+        means.append(mean);
+        bounds.append(starts[s + 1]);
+    }
+
+    double previousRate = 0.0;
+    for (int s = 0; s < means.size(); ++s) {
+        const int a = bounds[s], b = bounds[s + 1];
+        FlowPeriod period;
+        period.startRow = order[a];
+        period.endRow = order[b - 1];
+        period.startTime = a > 0 ? t[a - 1] : t[0];
+        period.rate = means[s];
+        period.shutIn = useRates && std::abs(means[s]) <= config.shutInTolerance * scale;
+
+        // 压差基准取段起点（变化前最后一行）的压力
+        const double pStart = a > 0 ? p[a - 1] : p[a];
+        if (useRates) {
+            period.pressureSign = means[s] > previousRate ? -1.0 : 1.0;
+            previousRate = means[s];
+        } else {
+            period.pressureSign = p[b - 1] >= pStart ? 1.0 : -1.0;
+        }
+        const int index = result.periods.size();
+        for (int k = a; k < b; ++k) {
+            result.periodOfRow[order[k]] = index;
+            result.elapsed[order[k]] = t[k] - period.startTime;
+            if (std::isfinite(p[k]) && std::isfinite(pStart))
+                result.pressureChange[order[k]] = period.pressureSign * (p[k] - pStart);
+        }
+        result.periods.append(period);
+    }
+    return result;
+}
+
+RateSchedule FlowPeriodDetector::toSchedule(const FlowPeriodResult& result)
+{
+    RateSchedule schedule;
+    if (!result.fromRates) return schedule;
+    for (const FlowPeriod& period : result.periods) {
+        schedule.startTime.append(period.startTime);
+        schedule.rate.append(period.shutIn ? 0.0 : period.rate);
+    }
+    return schedule;
+}
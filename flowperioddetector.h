@@ -0,0 +1,72 @@
+#ifndef FLOWPERIODDETECTOR_H
+#define FLOWPERIODDETECTOR_H
+
+#include <QVector>
+#include "modelsuperposition.h"
+
+// 识别出的一个流动段（产量不变的一段生产或关井）
+struct FlowPeriod {
+    int startRow;           // 段内第一行
+    int endRow;             // 段内最后一行
+    double startTime;       // 段起点：变化前最后一行的时间（首段为首行时间）
+    double rate;            // 段内平均产量；仅由压力识别时为 NaN
+    bool shutIn;            // 关井段（产量近似为 0）
+    double pressureSign;    // 段内压差 Δp = pressureSign·(p − p_起点)，使压降段与恢复段都为正
+};
+
+// 识别设置
+struct FlowPeriodConfig {
+    double rateTolerance;       // 视为产量变化的最小幅度（相对最大产量）
+    double shutInTolerance;     // 视为关井的产量上限（相对最大产量）
+    double threshold;           // CUSUM 报警阈值（噪声标准差的倍数）
+    double drift;               // CUSUM 漂移量（噪声标准差的倍数）
+    double smoothing;           // 压力变化率参考值的指数平滑系数
+    int minPoints;              // 流动段最少行数
+
+    FlowPeriodConfig() :
+        rateTolerance(0.01),
+        shutInTolerance(0.02),
+        threshold(12.0),
+        drift(2.0),
+        smoothing(0.1),
+        minPoints(10) {}
+};
+
+// 识别结果，逐行数组与输入一一对应（无效行为 −1 / NaN）
+struct FlowPeriodResult {
+    QVector<FlowPeriod> periods;
+    bool fromRates;                 // 由产量列识别（否则由压力变化率识别）
+    QVector<int> periodOfRow;       // 所在流动段序号
+    QVector<double> elapsed;        // 段内时间 Δt = t − startTime
+    QVector<double> pressureChange; // 段内压差 Δp
+
+    FlowPeriodResult() : fromRates(false) {}
+};
+
+/**
+ * @brief 流动段（开关井、变产量）自动识别
+ *
+ * 单次顺序扫描的双侧 CUSUM 变点检测，O(n)：
+ *   有产量列时，对产量相对当前段均值的偏差累积，偏差超过 drift 的部分累积到 threshold
+ *   即报警，变点取累积量最后一次为 0 之后的一行；最小变化幅度取噪声与 rateTolerance 的较大者，
+ *   平稳的记录产量即使完全无噪声也能准确定位；
+ *   只有压力时，对压力变化率做 CUSUM：同一流动段内 |dp/dt| 随时间单调衰减，
+ *   只有变化率反号或幅度突增（开关井、调产）才累积，参考值取变化率的指数平滑。
+ * 噪声由一阶差分的中位数绝对偏差估计，不受趋势影响。
+ * 数据需按时间排序（表格数据通常如此；无序时先排序）。
+ */
+class FlowPeriodDetector
+{
+public:
+    /**
+     * @param rate 为空或全为缺测时按压力识别
+     */
+    static FlowPeriodResult detect(const QVector<double>& time, const QVector<double>& pressure,
+                                   const QVector<double>& rate,
+                                   const FlowPeriodConfig& config = FlowPeriodConfig());
+
+    // 由产量识别的流动段构成产量历史（供叠加时间、叠加导数使用）；按压力识别时返回空
+    static RateSchedule toSchedule(const FlowPeriodResult& result);
+};
+
+#endif // FLOWPERIODDETECTOR_H
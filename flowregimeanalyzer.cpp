@@ -0,0 +1,253 @@
+#include "flowregimeanalyzer.h"
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <QPair>
+
+namespace {
+// log-log 坐标下的前缀和，任意区间的直线拟合可 O(1) 求得
+struct PrefixSums {
+    QVector<double> sx, sy, sxx, sxy, syy;
+
+    explicit PrefixSums(const LogBinnedCurve& c) {
+        int n = c.t.size();
+        sx.fill(0.0, n + 1); sy.fill(0.0, n + 1); sxx.fill(0.0, n + 1); sxy.fill(0.0, n + 1); syy.fill(0.0, n + 1);
+        for (int i = 0; i < n; ++i) {
+            double x = std::log10(c.t[i]);
+            double y = std::log10(c.d[i]);
+            sx[i + 1] = sx[i] + x; sy[i + 1] = sy[i] + y;
+            sxx[i + 1] = sxx[i] + x * x; sxy[i + 1] = sxy[i] + x * y; syy[i + 1] = syy[i] + y * y;
+        }
+    }
+
+    // 区间 [first, last] 的直线拟合：返回残差平方和，输出斜率、截距及斜率的 Σ(x-x̄)²
+    double fit(int first, int last, double* slope = nullptr, double* intercept = nullptr, double* sxxc = nullptr) const {
+        int n = last - first + 1;
+        double Sx = sx[last + 1] - sx[first], Sy = sy[last + 1] - sy[first];
+        double Sxx = sxx[last + 1] - sxx[first] - Sx * Sx / n;
+        double Sxy = sxy[last + 1] - sxy[first] - Sx * Sy / n;
+        double Syy = syy[last + 1] - syy[first] - Sy * Sy / n;
+        double b = (Sxx > 1e-30) ? Sxy / Sxx : 0.0;
+        if (slope) *slope = b;
+        if (intercept) *intercept = (Sy - b * Sx) / n;
+        if (sxxc) *sxxc = Sxx;
+        return qMax(0.0, Syy - b * Sxy);
+    }
+};
+
+// 由二阶差分的中位数绝对值估计 log10(导数) 的噪声方差（对直线段为零，不受流动段斜率影响）
+double estimateNoiseVariance(const LogBinnedCurve& c)
+{
+    QVector<double> e;
+    for (int i = 1; i + 1 < c.d.size(); ++i)
+        e.append(std::abs(std::log10(c.d[i + 1]) - 2.0 * std::log10(c.d[i]) + std::log10(c.d[i - 1])));
+    if (e.isEmpty()) return 0.0;
+    std::nth_element(e.begin(), e.begin() + e.size() / 2, e.end());
+    double sigma = 1.4826 * e[e.size() / 2] / std::sqrt(6.0);
+    return sigma * sigma;
+}
+}
+
+LogBinnedCurve FlowRegimeAnalyzer::logBin(const QVector<double>& t, const QVector<double>& p,
+                                          const QVector<double>& d, int binsPerDecade)
+{
+    LogBinnedCurve out;
+    int n = qMin(t.size(), d.size());
+    if (n == 0 || binsPerDecade <= 0) return out;
+
+    // 压力计数据通常已按时间排序，只有乱序时才排序
+    QVector<int> order;
+    order.reserve(n);
+    bool sorted = true;
+    for (int i = 0; i < n; ++i) {
+        if (!(t[i] > 0 && d[i] > 0 && std::isfinite(t[i]) && std::isfinite(d[i]))) continue;
+        if (!order.isEmpty() && t[i] < t[order.last()]) sorted = false;
+        order.append(i);
+    }
+    if (!sorted)
+        std::sort(order.begin(), order.end(), [&t](int a, int b) { return t[a] < t[b]; });
+
+    int currentBin = 0;
+    double slt = 0, slp = 0, sld = 0;
+    int count = 0, countP = 0;
+    auto flush = [&]() {
+        if (count == 0) return;
+        out.t.append(std::pow(10.0, slt / count));
+        out.d.append(std::pow(10.0, sld / count));
+        out.p.append(countP > 0 ? std::pow(10.0, slp / countP) : 0.0);
+        slt = slp = sld = 0; count = countP = 0;
+    };
+    for (int k = 0; k < order.size(); ++k) {
+        int i = order[k];
+        int bin = (int)std::floor(std::log10(t[i]) * binsPerDecade);
+        if (k > 0 && bin != currentBin) flush();
+        currentBin = bin;
+        slt += std::log10(t[i]);
+        sld += std::log10(d[i]);
+        if (i < p.size() && p[i] > 0) { slp += std::log10(p[i]); ++countP; }
+        ++count;
+    }
+    flush();
+    return out;
+}
+
+QVector<FlowRegimeSegment> FlowRegimeAnalyzer::analyze(const QVector<double>& t, const QVector<double>& p,
+                                                       const QVector<double>& d, const FlowRegimeConfig& config)
+{
+    QVector<FlowRegimeSegment> segments;
+    LogBinnedCurve c = logBin(t, p, d, config.binsPerDecade);
+    int n = c.t.size();
+    int minLen = qMax(3, (int)std::ceil(config.minSegmentDecades * config.binsPerDecade));
+    if (n < minLen) return segments;
+    PrefixSums ps(c);
+
+    // 1. 最优分段：best[j] 为前 j 个点的最小代价，段长不小于 minLen
+    //    噪声方差设下限，避免无噪声（理论）曲线在弯曲的过渡段被切得过碎
+    double sigma2 = qMax(estimateNoiseVariance(c), 1e-4);
+    double penalty = config.penaltyScale * sigma2 * std::log((double)n) * minLen;
+    const double inf = std::numeric_limits<double>::infinity();
+    QVector<double> best(n + 1, inf);
+    QVector<int> prev(n + 1, -1);
+    best[0] = 0.0;
+    for (int j = minLen; j <= n; ++j) {
+        for (int i = 0; i + minLen <= j; ++i) {
+            if (best[i] == inf) continue;
+            double cost = best[i] + ps.fit(i, j - 1) + penalty;
+            if (cost < best[j]) { best[j] = cost; prev[j] = i; }
+        }
+    }
+    // 末尾不足 minLen 的点无法单独成段时并入最后一段
+    int end = n;
+    while (end > 0 && prev[end] < 0) --end;
+    QVector<QPair<int, int>> ranges;
+    for (int j = end; j > 0; j = prev[j]) ranges.prepend(qMakePair(prev[j], j - 1));
+    if (ranges.isEmpty()) return segments;
+    ranges.last().second = n - 1;
+
+    // 2. 逐段归类
+    struct RawSegment { int first; int last; FlowRegime regime; };
+    QVector<RawSegment> raw;
+    bool seenFlowRegime = false;
+    for (const auto& r : ranges) {
+        double slope = 0, sxxc = 0;
+        double sse = ps.fit(r.first, r.second, &slope, nullptr, &sxxc);
+        int count = r.second - r.first + 1;
+        double slopeError = (count > 2 && sxxc > 0) ? std::sqrt(sse / (count - 2) / sxxc) : 0.0;
+        double conf = 0;
+        FlowRegime regime = classifySlope(slope, slopeError, conf);
+        // 其他流动段之后出现的单位斜率或明显下掉，记为边界
+        if (seenFlowRegime && (regime == FlowRegime::Storage || slope < -0.62))
+            regime = FlowRegime::Boundary;
+        else if (regime == FlowRegime::Boundary)
+            regime = FlowRegime::Unknown;
+        if (regime != FlowRegime::Unknown && regime != FlowRegime::Storage && regime != FlowRegime::Boundary)
+            seenFlowRegime = true;
+        raw.append(RawSegment{r.first, r.second, regime});
+    }
+
+    // 3. 之后还出现流动段的“边界”只是两个流动段之间的过渡（如双重介质凹陷、复合区过渡）
+    bool laterFlowRegime = false;
+    for (int k = raw.size() - 1; k >= 0; --k) {
+        if (raw[k].regime == FlowRegime::Boundary) {
+            if (laterFlowRegime) raw[k].regime = FlowRegime::Unknown;
+        } else if (raw[k].regime != FlowRegime::Storage && raw[k].regime != FlowRegime::Unknown) {
+            laterFlowRegime = true;
+        }
+    }
+
+    // 4. 合并相邻同类段并计算输出
+    for (int k = 0; k < raw.size(); ++k) {
+        if (raw[k].regime == FlowRegime::Unknown) continue;
+        int first = raw[k].first;
+        int last = raw[k].last;
+        while (k + 1 < raw.size() && raw[k + 1].regime == raw[k].regime) last = raw[++k].last;
+
+        FlowRegimeSegment seg;
+        double slope = 0, intercept = 0, sxxc = 0;
+        double sse = ps.fit(first, last, &slope, &intercept, &sxxc);
+        int count = last - first + 1;
+        double slopeError = (count > 2 && sxxc > 0) ? std::sqrt(sse / (count - 2) / sxxc) : 0.0;
+        double slopeConfidence = 0;
+        FlowRegime fitted = classifySlope(slope, slopeError, slopeConfidence);
+        seg.regime = raw[k].regime;
+        if (seg.regime == FlowRegime::Boundary && fitted != FlowRegime::Storage) slopeConfidence = 1.0;   // 导数下掉
+        seg.tStart = c.t[first];
+        seg.tEnd = c.t[last];
+        seg.slope = slope;
+        seg.level = std::pow(10.0, (ps.sy[last + 1] - ps.sy[first]) / count);
+        seg.dStart = std::pow(10.0, intercept + slope * std::log10(seg.tStart));
+        seg.dEnd = std::pow(10.0, intercept + slope * std::log10(seg.tEnd));
+        seg.pointCount = count;
+        double decades = std::log10(seg.tEnd / seg.tStart);
+        seg.confidence = slopeConfidence * qMin(1.0, decades / 0.5);
+        segments.append(seg);
+    }
+    return segments;
+}
+
+FlowRegime FlowRegimeAnalyzer::classifySlope(double slope, double slopeError, double& confidence)
+{
+    static const FlowRegime candidates[] = {
+        FlowRegime::Storage, FlowRegime::Linear, FlowRegime::Bilinear,
+        FlowRegime::Radial, FlowRegime::Spherical
+    };
+    // 容差视为 2 倍标准差，与斜率的标准误差合成；置信度 = 吻合程度 × 在各候选中所占比重
+    double weights[5];
+    double total = 0;
+    int bestIndex = 0;
+    for (int k = 0; k < 5; ++k) {
+        double tol = slopeTolerance(candidates[k]);
+        double var = tol * tol / 4.0 + slopeError * slopeError;
+        double diff = slope - nominalSlope(candidates[k]);
+        weights[k] = std::exp(-0.5 * diff * diff / var);
+        total += weights[k];
+        if (weights[k] > weights[bestIndex]) bestIndex = k;
+    }
+    FlowRegime best = candidates[bestIndex];
+    confidence = (total > 0) ? weights[bestIndex] * weights[bestIndex] / total : 0.0;
+    if (std::abs(slope - nominalSlope(best)) <= slopeTolerance(best) + 2.0 * slopeError) return best;
+
+    confidence = 0;
+    // 远低于 -1/2 的斜率只可能是晚期边界效应，由调用方结合前后流动段判断
+    if (slope < -0.62) return FlowRegime::Boundary;
+    return FlowRegime::Unknown;
+}
+
+double FlowRegimeAnalyzer::slopeTolerance(FlowRegime regime)
+{
+    switch (regime) {
+    case FlowRegime::Storage: return 0.2;
+    case FlowRegime::Bilinear: return 0.08;
+    case FlowRegime::Linear: return 0.12;
+    case FlowRegime::Radial: return 0.1;
+    case FlowRegime::Spherical: return 0.12;
+    case FlowRegime::Boundary: return 0.3;
+    default: return 0.1;
+    }
+}
+
+double FlowRegimeAnalyzer::nominalSlope(FlowRegime regime)
+{
+    switch (regime) {
+    case FlowRegime::Storage: return 1.0;
+    case FlowRegime::Bilinear: return 0.25;
+    case FlowRegime::Linear: return 0.5;
+    case FlowRegime::Radial: return 0.0;
+    case FlowRegime::Spherical: return -0.5;
+    case FlowRegime::Boundary: return 1.0;
+    default: return 0.0;
+    }
+}
+
+QString FlowRegimeAnalyzer::regimeName(FlowRegime regime)
+{
+    switch (regime) {
+    case FlowRegime::Storage: return "井筒储集";
+    case FlowRegime::Bilinear: return "双线性流";
+    case FlowRegime::Linear: return "线性流";
+    case FlowRegime::Radial: return "径向流";
+    case FlowRegime::Spherical: return "球形流";
+    case FlowRegime::Boundary: return "边界";
+    default: return "过渡段";
+    }
+}
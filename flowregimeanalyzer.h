@@ -0,0 +1,82 @@
+#ifndef FLOWREGIMEANALYZER_H
+#define FLOWREGIMEANALYZER_H
+
+#include <QVector>
+#include <QString>
+
+// 流动段类型（按压力导数在双对数图上的斜率划分）
+enum class FlowRegime {
+    Unknown,     // 过渡段
+    Storage,     // 井筒储集（斜率 1）
+    Bilinear,    // 双线性流（斜率 1/4）
+    Linear,      // 线性流（斜率 1/2）
+    Radial,      // 径向流 / 拟径向流（斜率 0）
+    Spherical,   // 球形流（斜率 -1/2）
+    Boundary     // 边界（晚期斜率 1 或导数下掉）
+};
+
+// 识别出的一个流动段
+struct FlowRegimeSegment {
+    FlowRegime regime;
+    double tStart;
+    double tEnd;
+    double slope;        // 段内 log(导数)-log(时间) 的拟合斜率
+    double level;        // 段内导数的几何平均值
+    double dStart;       // 拟合直线在段起点、终点处的导数值（用于绘图）
+    double dEnd;
+    double confidence;   // 0~1，斜率越接近理论值、与其他流动段区分越明确、段越长越高
+    int pointCount;      // 段内（对数分箱后的）点数
+};
+
+// 分段设置
+struct FlowRegimeConfig {
+    int binsPerDecade;          // 对数分箱密度
+    double minSegmentDecades;   // 最短分段长度（对数周期）
+    double penaltyScale;        // 每增加一段的代价系数（乘以噪声方差与 ln(箱数)）
+
+    FlowRegimeConfig() :
+        binsPerDecade(20),
+        minSegmentDecades(0.3),
+        penaltyScale(3.0) {}
+};
+
+// 对数分箱后的曲线：每个箱内时间、压力、导数取几何平均
+struct LogBinnedCurve {
+    QVector<double> t;
+    QVector<double> p;
+    QVector<double> d;
+};
+
+/**
+ * @brief 流动段识别
+ *
+ * 1. 按对数时间分箱（O(n)，仅在输入无序时排序，O(n log n)），百万点的压力计数据
+ *    压缩为每个对数周期 binsPerDecade 个点；
+ * 2. 对 log(导数)-log(时间) 做最优分段直线拟合：动态规划最小化 残差平方和 + 段数惩罚，
+ *    各段代价由前缀和 O(1) 求得，惩罚按二阶差分估计的噪声方差自适应；
+ * 3. 按段斜率（考虑其标准误差）归类为储集、双线性流、线性流、径向流、球形流，
+ *    置信度综合斜率吻合程度、与相邻理论斜率的区分度和段长；
+ * 4. 出现在其他流动段之后的单位斜率段、晚期导数明显下掉的段记为边界，
+ *    其后仍有流动段的“边界”视为过渡段舍去；相邻同类段合并。
+ */
+class FlowRegimeAnalyzer
+{
+public:
+    // 对数分箱（忽略非正的时间、导数；压力可为空）
+    static LogBinnedCurve logBin(const QVector<double>& t, const QVector<double>& p,
+                                 const QVector<double>& d, int binsPerDecade = 10);
+
+    static QVector<FlowRegimeSegment> analyze(const QVector<double>& t, const QVector<double>& p,
+                                              const QVector<double>& d,
+                                              const FlowRegimeConfig& config = FlowRegimeConfig());
+
+    static QString regimeName(FlowRegime regime);
+    static double nominalSlope(FlowRegime regime);
+
+private:
+    // 按斜率及其标准误差归类，confidence 返回斜率部分的置信度
+    static FlowRegime classifySlope(double slope, double slopeError, double& confidence);
+    static double slopeTolerance(FlowRegime regime);
+};
+
+#endif // FLOWREGIMEANALYZER_H
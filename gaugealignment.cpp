@@ -0,0 +1,690 @@
+#include "gaugealignment.h"
+#include "qcustomplot.h"
+
+#include <QApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QDateTime>
+#include <QRegularExpression>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QGridLayout>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QLabel>
+#include <QPushButton>
+#include <queue>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace {
+const double kTwoPi = 6.28318530717958647692;
+
+double medianSpacing(const QVector<double>& t)
+{
+    std::vector<double> dts;
+    dts.reserve(t.size());
+    for (int i = 1; i < t.size(); ++i)
+        if (t[i] > t[i - 1]) dts.push_back(t[i] - t[i - 1]);
+    if (dts.empty()) return 0.0;
+    auto mid = dts.begin() + dts.size() / 2;
+    std::nth_element(dts.begin(), mid, dts.end());
+    return *mid;
+}
+
+// ---------------------------------------------------------------------------
+// 文件读取
+// ---------------------------------------------------------------------------
+
+QDate parseDate(const QString& text)
+{
+    static const char* formats[] = {"yyyy-MM-dd", "yyyy/MM/dd", "yyyy-M-d", "yyyy/M/d", "yyyy.MM.dd"};
+    for (const char* format : formats) {
+        QDate date = QDate::fromString(text, format);
+        if (date.isValid()) return date;
+    }
+    return QDate();
+}
+
+QTime parseClock(const QString& text)
+{
+    static const char* formats[] = {"hh:mm:ss", "h:mm:ss", "hh:mm:ss.zzz", "h:mm:ss.zzz", "hh:mm", "h:mm"};
+    for (const char* format : formats) {
+        QTime time = QTime::fromString(text, format);
+        if (time.isValid()) return time;
+    }
+    return QTime();
+}
+
+// 日期 + 时刻转为按儒略日计的小时数（不涉及时区与夏令时）
+double absoluteHours(const QDate& date, const QTime& time)
+{
+    return date.toJulianDay() * 24.0 + time.msecsSinceStartOfDay() / 3.6e6;
+}
+
+// 单个字段中的日期时间（“日期 时刻”或 ISO 的“日期T时刻”）
+bool parseDateTimeField(const QString& text, double& hours)
+{
+    QString normalized = text.trimmed();
+    normalized.replace('T', ' ');
+    int space = normalized.indexOf(' ');
+    if (space <= 0) return false;
+    QDate date = parseDate(normalized.left(space));
+    QTime time = parseClock(normalized.mid(space + 1).trimmed());
+    if (!date.isValid() || !time.isValid()) return false;
+    hours = absoluteHours(date, time);
+    return true;
+}
+
+bool isNumber(const QString& text, double* value = nullptr)
+{
+    bool ok = false;
+    double v = text.trimmed().toDouble(&ok);
+    if (ok && value) *value = v;
+    return ok && std::isfinite(v);
+}
+
+bool isValueField(const QString& text)
+{
+    double hours;
+    return isNumber(text) || parseDateTimeField(text, hours) || parseDate(text.trimmed()).isValid()
+           || parseClock(text.trimmed()).isValid();
+}
+
+QStringList splitFields(const QString& line, QChar separator)
+{
+    if (separator.isNull()) return line.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+    QStringList fields = line.split(separator);
+    for (QString& field : fields) {
+        field = field.trimmed();
+        if (field.size() >= 2 && field.startsWith('"') && field.endsWith('"')) field = field.mid(1, field.size() - 2);
+    }
+    return fields;
+}
+
+enum class TimeKind { Invalid, Numeric, Absolute };
+
+/**
+ * 读取一行的时间：timeColumn 可为数值、日期时间，或日期 / 时刻两列中的任一列
+ * （另一列相邻）；consumed 返回时间占用的最后一列
+ */
+TimeKind readTime(const QStringList& fields, int timeColumn, double& value, int& consumed)
+{
+    consumed = timeColumn;
+    if (timeColumn >= fields.size()) return TimeKind::Invalid;
+    const QString text = fields[timeColumn].trimmed();
+    if (isNumber(text, &value)) return TimeKind::Numeric;
+    if (parseDateTimeField(text, value)) return TimeKind::Absolute;
+
+    QDate date = parseDate(text);
+    if (date.isValid() && timeColumn + 1 < fields.size()) {
+        QTime time = parseClock(fields[timeColumn + 1].trimmed());
+        if (time.isValid()) {
+            value = absoluteHours(date, time);
+            consumed = timeColumn + 1;
+            return TimeKind::Absolute;
+        }
+    }
+    QTime time = parseClock(text);
+    if (time.isValid() && timeColumn > 0) {
+        date = parseDate(fields[timeColumn - 1].trimmed());
+        if (date.isValid()) {
+            value = absoluteHours(date, time);
+            return TimeKind::Absolute;
+        }
+    }
+    return TimeKind::Invalid;
+}
+
+// ---------------------------------------------------------------------------
+// 互相关
+// ---------------------------------------------------------------------------
+
+// 按网格 start + k·dt 重采样：落在同一格的记录取平均，覆盖范围内的空格线性插补，范围外为 NaN
+QVector<double> resample(const GaugeSeries& s, double start, double dt, int m)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    QVector<double> sum(m, 0.0);
+    QVector<int> count(m, 0);
+    for (int i = 0; i < s.time.size(); ++i) {
+        if (!std::isfinite(s.time[i]) || !std::isfinite(s.pressure[i])) continue;
+        int k = qBound(0, int(std::lround((s.time[i] - start) / dt)), m - 1);
+        sum[k] += s.pressure[i];
+        ++count[k];
+    }
+    QVector<double> grid(m, nan);
+    int previous = -1;
+    for (int k = 0; k < m; ++k) {
+        if (count[k] == 0) continue;
+        grid[k] = sum[k] / count[k];
+        if (previous >= 0 && k - previous > 1) {
+            for (int j = previous + 1; j < k; ++j) {
+                double w = double(j - previous) / (k - previous);
+                grid[j] = grid[previous] + w * (grid[k] - grid[previous]);
+            }
+        }
+        previous = k;
+    }
+    return grid;
+}
+
+// 互相关用的信号：差分（或原值）在有效格上去均值，无数据处为 0
+QVector<double> correlationSignal(const QVector<double>& grid, bool difference)
+{
+    const int m = grid.size();
+    QVector<double> x(m, 0.0);
+    QVector<char> mask(m, 0);
+    double sum = 0;
+    int count = 0;
+    for (int k = 0; k < m; ++k) {
+        double v = difference ? (k + 1 < m ? grid[k + 1] - grid[k] : std::numeric_limits<double>::quiet_NaN())
+                              : grid[k];
+        if (!std::isfinite(v)) continue;
+        x[k] = v;
+        mask[k] = 1;
+        sum += v;
+        ++count;
+    }
+    if (count > 0) {
+        const double mean = sum / count;
+        for (int k = 0; k < m; ++k)
+            if (mask[k]) x[k] -= mean;
+    }
+    return x;
+}
+}
+
+// ============================================================================
+// 文件读取
+// ============================================================================
+
+bool GaugeAlignment::readGaugeFile(const QString& filePath, GaugeSeries& series, QString& errorMessage)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        errorMessage = QString("无法打开文件: %1").arg(file.errorString());
+        return false;
+    }
+    QStringList lines;
+    QTextStream in(&file);
+    while (!in.atEnd()) lines.append(in.readLine());
+    file.close();
+
+    // 分隔符：前 20 个非空行中出现最多的制表符、逗号或分号，都没有时按空白分隔
+    QChar separator;
+    int best = 0;
+    for (const QChar candidate : {QChar('\t'), QChar(','), QChar(';')}) {
+        int count = 0, sampled = 0;
+        for (const QString& line : lines) {
+            if (line.trimmed().isEmpty()) continue;
+            count += line.count(candidate);
+            if (++sampled >= 20) break;
+        }
+        if (count > best) {
+            best = count;
+            separator = candidate;
+        }
+    }
+
+    // 数据起始行：至少有两个数值 / 日期 / 时刻字段的第一行；其前最近的非空行视为表头
+    int dataStart = -1;
+    for (int i = 0; i < lines.size() && dataStart < 0; ++i) {
+        int values = 0;
+        for (const QString& field : splitFields(lines[i], separator))
+            if (isValueField(field)) ++values;
+        if (values >= 2) dataStart = i;
+    }
+    if (dataStart < 0) {
+        errorMessage = "未找到数据行";
+        return false;
+    }
+    QStringList header;
+    for (int i = dataStart - 1; i >= 0 && header.isEmpty(); --i)
+        if (!lines[i].trimmed().isEmpty()) header = splitFields(lines[i], separator);
+
+    // 表头字段数与数据行不一致时（如以空白分隔而列名含空格）不按列名识别
+    const QStringList first = splitFields(lines[dataStart], separator);
+    if (header.size() != first.size()) header.clear();
+
+    int timeColumn = -1, pressureColumn = -1;
+    for (int c = 0; c < header.size(); ++c) {
+        QString name = header[c].toLower();
+        if (timeColumn < 0 && (name.contains("date") || name.contains("日期") || name.contains("time") || name.contains("时间")))
+            timeColumn = c;
+    }
+    for (int c = 0; c < header.size(); ++c) {
+        QString name = header[c].toLower();
+        if (c != timeColumn && (name.contains("pressure") || name.contains("压力") || name.contains("压强")
+                                || name.startsWith("pres") || name == "p")) {
+            pressureColumn = c;
+            break;
+        }
+    }
+
+    if (timeColumn < 0) timeColumn = 0;
+    double firstTime = 0;
+    int consumed = timeColumn;
+    const TimeKind kind = readTime(first, timeColumn, firstTime, consumed);
+    if (kind == TimeKind::Invalid) {
+        errorMessage = QString("第 %1 行的时间无法识别: %2").arg(dataStart + 1).arg(lines[dataStart]);
+        return false;
+    }
+    if (pressureColumn < 0) {
+        for (int c = consumed + 1; c < first.size() && pressureColumn < 0; ++c)
+            if (isNumber(first[c])) pressureColumn = c;
+    }
+    if (pressureColumn < 0) {
+        errorMessage = "未找到压力列";
+        return false;
+    }
+
+    series.name = QFileInfo(filePath).completeBaseName();
+    series.pressureHeader = pressureColumn < header.size() ? header[pressureColumn].trimmed() : QString();
+    series.absoluteTime = kind == TimeKind::Absolute;
+    series.time.clear();
+    series.pressure.clear();
+    series.time.reserve(lines.size() - dataStart);
+    series.pressure.reserve(lines.size() - dataStart);
+
+    bool sorted = true;
+    for (int i = dataStart; i < lines.size(); ++i) {
+        const QStringList fields = splitFields(lines[i], separator);
+        double t = 0, p = 0;
+        if (readTime(fields, timeColumn, t, consumed) != kind) continue;
+        if (pressureColumn >= fields.size() || !isNumber(fields[pressureColumn], &p)) continue;
+        if (!series.time.isEmpty() && t < series.time.last()) sorted = false;
+        series.time.append(t);
+        series.pressure.append(p);
+    }
+    if (series.time.size() < 2) {
+        errorMessage = "未识别到有效的时间、压力数据";
+        return false;
+    }
+
+    if (!sorted) {
+        QVector<int> order(series.time.size());
+        for (int i = 0; i < order.size(); ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&series](int a, int b) { return series.time[a] < series.time[b]; });
+        QVector<double> t(order.size()), p(order.size());
+        for (int i = 0; i < order.size(); ++i) {
+            t[i] = series.time[order[i]];
+            p[i] = series.pressure[order[i]];
+        }
+        series.time = t;
+        series.pressure = p;
+    }
+    return true;
+}
+
+// ============================================================================
+// 时移估计
+// ============================================================================
+
+void GaugeAlignment::fft(QVector<double>& re, QVector<double>& im, bool inverse)
+{
+    const int n = re.size();
+    if (n < 2) return;
+    double* xr = re.data();
+    double* xi = im.data();
+
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            std::swap(xr[i], xr[j]);
+            std::swap(xi[i], xi[j]);
+        }
+    }
+
+    // 旋转因子只算一次，各级按步长取用
+    const double sign = inverse ? 1.0 : -1.0;
+    QVector<double> wr(n / 2), wi(n / 2);
+    for (int k = 0; k < n / 2; ++k) {
+        double angle = kTwoPi * k / n;
+        wr[k] = std::cos(angle);
+        wi[k] = sign * std::sin(angle);
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        const int half = len >> 1, stride = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int k = 0; k < half; ++k) {
+                const double cr = wr[k * stride], ci = wi[k * stride];
+                const int a = i + k, b = a + half;
+                const double tr = xr[b] * cr - xi[b] * ci;
+                const double ti = xr[b] * ci + xi[b] * cr;
+                xr[b] = xr[a] - tr;
+                xi[b] = xi[a] - ti;
+                xr[a] += tr;
+                xi[a] += ti;
+            }
+        }
+    }
+}
+
+GaugeShift GaugeAlignment::estimateShift(const GaugeSeries& reference, const GaugeSeries& other,
+                                         const GaugeAlignmentConfig& config)
+{
+    GaugeShift result;
+    if (reference.time.size() < 4 || other.time.size() < 4) return result;
+
+    const double start = qMin(reference.time.first(), other.time.first());
+    const double end = qMax(reference.time.last(), other.time.last());
+    double maxShift = config.maxShift;
+    if (!(maxShift > 0)) {
+        maxShift = 0.5 * qMin(reference.time.last() - reference.time.first(), other.time.last() - other.time.first());
+    }
+    double dt = qMin(medianSpacing(reference.time), medianSpacing(other.time));
+    if (!(dt > 0) || !(end > start) || !(maxShift > 0)) return result;
+
+    // 网格点数 m 加上最大滞后 lag 不超过上限（零填充后避免循环相关的混叠）
+    const int maxPoints = qMax(1024, config.maxGridPoints);
+    double required = (end - start + maxShift) / dt + 2;
+    if (required > maxPoints) dt *= required / maxPoints;
+    const int m = int(std::ceil((end - start) / dt)) + 1;
+    const int maxLag = qMin(int(std::ceil(maxShift / dt)), m - 1);
+    int n = 2;
+    while (n < m + maxLag + 1) n <<= 1;
+
+    const QVector<double> gridR = resample(reference, start, dt, m);
+    const QVector<double> gridO = resample(other, start, dt, m);
+    const QVector<double> r = correlationSignal(gridR, config.useDifference);
+    const QVector<double> o = correlationSignal(gridO, config.useDifference);
+
+    // 两路实信号打包为 z = r + i·o，一次正变换后拆出 R、O，再由 R·conj(O) 逆变换得互相关
+    QVector<double> re(n, 0.0), im(n, 0.0);
+    for (int k = 0; k < m; ++k) {
+        re[k] = r[k];
+        im[k] = o[k];
+    }
+    fft(re, im, false);
+    QVector<double> pr(n), pi(n);
+    for (int k = 0; k < n; ++k) {
+        const int c = (n - k) & (n - 1);
+        const double ar = 0.5 * (re[k] + re[c]), ai = 0.5 * (im[k] - im[c]);     // R
+        const double br = 0.5 * (im[k] + im[c]), bi = -0.5 * (re[k] - re[c]);    // O
+        pr[k] = ar * br + ai * bi;
+        pi[k] = ai * br - ar * bi;
+    }
+    fft(pr, pi, true);
+
+    // c[lag] = Σ r[j + lag]·o[j]，峰值处 other 的时间加 lag·dt 与参考对齐
+    auto corr = [&](int lag) { return pr[(lag + n) & (n - 1)]; };
+    int bestLag = 0;
+    double bestValue = -std::numeric_limits<double>::infinity();
+    for (int lag = -maxLag; lag <= maxLag; ++lag) {
+        if (corr(lag) > bestValue) {
+            bestValue = corr(lag);
+            bestLag = lag;
+        }
+    }
+    double delta = 0.0;
+    if (bestLag > -maxLag && bestLag < maxLag) {
+        const double y0 = corr(bestLag - 1), y1 = corr(bestLag), y2 = corr(bestLag + 1);
+        const double curvature = y0 - 2.0 * y1 + y2;
+        if (curvature < 0) delta = qBound(-0.5, 0.5 * (y0 - y2) / curvature, 0.5);
+    }
+    result.shift = (bestLag + delta) * dt;
+    result.resolution = dt;
+
+    // 整数滞后处重叠段上压力（非差分，差分会被噪声主导）的相关系数
+    double sxy = 0, sxx = 0, syy = 0, sx = 0, sy = 0;
+    int count = 0;
+    for (int j = qMax(0, -bestLag); j < m && j + bestLag < m; ++j) {
+        const double x = gridR[j + bestLag], y = gridO[j];
+        if (!std::isfinite(x) || !std::isfinite(y)) continue;
+        sx += x; sy += y; sxx += x * x; syy += y * y; sxy += x * y;
+        ++count;
+    }
+    if (count > 1) {
+        const double cov = sxy - sx * sy / count;
+        const double var = (sxx - sx * sx / count) * (syy - sy * sy / count);
+        result.correlation = var > 0 ? cov / std::sqrt(var) : 0.0;
+    }
+    return result;
+}
+
+QVector<GaugeShift> GaugeAlignment::estimateShifts(const QVector<GaugeSeries>& gauges, int reference,
+                                                   const GaugeAlignmentConfig& config)
+{
+    QVector<GaugeShift> shifts(gauges.size());
+    if (reference < 0 || reference >= gauges.size()) return shifts;
+    for (int g = 0; g < gauges.size(); ++g) {
+        if (g == reference) {
+            shifts[g].correlation = 1.0;
+            continue;
+        }
+        shifts[g] = estimateShift(gauges[reference], gauges[g], config);
+    }
+    return shifts;
+}
+
+// ============================================================================
+// 合并
+// ============================================================================
+
+GaugeMergeResult GaugeAlignment::merge(const QVector<GaugeSeries>& gauges, const QVector<double>& shifts,
+                                       double tolerance)
+{
+    const int k = gauges.size();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    GaugeMergeResult result;
+    result.pressure.resize(k);
+    result.samplesUsed.fill(0, k);
+
+    int total = 0;
+    double finest = std::numeric_limits<double>::infinity();
+    for (const GaugeSeries& gauge : gauges) {
+        total += gauge.time.size();
+        double dt = medianSpacing(gauge.time);
+        if (dt > 0) finest = qMin(finest, dt);
+    }
+    if (!(tolerance > 0)) tolerance = std::isfinite(finest) ? 0.5 * finest : 0.0;
+    result.time.reserve(total);
+    for (QVector<double>& column : result.pressure) column.reserve(total);
+
+    // 最小堆中每支压力计只放当前一条记录：(平移后时间, 压力计序号)
+    typedef std::pair<double, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+    QVector<int> cursor(k, 0), lastRow(k, -1);
+    auto advance = [&](int g) {
+        const GaugeSeries& gauge = gauges[g];
+        const double shift = shifts.value(g, 0.0);
+        for (int& i = cursor[g]; i < gauge.time.size(); ++i) {
+            if (std::isfinite(gauge.time[i]) && std::isfinite(gauge.pressure[i])) {
+                heap.push(Entry(gauge.time[i] + shift, g));
+                return;
+            }
+        }
+    };
+    for (int g = 0; g < k; ++g) advance(g);
+
+    double rowTime = nan;
+    while (!heap.empty()) {
+        const Entry top = heap.top();
+        heap.pop();
+        const int g = top.second;
+        int row = result.time.size() - 1;
+        if (row < 0 || top.first > rowTime + tolerance || lastRow[g] == row) {
+            result.time.append(top.first);
+            for (QVector<double>& column : result.pressure) column.append(nan);
+            rowTime = top.first;
+            ++row;
+        }
+        result.pressure[g][row] = gauges[g].pressure[cursor[g]];
+        lastRow[g] = row;
+        ++result.samplesUsed[g];
+        ++cursor[g];
+        advance(g);
+    }
+    return result;
+}
+
+// ============================================================================
+// 多压力计导入对话框
+// ============================================================================
+
+GaugeAlignmentDialog::GaugeAlignmentDialog(const QVector<GaugeSeries>& gauges, QWidget* parent)
+    : QDialog(parent),
+      m_gauges(gauges)
+{
+    setupUI();
+    onEstimate();
+}
+
+void GaugeAlignmentDialog::setupUI()
+{
+    setWindowTitle("多压力计对齐与合并");
+    setModal(true);
+    resize(860, 680);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout(this);
+
+    m_plot = new QCustomPlot(this);
+    m_plot->setBackground(Qt::white);
+    m_plot->xAxis->setLabel("时间 Time (h)");
+    m_plot->yAxis->setLabel("压力 − 首点压力");
+    m_plot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+    m_plot->legend->setVisible(true);
+    static const QColor colors[] = {QColor(231, 76, 60), QColor(41, 128, 185), QColor(39, 174, 96),
+                                    QColor(142, 68, 173), QColor(243, 156, 18), QColor(52, 73, 94)};
+    for (int g = 0; g < m_gauges.size(); ++g) {
+        m_plot->addGraph();
+        m_plot->graph(g)->setPen(QPen(colors[g % 6], 1.2));
+        m_plot->graph(g)->setName(m_gauges[g].name);
+    }
+    mainLayout->addWidget(m_plot, 1);
+
+    m_table = new QTableWidget(m_gauges.size(), 5, this);
+    m_table->setHorizontalHeaderLabels({"压力计", "记录数", "时间范围\\h", "时移\\h", "相关系数"});
+    m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    m_table->verticalHeader()->setVisible(false);
+    m_table->setMaximumHeight(40 + 30 * m_gauges.size());
+    for (int g = 0; g < m_gauges.size(); ++g) {
+        const GaugeSeries& gauge = m_gauges[g];
+        QString name = gauge.pressureHeader.isEmpty() ? gauge.name : QString("%1（%2）").arg(gauge.name, gauge.pressureHeader);
+        m_table->setItem(g, 0, new QTableWidgetItem(name));
+        m_table->setItem(g, 1, new QTableWidgetItem(QString::number(gauge.time.size())));
+        m_table->setItem(g, 2, new QTableWidgetItem(QString("%1 ~ %2").arg(gauge.time.first(), 0, 'g', 8)
+                                                        .arg(gauge.time.last(), 0, 'g', 8)));
+        QDoubleSpinBox* spin = new QDoubleSpinBox;
+        spin->setRange(-1e6, 1e6);
+        spin->setDecimals(6);
+        spin->setSingleStep(0.001);
+        connect(spin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &GaugeAlignmentDialog::updatePlot);
+        m_table->setCellWidget(g, 3, spin);
+        m_shiftSpins.append(spin);
+        m_table->setItem(g, 4, new QTableWidgetItem);
+        for (int c : {0, 1, 2, 4}) m_table->item(g, c)->setFlags(Qt::ItemIsEnabled);
+    }
+    mainLayout->addWidget(m_table);
+
+    QGridLayout* optionLayout = new QGridLayout;
+    optionLayout->addWidget(new QLabel("参考压力计:"), 0, 0);
+    m_referenceCombo = new QComboBox;
+    for (const GaugeSeries& gauge : m_gauges) m_referenceCombo->addItem(gauge.name);
+    m_referenceCombo->setToolTip("其余压力计的时移相对它估计；合并后它的压力列作为主压力列");
+    // 时移均相对参考压力计，换参考后重新估计（新参考的时移归零、不可编辑）
+    connect(m_referenceCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &GaugeAlignmentDialog::onEstimate);
+    optionLayout->addWidget(m_referenceCombo, 0, 1);
+    optionLayout->addWidget(new QLabel("最大时移:"), 0, 2);
+    m_maxShiftSpin = new QDoubleSpinBox;
+    m_maxShiftSpin->setRange(0.0, 1e5);
+    m_maxShiftSpin->setDecimals(4);
+    m_maxShiftSpin->setSuffix(" h");
+    m_maxShiftSpin->setSpecialValueText("自动");
+    m_maxShiftSpin->setToolTip("自动时取较短记录时长的一半");
+    optionLayout->addWidget(m_maxShiftSpin, 0, 3);
+    optionLayout->addWidget(new QLabel("合并容差:"), 1, 0);
+    m_toleranceSpin = new QDoubleSpinBox;
+    m_toleranceSpin->setRange(0.0, 1e3);
+    m_toleranceSpin->setDecimals(6);
+    m_toleranceSpin->setSuffix(" h");
+    m_toleranceSpin->setSpecialValueText("自动");
+    m_toleranceSpin->setToolTip("时间相差不超过容差的记录合并为一行；自动时取最密采样间隔的一半");
+    optionLayout->addWidget(m_toleranceSpin, 1, 1);
+    mainLayout->addLayout(optionLayout);
+
+    m_summaryLabel = new QLabel;
+    m_summaryLabel->setWordWrap(true);
+    mainLayout->addWidget(m_summaryLabel);
+
+    QHBoxLayout* buttonLayout = new QHBoxLayout;
+    QPushButton* estimateBtn = new QPushButton("估计时移");
+    connect(estimateBtn, &QPushButton::clicked, this, &GaugeAlignmentDialog::onEstimate);
+    buttonLayout->addWidget(estimateBtn);
+    buttonLayout->addStretch();
+    QPushButton* okBtn = new QPushButton("合并载入");
+    connect(okBtn, &QPushButton::clicked, this, &QDialog::accept);
+    buttonLayout->addWidget(okBtn);
+    QPushButton* cancelBtn = new QPushButton("取消");
+    connect(cancelBtn, &QPushButton::clicked, this, &QDialog::reject);
+    buttonLayout->addWidget(cancelBtn);
+    mainLayout->addLayout(buttonLayout);
+}
+
+int GaugeAlignmentDialog::referenceGauge() const
+{
+    return m_referenceCombo->currentIndex();
+}
+
+QVector<double> GaugeAlignmentDialog::shifts() const
+{
+    QVector<double> values;
+    for (QDoubleSpinBox* spin : m_shiftSpins) values.append(spin->value());
+    return values;
+}
+
+double GaugeAlignmentDialog::mergeTolerance() const
+{
+    return m_toleranceSpin->value();
+}
+
+void GaugeAlignmentDialog::onEstimate()
+{
+    GaugeAlignmentConfig config;
+    config.maxShift = m_maxShiftSpin->value();
+    const int reference = referenceGauge();
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QVector<GaugeShift> estimates = GaugeAlignment::estimateShifts(m_gauges, reference, config);
+    QApplication::restoreOverrideCursor();
+
+    double resolution = 0;
+    for (int g = 0; g < m_gauges.size(); ++g) {
+        m_shiftSpins[g]->blockSignals(true);
+        m_shiftSpins[g]->setValue(estimates[g].shift);
+        m_shiftSpins[g]->blockSignals(false);
+        m_shiftSpins[g]->setEnabled(g != reference);
+        m_table->item(g, 4)->setText(g == reference ? "参考" : QString::number(estimates[g].correlation, 'f', 3));
+        resolution = qMax(resolution, estimates[g].resolution);
+    }
+    updatePlot();
+    m_plot->rescaleAxes();
+    m_plot->replot();
+
+    m_summaryLabel->setText(QString("以“%1”为参考估计时移，重采样步长 %2 h；相关系数偏低（< 0.5）时"
+                                    "请检查压力计是否记录了同一事件，或手工修改时移。")
+                                .arg(m_gauges.value(reference).name)
+                                .arg(resolution, 0, 'g', 3));
+}
+
+void GaugeAlignmentDialog::updatePlot()
+{
+    const QVector<double> values = shifts();
+    for (int g = 0; g < m_gauges.size(); ++g) {
+        const GaugeSeries& gauge = m_gauges[g];
+        QVector<double> t(gauge.time.size()), p(gauge.time.size());
+        for (int i = 0; i < t.size(); ++i) {
+            t[i] = gauge.time[i] + values[g];
+            p[i] = gauge.pressure[i] - gauge.pressure.first();
+        }
+        m_plot->graph(g)->setData(t, p, true);
+    }
+    m_plot->replot();
+}
@@ -0,0 +1,128 @@
+#ifndef GAUGEALIGNMENT_H
+#define GAUGEALIGNMENT_H
+
+#include <QDialog>
+#include <QVector>
+#include <QString>
+#include <QStringList>
+
+class QCustomPlot;
+class QTableWidget;
+class QComboBox;
+class QDoubleSpinBox;
+class QLabel;
+
+// 一支压力计的记录
+struct GaugeSeries {
+    QString name;               // 显示名称（默认取文件名）
+    QString pressureHeader;     // 文件中压力列的列名
+    QVector<double> time;       // 时间\h；日期时间格式的文件为按儒略日计的绝对小时数
+    QVector<double> pressure;
+    bool absoluteTime;          // 时间列为日期时间（各文件可按同一时钟原点对齐）
+
+    GaugeSeries() : absoluteTime(false) {}
+};
+
+// 时移估计设置
+struct GaugeAlignmentConfig {
+    double maxShift;            // 搜索的最大时移\h；≤ 0 时取两支压力计重叠时长的一半
+    int maxGridPoints;          // 重采样网格的最大点数（超过时加大网格步长）
+    bool useDifference;         // 对压力一阶差分做互相关（消除不同深度压力计的静压差与漂移）
+
+    GaugeAlignmentConfig() :
+        maxShift(0.0),
+        maxGridPoints(1 << 20),
+        useDifference(true) {}
+};
+
+// 一支压力计相对参考压力计的时移：该压力计的时间加上 shift 后与参考压力计对齐
+struct GaugeShift {
+    double shift;
+    double correlation;         // 对齐后重叠段上的相关系数
+    double resolution;          // 重采样网格步长（时移估计的分辨率量级）
+
+    GaugeShift() : shift(0.0), correlation(0.0), resolution(0.0) {}
+};
+
+// 合并结果：按时间升序的一张表，每支压力计一列，无对应记录处为 NaN
+struct GaugeMergeResult {
+    QVector<double> time;
+    QVector<QVector<double>> pressure;      // pressure[g][row]
+    QVector<int> samplesUsed;               // 各压力计写入表格的记录数
+};
+
+/**
+ * @brief 多压力计时钟对齐与合并
+ *
+ * 时移估计：两支压力计按同一网格步长重采样（步长取较密一支的中位采样间隔，网格过大时放宽），
+ * 网格内多点取平均、空格线性插补，再对一阶差分去均值后做 FFT 互相关，
+ * 在 |lag| ≤ maxShift 内取正峰，并用峰两侧的值做抛物线插值得到亚网格时移。
+ * 两路实信号打包成一个复信号只做一次正变换，整体 O(N log N)。
+ * 合并：各压力计平移后按时间做 k 路归并（最小堆，O(N log k)），时间相差不超过容差的记录
+ * 并入同一行（每支压力计每行至多一条），其余各占一行，不插值、不丢弃记录。
+ */
+class GaugeAlignment
+{
+public:
+    /**
+     * 读取文本格式的压力计文件（分隔符自动识别）。时间列可为数值（按小时）、
+     * 日期时间或相邻的日期列 + 时刻列；有表头时按列名识别时间、压力列，否则取首列为时间、
+     * 其后第一个数值列为压力。
+     */
+    static bool readGaugeFile(const QString& filePath, GaugeSeries& series, QString& errorMessage);
+
+    static GaugeShift estimateShift(const GaugeSeries& reference, const GaugeSeries& other,
+                                    const GaugeAlignmentConfig& config = GaugeAlignmentConfig());
+
+    // 各压力计相对 gauges[reference] 的时移（参考压力计本身为 0）
+    static QVector<GaugeShift> estimateShifts(const QVector<GaugeSeries>& gauges, int reference,
+                                              const GaugeAlignmentConfig& config = GaugeAlignmentConfig());
+
+    /**
+     * @param tolerance 并入同一行的最大时间差；≤ 0 时取最密一支压力计中位采样间隔的一半
+     */
+    static GaugeMergeResult merge(const QVector<GaugeSeries>& gauges, const QVector<double>& shifts,
+                                  double tolerance = 0.0);
+
+    // 原地 radix-2 复数 FFT，长度需为 2 的幂；inverse 时结果未除以长度
+    static void fft(QVector<double>& re, QVector<double>& im, bool inverse);
+};
+
+/**
+ * @brief 多压力计导入对话框
+ *
+ * 列出所选文件及各自的记录数、估计时移与相关系数，时移可手工修改；
+ * 图中按当前时移叠画各压力计（减去各自首点压力，便于比较形态），
+ * 确认后由调用方把合并结果载入表格。
+ */
+class GaugeAlignmentDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    GaugeAlignmentDialog(const QVector<GaugeSeries>& gauges, QWidget* parent = nullptr);
+
+    int referenceGauge() const;
+    QVector<double> shifts() const;
+    double mergeTolerance() const;
+    const QVector<GaugeSeries>& gauges() const { return m_gauges; }
+
+private slots:
+    void onEstimate();
+    void updatePlot();
+
+private:
+    void setupUI();
+
+    QVector<GaugeSeries> m_gauges;
+
+    QTableWidget* m_table;
+    QComboBox* m_referenceCombo;
+    QDoubleSpinBox* m_maxShiftSpin;
+    QDoubleSpinBox* m_toleranceSpin;
+    QVector<QDoubleSpinBox*> m_shiftSpins;
+    QLabel* m_summaryLabel;
+    QCustomPlot* m_plot;
+};
+
+#endif // GAUGEALIGNMENT_H
@@ -0,0 +1,468 @@
+#include "gaugedatafilter.h"
+#include "qcustomplot.h"
+
+#include <QtConcurrent>
+#include <QApplication>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QGridLayout>
+#include <QCheckBox>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QLabel>
+#include <QPushButton>
+#include <set>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace {
+const int kChunkSize = 16384;
+
+// 滑动窗口中位数：low 存较小的一半（可多一个），high 存较大的一半
+class WindowMedian
+{
+public:
+    void insert(double v)
+    {
+        if (low.empty() || v <= *low.rbegin()) low.insert(v);
+        else high.insert(v);
+        rebalance();
+    }
+
+    void erase(double v)
+    {
+        if (!low.empty() && v <= *low.rbegin()) low.erase(low.find(v));
+        else high.erase(high.find(v));
+        rebalance();
+    }
+
+    double median() const
+    {
+        if (low.size() > high.size()) return *low.rbegin();
+        return 0.5 * (*low.rbegin() + *high.begin());
+    }
+
+private:
+    void rebalance()
+    {
+        while (low.size() > high.size() + 1) {
+            auto last = std::prev(low.end());
+            high.insert(*last);
+            low.erase(last);
+        }
+        while (high.size() > low.size()) {
+            low.insert(*high.begin());
+            high.erase(high.begin());
+        }
+    }
+
+    std::multiset<double> low, high;
+};
+
+QVector<int> chunkStarts(int n)
+{
+    QVector<int> starts;
+    for (int c0 = 0; c0 < n; c0 += kChunkSize) starts.append(c0);
+    return starts;
+}
+
+double medianOf(QVector<double> values)
+{
+    if (values.isEmpty()) return 0.0;
+    auto mid = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), mid, values.end());
+    return *mid;
+}
+
+// Daubechies-4 滤波器
+const double kSqrt3 = std::sqrt(3.0);
+const double kNorm = 4.0 * std::sqrt(2.0);
+const double kH[4] = {(1 + kSqrt3) / kNorm, (3 + kSqrt3) / kNorm, (3 - kSqrt3) / kNorm, (1 - kSqrt3) / kNorm};
+const double kG[4] = {kH[3], -kH[2], kH[1], -kH[0]};
+
+// 周期延拓下的一层分解：a[0, N) → 近似 a[0, N/2)、细节 a[N/2, N)
+void forwardStep(double* a, int N, QVector<double>& tmp)
+{
+    const int half = N / 2;
+    tmp.resize(N);
+    for (int i = 0; i < half; ++i) {
+        double s = 0, d = 0;
+        for (int k = 0; k < 4; ++k) {
+            double v = a[(2 * i + k) % N];
+            s += kH[k] * v;
+            d += kG[k] * v;
+        }
+        tmp[i] = s;
+        tmp[half + i] = d;
+    }
+    std::copy(tmp.constBegin(), tmp.constBegin() + N, a);
+}
+
+void inverseStep(double* a, int N, QVector<double>& tmp)
+{
+    const int half = N / 2;
+    tmp.fill(0.0, N);
+    for (int i = 0; i < half; ++i) {
+        for (int k = 0; k < 4; ++k) tmp[(2 * i + k) % N] += kH[k] * a[i] + kG[k] * a[half + i];
+    }
+    std::copy(tmp.constBegin(), tmp.constBegin() + N, a);
+}
+
+// 对称延拓的下标（周期 2n）
+inline int reflectIndex(int idx, int n)
+{
+    int period = 2 * n;
+    int m = idx % period;
+    if (m < 0) m += period;
+    return m < n ? m : period - 1 - m;
+}
+}
+
+QVector<double> GaugeDataFilter::rollingMedian(const QVector<double>& x, int halfWindow)
+{
+    const int n = x.size();
+    QVector<double> out(n);
+    const int w = qMax(0, halfWindow);
+
+    // 各块独立维护窗口，块首点的窗口从头建立
+    QVector<int> starts = chunkStarts(n);
+    QtConcurrent::blockingMap(starts, [&](int c0) {
+        const int c1 = qMin(c0 + kChunkSize, n);
+        WindowMedian window;
+        int lo = qMax(0, c0 - w), hi = lo;      // 窗口为 [lo, hi)
+        for (int i = c0; i < c1; ++i) {
+            const int a = qMax(0, i - w), b = qMin(n, i + w + 1);
+            while (hi < b) window.insert(x[hi++]);
+            while (lo < a) window.erase(x[lo++]);
+            out[i] = window.median();
+        }
+    });
+    return out;
+}
+
+QVector<double> GaugeDataFilter::hampel(const QVector<double>& x, int halfWindow, double threshold, int* outlierCount)
+{
+    if (outlierCount) *outlierCount = 0;
+    const int n = x.size();
+    QVector<double> out = x;
+    if (n < 3) return out;
+
+    QVector<double> median = rollingMedian(x, halfWindow);
+    QVector<double> residual(n);
+    for (int i = 0; i < n; ++i) residual[i] = std::abs(x[i] - median[i]);
+
+    // 稳健标准差；量化噪声下多数残差为 0 时退回平均绝对偏差
+    double sigma = 1.4826 * medianOf(residual);
+    if (!(sigma > 0)) {
+        double sum = 0;
+        for (double r : residual) sum += r;
+        sigma = 1.2533 * sum / n;
+    }
+    if (!(sigma > 0)) return out;
+
+    int count = 0;
+    for (int i = 0; i < n; ++i) {
+        if (residual[i] > threshold * sigma) {
+            out[i] = median[i];
+            ++count;
+        }
+    }
+    if (outlierCount) *outlierCount = count;
+    return out;
+}
+
+QVector<double> GaugeDataFilter::waveletDenoise(const QVector<double>& x, int levels, double scale, double* noiseLevel)
+{
+    if (noiseLevel) *noiseLevel = 0.0;
+    const int n = x.size();
+    if (n < 8) return x;
+
+    // 噪声水平：最细尺度细节系数的 MAD（D4 细节对线性趋势为 0）
+    QVector<double> finest;
+    finest.reserve(n / 2);
+    for (int i = 0; 2 * i + 3 < n; ++i) {
+        double d = 0;
+        for (int k = 0; k < 4; ++k) d += kG[k] * x[2 * i + k];
+        finest.append(std::abs(d));
+    }
+    const double sigma = medianOf(finest) / 0.6745;
+    if (noiseLevel) *noiseLevel = sigma;
+    if (!(sigma > 0)) return x;
+    const double lambda = scale * sigma * std::sqrt(2.0 * std::log(double(n)));
+
+    const int L = qBound(1, levels, 12);
+    const int block = 1 << L;
+    const int halo = 4 * block + 16;            // 周期延拓的回绕影响不超过约 3·2^L 个点
+    QVector<double> out(n);
+
+    QVector<int> starts = chunkStarts(n);
+    QtConcurrent::blockingMap(starts, [&](int c0) {
+        const int c1 = qMin(c0 + kChunkSize, n);
+        const int start = c0 - halo;
+        int len = (c1 - c0) + 2 * halo;
+        len = (len + block - 1) / block * block;
+        QVector<double> buffer(len), tmp;
+        for (int k = 0; k < len; ++k) buffer[k] = x[reflectIndex(start + k, n)];
+
+        for (int N = len, j = 0; j < L; ++j, N /= 2) forwardStep(buffer.data(), N, tmp);
+        for (int k = len >> L; k < len; ++k) {
+            double c = buffer[k];
+            buffer[k] = std::abs(c) <= lambda ? 0.0 : (c > 0 ? c - lambda : c + lambda);
+        }
+        for (int N = len >> (L - 1), j = 0; j < L; ++j, N *= 2) inverseStep(buffer.data(), N, tmp);
+
+        for (int i = c0; i < c1; ++i) out[i] = buffer[i - start];
+    });
+    return out;
+}
+
+QVector<int> GaugeDataFilter::logTimeDecimate(const QVector<double>& time, const QVector<double>& value,
+                                              int pointsPerDecade, const QVector<double>& periodStarts)
+{
+    const int n = qMin(time.size(), value.size());
+    QVector<int> kept;
+    if (n == 0) return kept;
+    const double density = qMax(1, pointsPerDecade);
+
+    auto keep = [&kept](int i) {
+        if (kept.isEmpty() || kept.last() < i) kept.append(i);
+    };
+
+    int period = -1;
+    int binPeriod = -2;
+    long long bin = 0;
+    int minIndex = -1, maxIndex = -1;
+    auto flush = [&]() {
+        if (minIndex < 0) return;
+        keep(qMin(minIndex, maxIndex));
+        keep(qMax(minIndex, maxIndex));
+        minIndex = maxIndex = -1;
+    };
+
+    keep(0);
+    for (int i = 0; i < n; ++i) {
+        while (period + 1 < periodStarts.size() && periodStarts[period + 1] <= time[i]) ++period;
+        const double origin = period >= 0 ? periodStarts[period] : time[0];
+        const double dt = time[i] - origin;
+        if (!(dt > 0)) {
+            // 段起点本身（及更早的点）单独保留
+            flush();
+            keep(i);
+            continue;
+        }
+        long long b = (long long)std::floor(density * std::log10(dt));
+        if (period != binPeriod || b != bin) {
+            flush();
+            binPeriod = period;
+            bin = b;
+        }
+        if (minIndex < 0 || value[i] < value[minIndex]) minIndex = i;
+        if (maxIndex < 0 || value[i] > value[maxIndex]) maxIndex = i;
+    }
+    flush();
+    keep(n - 1);
+    return kept;
+}
+
+GaugeFilterResult GaugeDataFilter::run(const QVector<double>& time, const QVector<double>& value,
+                                       const GaugeFilterConfig& config, const QVector<double>& periodStarts)
+{
+    GaugeFilterResult result;
+    const int n = qMin(time.size(), value.size());
+    result.values.fill(std::numeric_limits<double>::quiet_NaN(), value.size());
+
+    // 有效行按时间排序后处理（数据通常已排序，此时不做排序）
+    QVector<int> order;
+    order.reserve(n);
+    bool sorted = true;
+    for (int i = 0; i < n; ++i) {
+        if (!std::isfinite(time[i]) || !std::isfinite(value[i])) continue;
+        if (!order.isEmpty() && time[i] < time[order.last()]) sorted = false;
+        order.append(i);
+    }
+    if (!sorted) std::stable_sort(order.begin(), order.end(), [&time](int a, int b) { return time[a] < time[b]; });
+
+    QVector<double> t(order.size()), x(order.size());
+    for (int k = 0; k < order.size(); ++k) { t[k] = time[order[k]]; x[k] = value[order[k]]; }
+
+    if (config.hampel) x = hampel(x, config.hampelHalfWindow, config.hampelThreshold, &result.outlierCount);
+    if (config.wavelet) x = waveletDenoise(x, config.waveletLevels, config.waveletScale, &result.noiseLevel);
+
+    for (int k = 0; k < order.size(); ++k) result.values[order[k]] = x[k];
+
+    if (config.decimate) {
+        QVector<double> starts = periodStarts;
+        std::sort(starts.begin(), starts.end());
+        for (int k : logTimeDecimate(t, x, config.pointsPerDecade, starts)) result.keptRows.append(order[k]);
+        std::sort(result.keptRows.begin(), result.keptRows.end());
+    } else {
+        result.keptRows = order;
+        std::sort(result.keptRows.begin(), result.keptRows.end());
+    }
+    return result;
+}
+
+// ============================================================================
+// 数据预处理对话框
+// ============================================================================
+
+GaugeFilterDialog::GaugeFilterDialog(const QVector<double>& time, const QVector<double>& value,
+                                     const QString& columnName, const QVector<double>& periodStarts,
+                                     QWidget* parent)
+    : QDialog(parent),
+      m_time(time),
+      m_value(value),
+      m_periodStarts(periodStarts),
+      m_resultValid(false)
+{
+    setupUI(columnName);
+    onPreview();
+}
+
+void GaugeFilterDialog::setupUI(const QString& columnName)
+{
+    setWindowTitle(QString("数据预处理 - %1").arg(columnName));
+    setModal(true);
+    resize(760, 600);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout(this);
+
+    m_plot = new QCustomPlot(this);
+    m_plot->setBackground(Qt::white);
+    m_plot->xAxis->setLabel("时间 Time");
+    m_plot->yAxis->setLabel(columnName);
+    m_plot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+    m_plot->addGraph();
+    m_plot->graph(0)->setPen(QPen(QColor(170, 170, 170), 1));
+    m_plot->graph(0)->setName("原始数据");
+    m_plot->addGraph();
+    m_plot->graph(1)->setPen(QPen(Qt::red, 1.5));
+    m_plot->graph(1)->setName("处理后");
+    m_plot->legend->setVisible(true);
+    mainLayout->addWidget(m_plot, 1);
+
+    GaugeFilterConfig defaults;
+    QGridLayout* optionLayout = new QGridLayout;
+
+    m_hampelCheck = new QCheckBox("Hampel 去野值");
+    m_hampelCheck->setChecked(defaults.hampel);
+    optionLayout->addWidget(m_hampelCheck, 0, 0);
+    optionLayout->addWidget(new QLabel("窗口半宽:"), 0, 1);
+    m_hampelWindowSpin = new QSpinBox;
+    m_hampelWindowSpin->setRange(1, 500);
+    m_hampelWindowSpin->setValue(defaults.hampelHalfWindow);
+    m_hampelWindowSpin->setSuffix(" 点");
+    optionLayout->addWidget(m_hampelWindowSpin, 0, 2);
+    optionLayout->addWidget(new QLabel("阈值:"), 0, 3);
+    m_hampelThresholdSpin = new QDoubleSpinBox;
+    m_hampelThresholdSpin->setRange(1.0, 10.0);
+    m_hampelThresholdSpin->setSingleStep(0.5);
+    m_hampelThresholdSpin->setValue(defaults.hampelThreshold);
+    m_hampelThresholdSpin->setSuffix(" 倍稳健标准差");
+    optionLayout->addWidget(m_hampelThresholdSpin, 0, 4);
+
+    m_waveletCheck = new QCheckBox("小波阈值去噪");
+    m_waveletCheck->setChecked(defaults.wavelet);
+    optionLayout->addWidget(m_waveletCheck, 1, 0);
+    optionLayout->addWidget(new QLabel("分解层数:"), 1, 1);
+    m_waveletLevelSpin = new QSpinBox;
+    m_waveletLevelSpin->setRange(1, 12);
+    m_waveletLevelSpin->setValue(defaults.waveletLevels);
+    optionLayout->addWidget(m_waveletLevelSpin, 1, 2);
+    optionLayout->addWidget(new QLabel("阈值系数:"), 1, 3);
+    m_waveletScaleSpin = new QDoubleSpinBox;
+    m_waveletScaleSpin->setRange(0.1, 5.0);
+    m_waveletScaleSpin->setSingleStep(0.1);
+    m_waveletScaleSpin->setValue(defaults.waveletScale);
+    optionLayout->addWidget(m_waveletScaleSpin, 1, 4);
+
+    m_decimateCheck = new QCheckBox("对数时间抽稀");
+    m_decimateCheck->setChecked(defaults.decimate);
+    m_decimateCheck->setToolTip("每个对数时间区间只保留最大、最小值所在行，其余行将从表格中删除");
+    optionLayout->addWidget(m_decimateCheck, 2, 0);
+    optionLayout->addWidget(new QLabel("区间密度:"), 2, 1);
+    m_decimateDensitySpin = new QSpinBox;
+    m_decimateDensitySpin->setRange(5, 1000);
+    m_decimateDensitySpin->setValue(defaults.pointsPerDecade);
+    m_decimateDensitySpin->setSuffix(" /对数周期");
+    optionLayout->addWidget(m_decimateDensitySpin, 2, 2);
+    mainLayout->addLayout(optionLayout);
+
+    m_summaryLabel = new QLabel;
+    m_summaryLabel->setWordWrap(true);
+    mainLayout->addWidget(m_summaryLabel);
+
+    QHBoxLayout* buttonLayout = new QHBoxLayout;
+    QPushButton* previewBtn = new QPushButton("预览");
+    connect(previewBtn, &QPushButton::clicked, this, &GaugeFilterDialog::onPreview);
+    buttonLayout->addWidget(previewBtn);
+    buttonLayout->addStretch();
+    QPushButton* okBtn = new QPushButton("写入新列");
+    connect(okBtn, &QPushButton::clicked, this, &QDialog::accept);
+    buttonLayout->addWidget(okBtn);
+    QPushButton* cancelBtn = new QPushButton("取消");
+    connect(cancelBtn, &QPushButton::clicked, this, &QDialog::reject);
+    buttonLayout->addWidget(cancelBtn);
+    mainLayout->addLayout(buttonLayout);
+
+    for (QCheckBox* check : {m_hampelCheck, m_waveletCheck, m_decimateCheck})
+        connect(check, &QCheckBox::toggled, this, &GaugeFilterDialog::onConfigChanged);
+    for (QSpinBox* spin : {m_hampelWindowSpin, m_waveletLevelSpin, m_decimateDensitySpin})
+        connect(spin, QOverload<int>::of(&QSpinBox::valueChanged), this, &GaugeFilterDialog::onConfigChanged);
+    for (QDoubleSpinBox* spin : {m_hampelThresholdSpin, m_waveletScaleSpin})
+        connect(spin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &GaugeFilterDialog::onConfigChanged);
+}
+
+GaugeFilterConfig GaugeFilterDialog::config() const
+{
+    GaugeFilterConfig config;
+    config.hampel = m_hampelCheck->isChecked();
+    config.hampelHalfWindow = m_hampelWindowSpin->value();
+    config.hampelThreshold = m_hampelThresholdSpin->value();
+    config.wavelet = m_waveletCheck->isChecked();
+    config.waveletLevels = m_waveletLevelSpin->value();
+    config.waveletScale = m_waveletScaleSpin->value();
+    config.decimate = m_decimateCheck->isChecked();
+    config.pointsPerDecade = m_decimateDensitySpin->value();
+    return config;
+}
+
+GaugeFilterResult GaugeFilterDialog::result()
+{
+    if (!m_resultValid) {
+        m_result = GaugeDataFilter::run(m_time, m_value, config(), m_periodStarts);
+        m_resultValid = true;
+    }
+    return m_result;
+}
+
+void GaugeFilterDialog::onConfigChanged()
+{
+    m_resultValid = false;
+    m_summaryLabel->setText("参数已修改，点击“预览”查看处理效果");
+}
+
+void GaugeFilterDialog::onPreview()
+{
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    m_resultValid = false;
+    const GaugeFilterResult& r = result();
+    QApplication::restoreOverrideCursor();
+
+    QVector<double> t0, v0, t1, v1;
+    for (int i = 0; i < m_time.size() && i < m_value.size(); ++i) {
+        if (std::isfinite(m_time[i]) && std::isfinite(m_value[i])) { t0 << m_time[i]; v0 << m_value[i]; }
+    }
+    for (int i : r.keptRows) { t1 << m_time[i]; v1 << r.values[i]; }
+    m_plot->graph(0)->setData(t0, v0);
+    m_plot->graph(1)->setData(t1, v1);
+    m_plot->graph(1)->setScatterStyle(config().decimate ? QCPScatterStyle(QCPScatterStyle::ssDisc, 3)
+                                                        : QCPScatterStyle(QCPScatterStyle::ssNone));
+    m_plot->rescaleAxes();
+    m_plot->replot();
+
+    m_summaryLabel->setText(QString("有效数据 %1 行；替换野值 %2 个；估计噪声标准差 %3；保留 %4 行")
+                                .arg(t0.size()).arg(r.outlierCount).arg(r.noiseLevel, 0, 'g', 3)
+                                .arg(r.keptRows.size()));
+}
@@ -0,0 +1,127 @@
+#ifndef GAUGEDATAFILTER_H
+#define GAUGEDATAFILTER_H
+
+#include <QDialog>
+#include <QVector>
+#include <QString>
+
+class QCustomPlot;
+class QCheckBox;
+class QSpinBox;
+class QDoubleSpinBox;
+class QLabel;
+
+// 压力计数据预处理设置（按 Hampel → 小波 → 抽稀 的顺序执行）
+struct GaugeFilterConfig {
+    bool hampel;                // 滑动中位数（Hampel）去野值
+    int hampelHalfWindow;       // 窗口半宽（点数）
+    double hampelThreshold;     // 判为野值的残差阈值（稳健标准差的倍数）
+    bool wavelet;               // 小波阈值去噪
+    int waveletLevels;          // 分解层数
+    double waveletScale;        // 阈值相对通用阈值 σ·√(2 ln n) 的倍数
+    bool decimate;              // 对数时间抽稀
+    int pointsPerDecade;        // 每个对数周期的区间数
+
+    GaugeFilterConfig() :
+        hampel(true),
+        hampelHalfWindow(5),
+        hampelThreshold(3.0),
+        wavelet(true),
+        waveletLevels(4),
+        waveletScale(1.0),
+        decimate(false),
+        pointsPerDecade(50) {}
+};
+
+// 预处理结果，与输入逐行对应
+struct GaugeFilterResult {
+    QVector<double> values;     // 处理后的值；输入为缺测（非有限值）的行仍为 NaN
+    QVector<int> keptRows;      // 抽稀后保留的行（升序）；未抽稀时为全部有效行
+    int outlierCount;           // Hampel 替换的点数
+    double noiseLevel;          // 由最细尺度小波系数估计的噪声标准差
+
+    GaugeFilterResult() : outlierCount(0), noiseLevel(0) {}
+};
+
+/**
+ * @brief 压力计数据预处理：去野值、去噪与抽稀
+ *
+ * Hampel 滤波以滑动窗口中位数为基准，残差超过 k 倍稳健标准差（残差绝对值中位数 × 1.4826）
+ * 的点替换为中位数。窗口中位数用两个有序集合维护，每点 O(log w)；阶跃（开关井）两侧
+ * 各自保持，趋势不会像全局均值 ± kσ 那样被误判为异常。
+ * 小波去噪采用 Daubechies-4 正交小波，对各层细节系数做软阈值，噪声水平取最细尺度系数的
+ * 中位数绝对偏差；低频趋势留在近似系数中不受影响。
+ * 两种滤波都按块并行计算，块两端各带一段重叠区，拼接后与整体计算一致（小波在块边界处
+ * 仅有阈值量级的差别）。
+ * 抽稀在 ln(t − 段起点) 上分区间，每个区间只保留最大、最小值所在的行，保留峰谷与
+ * 早期的密集数据，长时间段的数据量按对数减少。
+ */
+class GaugeDataFilter
+{
+public:
+    /**
+     * @param periodStarts 流动段起点（升序）；抽稀时各段分别以起点为时间零点，为空时以首行时间为零点
+     */
+    static GaugeFilterResult run(const QVector<double>& time, const QVector<double>& value,
+                                 const GaugeFilterConfig& config,
+                                 const QVector<double>& periodStarts = QVector<double>());
+
+    // 窗口 [i − halfWindow, i + halfWindow]（在两端截断）内的中位数
+    static QVector<double> rollingMedian(const QVector<double>& x, int halfWindow);
+
+    static QVector<double> hampel(const QVector<double>& x, int halfWindow, double threshold,
+                                  int* outlierCount = nullptr);
+
+    static QVector<double> waveletDenoise(const QVector<double>& x, int levels, double scale,
+                                          double* noiseLevel = nullptr);
+
+    // 返回保留的下标（升序）；时间需已按升序排列
+    static QVector<int> logTimeDecimate(const QVector<double>& time, const QVector<double>& value,
+                                        int pointsPerDecade,
+                                        const QVector<double>& periodStarts = QVector<double>());
+};
+
+/**
+ * @brief 数据预处理对话框
+ *
+ * 调整参数后点击“预览”在图中对比原始数据与处理结果（抽稀时只画保留的点），
+ * 确认后由调用方写入新列。
+ */
+class GaugeFilterDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    GaugeFilterDialog(const QVector<double>& time, const QVector<double>& value, const QString& columnName,
+                      const QVector<double>& periodStarts = QVector<double>(), QWidget* parent = nullptr);
+
+    GaugeFilterConfig config() const;
+    // 最近一次预览的结果；参数在预览后又改动时按当前参数重新计算
+    GaugeFilterResult result();
+
+private slots:
+    void onPreview();
+    void onConfigChanged();
+
+private:
+    void setupUI(const QString& columnName);
+
+    QVector<double> m_time;
+    QVector<double> m_value;
+    QVector<double> m_periodStarts;
+    GaugeFilterResult m_result;
+    bool m_resultValid;
+
+    QCheckBox* m_hampelCheck;
+    QSpinBox* m_hampelWindowSpin;
+    QDoubleSpinBox* m_hampelThresholdSpin;
+    QCheckBox* m_waveletCheck;
+    QSpinBox* m_waveletLevelSpin;
+    QDoubleSpinBox* m_waveletScaleSpin;
+    QCheckBox* m_decimateCheck;
+    QSpinBox* m_decimateDensitySpin;
+    QLabel* m_summaryLabel;
+    QCustomPlot* m_plot;
+};
+
+#endif // GAUGEDATAFILTER_H
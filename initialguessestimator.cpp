@@ -0,0 +1,158 @@
+#include "initialguessestimator.h"
+#include <cmath>
+#include <algorithm>
+#include <functional>
+
+namespace {
+// 段内各点某个量的中位数（对数分箱后的曲线）
+double medianOver(const LogBinnedCurve& c, double tStart, double tEnd,
+                  const std::function<double(int)>& value)
+{
+    QVector<double> v;
+    for (int i = 0; i < c.t.size(); ++i) {
+        if (c.t[i] < tStart || c.t[i] > tEnd) continue;
+        double x = value(i);
+        if (std::isfinite(x) && x > 0) v.append(x);
+    }
+    if (v.isEmpty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+}
+
+InitialGuessResult InitialGuessEstimator::estimate(const QVector<double>& t, const QVector<double>& p,
+                                                   const QVector<double>& d, const QMap<QString, double>& current)
+{
+    InitialGuessResult result;
+    result.segments = FlowRegimeAnalyzer::analyze(t, p, d);
+    if (result.segments.isEmpty()) return result;
+    LogBinnedCurve c = FlowRegimeAnalyzer::logBin(t, p, d);
+
+    double phi = current.value("phi", 0.05);
+    double h = current.value("h", 20.0);
+    double mu = current.value("mu", 0.5);
+    double B = current.value("B", 1.05);
+    double Ct = current.value("Ct", 5e-4);
+    double q = current.value("q", 5.0);
+    double L = current.value("L", 1000.0);
+    double nf = qMax(1.0, current.value("nf", 4.0));
+    double kf = current.value("kf", 1e-3);
+    double km = current.value("km", 1e-4);
+    if (phi <= 0 || h <= 0 || mu <= 0 || B <= 0 || Ct <= 0 || q <= 0 || L <= 0 || kf <= 0 || km <= 0)
+        return result;
+
+    // Δp = pScale/kf·PD，tD = tScale·kf·t
+    const double pScale = 1.842e-3 * q * mu * B / h;
+    const double tScale = 14.4 / (phi * mu * Ct * L * L);
+
+    QVector<FlowRegimeSegment> radials;
+    const FlowRegimeSegment* storage = nullptr;
+    const FlowRegimeSegment* linear = nullptr;
+    const FlowRegimeSegment* boundary = nullptr;
+    for (const FlowRegimeSegment& s : result.segments) {
+        if (s.regime == FlowRegime::Radial) radials.append(s);
+        else if (s.regime == FlowRegime::Storage && !storage) storage = &s;
+        else if (s.regime == FlowRegime::Linear && (!linear || s.pointCount > linear->pointCount)) linear = &s;
+        else if (s.regime == FlowRegime::Boundary && !boundary) boundary = &s;
+    }
+
+    // 1. 径向流平台：PD' = 0.5（内区），外区为 0.5·kf/km
+    if (radials.size() >= 2) {
+        kf = pScale / (2.0 * radials.first().level);
+        km = pScale / (2.0 * radials.last().level);
+        result.values["kf"] = kf;
+        result.values["km"] = km;
+        result.notes << QString("内区径向流平台 Δp'=%1 → kf=%2").arg(radials.first().level, 0, 'g', 4).arg(kf, 0, 'g', 4);
+        result.notes << QString("外区径向流平台 Δp'=%1 → km=%2").arg(radials.last().level, 0, 'g', 4).arg(km, 0, 'g', 4);
+    } else if (radials.size() == 1) {
+        km = pScale / (2.0 * radials.first().level);
+        result.values["km"] = km;
+        result.notes << QString("径向流平台 Δp'=%1（按外区处理）→ km=%2").arg(radials.first().level, 0, 'g', 4).arg(km, 0, 'g', 4);
+    }
+
+    // 2. 井筒储集：PD = tD/CD，即 CD = pScale·tScale·t/Δp（与 kf 无关）
+    if (storage) {
+        double cD = medianOver(c, storage->tStart, storage->tEnd, [&](int i) {
+            return c.p[i] > 0 ? pScale * tScale * c.t[i] / c.p[i] : 0.0;
+        });
+        if (cD > 0) {
+            result.values["cD"] = cD;
+            result.notes << QString("单位斜率储集段 (%1~%2 h) → cD=%3").arg(storage->tStart, 0, 'g', 3)
+                                .arg(storage->tEnd, 0, 'g', 3).arg(cD, 0, 'g', 4);
+        }
+    }
+
+    // 3. 裂缝线性流：PD = √(π·tD)/(nf·LfD)，导数为其一半
+    if (linear) {
+        double LfD = medianOver(c, linear->tStart, linear->tEnd, [&](int i) {
+            return pScale / kf * std::sqrt(M_PI * tScale * kf * c.t[i]) / (2.0 * nf * c.d[i]);
+        });
+        if (LfD > 0) {
+            result.values["Lf"] = LfD * L;
+            result.notes << QString("1/2 斜率线性流段 (%1~%2 h) → Lf=%3 m").arg(linear->tStart, 0, 'g', 3)
+                                .arg(linear->tEnd, 0, 'g', 3).arg(LfD * L, 0, 'g', 4);
+        }
+    }
+
+    // 4. 内外区过渡：外区径向流开始前，探测半径 rD ≈ 2√tD 到达复合半径
+    if (!radials.isEmpty()) {
+        const FlowRegimeSegment& outer = radials.last();
+        double tPrevEnd = 0;
+        for (const FlowRegimeSegment& s : result.segments)
+            if (s.tEnd < outer.tStart) tPrevEnd = s.tEnd;
+        if (tPrevEnd > 0) {
+            double tTransition = std::sqrt(tPrevEnd * outer.tStart);
+            double rmD = 2.0 * std::sqrt(tScale * kf * tTransition);
+            result.values["rmD"] = rmD;
+            result.notes << QString("外区径向流前的过渡时间 %1 h → rmD=%2").arg(tTransition, 0, 'g', 3).arg(rmD, 0, 'g', 4);
+        }
+    }
+
+    // 5. 双重介质：外区径向流前的导数凹陷
+    if (!radials.isEmpty()) {
+        const FlowRegimeSegment& outer = radials.last();
+        double from = (radials.size() >= 2) ? radials.first().tEnd : (storage ? storage->tEnd : 0.0);
+        double reference = (radials.size() >= 2) ? qMin(radials.first().level, outer.level) : outer.level;
+        int iMin = -1, iFirst = -1, iLast = -1;
+        for (int i = 0; i < c.t.size(); ++i) {
+            if (c.t[i] <= from || c.t[i] >= outer.tStart) continue;
+            if (iFirst < 0) iFirst = i;
+            iLast = i;
+            if (iMin < 0 || c.d[i] < c.d[iMin]) iMin = i;
+        }
+        // 只有内部极小值才算凹陷（单调上升到平台的过渡不算）
+        if (iMin > iFirst && iMin < iLast && c.d[iMin] < 0.9 * reference) {
+            double omega = solveOmega(c.d[iMin] / reference);
+            double tDmin = tScale * kf * c.t[iMin];
+            double lambda = omega * std::log(1.0 / omega) / tDmin;
+            result.values["omega1"] = omega;
+            result.values["lambda1"] = lambda;
+            result.notes << QString("导数凹陷 Δp'min/Δp'=%1 (t=%2 h) → ω=%3, λ=%4")
+                                .arg(c.d[iMin] / reference, 0, 'f', 3).arg(c.t[iMin], 0, 'g', 3)
+                                .arg(omega, 0, 'g', 3).arg(lambda, 0, 'g', 3);
+        }
+    }
+
+    // 6. 边界：边界效应出现时外区探测半径 rD ≈ 2√(tD·km/kf)
+    if (boundary) {
+        double reD = 2.0 * std::sqrt(tScale * km * boundary->tStart);
+        result.values["reD"] = reD;
+        result.notes << QString("边界效应出现于 %1 h → reD=%2").arg(boundary->tStart, 0, 'g', 3).arg(reD, 0, 'g', 4);
+    }
+
+    return result;
+}
+
+double InitialGuessEstimator::solveOmega(double ratio)
+{
+    // Δp'min/Δp'径向 = 1 + ω^(1/(1-ω)) - ω^(ω/(1-ω))，在 (0,1) 上单调递增，二分求解
+    auto f = [](double w) { return 1.0 + std::pow(w, 1.0 / (1.0 - w)) - std::pow(w, w / (1.0 - w)); };
+    double lo = 1e-4, hi = 0.99;
+    if (ratio <= f(lo)) return lo;
+    if (ratio >= f(hi)) return hi;
+    for (int k = 0; k < 60; ++k) {
+        double mid = 0.5 * (lo + hi);
+        if (f(mid) < ratio) lo = mid; else hi = mid;
+    }
+    return 0.5 * (lo + hi);
+}
@@ -0,0 +1,36 @@
+#ifndef INITIALGUESSESTIMATOR_H
+#define INITIALGUESSESTIMATOR_H
+
+#include <QMap>
+#include <QVector>
+#include <QStringList>
+#include "flowregimeanalyzer.h"
+
+// 初值估计结果
+struct InitialGuessResult {
+    QMap<QString, double> values;          // 估计得到的参数（未做范围限制）
+    QStringList notes;                     // 每个估计值的依据
+    QVector<FlowRegimeSegment> segments;   // 识别出的流动段
+};
+
+/**
+ * @brief 由流动段估计拟合初值
+ *
+ * 依据识别出的流动段，用各流动段的解析近似反推参数：
+ * 径向流导数平台 → kf / km；单位斜率储集段 → cD；1/2 斜率线性流 → Lf；
+ * 两个径向流之间的导数凹陷 → ω / λ；内外区过渡时间 → rmD；边界出现时间 → reD。
+ * 量纲换算与模型一致：tD = 14.4·kf·t/(φμCtL²)，Δp = 1.842e-3·qμB/(kf·h)·PD。
+ */
+class InitialGuessEstimator
+{
+public:
+    // current 提供基础参数（φ、h、μ、B、Ct、q、L、nf）以及未能估计时沿用的 kf、km
+    static InitialGuessResult estimate(const QVector<double>& t, const QVector<double>& p,
+                                       const QVector<double>& d, const QMap<QString, double>& current);
+
+private:
+    // 由导数凹陷深度 Δp'min/Δp'径向 反解储容比 ω（拟稳态窜流）
+    static double solveOmega(double ratio);
+};
+
+#endif // INITIALGUESSESTIMATOR_H
@@ -0,0 +1,148 @@
+#include "laplacetransform.h"
+#include <cmath>
+#include <algorithm>
+#include <boost/math/special_functions/gamma.hpp>
+#include <boost/math/special_functions/expint.hpp>
+
+namespace {
+// 对数坐标下 [first, last] 的最小二乘直线斜率与在 xRef 处的取值，点数不足返回 false
+bool fitLogLine(const QVector<double>& x, const QVector<double>& y, int first, int last,
+                double xRef, double& slope, double& valueAtRef)
+{
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    int n = 0;
+    for (int i = first; i <= last; ++i) {
+        if (!(x[i] > 0 && y[i] > 0)) continue;
+        double lx = std::log(x[i]), ly = std::log(y[i]);
+        sx += lx; sy += ly; sxx += lx * lx; sxy += lx * ly; ++n;
+    }
+    if (n < 2) return false;
+    double den = sxx - sx * sx / n;
+    if (den <= 1e-30) return false;
+    slope = (sxy - sx * sy / n) / den;
+    valueAtRef = std::exp((sy - slope * sx) / n + slope * std::log(xRef));
+    return true;
+}
+
+// ∫_a^(a+Δ) 线性插值压差·e^(-st) dt = e^(-sa)/s·(pa·w1 + pb·w2)，x = s·Δ
+double segmentIntegral(double s, double a, double dt, double pa, double pb)
+{
+    double x = s * dt;
+    double w1, w2;
+    if (x < 1e-3) {
+        w1 = x / 2.0 - x * x / 6.0 + x * x * x / 24.0;
+        w2 = x / 2.0 - x * x / 3.0 + x * x * x / 8.0;
+    } else {
+        double ex = -std::expm1(-x) / x;    // (1 - e^(-x))/x
+        w1 = 1.0 - ex;
+        w2 = ex - std::exp(-x);
+    }
+    return std::exp(-s * a) / s * (pa * w1 + pb * w2);
+}
+}
+
+QVector<double> LaplaceDataTransform::sampleVariables(double tMin, double tMax, int pointsPerDecade, int maxCount)
+{
+    QVector<double> s;
+    if (!(tMin > 0 && tMax > tMin) || pointsPerDecade <= 0 || maxCount < 2) return s;
+    double lo = std::log10(2.0 / tMax);
+    double hi = std::log10(0.5 / tMin);
+    if (hi <= lo) return s;
+    int count = qBound(2, (int)std::ceil((hi - lo) * pointsPerDecade) + 1, maxCount);
+    for (int i = 0; i < count; ++i)
+        s.append(std::pow(10.0, lo + (hi - lo) * i / (count - 1)));
+    return s;
+}
+
+LaplaceSampledData LaplaceDataTransform::transform(const QVector<double>& tIn, const QVector<double>& pIn,
+                                                   const QVector<double>& dIn, const QVector<double>& s)
+{
+    LaplaceSampledData out;
+    QVector<double> t, p, d;
+    int n0 = qMin(tIn.size(), pIn.size());
+    for (int i = 0; i < n0; ++i) {
+        if (!(tIn[i] > 0 && std::isfinite(tIn[i]) && std::isfinite(pIn[i]))) continue;
+        if (!t.isEmpty() && tIn[i] <= t.last()) continue;
+        t.append(tIn[i]); p.append(pIn[i]);
+        d.append(i < dIn.size() ? dIn[i] : 0.0);
+    }
+    int n = t.size();
+    if (n < 3 || s.isEmpty()) return out;
+
+    // 早期：Δp = p0·(t/t0)^a，a 取首 0.3 个对数周期（至少 5 个点）的双对数斜率；
+    // p0 取实测首点而非拟合值，保证与数据段在 t0 处连续
+    double a = 1.0, unusedFitAtT0 = 0.0;
+    int headLast = 0;
+    while (headLast + 1 < n && (headLast < 4 || t[headLast + 1] < t[0] * 2.0)) ++headLast;
+    if (fitLogLine(t, p, 0, headLast, t[0], a, unusedFitAtT0)) a = qBound(0.1, a, 1.5);
+    else a = 1.0;
+
+    // 晚期：导数 d_N·(t/t_N)^nTail，取末 0.5 个对数周期（至少 5 个点）
+    const double tN = t.last(), pN = p.last();
+    int tailFirst = n - 1;
+    while (tailFirst > 0 && (n - tailFirst < 5 || t[tailFirst - 1] > tN / std::sqrt(10.0))) --tailFirst;
+    double nTail = 0.0, dN = 0.0;
+    if (fitLogLine(t, d, tailFirst, n - 1, tN, nTail, dN)) {
+        nTail = qBound(-0.5, nTail, 1.0);
+    } else {
+        // 无导数：末段压差对 ln t 的斜率（按径向流外推）
+        double sx = 0, sy = 0, sxx = 0, sxy = 0;
+        int m = n - tailFirst;
+        for (int i = tailFirst; i < n; ++i) {
+            double lx = std::log(t[i]);
+            sx += lx; sy += p[i]; sxx += lx * lx; sxy += lx * p[i];
+        }
+        double den = sxx - sx * sx / m;
+        dN = (den > 1e-30) ? qMax(0.0, (sxy - sx * sy / m) / den) : 0.0;
+        nTail = 0.0;
+    }
+
+    for (double sv : s) {
+        if (!(sv > 0)) continue;
+        // 首点之前：p0·t0·γ(a+1, x)/x^(a+1)，x = s·t0
+        double x0 = sv * t[0];
+        double head = p[0] * t[0] * boost::math::tgamma_lower(a + 1.0, x0) / std::pow(x0, a + 1.0);
+
+        // 数据段：e^(-st) 下溢后不再累加
+        double body = 0.0;
+        for (int i = 0; i + 1 < n; ++i) {
+            if (sv * t[i] > 700.0) break;
+            body += segmentIntegral(sv, t[i], t[i + 1] - t[i], p[i], p[i + 1]);
+        }
+
+        // 末点之后
+        double xN = sv * tN;
+        double tail = 0.0;
+        if (xN < 700.0) {
+            tail = pN * std::exp(-xN) / sv;
+            if (dN > 0) {
+                if (std::abs(nTail) < 1e-3) {
+                    tail += dN * boost::math::expint(1, xN) / sv;
+                } else {
+                    double upper = tN * boost::math::tgamma(nTail + 1.0, xN) / std::pow(xN, nTail + 1.0);
+                    tail += dN / nTail * (upper - std::exp(-xN) / sv);
+                }
+            }
+        }
+
+        double total = head + body + tail;
+        out.s.append(sv);
+        out.value.append(total);
+        out.extrapolated.append(std::abs(total) > 0 ? qMin(1.0, (std::abs(head) + std::abs(tail)) / std::abs(total)) : 1.0);
+    }
+    out.derivative = logDerivative(out.s, out.value);
+    return out;
+}
+
+QVector<double> LaplaceDataTransform::logDerivative(const QVector<double>& s, const QVector<double>& F)
+{
+    int n = qMin(s.size(), F.size());
+    QVector<double> D(n, 0.0);
+    if (n < 2) return D;
+    for (int i = 0; i < n; ++i) {
+        int lo = qMax(0, i - 1), hi = qMin(n - 1, i + 1);
+        double dl = std::log(s[hi]) - std::log(s[lo]);
+        if (dl > 0) D[i] = -(s[hi] * F[hi] - s[lo] * F[lo]) / dl;
+    }
+    return D;
+}
@@ -0,0 +1,37 @@
+#ifndef LAPLACETRANSFORM_H
+#define LAPLACETRANSFORM_H
+
+#include <QVector>
+
+// 观测压差在一组拉普拉斯变量上的变换值
+struct LaplaceSampledData {
+    QVector<double> s;              // 拉普拉斯变量（1/h）
+    QVector<double> value;          // Δp̄(s)
+    QVector<double> derivative;     // -d(s·Δp̄)/d ln s，对应时间域的 Bourdet 导数
+    QVector<double> extrapolated;   // 首点之前与末点之后的外推部分在 Δp̄(s) 中的占比
+};
+
+/**
+ * @brief 观测数据的拉普拉斯变换
+ *
+ * 数据点之间按时间线性插值，每段与 e^(-st) 的乘积解析积分（小 s·Δt 时用级数，避免相消）；
+ * 首点之前按前几个点的双对数斜率做幂律外推（过原点），末点之后按晚期导数的双对数斜率
+ * 外推：导数 ∝ t^n 时压差为 p_N + d_N/n·((t/t_N)^n - 1)，用不完全伽马函数解析积分，
+ * n≈0（径向流）时退化为对数，积分为指数积分 E1。
+ * 整个变换只做一次，拉普拉斯域拟合每次只需计算模型在几十个 s 上的解析解。
+ */
+class LaplaceDataTransform
+{
+public:
+    // s 取 [2/tMax, 0.5/tMin] 内的对数等距点，数目不超过 maxCount
+    static QVector<double> sampleVariables(double tMin, double tMax, int pointsPerDecade = 8, int maxCount = 40);
+
+    // t 升序；d 为观测导数（可为空，此时由末段压差估计晚期导数）
+    static LaplaceSampledData transform(const QVector<double>& t, const QVector<double>& p,
+                                        const QVector<double>& d, const QVector<double>& s);
+
+    // G = s·F 对 ln s 的中心差分（两端单侧差分），取负号
+    static QVector<double> logDerivative(const QVector<double>& s, const QVector<double>& F);
+};
+
+#endif // LAPLACETRANSFORM_H
@@ -1,4 +1,6 @@
 #include "mainwindow.h"
+#include "batchfitrunner.h"
+#include "modelmanager.h"
 #include <QApplication >
 #include <QStyleFactory>
 #include <QMessageBox>
@@ -6,8 +8,22 @@
 
 int main(int argc, char *argv[])
 {
+    // 批量拟合模式：不显示界面，模型计算仍依赖模型窗口，因此用离屏平台创建
+    bool batchMode = false;
+    for (int i = 1; i < argc; ++i)
+        if (QString::fromLocal8Bit(argv[i]) == "--batch") batchMode = true;
+    if (batchMode && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
     QApplication app(argc, argv);
 
+    if (batchMode) {
+        QWidget host;
+        ModelManager manager(&host);
+        manager.initializeModels(&host);
+        return BatchFitRunner::runFromCommandLine(app.arguments(), &manager);
+    }
+
     // 设置全局样式，确保所有对话框和消息框的文本都显示为黑色
     QString styleSheet = R"(
         /* 全局黑色文字样式 */
@@ -0,0 +1,242 @@
+#include "modelcurveinterpolator.h"
+
+#include <cmath>
+#include <algorithm>
+
+QVector<double> ModelCurveInterpolator::buildLogGrid(double tMin, double tMax, int pointsPerDecade)
+{
+    QVector<double> grid;
+    if (tMin <= 0 || tMax <= tMin || pointsPerDecade < 1) return grid;
+
+    double e0 = std::log10(tMin);
+    double e1 = std::log10(tMax);
+    int n = std::max(2, (int)std::ceil((e1 - e0) * pointsPerDecade) + 1);
+    grid.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        grid.append(std::pow(10.0, e0 + (e1 - e0) * i / (n - 1)));
+    }
+    // 端点严格取观测范围，避免插值时外推
+    grid.first() = tMin;
+    grid.last() = tMax;
+    return grid;
+}
+
+QVector<double> ModelCurveInterpolator::buildAdaptiveGrid(const QVector<double>& obsTime,
+                                                          const CurveEvaluator& evaluator,
+                                                          const ModelGridConfig& config,
+                                                          ModelCurveData* outGridCurve)
+{
+    double tMin = -1.0, tMax = -1.0;
+    int positiveCount = 0;
+    for (double t : obsTime) {
+        if (t <= 0) continue;
+        if (tMin < 0 || t < tMin) tMin = t;
+        if (tMax < 0 || t > tMax) tMax = t;
+        ++positiveCount;
+    }
+    if (positiveCount < 3 || tMax <= tMin) return QVector<double>();
+
+    // 1. 基础网格
+    QVector<double> grid = buildLogGrid(tMin, tMax, config.pointsPerDecade);
+    if (grid.size() >= positiveCount) return QVector<double>();
+    ModelCurveData curve = evaluator(grid);
+
+    // 2. 曲率大的区间加密
+    QVector<double> refined = refineGrid(curve, config.curvatureTol, config.maxPointsPerDecade);
+    if (refined.size() > grid.size()) {
+        if (refined.size() >= positiveCount) return QVector<double>();
+        grid = refined;
+        curve = evaluator(grid);
+    }
+
+    // 3. 校验点误差检查，不满足则整体提升到最大密度
+    double err = checkGridError(obsTime, curve, evaluator, config.checkPoints);
+    if (err > config.checkTol && config.maxPointsPerDecade > config.pointsPerDecade) {
+        QVector<double> dense = buildLogGrid(tMin, tMax, config.maxPointsPerDecade);
+        if (dense.size() >= positiveCount) return QVector<double>();
+        grid = dense;
+        curve = evaluator(grid);
+    }
+
+    if (outGridCurve) *outGridCurve = curve;
+    return grid;
+}
+
+double ModelCurveInterpolator::checkGridError(const QVector<double>& obsTime,
+                                              const ModelCurveData& gridCurve,
+                                              const CurveEvaluator& evaluator,
+                                              int checkPoints)
+{
+    const QVector<double>& gridT = std::get<0>(gridCurve);
+    const QVector<double>& gridP = std::get<1>(gridCurve);
+    if (checkPoints <= 0 || gridT.size() < 2 || gridP.size() != gridT.size()) return 0.0;
+
+    QVector<double> positive;
+    positive.reserve(obsTime.size());
+    for (double t : obsTime) if (t > 0) positive.append(t);
+    if (positive.isEmpty()) return 0.0;
+
+    // 在观测点中均匀选取内部校验点
+    QVector<double> checkT;
+    for (int k = 0; k < checkPoints; ++k) {
+        int idx = (int)((long long)(k + 1) * positive.size() / (checkPoints + 1));
+        idx = std::min(idx, (int)positive.size() - 1);
+        checkT.append(positive[idx]);
+    }
+    std::sort(checkT.begin(), checkT.end());
+
+    ModelCurveData direct = evaluator(checkT);
+    const QVector<double>& directP = std::get<1>(direct);
+    QVector<double> interpP = interpolateLogLog(gridT, gridP, checkT);
+
+    double maxErr = 0.0;
+    int count = std::min(directP.size(), interpP.size());
+    for (int i = 0; i < count; ++i) {
+        double ref = std::abs(directP[i]);
+        if (ref < 1e-12) continue;
+        maxErr = std::max(maxErr, std::abs(interpP[i] - directP[i]) / ref);
+    }
+    return maxErr;
+}
+
+double ModelCurveInterpolator::curvatureAt(const QVector<double>& lx, const QVector<double>& ly, int i)
+{
+    // 双对数空间中相邻两段斜率之差
+    double h0 = lx[i] - lx[i - 1];
+    double h1 = lx[i + 1] - lx[i];
+    if (h0 <= 0 || h1 <= 0) return 0.0;
+    return std::abs((ly[i + 1] - ly[i]) / h1 - (ly[i] - ly[i - 1]) / h0);
+}
+
+QVector<double> ModelCurveInterpolator::refineGrid(const ModelCurveData& gridCurve, double curvatureTol, int maxPointsPerDecade)
+{
+    const QVector<double>& t = std::get<0>(gridCurve);
+    const QVector<double>& p = std::get<1>(gridCurve);
+    const QVector<double>& d = std::get<2>(gridCurve);
+    int n = t.size();
+    if (n < 3 || p.size() != n) return t;
+
+    QVector<double> lx(n), lp(n), ld(n);
+    QVector<bool> valid(n);
+    for (int i = 0; i < n; ++i) {
+        lx[i] = std::log(t[i]);
+        bool ok = p[i] > 0 && (d.size() != n || d[i] > 0);
+        valid[i] = ok;
+        lp[i] = p[i] > 0 ? std::log(p[i]) : 0.0;
+        ld[i] = (d.size() == n && d[i] > 0) ? std::log(d[i]) : 0.0;
+    }
+
+    // 标记需要加密的区间 [i, i+1]
+    QVector<bool> mark(n - 1, false);
+    for (int i = 1; i < n - 1; ++i) {
+        if (!valid[i - 1] || !valid[i] || !valid[i + 1]) continue;
+        double c = curvatureAt(lx, lp, i);
+        if (d.size() == n) c = std::max(c, curvatureAt(lx, ld, i));
+        if (c > curvatureTol) { mark[i - 1] = true; mark[i] = true; }
+    }
+
+    double minWidth = std::log(10.0) / std::max(1, maxPointsPerDecade);
+    QVector<double> refined;
+    refined.reserve(2 * n);
+    for (int i = 0; i < n - 1; ++i) {
+        refined.append(t[i]);
+        if (mark[i] && (lx[i + 1] - lx[i]) > 1.5 * minWidth) {
+            refined.append(std::exp(0.5 * (lx[i] + lx[i + 1])));
+        }
+    }
+    refined.append(t[n - 1]);
+    return refined;
+}
+
+QVector<double> ModelCurveInterpolator::pchipSlopes(const QVector<double>& x, const QVector<double>& y)
+{
+    int n = x.size();
+    QVector<double> slopes(n, 0.0);
+    if (n < 2) return slopes;
+
+    QVector<double> h(n - 1), del(n - 1);
+    for (int k = 0; k < n - 1; ++k) {
+        h[k] = x[k + 1] - x[k];
+        del[k] = (h[k] > 0) ? (y[k + 1] - y[k]) / h[k] : 0.0;
+    }
+    if (n == 2) { slopes[0] = slopes[1] = del[0]; return slopes; }
+
+    // 内部节点：加权调和平均 (Fritsch-Butland)，保证单调段不过冲
+    for (int k = 1; k < n - 1; ++k) {
+        if (del[k - 1] * del[k] <= 0) { slopes[k] = 0.0; continue; }
+        double w1 = 2.0 * h[k] + h[k - 1];
+        double w2 = h[k] + 2.0 * h[k - 1];
+        slopes[k] = (w1 + w2) / (w1 / del[k - 1] + w2 / del[k]);
+    }
+
+    // 端点：三点公式 + 形状保持修正
+    auto endSlope = [](double h0, double h1, double d0, double d1) {
+        double s = ((2.0 * h0 + h1) * d0 - h0 * d1) / (h0 + h1);
+        if (s * d0 <= 0) return 0.0;
+        if (d0 * d1 <= 0 && std::abs(s) > 3.0 * std::abs(d0)) return 3.0 * d0;
+        return s;
+    };
+    slopes[0] = endSlope(h[0], h[1], del[0], del[1]);
+    slopes[n - 1] = endSlope(h[n - 2], h[n - 3], del[n - 2], del[n - 3]);
+    return slopes;
+}
+
+QVector<double> ModelCurveInterpolator::interpolateLogLog(const QVector<double>& xNodes,
+                                                          const QVector<double>& yNodes,
+                                                          const QVector<double>& xTargets)
+{
+    QVector<double> out(xTargets.size(), 0.0);
+    int n = std::min(xNodes.size(), yNodes.size());
+    if (n == 0) return out;
+    if (n == 1) { out.fill(yNodes[0]); return out; }
+
+    bool allPositive = true;
+    for (int i = 0; i < n; ++i) if (yNodes[i] <= 0) { allPositive = false; break; }
+
+    QVector<double> lx(n), ly(n);
+    for (int i = 0; i < n; ++i) {
+        lx[i] = std::log(xNodes[i]);
+        ly[i] = allPositive ? std::log(yNodes[i]) : yNodes[i];
+    }
+    QVector<double> m = pchipSlopes(lx, ly);
+
+    // 目标时间通常递增，用游标顺序推进；遇到回退时退化为二分查找
+    int seg = 0;
+    double prevX = -HUGE_VAL;
+    for (int j = 0; j < xTargets.size(); ++j) {
+        double xt = xTargets[j];
+        if (xt <= 0) { out[j] = 0.0; continue; }
+        double lxt = std::log(xt);
+
+        double v;
+        if (lxt <= lx[0]) v = ly[0];
+        else if (lxt >= lx[n - 1]) v = ly[n - 1];
+        else {
+            if (lxt < prevX) {
+                seg = (int)(std::upper_bound(lx.begin(), lx.end(), lxt) - lx.begin()) - 1;
+            } else {
+                while (seg < n - 2 && lx[seg + 1] <= lxt) ++seg;
+            }
+            seg = std::max(0, std::min(seg, n - 2));
+            double hk = lx[seg + 1] - lx[seg];
+            double s = (lxt - lx[seg]) / hk;
+            double s2 = s * s, s3 = s2 * s;
+            double h00 = 2 * s3 - 3 * s2 + 1;
+            double h10 = s3 - 2 * s2 + s;
+            double h01 = -2 * s3 + 3 * s2;
+            double h11 = s3 - s2;
+            v = h00 * ly[seg] + h10 * hk * m[seg] + h01 * ly[seg + 1] + h11 * hk * m[seg + 1];
+        }
+        prevX = lxt;
+        out[j] = allPositive ? std::exp(v) : v;
+    }
+    return out;
+}
+
+ModelCurveData ModelCurveInterpolator::interpolateCurve(const ModelCurveData& gridCurve, const QVector<double>& targetTime)
+{
+    const QVector<double>& t = std::get<0>(gridCurve);
+    QVector<double> p = interpolateLogLog(t, std::get<1>(gridCurve), targetTime);
+    QVector<double> d = interpolateLogLog(t, std::get<2>(gridCurve), targetTime);
+    return std::make_tuple(targetTime, p, d);
+}
@@ -0,0 +1,83 @@
+#ifndef MODELCURVEINTERPOLATOR_H
+#define MODELCURVEINTERPOLATOR_H
+
+#include <QVector>
+#include <functional>
+#include <tuple>
+
+// 定义数据类型: <时间t, 压力p, 导数dp>
+typedef std::tuple<QVector<double>, QVector<double>, QVector<double>> ModelCurveData;
+
+// 粗网格配置
+struct ModelGridConfig {
+    int pointsPerDecade;      // 基础网格密度（每个对数周期的点数）
+    int maxPointsPerDecade;   // 曲率加密后的最大密度
+    double curvatureTol;      // 双对数空间二阶差分阈值，超过则在该区间加密
+    int checkPoints;          // 直接计算校验点数
+    double checkTol;          // 校验点允许的最大相对误差
+
+    ModelGridConfig() :
+        pointsPerDecade(12),
+        maxPointsPerDecade(24),
+        curvatureTol(0.05),
+        checkPoints(4),
+        checkTol(0.01) {}
+};
+
+/**
+ * @brief 模型曲线粗网格插值器
+ *
+ * 在自适应加密的对数时间网格上计算理论曲线，再通过双对数空间中的
+ * 单调三次 Hermite 样条 (PCHIP, Fritsch-Carlson) 插值到观测时刻。
+ * 模型计算量只取决于网格点数，与用户加载的观测点数无关。
+ */
+class ModelCurveInterpolator
+{
+public:
+    // 给定时间序列，返回该时间序列上的理论曲线
+    typedef std::function<ModelCurveData(const QVector<double>&)> CurveEvaluator;
+
+    /**
+     * @brief 构建自适应对数时间网格
+     * @param obsTime 观测时间（决定网格覆盖范围）
+     * @param evaluator 模型计算回调
+     * @param config 网格配置
+     * @param outGridCurve 输出：最终网格上的理论曲线（可直接复用）
+     * @return 网格时间序列；观测点数不多于网格点数时返回空（直接计算更划算）
+     */
+    static QVector<double> buildAdaptiveGrid(const QVector<double>& obsTime,
+                                             const CurveEvaluator& evaluator,
+                                             const ModelGridConfig& config,
+                                             ModelCurveData* outGridCurve = nullptr);
+
+    /**
+     * @brief 用若干直接计算的校验点检查网格插值误差（仅比较压力，导数依赖相邻点）
+     * @return 最大相对误差
+     */
+    static double checkGridError(const QVector<double>& obsTime,
+                                 const ModelCurveData& gridCurve,
+                                 const CurveEvaluator& evaluator,
+                                 int checkPoints);
+
+    // 生成 [tMin, tMax] 上等对数间距网格（包含两个端点）
+    static QVector<double> buildLogGrid(double tMin, double tMax, int pointsPerDecade);
+
+    // 将网格上的理论曲线插值到目标时刻
+    static ModelCurveData interpolateCurve(const ModelCurveData& gridCurve, const QVector<double>& targetTime);
+
+    /**
+     * @brief 双对数空间单调样条插值
+     * 节点值全部为正时在 (ln x, ln y) 空间插值，否则退化为 (ln x, y) 空间插值。
+     * 目标点超出节点范围时取端点值。
+     */
+    static QVector<double> interpolateLogLog(const QVector<double>& xNodes,
+                                             const QVector<double>& yNodes,
+                                             const QVector<double>& xTargets);
+
+private:
+    static QVector<double> refineGrid(const ModelCurveData& gridCurve, double curvatureTol, int maxPointsPerDecade);
+    static QVector<double> pchipSlopes(const QVector<double>& x, const QVector<double>& y);
+    static double curvatureAt(const QVector<double>& lx, const QVector<double>& ly, int i);
+};
+
+#endif // MODELCURVEINTERPOLATOR_H
@@ -200,18 +200,38 @@ QMap<QString, double> ModelManager::getDefaultParameters(ModelType type)
     return p;
 }
 
-ModelCurveData ModelManager::calculateTheoreticalCurve(ModelType type, const QMap<QString, double>& params, const QVector<double>& providedTime)
+bool ModelManager::supportsTheoreticalCurve(ModelType type)
+{
+    return type == Model_1 || type == Model_2;
+}
+
+ModelCurveData ModelManager::calculateTheoreticalCurve(ModelType type, const QMap<QString, double>& params, const QVector<double>& providedTime,
+                                                       const CancellationToken* cancel)
 {
     if (type == Model_1 && m_modelWidget1) {
-        return m_modelWidget1->calculateTheoreticalCurve(params, providedTime);
+        return m_modelWidget1->calculateTheoreticalCurve(params, providedTime, cancel);
     }
     else if (type == Model_2 && m_modelWidget2) {
-        return m_modelWidget2->calculateTheoreticalCurve(params, providedTime);
+        return m_modelWidget2->calculateTheoreticalCurve(params, providedTime, cancel);
     }
     // ...
     return ModelCurveData();
 }
 
+QVector<double> ModelManager::calculateLaplaceTransform(ModelType type, const QMap<QString, double>& params,
+                                                        const QVector<double>& s, const CancellationToken* cancel)
+{
+    switch (type) {
+    case Model_1: if (m_modelWidget1) return m_modelWidget1->calculateLaplaceTransform(params, s, cancel); break;
+    case Model_2: if (m_modelWidget2) return m_modelWidget2->calculateLaplaceTransform(params, s, cancel); break;
+    case Model_3: if (m_modelWidget3) return m_modelWidget3->calculateLaplaceTransform(params, s, cancel); break;
+    case Model_4: if (m_modelWidget4) return m_modelWidget4->calculateLaplaceTransform(params, s, cancel); break;
+    case Model_5: if (m_modelWidget5) return m_modelWidget5->calculateLaplaceTransform(params, s, cancel); break;
+    case Model_6: if (m_modelWidget6) return m_modelWidget6->calculateLaplaceTransform(params, s, cancel); break;
+    }
+    return QVector<double>();
+}
+
 QVector<double> ModelManager::generateLogTimeSteps(int count, double startExp, double endExp) {
     QVector<double> t;
     t.reserve(count);
@@ -9,6 +9,7 @@
 #include <QStackedWidget>
 #include <QPushButton>
 #include <tuple>
+#include "cancellationtoken.h"
 
 class ModelWidget1;
 class ModelWidget2;
@@ -46,9 +47,18 @@ public:
     // 获取默认参数 (现在会从全局参数读取)
     QMap<QString, double> getDefaultParameters(ModelType type);
 
-    // 计算理论曲线
+    // 是否已接入理论曲线计算与默认参数（目前为模型 1、2；其余模型只提供拉普拉斯域解）
+    static bool supportsTheoreticalCurve(ModelType type);
+
+    // 计算理论曲线（cancel 被取消时提前返回不完整结果）
     ModelCurveData calculateTheoreticalCurve(ModelType type, const QMap<QString, double>& params,
-                                             const QVector<double>& providedTime = QVector<double>());
+                                             const QVector<double>& providedTime = QVector<double>(),
+                                             const CancellationToken* cancel = nullptr);
+
+    // 压差的拉普拉斯变换 Δp̄(s)（拉普拉斯域拟合用，s 以 1/h 计）
+    QVector<double> calculateLaplaceTransform(ModelType type, const QMap<QString, double>& params,
+                                              const QVector<double>& s,
+                                              const CancellationToken* cancel = nullptr);
 
     // 生成对数时间步长
     static QVector<double> generateLogTimeSteps(int count, double startExp, double endExp);
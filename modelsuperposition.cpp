@@ -0,0 +1,169 @@
+#include "modelsuperposition.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace {
+// 时刻 t 已开始的最后一个流动段，−1 表示尚未生产
+inline int activePeriod(const QVector<double>& T, double t)
+{
+    return (int)(std::lower_bound(T.begin(), T.end(), t) - T.begin()) - 1;
+}
+}
+
+void ModelSuperposition::normalizedSchedule(const RateSchedule& schedule, QVector<double>& T, QVector<double>& q)
+{
+    int M = qMin(schedule.startTime.size(), schedule.rate.size());
+    QVector<int> order;
+    for (int j = 0; j < M; ++j)
+        if (std::isfinite(schedule.startTime[j]) && std::isfinite(schedule.rate[j])) order.append(j);
+    std::stable_sort(order.begin(), order.end(),
+                     [&schedule](int a, int b) { return schedule.startTime[a] < schedule.startTime[b]; });
+    T.clear(); q.clear();
+    for (int j : order) {
+        double previous = q.isEmpty() ? 0.0 : q.last();
+        if (schedule.rate[j] == previous) continue;
+        // 同一时刻的多次变化只保留最后一次
+        if (!T.isEmpty() && schedule.startTime[j] == T.last()) {
+            T.removeLast(); q.removeLast();
+            if (schedule.rate[j] == (q.isEmpty() ? 0.0 : q.last())) continue;
+        }
+        T.append(schedule.startTime[j]); q.append(schedule.rate[j]);
+    }
+}
+
+QVector<double> ModelSuperposition::responseGrid(const RateSchedule& schedule, const QVector<double>& time,
+                                                 int pointsPerDecade)
+{
+    QVector<double> T, q;
+    normalizedSchedule(schedule, T, q);
+    if (T.isEmpty()) return QVector<double>();
+    double tauMin = -1.0, tauMax = -1.0;
+    for (double t : time) {
+        int a = activePeriod(T, t);
+        if (a < 0) continue;
+        double first = t - T[0], last = t - T[a];
+        if (tauMax < 0 || first > tauMax) tauMax = first;
+        if (tauMin < 0 || last < tauMin) tauMin = last;
+    }
+    if (tauMax <= 0) return QVector<double>();
+    // 紧贴产量变化的点不必把网格拉到极短时间，更早的部分按单位斜率外推
+    tauMin = qMax(tauMin, tauMax * 1e-8);
+    if (!(tauMax > tauMin)) tauMin = tauMax * 0.1;
+    return ModelCurveInterpolator::buildLogGrid(tauMin, tauMax, pointsPerDecade);
+}
+
+SuperpositionPlan ModelSuperposition::planOnGrid(const RateSchedule& schedule, const QVector<double>& time,
+                                                 const QVector<double>& grid)
+{
+    SuperpositionPlan plan;
+    plan.time = time;
+    QVector<double> T, q;
+    normalizedSchedule(schedule, T, q);
+    int n = grid.size();
+    if (n < 2 || T.isEmpty()) return plan;
+    plan.grid = grid;
+
+    // 网格等对数间距，ln τ 只在这里求一次
+    const double s0 = std::log(grid[0]);
+    const double h = (std::log(grid[n - 1]) - s0) / (n - 1);
+    plan.offset.reserve(time.size() + 1);
+    plan.lastDq.fill(0.0, time.size());
+    plan.offset.append(0);
+    for (int i = 0; i < time.size(); ++i) {
+        double t = time[i];
+        int a = activePeriod(T, t);
+        for (int j = 0; j <= a; ++j) {
+            double tau = t - T[j];
+            plan.dq.append(q[j] - (j > 0 ? q[j - 1] : 0.0));
+            plan.tau.append(tau);
+            plan.u.append((std::log(tau) - s0) / h);
+        }
+        if (a >= 0) plan.lastDq[i] = std::abs(q[a] - (a > 0 ? q[a - 1] : 0.0));
+        plan.offset.append(plan.dq.size());
+    }
+    return plan;
+}
+
+SuperpositionPlan ModelSuperposition::plan(const RateSchedule& schedule, const QVector<double>& time, int pointsPerDecade)
+{
+    SuperpositionPlan p = planOnGrid(schedule, time, responseGrid(schedule, time, pointsPerDecade));
+    p.pointsPerDecade = pointsPerDecade;
+    return p;
+}
+
+ModelCurveData ModelSuperposition::superpose(const ModelCurveData& gridCurve, double modelRate,
+                                             const RateSchedule& schedule, const QVector<double>& time)
+{
+    return superpose(gridCurve, modelRate, planOnGrid(schedule, time, std::get<0>(gridCurve)));
+}
+
+ModelCurveData ModelSuperposition::superpose(const ModelCurveData& gridCurve, double modelRate, const SuperpositionPlan& plan)
+{
+    const QVector<double>& gridT = plan.grid;
+    const QVector<double>& gridP = std::get<1>(gridCurve);
+    const QVector<double>& gridD = std::get<2>(gridCurve);
+    const QVector<double>& time = plan.time;
+    QVector<double> outP(time.size(), 0.0), outD(time.size(), 0.0);
+    int n = gridT.size();
+    if (!plan.isValid() || gridP.size() != n || gridD.size() != n || modelRate == 0.0)
+        return std::make_tuple(time, outP, outD);
+
+    // 单位产量响应；导数缺失（非有限值）的节点用相邻压降差分代替
+    const double h = (std::log(gridT[n - 1]) - std::log(gridT[0])) / (n - 1);
+    QVector<double> g(n), d(n);
+    for (int k = 0; k < n; ++k) g[k] = gridP[k] / modelRate;
+    for (int k = 0; k < n; ++k) {
+        d[k] = gridD[k] / modelRate;
+        if (!std::isfinite(d[k])) {
+            int k0 = qMax(0, k - 1), k1 = qMin(n - 1, k + 1);
+            d[k] = (g[k1] - g[k0]) / ((k1 - k0) * h);
+        }
+    }
+
+    // Δp_u(τ) 与 dΔp_u/dln τ，u 为 τ 在网格上的连续序号
+    auto unitResponse = [&](double tau, double u, double& deriv) {
+        if (u <= 0) {
+            deriv = g[0] * tau / gridT[0];
+            return deriv;
+        }
+        if (u >= n - 1) {
+            deriv = d[n - 1];
+            return g[n - 1] + d[n - 1] * (u - (n - 1)) * h;
+        }
+        int k = (int)u;
+        double w = u - k, w2 = w * w, w3 = w2 * w;
+        deriv = ((6.0 * w2 - 6.0 * w) * (g[k] - g[k + 1])) / h
+              + (3.0 * w2 - 4.0 * w + 1.0) * d[k] + (3.0 * w2 - 2.0 * w) * d[k + 1];
+        return (2.0 * w3 - 3.0 * w2 + 1.0) * g[k] + (w3 - 2.0 * w2 + w) * h * d[k]
+             + (-2.0 * w3 + 3.0 * w2) * g[k + 1] + (w3 - w2) * h * d[k + 1];
+    };
+
+    for (int i = 0; i < time.size(); ++i) {
+        double dp = 0, slope = 0, rate = 0;
+        for (int m = plan.offset[i]; m < plan.offset[i + 1]; ++m) {
+            double dq = plan.dq[m], tau = plan.tau[m];
+            double deriv = 0;
+            dp += dq * unitResponse(tau, plan.u[m], deriv);
+            slope += dq * deriv / tau;
+            rate += dq / tau;
+        }
+        outP[i] = dp;
+        if (plan.offset[i + 1] > plan.offset[i] && rate != 0.0) outD[i] = plan.lastDq[i] * slope / rate;
+    }
+    return std::make_tuple(time, outP, outD);
+}
+
+ModelCurveData ModelSuperposition::evaluate(const CurveEvaluator& evaluator, double modelRate,
+                                            const RateSchedule& schedule, const QVector<double>& time,
+                                            int pointsPerDecade)
+{
+    return evaluate(evaluator, modelRate, plan(schedule, time, pointsPerDecade));
+}
+
+ModelCurveData ModelSuperposition::evaluate(const CurveEvaluator& evaluator, double modelRate, const SuperpositionPlan& plan)
+{
+    const QVector<double>& time = plan.time;
+    if (!plan.isValid()) return std::make_tuple(time, QVector<double>(time.size(), 0.0), QVector<double>(time.size(), 0.0));
+    return superpose(evaluator(plan.grid), modelRate, plan);
+}
@@ -0,0 +1,79 @@
+#ifndef MODELSUPERPOSITION_H
+#define MODELSUPERPOSITION_H
+
+#include <QVector>
+#include "modelcurveinterpolator.h"
+#include "rateschedule.h"
+
+// 叠加计划：单位响应网格与各 (点, 流动段) 组合在网格上的位置只取决于观测时刻、产量历史与网格密度，
+// 与模型参数无关。拟合中每次模型计算（含雅可比矩阵的各列）复用同一计划，不再逐次求 ln τ
+struct SuperpositionPlan {
+    QVector<double> time;
+    QVector<double> grid;           // 单位响应网格，为空表示没有已开始生产的时刻
+    int pointsPerDecade;
+    QVector<int> offset;            // 第 i 点的组合存于 [offset[i], offset[i + 1])
+    QVector<double> dq;             // 组合对应流动段的产量变化量
+    QVector<double> tau;            // t_i − T_j
+    QVector<double> u;              // (ln τ − ln grid[0]) / h，网格上的连续序号
+    QVector<double> lastDq;         // 第 i 点所在流动段的 |Δq|，尚未生产为 0
+
+    SuperpositionPlan() : pointsPerDecade(0) {}
+    bool isValid() const { return grid.size() >= 2; }
+};
+
+/**
+ * @brief 变产量历史的模型响应叠加
+ *
+ * 理论模型只给出定产量 q 的压降。变产量（含关井恢复、多级产量）时
+ *     Δp(t) = Σ_j (q_j − q_{j−1}) · Δp_u(t − T_j)，
+ * 逐点逐段直接调用模型需要 点数 × 流动段数 次 Stehfest 反演。
+ * 这里只在覆盖全部 t − T_j 的等对数间距网格上计算一次单位产量响应，
+ * 各 (点, 流动段) 组合由网格插值得到：网格等距，定位为 O(1)；
+ * 模型导数即 dΔp_u/dln τ，压降用以其为斜率的三次 Hermite 插值，导数取该插值的导数。
+ * 模型计算量只取决于网格点数，与观测点数和流动段数无关。
+ *
+ * 输出导数为各流动段对叠加时间 X = Σ_j (Δq_j/Δq_n)·ln(t − T_j) 的导数乘以 sign(Δq_n)，
+ *     |Δq_n| · Σ_j Δq_j·Δp_u'(τ_j)/τ_j / Σ_j Δq_j/τ_j，
+ * 与 TimeTransform::superpositionDerivative 对观测压降的计算口径一致；单一流动段时即 q·dΔp_u/dln Δt。
+ */
+class ModelSuperposition
+{
+public:
+    typedef ModelCurveInterpolator::CurveEvaluator CurveEvaluator;
+
+    /**
+     * @brief 计算变产量历史下 time 各时刻的压降与导数
+     * @param evaluator 定产量模型的计算回调（在单位响应网格上调用一次）
+     * @param modelRate 模型参数中的产量 q，用于把模型输出换算为单位产量响应
+     * @param pointsPerDecade 单位响应网格密度
+     * @return 尚未开始生产的时刻压降与导数为 0
+     */
+    static ModelCurveData evaluate(const CurveEvaluator& evaluator, double modelRate,
+                                   const RateSchedule& schedule, const QVector<double>& time,
+                                   int pointsPerDecade = 12);
+    // 按预先建立的叠加计划计算（结果与上面相同）
+    static ModelCurveData evaluate(const CurveEvaluator& evaluator, double modelRate, const SuperpositionPlan& plan);
+
+    // 建立 time 在单位响应网格上的叠加计划
+    static SuperpositionPlan plan(const RateSchedule& schedule, const QVector<double>& time, int pointsPerDecade = 12);
+
+    // 覆盖全部 t − T_j（t 晚于 T_j）的单位响应网格；没有可用组合时返回空
+    static QVector<double> responseGrid(const RateSchedule& schedule, const QVector<double>& time,
+                                        int pointsPerDecade = 12);
+
+    // 由网格上的定产量曲线（产量 modelRate）叠加出 time 各时刻的压降与导数
+    static ModelCurveData superpose(const ModelCurveData& gridCurve, double modelRate,
+                                    const RateSchedule& schedule, const QVector<double>& time);
+    // gridCurve 须在 plan.grid 上计算
+    static ModelCurveData superpose(const ModelCurveData& gridCurve, double modelRate, const SuperpositionPlan& plan);
+
+    // 归一化产量历史：剔除非有限值、按起始时间排序，合并产量不变的相邻段并去掉开头的零产量段，
+    // 因而每段的产量变化量都不为零
+    static void normalizedSchedule(const RateSchedule& schedule, QVector<double>& startTime, QVector<double>& rate);
+
+private:
+    static SuperpositionPlan planOnGrid(const RateSchedule& schedule, const QVector<double>& time,
+                                        const QVector<double>& grid);
+};
+
+#endif // MODELSUPERPOSITION_H
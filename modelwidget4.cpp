@@ -329,7 +329,8 @@ void ModelWidget4::onExportImage() {
     else QMessageBox::critical(this, "错误", "导出图表失败。");
 }
 
-ModelCurveData ModelWidget4::calculateTheoreticalCurve(const QMap<QString, double>& params, const QVector<double>& providedTime)
+ModelCurveData ModelWidget4::calculateTheoreticalCurve(const QMap<QString, double>& params, const QVector<double>& providedTime,
+                                                      const CancellationToken* cancel)
 {
     QVector<double> tPoints = providedTime;
     if (tPoints.isEmpty()) {
@@ -353,8 +354,8 @@ ModelCurveData ModelWidget4::calculateTheoreticalCurve(const QMap<QString, doubl
     }
 
     QVector<double> PD_vec, Deriv_vec;
-    auto func = std::bind(&ModelWidget4::flaplace_composite, this, std::placeholders::_1, std::placeholders::_2);
-    calculatePDandDeriv(tD_vec, params, func, PD_vec, Deriv_vec);
+    auto func = [this, cancel](double z, const QMap<QString, double>& p) { return flaplace_composite(z, p, cancel); };
+    calculatePDandDeriv(tD_vec, params, func, PD_vec, Deriv_vec, cancel);
 
     double factor = 1.842e-3 * q * mu * B / (kf * h);
     QVector<double> finalP(tPoints.size()), finalDP(tPoints.size());
@@ -367,9 +368,36 @@ ModelCurveData ModelWidget4::calculateTheoreticalCurve(const QMap<QString, doubl
     return std::make_tuple(tPoints, finalP, finalDP);
 }
 
+QVector<double> ModelWidget4::calculateLaplaceTransform(const QMap<QString, double>& params, const QVector<double>& s,
+                                                        const CancellationToken* cancel)
+{
+    double phi = params.value("phi", 0.05);
+    double mu = params.value("mu", 0.5);
+    double B = params.value("B", 1.05);
+    double Ct = params.value("Ct", 5e-4);
+    double q = params.value("q", 5.0);
+    double h = params.value("h", 20.0);
+    double kf = params.value("kf", 1e-3);
+    double L = params.value("L", 1000.0);
+
+    // tD = a·t，Δp = factor·PD  =>  Δp̄(s) = factor/a·P̄D(s/a)
+    double a = 14.4 * kf / (phi * mu * Ct * pow(L, 2));
+    double factor = 1.842e-3 * q * mu * B / (kf * h);
+
+    QVector<double> out(s.size(), 0.0);
+    for (int i = 0; i < s.size(); ++i) {
+        if (CancellationToken::isCancelled(cancel)) break;
+        double pf = flaplace_composite(s[i] / a, params, cancel);
+        if (std::isnan(pf) || std::isinf(pf)) pf = 0.0;
+        out[i] = factor / a * pf;
+    }
+    return out;
+}
+
 void ModelWidget4::calculatePDandDeriv(const QVector<double>& tD, const QMap<QString, double>& params,
                                        std::function<double(double, const QMap<QString, double>&)> laplaceFunc,
-                                       QVector<double>& outPD, QVector<double>& outDeriv)
+                                       QVector<double>& outPD, QVector<double>& outDeriv,
+                                       const CancellationToken* cancel)
 {
     int numPoints = tD.size();
     outPD.resize(numPoints);
@@ -385,6 +413,12 @@ void ModelWidget4::calculatePDandDeriv(const QVector<double>& tD, const QMap<QSt
     for (int k = 0; k < numPoints; ++k) {
         double t = tD[k];
         if (t <= 1e-12) { outPD[k] = 0; continue; }
+        // 已取消：剩余点补零并跳过导数计算
+        if (CancellationToken::isCancelled(cancel)) {
+            for (int r = k; r < numPoints; ++r) outPD[r] = 0.0;
+            outDeriv.fill(0.0);
+            return;
+        }
         double pd_val = 0.0;
         for (int m = 1; m <= N; ++m) {
             double z = m * ln2 / t;
@@ -408,7 +442,7 @@ void ModelWidget4::calculatePDandDeriv(const QVector<double>& tD, const QMap<QSt
     else outDeriv.fill(0.0);
 }
 
-double ModelWidget4::flaplace_composite(double z, const QMap<QString, double>& p) {
+double ModelWidget4::flaplace_composite(double z, const QMap<QString, double>& p, const CancellationToken* cancel) {
     double kf = p.value("kf");
     double km = p.value("km");
     double LfD = p.value("LfD");
@@ -439,7 +473,7 @@ double ModelWidget4::flaplace_composite(double z, const QMap<QString, double>& p
     double fs1 = omga1 + remda1 * temp / (remda1 + z * temp);
     double fs2 = M12 * temp;
 
-    double pf = PWD_inf(z, fs1, fs2, M12, LfD, rmD, reD, nf, xwD);
+    double pf = PWD_inf(z, fs1, fs2, M12, LfD, rmD, reD, nf, xwD, p.value("quadEps", 1e-5), cancel);
 
     double CD = p.value("cD", 0.0);
     double S = p.value("S", 0.0);
@@ -450,7 +484,7 @@ double ModelWidget4::flaplace_composite(double z, const QMap<QString, double>& p
     return pf;
 }
 
-double ModelWidget4::PWD_inf(double z, double fs1, double fs2, double M12, double LfD, double rmD, double reD, int nf, const QVector<double>& xwD) {
+double ModelWidget4::PWD_inf(double z, double fs1, double fs2, double M12, double LfD, double rmD, double reD, int nf, const QVector<double>& xwD, double quadEps, const CancellationToken* cancel) {
     using namespace boost::math;
     QVector<double> ywD(nf, 0.0);
     double gama1 = sqrt(z * fs1);
@@ -502,7 +536,7 @@ double ModelWidget4::PWD_inf(double z, double fs1, double fs2, double M12, doubl
                 if (exponent > -700.0) term2 = Ac_prefactor * scaled_besseli(0, arg_dist) * std::exp(exponent);
                 return cyl_bessel_k(0, arg_dist) + term2;
             };
-            double val = adaptiveGauss(integrand, -LfD, LfD, 1e-5, 0, 10);
+            double val = adaptiveGauss(integrand, -LfD, LfD, quadEps, 0, 10, cancel);
             A_mat(i, j) = z * val / (M12 * z * 2 * LfD);
         }
     }
@@ -523,10 +557,11 @@ double ModelWidget4::gauss15(std::function<double(double)> f, double a, double b
     for (int i = 1; i < 8; ++i) { double dx = h * X[i]; s += W[i] * (f(c - dx) + f(c + dx)); }
     return s * h;
 }
-double ModelWidget4::adaptiveGauss(std::function<double(double)> f, double a, double b, double eps, int depth, int maxDepth) {
+double ModelWidget4::adaptiveGauss(std::function<double(double)> f, double a, double b, double eps, int depth, int maxDepth, const CancellationToken* cancel) {
+    if (CancellationToken::isCancelled(cancel)) return 0.0;
     double c = (a + b) / 2.0; double v1 = gauss15(f, a, b); double v2 = gauss15(f, a, c) + gauss15(f, c, b);
     if (depth >= maxDepth || std::abs(v1 - v2) < 1e-10 * std::abs(v2) + eps) return v2;
-    return adaptiveGauss(f, a, c, eps/2, depth+1, maxDepth) + adaptiveGauss(f, c, b, eps/2, depth+1, maxDepth);
+    return adaptiveGauss(f, a, c, eps/2, depth+1, maxDepth, cancel) + adaptiveGauss(f, c, b, eps/2, depth+1, maxDepth, cancel);
 }
 double ModelWidget4::stefestCoefficient(int i, int N) {
     double s = 0.0; int k1 = (i + 1) / 2; int k2 = std::min(i, N / 2);
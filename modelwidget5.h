@@ -10,6 +10,7 @@
 
 #include "mousezoom.h"
 #include "chartsetting1.h"
+#include "cancellationtoken.h"
 
 typedef std::tuple<QVector<double>, QVector<double>, QVector<double>> ModelCurveData;
 
@@ -25,8 +26,15 @@ public:
     explicit ModelWidget5(QWidget *parent = nullptr);
     ~ModelWidget5();
 
+    // cancel 非空且被取消时尽快返回（结果不完整，调用方应丢弃）
     ModelCurveData calculateTheoreticalCurve(const QMap<QString, double>& params,
-                                             const QVector<double>& providedTime = QVector<double>());
+                                             const QVector<double>& providedTime = QVector<double>(),
+                                             const CancellationToken* cancel = nullptr);
+
+    // 压差的拉普拉斯变换 Δp̄(s)（s 以 1/h 计），由拉普拉斯域解直接给出、不经数值反演；
+    // 不含压敏系数 gamaD 的修正（该修正作用在反演后的时间域）
+    QVector<double> calculateLaplaceTransform(const QMap<QString, double>& params, const QVector<double>& s,
+                                              const CancellationToken* cancel = nullptr);
 
     void setHighPrecision(bool high);
 
@@ -55,13 +63,14 @@ private:
 
     void calculatePDandDeriv(const QVector<double>& tD, const QMap<QString, double>& params,
                              std::function<double(double, const QMap<QString, double>&)> laplaceFunc,
-                             QVector<double>& outPD, QVector<double>& outDeriv);
+                             QVector<double>& outPD, QVector<double>& outDeriv,
+                             const CancellationToken* cancel = nullptr);
 
-    double flaplace_composite(double z, const QMap<QString, double>& p);
+    double flaplace_composite(double z, const QMap<QString, double>& p, const CancellationToken* cancel = nullptr);
     // 增加 reD
-    double PWD_inf(double z, double fs1, double fs2, double M12, double LfD, double rmD, double reD, int nf, const QVector<double>& xwD);
+    double PWD_inf(double z, double fs1, double fs2, double M12, double LfD, double rmD, double reD, int nf, const QVector<double>& xwD, double quadEps, const CancellationToken* cancel = nullptr);
     double scaled_besseli(int v, double x);
-    double adaptiveGauss(std::function<double(double)> f, double a, double b, double eps, int depth, int maxDepth);
+    double adaptiveGauss(std::function<double(double)> f, double a, double b, double eps, int depth, int maxDepth, const CancellationToken* cancel = nullptr);
     double gauss15(std::function<double(double)> f, double a, double b);
     double stefestCoefficient(int i, int N);
     double factorial(int n);
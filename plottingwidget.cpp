@@ -1,5 +1,7 @@
 #include "plottingwidget.h"
 #include "ui_plottingwidget.h"
+#include "flowregimeanalyzer.h"
+#include "pressurederivativecalculator.h"
 #include <QPaintEvent>
 #include <QPainter>
 #include <QApplication>
@@ -259,6 +261,16 @@ void PlottingWidget::setupContextMenu()
     m_zoomYInAction = m_zoomMenu->addAction("↕️ 纵向放大");
     m_zoomYOutAction = m_zoomMenu->addAction("↕️ 纵向缩小");
 
+    m_contextMenu->addSeparator();
+
+    QMenu *analysisMenu = m_contextMenu->addMenu("📈 流动段识别");
+    connect(analysisMenu->addAction("双对数分析（由压力曲线计算导数）"), &QAction::triggered,
+            this, &PlottingWidget::performLogLogAnalysis);
+    connect(analysisMenu->addAction("压力导数分析"), &QAction::triggered,
+            this, &PlottingWidget::performDerivativeAnalysis);
+    connect(analysisMenu->addAction("清除识别结果"), &QAction::triggered,
+            this, &PlottingWidget::removeFlowRegimeOverlays);
+
     connect(m_addMarkerAction, &QAction::triggered, this, &PlottingWidget::onMarkerAdded);
     connect(m_addAnnotationAction, &QAction::triggered, this, &PlottingWidget::onAnnotationAdded);
     connect(m_removeLastMarkerAction, &QAction::triggered, this, &PlottingWidget::onRemoveLastMarker);
@@ -2425,14 +2437,144 @@ void PlottingWidget::exportPlot(const QString &fileName, const QString &format)
     }
 }
 
-// 分析函数实现（占位符）
-void PlottingWidget::performLogLogAnalysis()
+// 流动段识别叠加曲线的类型标记
+static const char *kFlowRegimeCurveType = "流动段识别";
+
+static QColor flowRegimeColor(FlowRegime regime)
 {
+    switch (regime) {
+    case FlowRegime::Storage: return QColor(0x9C, 0x27, 0xB0);
+    case FlowRegime::Bilinear: return QColor(0x00, 0x96, 0x88);
+    case FlowRegime::Linear: return QColor(0x21, 0x96, 0xF3);
+    case FlowRegime::Radial: return QColor(0x4C, 0xAF, 0x50);
+    case FlowRegime::Spherical: return QColor(0xFF, 0x98, 0x00);
+    case FlowRegime::Boundary: return QColor(0xF4, 0x43, 0x36);
+    default: return QColor(0x75, 0x75, 0x75);
+    }
+}
+
+void PlottingWidget::removeFlowRegimeOverlays()
+{
+    for (int i = m_curves.size() - 1; i >= 0; --i) {
+        if (m_curves[i].curveType == kFlowRegimeCurveType) m_curves.removeAt(i);
+    }
+    updateCurvesList();
+    updatePlot();
+}
+
+void PlottingWidget::runFlowRegimeAnalysis(const QString &analysisType, const CurveData &derivativeCurve,
+                                           const QVector<double> &pressure)
+{
+    QVector<FlowRegimeSegment> segments =
+        FlowRegimeAnalyzer::analyze(derivativeCurve.xData, pressure, derivativeCurve.yData);
+
+    removeFlowRegimeOverlays();
     QMap<QString, double> results;
-    QString message = "双对数分析完成\n使用当前显示的数据进行分析";
+    results["流动段数"] = segments.size();
+    QString summary;
+    for (int k = 0; k < segments.size(); ++k) {
+        const FlowRegimeSegment &seg = segments[k];
+        QString regimeName = FlowRegimeAnalyzer::regimeName(seg.regime);
+
+        CurveData overlay;
+        overlay.name = QString("%1 (斜率 %2, 置信度 %3)").arg(regimeName)
+                           .arg(seg.slope, 0, 'f', 2).arg(seg.confidence, 0, 'f', 2);
+        overlay.color = flowRegimeColor(seg.regime);
+        overlay.xData << seg.tStart << seg.tEnd;
+        overlay.yData << seg.dStart << seg.dEnd;
+        overlay.lineWidth = 3;
+        overlay.pointSize = 0;
+        overlay.lineStyle = LineStyle::Dash;
+        overlay.curveType = kFlowRegimeCurveType;
+        overlay.xLabel = derivativeCurve.xLabel;
+        overlay.yLabel = derivativeCurve.yLabel;
+        overlay.xUnit = derivativeCurve.xUnit;
+        overlay.yUnit = derivativeCurve.yUnit;
+        overlay.xAxisType = AxisType::Logarithmic;
+        overlay.yAxisType = AxisType::Logarithmic;
+        m_curves.append(overlay);
+
+        QString prefix = QString("段%1_").arg(k + 1);
+        results[prefix + "类型"] = static_cast<int>(seg.regime);
+        results[prefix + "起始时间"] = seg.tStart;
+        results[prefix + "结束时间"] = seg.tEnd;
+        results[prefix + "斜率"] = seg.slope;
+        results[prefix + "导数水平"] = seg.level;
+        results[prefix + "置信度"] = seg.confidence;
+
+        summary += QString("%1. %2：%3 ~ %4，斜率 %5，置信度 %6\n").arg(k + 1).arg(regimeName)
+                       .arg(seg.tStart, 0, 'g', 4).arg(seg.tEnd, 0, 'g', 4)
+                       .arg(seg.slope, 0, 'f', 3).arg(seg.confidence, 0, 'f', 2);
+    }
+
+    // 流动段按双对数坐标判读
+    m_plotSettings.logScaleX = true;
+    m_plotSettings.logScaleY = true;
+    m_plotSettings.xAxisType = AxisType::Logarithmic;
+    m_plotSettings.yAxisType = AxisType::Logarithmic;
+    updateCurvesList();
+    calculateDataBounds();
+    updatePlot();
 
-    QMessageBox::information(this, "分析完成", "双对数分析功能正在开发中！");
-    emit analysisCompleted("双对数分析", results);
+    if (segments.isEmpty())
+        QMessageBox::information(this, analysisType, "未识别出明显的流动段，请检查导数曲线的数据范围与噪声。");
+    else
+        QMessageBox::information(this, analysisType, QString("识别出 %1 个流动段：\n").arg(segments.size()) + summary);
+    emit analysisCompleted(analysisType, results);
+}
+
+void PlottingWidget::performLogLogAnalysis()
+{
+    // 取第一条可见的压力曲线，在导数对话框中选定算法计算导数后识别
+    const CurveData *source = nullptr;
+    for (const CurveData &curve : m_curves) {
+        if (!curve.visible || curve.curveType == kFlowRegimeCurveType) continue;
+        if (curve.name.contains("导数") || curve.yLabel.contains("导数")) continue;
+        source = &curve;
+        break;
+    }
+    if (!source) {
+        QMessageBox::warning(this, "双对数分析", "请先绘制压力曲线！");
+        return;
+    }
+
+    CurveData derivative = *source;
+    derivative.name = source->name + " 导数";
+    derivative.yLabel = "压力导数";
+    derivative.xData.clear();
+    derivative.yData.clear();
+    // 曲线通常为原始压力：与 readSeries 相同以首点为初始压力求压差 Δp = |p - p(t0)|，
+    // 降落与恢复的导数均为正（已是压差的曲线首点接近 0，结果不变）
+    QVector<double> pressure;
+    int n = qMin(source->xData.size(), source->yData.size());
+    bool haveInitial = false;
+    double initialPressure = 0.0;
+    int positive = 0;
+    for (int i = 0; i < n; ++i) {
+        if (!(source->xData[i] > 0) || !std::isfinite(source->yData[i])) continue;
+        if (!haveInitial) { initialPressure = source->yData[i]; haveInitial = true; }
+        derivative.xData.append(source->xData[i]);
+        pressure.append(std::abs(source->yData[i] - initialPressure));
+        if (pressure.last() > 0) ++positive;
+    }
+    if (positive < 3) {
+        QMessageBox::warning(this, "双对数分析", "压力曲线的有效数据点不足！");
+        return;
+    }
+    PressureDerivativeDialog dialog(derivative.xData, pressure, m_derivativeOptions.lSpacing, RateSchedule(), this);
+    if (dialog.exec() != QDialog::Accepted) return;
+    m_derivativeOptions = dialog.selectedOptions();
+    derivative.yData = dialog.selectedDerivative();
+    derivative.color = source->color.darker(150);
+    derivative.xAxisType = AxisType::Logarithmic;
+    derivative.yAxisType = AxisType::Logarithmic;
+
+    // 重复分析时替换上次计算的导数曲线
+    for (int i = m_curves.size() - 1; i >= 0; --i) {
+        if (m_curves[i].name == derivative.name) m_curves.removeAt(i);
+    }
+    m_curves.append(derivative);
+    runFlowRegimeAnalysis("双对数分析", derivative, pressure);
 }
 
 void PlottingWidget::performSemiLogAnalysis()
@@ -2451,9 +2593,22 @@ void PlottingWidget::performCartesianAnalysis()
 
 void PlottingWidget::performDerivativeAnalysis()
 {
-    QMap<QString, double> results;
-    QMessageBox::information(this, "分析完成", "压力导数分析功能正在开发中！");
-    emit analysisCompleted("压力导数分析", results);
+    // 取第一条可见的导数曲线（名称或纵轴标签含“导数”）；没有时提示，不把压力曲线当作导数分析
+    const CurveData *source = nullptr;
+    for (const CurveData &curve : m_curves) {
+        if (!curve.visible || curve.curveType == kFlowRegimeCurveType) continue;
+        if (curve.name.contains("导数") || curve.yLabel.contains("导数")) { source = &curve; break; }
+    }
+    if (!source) {
+        QMessageBox::warning(this, "压力导数分析",
+                             "没有可见的压力导数曲线（名称或纵轴标签含“导数”）。\n"
+                             "请先绘制导数曲线，或使用双对数分析由压力曲线计算导数。");
+        return;
+    }
+
+    // 叠加曲线会改动 m_curves，先复制数据源
+    CurveData derivative = *source;
+    runFlowRegimeAnalysis("压力导数分析", derivative, QVector<double>());
 }
 
 void PlottingWidget::performModelMatching()
@@ -41,6 +41,7 @@
 #include <QMdiArea>
 #include <QMdiSubWindow>
 #include <cmath>
+#include "pressurederivativecalculator.h"
 
 namespace Ui {
 class PlottingWidget;
@@ -437,6 +438,7 @@ private:
 
     // 多曲线数据存储
     QVector<CurveData> m_curves;
+    DerivativeOptions m_derivativeOptions;  // 双对数分析上次选用的导数算法
 
     // 绘图设置
     PlotSettings m_plotSettings;
@@ -552,6 +554,11 @@ private:
     // 数据处理函数
     bool isValidDataPoint(double x, double y);
 
+    // 流动段识别：在导数曲线上叠加各段的拟合直线，汇总结果并发出 analysisCompleted
+    void runFlowRegimeAnalysis(const QString &analysisType, const CurveData &derivativeCurve,
+                               const QVector<double> &pressure);
+    void removeFlowRegimeOverlays();
+
     // 数据范围计算优化函数
     QPair<double, double> calculateOptimalRange(double min, double max, bool isLog);
 
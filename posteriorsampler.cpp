@@ -0,0 +1,518 @@
+#include "posteriorsampler.h"
+#include "mousezoom.h"
+
+#include <QtConcurrent>
+#include <QThreadPool>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QGridLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QFile>
+#include <QTextStream>
+#include <QMessageBox>
+#include <QScrollArea>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <Eigen/Dense>
+
+// ===========================================================================
+// RbfSurrogate 实现
+// ===========================================================================
+
+RbfSurrogate::RbfSurrogate() : m_valid(false), m_dim(0), m_nRes(0) {}
+
+QVector<double> RbfSurrogate::basis(const QVector<double>& x) const
+{
+    int n = m_nodes.size();
+    QVector<double> u(m_dim);
+    for (int i = 0; i < m_dim; ++i) u[i] = (x[i] - m_center[i]) / m_scale[i];
+    QVector<double> a(n + m_dim + 1);
+    for (int k = 0; k < n; ++k) {
+        double r2 = 0.0;
+        for (int i = 0; i < m_dim; ++i) { double dx = u[i] - m_nodes[k][i]; r2 += dx * dx; }
+        double r = std::sqrt(r2);
+        a[k] = r * r * r;
+    }
+    a[n] = 1.0;
+    for (int i = 0; i < m_dim; ++i) a[n + 1 + i] = u[i];
+    return a;
+}
+
+bool RbfSurrogate::fit(const QVector<SurrogateSample>& samples, const QVector<double>& center, const QVector<double>& scale)
+{
+    m_valid = false;
+    m_dim = center.size();
+    int n = samples.size();
+    if (m_dim == 0 || scale.size() != m_dim || n < m_dim + 2) return false;
+    m_nRes = samples[0].residuals.size();
+    if (m_nRes == 0) return false;
+    for (const auto& s : samples) {
+        if (s.x.size() != m_dim || s.residuals.size() != m_nRes) return false;
+    }
+
+    m_center = center;
+    m_scale = scale;
+    m_nodes.resize(n);
+    for (int k = 0; k < n; ++k) {
+        m_nodes[k].resize(m_dim);
+        for (int i = 0; i < m_dim; ++i) m_nodes[k][i] = (samples[k].x[i] - center[i]) / scale[i];
+    }
+
+    // 插值方程 [Φ P; Pᵀ 0][W; C] = [R; 0]
+    int q = n + m_dim + 1;
+    Eigen::MatrixXd A = Eigen::MatrixXd::Zero(q, q);
+    for (int k = 0; k < n; ++k) {
+        for (int l = 0; l < n; ++l) {
+            double r2 = 0.0;
+            for (int i = 0; i < m_dim; ++i) { double dx = m_nodes[k][i] - m_nodes[l][i]; r2 += dx * dx; }
+            double r = std::sqrt(r2);
+            A(k, l) = r * r * r;
+        }
+        A(k, n) = 1.0; A(n, k) = 1.0;
+        for (int i = 0; i < m_dim; ++i) { A(k, n + 1 + i) = m_nodes[k][i]; A(n + 1 + i, k) = m_nodes[k][i]; }
+    }
+    Eigen::MatrixXd B = Eigen::MatrixXd::Zero(q, m_nRes);
+    for (int k = 0; k < n; ++k)
+        for (int j = 0; j < m_nRes; ++j) B(k, j) = samples[k].residuals[j];
+
+    Eigen::FullPivLU<Eigen::MatrixXd> lu(A);
+    if (lu.rank() < q) return false;
+    Eigen::MatrixXd W = lu.solve(B);
+    Eigen::MatrixXd G = W * W.transpose();
+
+    m_M.resize(q * m_nRes);
+    for (int k = 0; k < q; ++k)
+        for (int j = 0; j < m_nRes; ++j) m_M[k * m_nRes + j] = W(k, j);
+    m_G.resize(q * q);
+    for (int k = 0; k < q; ++k)
+        for (int l = 0; l < q; ++l) m_G[k * q + l] = G(k, l);
+    m_valid = true;
+    return true;
+}
+
+QVector<double> RbfSurrogate::predictResiduals(const QVector<double>& x) const
+{
+    QVector<double> r(m_nRes, 0.0);
+    if (!m_valid || x.size() != m_dim) return r;
+    QVector<double> a = basis(x);
+    for (int k = 0; k < a.size(); ++k) {
+        const double* row = m_M.constData() + k * m_nRes;
+        for (int j = 0; j < m_nRes; ++j) r[j] += a[k] * row[j];
+    }
+    return r;
+}
+
+double RbfSurrogate::predictSSE(const QVector<double>& x) const
+{
+    if (!m_valid || x.size() != m_dim) return std::numeric_limits<double>::infinity();
+    QVector<double> a = basis(x);
+    int q = a.size();
+    double sse = 0.0;
+    for (int k = 0; k < q; ++k) {
+        const double* row = m_G.constData() + k * q;
+        double s = 0.0;
+        for (int l = 0; l < q; ++l) s += row[l] * a[l];
+        sse += a[k] * s;
+    }
+    return std::max(0.0, sse);
+}
+
+// ===========================================================================
+// PosteriorSampler 实现
+// ===========================================================================
+
+PosteriorSampler::PosteriorSampler(const PosteriorConfig& config) : m_config(config), m_threadPool(nullptr) {}
+
+PosteriorConfig PosteriorSampler::defaultConfig()
+{
+    PosteriorConfig c;
+    c.walkers = 0;
+    c.steps = 2000;
+    c.burnIn = 500;
+    c.thin = 5;
+    c.checkInterval = 200;
+    c.checkTol = 0.05;
+    c.maxNodes = 80;
+    c.checkpointInterval = 100;
+    return c;
+}
+
+double PosteriorSampler::logPosterior(const RbfSurrogate& surrogate, const PosteriorProblem& problem, const QVector<double>& x) const
+{
+    for (int i = 0; i < x.size(); ++i) {
+        if (x[i] < problem.lower[i] || x[i] > problem.upper[i]) return -std::numeric_limits<double>::infinity();
+    }
+    return -0.5 * surrogate.predictSSE(x) / problem.sigma2;
+}
+
+QVector<SurrogateSample> PosteriorSampler::selectNodes(const QVector<SurrogateSample>& pool, const PosteriorProblem& problem,
+                                                       const QVector<double>& around) const
+{
+    // 取距离 around 最近的训练点（按参数尺度归一化），剔除几乎重合的点以保证插值方程非奇异
+    int d = around.size();
+    QVector<QPair<double, int>> order;
+    for (int k = 0; k < pool.size(); ++k) {
+        double r2 = 0.0;
+        for (int i = 0; i < d; ++i) { double dx = (pool[k].x[i] - around[i]) / problem.scale[i]; r2 += dx * dx; }
+        order.append(qMakePair(r2, k));
+    }
+    std::sort(order.begin(), order.end());
+    QVector<SurrogateSample> nodes;
+    for (const auto& item : order) {
+        const SurrogateSample& s = pool[item.second];
+        bool duplicate = false;
+        for (const auto& c : nodes) {
+            double r2 = 0.0;
+            for (int i = 0; i < d; ++i) { double dx = (s.x[i] - c.x[i]) / problem.scale[i]; r2 += dx * dx; }
+            if (r2 < 1e-12) { duplicate = true; break; }
+        }
+        if (duplicate) continue;
+        nodes.append(s);
+        if (nodes.size() >= m_config.maxNodes) break;
+    }
+    return nodes;
+}
+
+namespace {
+QString rngToString(const std::mt19937& g)
+{
+    std::ostringstream os;
+    os << g;
+    return QString::fromStdString(os.str());
+}
+
+bool rngFromString(const QString& text, std::mt19937& g)
+{
+    std::istringstream is(text.toStdString());
+    is >> g;
+    return !is.fail();
+}
+}
+
+PosteriorResult PosteriorSampler::run(const PosteriorProblem& problem, ResidualFunction trueResiduals,
+                                      const CancellationToken* cancel, ProgressFunction progress,
+                                      CheckpointFunction checkpoint, const PosteriorSamplerState* resume)
+{
+    PosteriorResult res;
+    res.valid = false; res.acceptanceRate = 0.0; res.modelChecks = 0; res.surrogateRefits = 0; res.maxCheckError = 0.0;
+    res.names = problem.names;
+    res.isLog = problem.isLog;
+    int d = problem.best.size();
+    if (d == 0 || problem.sigma2 <= 0 || problem.scale.size() != d) return res;
+
+    std::mt19937 master(20240601u);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    auto clampToBounds = [&](QVector<double>& x) {
+        for (int i = 0; i < d; ++i) x[i] = qBound(problem.lower[i], x[i], problem.upper[i]);
+    };
+
+    // 从检查点继续：状态须与当前问题的维数一致
+    bool resumed = resume && resume->valid && resume->walkers.size() >= 2 && resume->walkers.size() % 2 == 0
+                   && resume->walkerRng.size() == resume->walkers.size() && !resume->nodes.isEmpty();
+    if (resumed) {
+        for (const auto& w : resume->walkers) if (w.size() != d) resumed = false;
+        for (const auto& s : resume->nodes) if (s.x.size() != d) resumed = false;
+        if (resumed) resumed = rngFromString(resume->masterRng, master);
+    }
+
+    QVector<SurrogateSample> pool;
+    QVector<SurrogateSample> nodes;
+    int nRes = -1;
+    if (resumed) {
+        pool = resume->pool;
+        nodes = resume->nodes;
+        nRes = nodes.first().residuals.size();
+        res.samples = resume->samples;
+        res.modelChecks = resume->modelChecks;
+        res.surrogateRefits = resume->surrogateRefits;
+        res.maxCheckError = resume->maxCheckError;
+    } else {
+        // 1. 训练集：拟合阶段的模型计算 + 最优点附近补充的真实模型计算
+        for (const auto& s : problem.archive) {
+            if (s.x.size() != d) continue;
+            if (nRes < 0) nRes = s.residuals.size();
+            if (s.residuals.size() == nRes) pool.append(s);
+        }
+        int minNodes = 2 * d + 2;
+        nodes = selectNodes(pool, problem, problem.best);
+        int extra = qMax(0, minNodes - nodes.size());
+        for (int k = 0; k < extra; ++k) {
+            if (CancellationToken::isCancelled(cancel)) return res;
+            SurrogateSample s;
+            s.x = problem.best;
+            for (int i = 0; i < d; ++i) s.x[i] += problem.scale[i] * normal(master);
+            clampToBounds(s.x);
+            s.residuals = trueResiduals(s.x);
+            ++res.modelChecks;
+            if (nRes < 0) nRes = s.residuals.size();
+            if (s.residuals.size() == nRes) pool.append(s);
+        }
+        if (extra > 0) nodes = selectNodes(pool, problem, problem.best);
+    }
+
+    RbfSurrogate surrogate;
+    if (!surrogate.fit(nodes, problem.best, problem.scale)) return res;
+
+    // 2. 初始化游走者：最优点附近的小扰动（继续采样时取检查点中的位置与随机数状态）
+    int walkers = resumed ? resume->walkers.size() : (m_config.walkers > 0 ? m_config.walkers : qMax(16, 4 * d));
+    if (walkers % 2) ++walkers;
+    std::vector<QVector<double>> X(walkers);
+    std::vector<double> lp(walkers);
+    std::vector<std::mt19937> rngs(walkers);
+    for (int k = 0; k < walkers; ++k) {
+        if (resumed) {
+            X[k] = resume->walkers[k];
+            if (!rngFromString(resume->walkerRng[k], rngs[k])) return res;
+        } else {
+            rngs[k].seed(master());
+            X[k] = problem.best;
+            for (int i = 0; i < d; ++i) X[k][i] += 0.1 * problem.scale[i] * normal(master);
+            clampToBounds(X[k]);
+        }
+        lp[k] = logPosterior(surrogate, problem, X[k]);
+    }
+
+    // 在调用方的线程池中并行，阻塞时调用线程也参与更新，不超出任务队列的线程预算
+    QThreadPool* threadPool = m_threadPool ? m_threadPool : QThreadPool::globalInstance();
+    std::atomic<long long> accepted(resumed ? resume->accepted : 0);
+    long long proposals = resumed ? resume->proposals : 0;
+    const double a = 2.0;   // stretch move 尺度参数
+
+    QList<int> halves[2];
+    for (int k = 0; k < walkers; ++k) halves[k < walkers / 2 ? 0 : 1].append(k);
+
+    int steps = qMax(1, m_config.steps);
+    int lastPercent = -1;
+    for (int step = resumed ? resume->step : 0; step < steps; ++step) {
+        if (CancellationToken::isCancelled(cancel)) return res;
+
+        // 3. 两半游走者交替更新：同一半内的游走者相互独立，可并行
+        for (int h = 0; h < 2; ++h) {
+            const QList<int>& others = halves[1 - h];
+            auto move = [&](int k) {
+                std::mt19937& g = rngs[k];
+                std::uniform_real_distribution<double> uni(0.0, 1.0);
+                int j = others[std::min((int)(uni(g) * others.size()), (int)others.size() - 1)];
+                double zu = (a - 1.0) * uni(g) + 1.0;
+                double z = zu * zu / a;
+                QVector<double> y(d);
+                for (int i = 0; i < d; ++i) y[i] = X[j][i] + z * (X[k][i] - X[j][i]);
+                double lpy = logPosterior(surrogate, problem, y);
+                double logAccept = (d - 1) * std::log(z) + lpy - lp[k];
+                if (std::isfinite(lpy) && std::log(uni(g)) < logAccept) {
+                    X[k] = y; lp[k] = lpy; ++accepted;
+                }
+            };
+            QtConcurrent::blockingMap(threadPool, halves[h], move);
+            proposals += halves[h].size();
+        }
+
+        if (step >= m_config.burnIn && (step - m_config.burnIn) % qMax(1, m_config.thin) == 0) {
+            for (int k = 0; k < walkers; ++k) {
+                QVector<double> v(d);
+                for (int i = 0; i < d; ++i) v[i] = problem.isLog[i] ? std::pow(10.0, X[k][i]) : X[k][i];
+                res.samples.append(v);
+            }
+        }
+
+        // 4. 定期用真实模型校验代理模型，误差超限时加入训练点并以当前游走者中心重建
+        if (m_config.checkInterval > 0 && step > 0 && step % m_config.checkInterval == 0) {
+            int k = (int)(master() % walkers);
+            QVector<double> rTrue = trueResiduals(X[k]);
+            if (CancellationToken::isCancelled(cancel)) return res;
+            ++res.modelChecks;
+            if (rTrue.size() == nRes) {
+                double sseTrue = 0.0; for (double r : rTrue) sseTrue += r * r;
+                double sseSur = surrogate.predictSSE(X[k]);
+                double err = std::abs(sseSur - sseTrue) / qMax(sseTrue, 1e-300);
+                res.maxCheckError = qMax(res.maxCheckError, err);
+                SurrogateSample s; s.x = X[k]; s.residuals = rTrue;
+                pool.append(s);
+                if (err > m_config.checkTol) {
+                    QVector<double> mean(d, 0.0);
+                    for (int w = 0; w < walkers; ++w) for (int i = 0; i < d; ++i) mean[i] += X[w][i] / walkers;
+                    RbfSurrogate refit;
+                    QVector<SurrogateSample> refitNodes = selectNodes(pool, problem, mean);
+                    if (refit.fit(refitNodes, problem.best, problem.scale)) {
+                        surrogate = refit;
+                        nodes = refitNodes;
+                        ++res.surrogateRefits;
+                        for (int w = 0; w < walkers; ++w) lp[w] = logPosterior(surrogate, problem, X[w]);
+                    }
+                }
+            }
+        }
+
+        int percent = step * 100 / steps;
+        if (progress && percent != lastPercent) { progress(percent); lastPercent = percent; }
+
+        if (checkpoint && m_config.checkpointInterval > 0 && (step + 1) % m_config.checkpointInterval == 0 && step + 1 < steps) {
+            PosteriorSamplerState state;
+            state.valid = true;
+            state.step = step + 1;
+            for (int k = 0; k < walkers; ++k) {
+                state.walkers.append(X[k]);
+                state.walkerRng.append(rngToString(rngs[k]));
+            }
+            state.masterRng = rngToString(master);
+            state.pool = pool;
+            state.nodes = nodes;
+            state.samples = res.samples;
+            state.accepted = accepted;
+            state.proposals = proposals;
+            state.modelChecks = res.modelChecks;
+            state.surrogateRefits = res.surrogateRefits;
+            state.maxCheckError = res.maxCheckError;
+            checkpoint(state);
+        }
+    }
+
+    if (res.samples.isEmpty()) return res;
+    res.acceptanceRate = proposals > 0 ? (double)accepted / proposals : 0.0;
+
+    // 5. 边缘分布统计
+    for (int i = 0; i < d; ++i) {
+        QVector<double> v;
+        v.reserve(res.samples.size());
+        for (const auto& s : res.samples) v.append(s[i]);
+        std::sort(v.begin(), v.end());
+        double sum = 0.0; for (double x : v) sum += x;
+        auto quantile = [&v](double p) { return v[qBound(0, (int)std::lround(p * (v.size() - 1)), (int)v.size() - 1)]; };
+        res.mean.append(sum / v.size());
+        res.median.append(quantile(0.5));
+        res.p05.append(quantile(0.05));
+        res.p95.append(quantile(0.95));
+    }
+    res.valid = true;
+    return res;
+}
+
+// ===========================================================================
+// PosteriorDialog 实现
+// ===========================================================================
+
+PosteriorDialog::PosteriorDialog(const PosteriorResult& result, const QStringList& displayNames,
+                                 const QString& defaultDir, QWidget *parent)
+    : QDialog(parent), m_result(result), m_displayNames(displayNames), m_defaultDir(defaultDir)
+{
+    setWindowTitle("参数后验分布 (MCMC)");
+    resize(960, 720);
+    setStyleSheet(
+        "QDialog { background-color: #ffffff; color: #000000; font-family: 'Microsoft YaHei'; }"
+        "QLabel, QTableWidget { color: #000000; }"
+        "QTableWidget { gridline-color: #d0d0d0; border: 1px solid #c0c0c0; }"
+        "QHeaderView::section { background-color: #f0f0f0; border: 1px solid #d0d0d0; color: #000000; }"
+        "QPushButton { background-color: #ffffff; border: 1px solid #c0c0c0; border-radius: 4px; padding: 5px 15px; color: #333333; }"
+        "QPushButton:hover { background-color: #f2f2f2; border-color: #a0a0a0; color: #000000; }"
+        );
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    int d = m_result.names.size();
+    layout->addWidget(new QLabel(QString("样本数: %1    接受率: %2%    真实模型校验: %3 次    代理模型重建: %4 次    最大校验误差: %5%")
+                                     .arg(m_result.samples.size())
+                                     .arg(m_result.acceptanceRate * 100.0, 0, 'f', 1)
+                                     .arg(m_result.modelChecks)
+                                     .arg(m_result.surrogateRefits)
+                                     .arg(m_result.maxCheckError * 100.0, 0, 'f', 2), this));
+
+    QTableWidget* table = new QTableWidget(d, 5, this);
+    table->setHorizontalHeaderLabels({"参数", "均值", "中位数", "P5", "P95"});
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setMaximumHeight(40 + 30 * d);
+    for (int i = 0; i < d; ++i) {
+        table->setItem(i, 0, new QTableWidgetItem(m_displayNames.value(i, m_result.names[i])));
+        table->setItem(i, 1, new QTableWidgetItem(QString::number(m_result.mean[i], 'g', 5)));
+        table->setItem(i, 2, new QTableWidgetItem(QString::number(m_result.median[i], 'g', 5)));
+        table->setItem(i, 3, new QTableWidgetItem(QString::number(m_result.p05[i], 'g', 5)));
+        table->setItem(i, 4, new QTableWidgetItem(QString::number(m_result.p95[i], 'g', 5)));
+    }
+    layout->addWidget(table);
+
+    // 边缘分布直方图（对数参数在 log10 坐标下统计）
+    m_plotArea = new QWidget(this);
+    m_plotArea->setStyleSheet("background-color: #ffffff;");
+    QGridLayout* grid = new QGridLayout(m_plotArea);
+    const int cols = 3, bins = 30;
+    for (int i = 0; i < d; ++i) {
+        QVector<double> v;
+        for (const auto& s : m_result.samples) {
+            double x = s[i];
+            if (m_result.isLog[i]) { if (x <= 0) continue; x = std::log10(x); }
+            v.append(x);
+        }
+        if (v.isEmpty()) continue;
+        double lo = *std::min_element(v.begin(), v.end());
+        double hi = *std::max_element(v.begin(), v.end());
+        if (hi <= lo) hi = lo + 1e-6;
+        double w = (hi - lo) / bins;
+        QVector<double> keys(bins), counts(bins, 0.0);
+        for (int b = 0; b < bins; ++b) keys[b] = lo + (b + 0.5) * w;
+        for (double x : v) counts[qBound(0, (int)((x - lo) / w), bins - 1)] += 1.0;
+        for (double& c : counts) c /= (v.size() * w);
+
+        MouseZoom* plot = new MouseZoom(m_plotArea);
+        plot->setMinimumSize(280, 200);
+        QCPBars* bars = new QCPBars(plot->xAxis, plot->yAxis);
+        bars->setData(keys, counts);
+        bars->setWidth(w);
+        bars->setPen(QPen(QColor(30, 90, 160)));
+        bars->setBrush(QColor(30, 90, 160, 120));
+        QString name = m_displayNames.value(i, m_result.names[i]);
+        plot->xAxis->setLabel(m_result.isLog[i] ? QString("log10(%1)").arg(name) : name);
+        plot->yAxis->setLabel("概率密度");
+        plot->rescaleAxes();
+        plot->yAxis->setRangeLower(0);
+        plot->replot();
+        grid->addWidget(plot, i / cols, i % cols);
+    }
+    QScrollArea* scroll = new QScrollArea(this);
+    scroll->setWidgetResizable(true);
+    scroll->setWidget(m_plotArea);
+    layout->addWidget(scroll, 1);
+
+    QHBoxLayout* btns = new QHBoxLayout;
+    QPushButton* btnSamples = new QPushButton("导出样本 (CSV)", this);
+    QPushButton* btnPlots = new QPushButton("导出边缘分布图", this);
+    QPushButton* btnClose = new QPushButton("关闭", this);
+    connect(btnSamples, &QPushButton::clicked, this, &PosteriorDialog::onExportSamples);
+    connect(btnPlots, &QPushButton::clicked, this, &PosteriorDialog::onExportPlots);
+    connect(btnClose, &QPushButton::clicked, this, &QDialog::accept);
+    btns->addWidget(btnSamples); btns->addWidget(btnPlots); btns->addStretch(); btns->addWidget(btnClose);
+    layout->addLayout(btns);
+}
+
+void PosteriorDialog::onExportSamples()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "导出后验样本", m_defaultDir + "/PosteriorSamples.csv", "CSV Files (*.csv)");
+    if (fileName.isEmpty()) return;
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) { QMessageBox::critical(this, "错误", "无法写入文件。"); return; }
+    file.write("\xEF\xBB\xBF");
+    QTextStream out(&file);
+    out << m_result.names.join(",") << "\n";
+    for (const auto& s : m_result.samples) {
+        QStringList row;
+        for (double v : s) row << QString::number(v, 'g', 10);
+        out << row.join(",") << "\n";
+    }
+    file.close();
+    QMessageBox::information(this, "完成", "后验样本已成功导出。");
+}
+
+void PosteriorDialog::onExportPlots()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "导出边缘分布图", m_defaultDir + "/PosteriorMarginals.png", "PNG Image (*.png)");
+    if (fileName.isEmpty()) return;
+    if (m_plotArea->grab().save(fileName)) QMessageBox::information(this, "完成", "图表已成功导出。");
+    else QMessageBox::critical(this, "错误", "导出图表失败。");
+}
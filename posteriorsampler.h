@@ -0,0 +1,169 @@
+#ifndef POSTERIORSAMPLER_H
+#define POSTERIORSAMPLER_H
+
+#include <QVector>
+#include <QStringList>
+#include <QDialog>
+#include <functional>
+#include "cancellationtoken.h"
+
+class QWidget;
+class QThreadPool;
+
+// 代理模型训练样本：变换参数空间（对数参数取 log10）中的坐标及其残差向量
+struct SurrogateSample {
+    QVector<double> x;
+    QVector<double> residuals;
+};
+
+/**
+ * @brief 残差向量的 RBF 代理模型
+ *
+ * 三次径向基 φ(r) = r³ 加线性多项式项，坐标按参数尺度归一化。
+ * 残差 r(x) = Mᵀa(x)，其中 a(x) = [φ(|u-u_k|), 1, u]；目标函数 |r|² = aᵀGa，
+ * G = MMᵀ 在训练时预先算好，采样时单次评估的代价与观测点数无关。
+ */
+class RbfSurrogate
+{
+public:
+    RbfSurrogate();
+
+    // 训练（center/scale 用于坐标归一化）；样本不足或方程奇异时返回 false
+    bool fit(const QVector<SurrogateSample>& samples, const QVector<double>& center, const QVector<double>& scale);
+
+    bool isValid() const { return m_valid; }
+    int nodeCount() const { return m_nodes.size(); }
+
+    QVector<double> predictResiduals(const QVector<double>& x) const;
+    double predictSSE(const QVector<double>& x) const;
+
+private:
+    QVector<double> basis(const QVector<double>& x) const;
+
+    bool m_valid;
+    int m_dim;
+    int m_nRes;
+    QVector<QVector<double>> m_nodes;   // 归一化后的训练点
+    QVector<double> m_center;
+    QVector<double> m_scale;
+    QVector<double> m_M;                // q × nRes 系数矩阵（行优先）
+    QVector<double> m_G;                // q × q Gram 矩阵（行优先）
+};
+
+// 采样设置
+struct PosteriorConfig {
+    int walkers;            // 集合采样的游走者数（0 表示按参数个数自动确定）
+    int steps;              // 每个游走者的步数
+    int burnIn;             // 舍弃的预烧步数
+    int thin;               // 抽稀间隔
+    int checkInterval;      // 每隔多少步用真实模型校验一次代理模型
+    double checkTol;        // 校验允许的目标函数相对误差，超出则加入训练集并重建代理模型
+    int maxNodes;           // 代理模型最多使用的训练点数
+    int checkpointInterval; // 每隔多少步输出一次可恢复状态（0 表示不输出）
+};
+
+// 采样问题：最优点、参数尺度、先验范围（均在变换参数空间）及噪声方差
+struct PosteriorProblem {
+    QStringList names;
+    QVector<bool> isLog;
+    QVector<double> best;
+    QVector<double> scale;
+    QVector<double> lower;
+    QVector<double> upper;
+    double sigma2;
+    QVector<SurrogateSample> archive;   // 拟合过程中已完成的模型计算
+};
+
+// 采样结果（样本为物理单位）
+struct PosteriorResult {
+    bool valid;
+    QStringList names;
+    QVector<bool> isLog;
+    QVector<QVector<double>> samples;   // 每个样本为一组参数值
+    double acceptanceRate;
+    int modelChecks;                    // 真实模型校验次数
+    int surrogateRefits;                // 代理模型重建次数
+    double maxCheckError;               // 校验中目标函数的最大相对误差
+    QVector<double> mean;
+    QVector<double> median;
+    QVector<double> p05;
+    QVector<double> p95;
+};
+
+// 采样器的可恢复状态：游走者位置、随机数发生器状态、代理模型训练点及已收集的样本，
+// 从该状态继续采样与不中断时的结果一致
+struct PosteriorSamplerState {
+    bool valid;
+    int step;                               // 下一步的序号
+    QVector<QVector<double>> walkers;       // 变换参数空间中的游走者位置
+    QStringList walkerRng;                  // 各游走者的随机数发生器状态（std::mt19937 文本表示）
+    QString masterRng;
+    QVector<SurrogateSample> pool;          // 代理模型训练点池
+    QVector<SurrogateSample> nodes;         // 当前代理模型使用的训练点
+    QVector<QVector<double>> samples;       // 已收集的样本（物理单位）
+    qint64 accepted;
+    qint64 proposals;
+    int modelChecks;
+    int surrogateRefits;
+    double maxCheckError;
+};
+
+/**
+ * @brief 基于代理模型的集合 MCMC 采样器
+ *
+ * 使用仿射不变集合采样（Goodman-Weare stretch move），游走者分为两半交替并行更新；
+ * 似然由 RBF 代理模型给出，参数先验为拟合范围内的均匀分布。
+ * 训练点优先取拟合阶段已计算过的残差，不足时在最优点附近补充真实模型计算；
+ * 采样过程中定期在随机游走者位置计算真实模型，误差超限时加入训练集重建代理模型。
+ * 每隔 checkpointInterval 步通过回调输出可恢复状态，run() 可从该状态继续。
+ */
+class PosteriorSampler
+{
+public:
+    typedef std::function<QVector<double>(const QVector<double>& x)> ResidualFunction;
+    typedef std::function<void(int percent)> ProgressFunction;
+    typedef std::function<void(const PosteriorSamplerState& state)> CheckpointFunction;
+
+    explicit PosteriorSampler(const PosteriorConfig& config = defaultConfig());
+
+    static PosteriorConfig defaultConfig();
+
+    // 游走者并行更新使用的线程池（与调用方共享线程预算）；为空时用全局线程池
+    void setThreadPool(QThreadPool* pool) { m_threadPool = pool; }
+
+    // 阻塞执行；trueResiduals 在变换参数空间中计算真实残差。resume 有效时从该状态继续
+    PosteriorResult run(const PosteriorProblem& problem, ResidualFunction trueResiduals,
+                        const CancellationToken* cancel = nullptr, ProgressFunction progress = ProgressFunction(),
+                        CheckpointFunction checkpoint = CheckpointFunction(),
+                        const PosteriorSamplerState* resume = nullptr);
+
+private:
+    QVector<SurrogateSample> selectNodes(const QVector<SurrogateSample>& pool, const PosteriorProblem& problem,
+                                         const QVector<double>& around) const;
+    double logPosterior(const RbfSurrogate& surrogate, const PosteriorProblem& problem, const QVector<double>& x) const;
+
+    PosteriorConfig m_config;
+    QThreadPool* m_threadPool;
+};
+
+// 后验分布对话框：统计表、各参数边缘分布直方图，可导出样本与图片
+class PosteriorDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    PosteriorDialog(const PosteriorResult& result, const QStringList& displayNames,
+                    const QString& defaultDir, QWidget *parent = nullptr);
+
+private slots:
+    void onExportSamples();
+    void onExportPlots();
+
+private:
+    PosteriorResult m_result;
+    QStringList m_displayNames;
+    QString m_defaultDir;
+    QWidget* m_plotArea;
+};
+
+#endif // POSTERIORSAMPLER_H
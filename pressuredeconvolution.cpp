@@ -0,0 +1,760 @@
+#include "pressuredeconvolution.h"
+#include "cancellationtoken.h"
+#include <QtConcurrent>
+#include <QPair>
+#include <Eigen/Dense>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace {
+// ∫_0^u e^{bσ} dσ = (e^{bu} − 1)/b 及其对 b 的导数，|bu| 很小时用级数避免相消
+inline void segmentIntegral(double b, double u, double& E, double& Eb)
+{
+    double x = b * u;
+    if (std::abs(x) < 1e-4) {
+        E = u * (1.0 + x / 2.0 + x * x / 6.0);
+        Eb = u * u * (0.5 + x / 3.0 + x * x / 8.0);
+    } else {
+        double ex = std::exp(x);
+        E = (ex - 1.0) / b;
+        Eb = (u * ex - E) / b;
+    }
+}
+
+// 节点表示的单位产量响应：z 在 σ_k = σ0 + k·h 上分段线性，
+// 另有一个参数 w = ln Δp_u(e^{σ0})，即首节点之前的累计压降（该处未必已进入井筒储集段）
+class NodalResponse
+{
+public:
+    NodalResponse(double sigma0, double h, int n) : m_sigma0(sigma0), m_h(h), m_n(n) {}
+
+    int nodeCount() const { return m_n; }
+    double full(int m) const { return m_full[m]; }
+    double edge(int m) const { return m_edge[m]; }
+
+    double tail() const { return m_tail; }
+
+    // 更新参数（z[0..n−1] 为节点值，z[n] 为 w），预计算各段积分的前缀和及其对节点的导数：
+    // 对 σ 落在第 s 段（或 s = n−1 的外推段），前缀 C_s 对 z_m 的导数
+    // 在 m < s 时为 full(m)，m = s 时为 edge(m)，m > s 时为 0；对 w 的导数恒为 tail()
+    void setNodes(const double* z)
+    {
+        m_z.resize(m_n); m_e.resize(m_n); m_b.fill(0.0, m_n); m_c.resize(m_n);
+        m_full.fill(0.0, m_n); m_edge.fill(0.0, m_n);
+        for (int k = 0; k < m_n; ++k) { m_z[k] = z[k]; m_e[k] = std::exp(z[k]); }
+        m_tail = std::exp(z[m_n]);
+        m_c[0] = m_tail;
+        QVector<double> left(m_n, 0.0);
+        for (int k = 0; k + 1 < m_n; ++k) {
+            m_b[k] = (m_z[k + 1] - m_z[k]) / m_h;
+            double E, Eb;
+            segmentIntegral(m_b[k], m_h, E, Eb);
+            m_c[k + 1] = m_c[k] + m_e[k] * E;
+            left[k] = m_e[k] * (E - Eb / m_h);
+            m_edge[k + 1] += m_e[k] * Eb / m_h;
+        }
+        for (int m = 0; m < m_n; ++m) m_full[m] = m_edge[m] + left[m];
+    }
+
+    // 返回 Δp_u(e^σ)；seg 为前缀位置（−1 表示首节点之前，按单位斜率外推，只依赖 w），
+    // 当前段的部分积分对两个参数的导数由 (i0, d0)、(i1, d1) 返回（i1 < 0 表示无）
+    double evaluate(double sigma, int& seg, int& i0, double& d0, int& i1, double& d1) const
+    {
+        double u = sigma - m_sigma0;
+        if (u < 0) {
+            double g = m_tail * std::exp(u);
+            seg = -1; i0 = m_n; d0 = g; i1 = -1; d1 = 0;
+            return g;
+        }
+        int k = (int)(u / m_h);
+        double E, Eb;
+        if (k >= m_n - 1) {
+            // 末节点之后沿最后一段斜率外推
+            k = m_n - 1;
+            double b = (m_n >= 2) ? m_b[m_n - 2] : 0.0;
+            segmentIntegral(b, u - k * m_h, E, Eb);
+            seg = k; i0 = k; d0 = m_e[k] * (E + Eb / m_h);
+            i1 = (m_n >= 2) ? k - 1 : -1; d1 = -m_e[k] * Eb / m_h;
+            return m_c[k] + m_e[k] * E;
+        }
+        segmentIntegral(m_b[k], u - k * m_h, E, Eb);
+        seg = k; i0 = k; d0 = m_e[k] * (E - Eb / m_h);
+        i1 = k + 1; d1 = m_e[k] * Eb / m_h;
+        return m_c[k] + m_e[k] * E;
+    }
+
+    // 仅求值；derivative 返回 e^{z(σ)}
+    double value(double sigma, double* derivative = nullptr) const
+    {
+        double u = sigma - m_sigma0;
+        if (u < 0) {
+            double g = m_tail * std::exp(u);
+            if (derivative) *derivative = g;
+            return g;
+        }
+        int k = qMin((int)(u / m_h), m_n - 1);
+        double b = (k < m_n - 1) ? m_b[k] : ((m_n >= 2) ? m_b[m_n - 2] : 0.0);
+        double E, Eb;
+        double uu = u - k * m_h;
+        segmentIntegral(b, uu, E, Eb);
+        if (derivative) *derivative = m_e[k] * std::exp(b * uu);
+        return m_c[k] + m_e[k] * E;
+    }
+
+private:
+    double m_sigma0, m_h;
+    int m_n;
+    double m_tail = 0;
+    QVector<double> m_z, m_e, m_b, m_c, m_full, m_edge;
+};
+
+// 参与拟合的数据（产量已统一为“生产使压力下降”的符号）
+struct DeconvolutionProblem {
+    QVector<double> t, p;       // 压力点（按时间排序）
+    QVector<int> active;        // 各点已开始的最后一个流动段，−1 表示尚未生产
+    QVector<double> T, q;       // 流动段起点与观测产量
+    QVector<int> offset;        // 第 i 点的 ln(t_i − T_j) 存于 lnTau[offset[i] + j]，各误差模型共用
+    QVector<double> lnTau;
+    double sigma0;
+    double h;
+    int nodes;
+    double noise;               // 压力噪声标准差
+};
+
+struct CandidateSolution {
+    DeconvolutionCandidate info;
+    QVector<double> z;          // 节点值 z_0..z_{n−1} 与 w
+    double p0;
+    QVector<double> rates;
+};
+
+// 初值：导数 f = e^z 取分段线性时压力对 (f, p0) 是线性的，带曲率惩罚的线性最小二乘一次求得，
+// 从其对数出发的 Levenberg-Marquardt 只需少量迭代（直接从常数 z 出发非线性很强，收敛缓慢）
+void linearInitialGuess(const DeconvolutionProblem& pb, const QVector<double>& rates, double level,
+                        double lambda, QVector<double>& z0, double& p00)
+{
+    const int n = pb.nodes;
+    const int np = pb.t.size();
+    const double h = pb.h;
+    const double inv = 1.0 / pb.noise;
+    // 未知量：f_0..f_{n−1}、首节点处压降 F = e^w、p0
+    Eigen::MatrixXd A = Eigen::MatrixXd::Zero(n + 2, n + 2);
+    Eigen::VectorXd b = Eigen::VectorXd::Zero(n + 2);
+    Eigen::VectorXd row(n + 2);
+    QVector<double> weights(n);
+    for (int i = 0; i < np; ++i) {
+        row.setZero();
+        std::fill(weights.begin(), weights.end(), 0.0);
+        for (int j = 0; j <= pb.active[i]; ++j) {
+            double w = -(rates[j] - (j > 0 ? rates[j - 1] : 0.0)) * inv;
+            double u = pb.lnTau[pb.offset[i] + j] - pb.sigma0;
+            if (u < 0) { row(n) += w * std::exp(u); continue; }
+            row(n) += w;
+            int k = (int)(u / h);
+            if (k >= n - 1) { weights[n - 1] += w; row(n - 1) += w * (u - (n - 1) * h); continue; }
+            double v = u - k * h;
+            weights[k] += w;
+            row(k) += w * (v - v * v / (2.0 * h));
+            row(k + 1) += w * v * v / (2.0 * h);
+        }
+        // 前缀：首节点之前的积分为 F，每个完整段为 h(f_k + f_{k+1})/2
+        double above = 0;
+        for (int m = n - 1; m >= 0; --m) {
+            double edge = (m > 0 ? h / 2.0 : 0.0) * (weights[m] + above);
+            row(m) += edge + (m < n - 1 ? h / 2.0 : 0.0) * above;
+            above += weights[m];
+        }
+        row(n + 1) = inv;
+        A.selfadjointView<Eigen::Lower>().rankUpdate(row);
+        b += row * (pb.p[i] * inv);
+    }
+    double reg = (n > 2) ? std::sqrt(lambda * np / (n - 2)) / (h * h * level) : 0.0;
+    for (int k = 1; k + 1 < n; ++k) {
+        const int idx[3] = {k - 1, k, k + 1};
+        const double c[3] = {reg, -2.0 * reg, reg};
+        for (int u = 0; u < 3; ++u)
+            for (int v = 0; v <= u; ++v) A(idx[u], idx[v]) += c[u] * c[v];
+    }
+    Eigen::MatrixXd full = A.selfadjointView<Eigen::Lower>();
+    Eigen::LDLT<Eigen::MatrixXd> ldlt(full);
+    Eigen::VectorXd x = ldlt.solve(b);
+    if (ldlt.info() != Eigen::Success || !x.allFinite()) return;
+    for (int k = 0; k <= n; ++k) z0[k] = std::log(qMax(x[k], 1e-3 * level));
+    p00 = x[n + 1];
+}
+
+// 单个误差模型的 Levenberg-Marquardt 求解
+class CandidateSolver
+{
+public:
+    CandidateSolver(const DeconvolutionProblem& pb, double lambda, double rateError)
+        : m_pb(pb), m_lambda(lambda), m_rateError(rateError), m_response(pb.sigma0, pb.h, pb.nodes)
+    {
+        int n = m_pb.nodes;
+        m_params = n + 2;
+        m_rateColumn.fill(-1, m_pb.q.size());
+        for (int j = 0; j < m_pb.q.size(); ++j) {
+            // 关井段产量确为零，不参与校正
+            if (m_rateError > 0 && m_pb.q[j] != 0.0) m_rateColumn[j] = m_params++;
+        }
+        m_pairResponse.resize(m_pb.lnTau.size());
+        m_regWeight = (n > 2) ? std::sqrt(m_lambda * m_pb.t.size() / (n - 2)) / (m_pb.h * m_pb.h) : 0.0;
+    }
+
+    // 参数排列为 [z_0..z_{n−1}, w, p0, 待校正产量]。
+    // start 为初值；冷启动（warm 为 false）时校正产量的模型从常数 z = ln(level) 出发，
+    // 因为按观测产量求得的初值已把产量误差吸收进 z，离真解很远
+    CandidateSolution solve(const CandidateSolution& start, bool warm, double level, int maxIterations,
+                            const CancellationToken* cancel)
+    {
+        const int n = m_pb.nodes;
+        const int nz = n + 1;
+        Eigen::VectorXd x(m_params);
+        for (int k = 0; k < nz; ++k) x[k] = start.z[k];
+        x[nz] = start.p0;
+        for (int j = 0; j < m_pb.q.size(); ++j)
+            if (m_rateColumn[j] >= 0) x[m_rateColumn[j]] = start.rates[j];
+
+        // 压力对 p0 与产量是线性的：每次试探步后按新的 z 重新求解这部分线性最小二乘（变量投影），
+        // 联合迭代沿“产量整体放大、响应同比缩小”这一近似零空间方向收敛很慢，投影后只需少量迭代
+        const bool project = m_params > nz + 1;
+        if (project) {
+            if (!warm)
+                for (int k = 0; k < nz; ++k) x[k] = std::log(level);
+            refineRates(x);
+        }
+
+        Eigen::MatrixXd A;
+        Eigen::VectorXd g;
+        double cost = evaluate(x, &A, &g);
+        double mu = 1e-3;
+        int iter = 0;
+        bool converged = false;
+        while (iter < maxIterations && !CancellationToken::isCancelled(cancel)) {
+            ++iter;
+            // 变量投影时只对 z 迭代：消去线性参数后的 Schur 补即约化问题的 Gauss-Newton 矩阵
+            Eigen::MatrixXd H = A;
+            Eigen::VectorXd rhs = g;
+            if (project) {
+                int ny = m_params - nz;
+                Eigen::LDLT<Eigen::MatrixXd> yy(A.bottomRightCorner(ny, ny));
+                Eigen::MatrixXd K = yy.solve(A.bottomLeftCorner(ny, nz));
+                H = A.topLeftCorner(nz, nz) - A.topRightCorner(nz, ny) * K;
+                rhs = g.head(nz) - K.transpose() * g.tail(ny);
+            }
+            Eigen::VectorXd diag = H.diagonal().cwiseMax(1e-12 * H.diagonal().maxCoeff() + 1e-300);
+            bool accepted = false;
+            while (mu < 1e12) {
+                Eigen::MatrixXd M = H;
+                M.diagonal() += mu * diag;
+                Eigen::LDLT<Eigen::MatrixXd> ldlt(M);
+                if (ldlt.info() != Eigen::Success) { mu *= 4.0; continue; }
+                Eigen::VectorXd trial = x;
+                if (project) {
+                    trial.head(nz) -= ldlt.solve(rhs);
+                    refineRates(trial);
+                } else {
+                    trial -= ldlt.solve(rhs);
+                }
+                double trialCost = evaluate(trial, nullptr, nullptr, project);
+                if (std::isfinite(trialCost) && trialCost < cost) {
+                    double decrease = cost - trialCost;
+                    x = trial;
+                    cost = evaluate(x, &A, &g);
+                    mu = qMax(mu / 3.0, 1e-12);
+                    accepted = true;
+                    converged = decrease <= 1e-4 * cost + 1e-2;
+                    break;
+                }
+                mu *= 4.0;
+            }
+            if (!accepted) { converged = true; break; }
+            if (converged) break;
+        }
+        evaluate(x, nullptr, nullptr);
+
+        CandidateSolution s;
+        s.info.lambda = m_lambda;
+        s.info.rateError = m_rateError;
+        s.info.iterations = iter;
+        s.info.converged = converged;
+        s.info.pressureChi2 = m_pressureSS / qMax(1, m_pb.t.size());
+        double rough = 0;
+        for (int k = 1; k + 1 < n; ++k) {
+            double c = x[k - 1] - 2.0 * x[k] + x[k + 1];
+            rough += c * c;
+        }
+        s.info.roughness = rough;
+        s.z.resize(nz);
+        for (int k = 0; k < nz; ++k) s.z[k] = x[k];
+        s.p0 = x[nz];
+        s.rates = m_pb.q;
+        for (int j = 0; j < m_pb.q.size(); ++j)
+            if (m_rateColumn[j] >= 0) s.rates[j] = x[m_rateColumn[j]];
+        return s;
+    }
+
+private:
+    // 固定 z，p0 与待校正产量的线性最小二乘（含产量先验）
+    void refineRates(Eigen::VectorXd& x)
+    {
+        const int nz = m_pb.nodes + 1;
+        const int M = m_pb.q.size();
+        const int unknowns = m_params - nz;
+        m_response.setNodes(x.data());
+        Eigen::MatrixXd A = Eigen::MatrixXd::Zero(unknowns, unknowns);
+        Eigen::VectorXd b = Eigen::VectorXd::Zero(unknowns);
+        const int blockRows = 256;
+        Eigen::MatrixXd block(blockRows, unknowns);
+        Eigen::VectorXd blockRhs(blockRows);
+        int rowInBlock = 0;
+        auto flush = [&]() {
+            A.selfadjointView<Eigen::Lower>().rankUpdate(block.topRows(rowInBlock).transpose());
+            b.noalias() += block.topRows(rowInBlock).transpose() * blockRhs.head(rowInBlock);
+            rowInBlock = 0;
+        };
+        QVector<double> gj(M);
+        const double inv = 1.0 / m_pb.noise;
+        for (int i = 0; i < m_pb.t.size(); ++i) {
+            int a = m_pb.active[i];
+            for (int j = 0; j <= a; ++j) {
+                gj[j] = m_response.value(m_pb.lnTau[m_pb.offset[i] + j]);
+                m_pairResponse[m_pb.offset[i] + j] = gj[j];
+            }
+            auto row = block.row(rowInBlock);
+            row.setZero();
+            row(0) = inv;
+            double known = 0;
+            for (int j = 0; j <= a; ++j) {
+                double D = gj[j] - (j < a ? gj[j + 1] : 0.0);
+                int col = m_rateColumn[j];
+                if (col >= 0) row(col - nz) = -D * inv;
+                else known -= m_pb.q[j] * D;
+            }
+            blockRhs[rowInBlock] = (m_pb.p[i] - known) * inv;
+            if (++rowInBlock == blockRows) flush();
+        }
+        if (rowInBlock > 0) flush();
+        for (int j = 0; j < M; ++j) {
+            int col = m_rateColumn[j];
+            if (col < 0) continue;
+            double w = 1.0 / (m_rateError * std::abs(m_pb.q[j]));
+            A(col - nz, col - nz) += w * w;
+            b(col - nz) += w * w * m_pb.q[j];
+        }
+        Eigen::MatrixXd full = A.selfadjointView<Eigen::Lower>();
+        Eigen::LDLT<Eigen::MatrixXd> ldlt(full);
+        Eigen::VectorXd y = ldlt.solve(b);
+        if (ldlt.info() != Eigen::Success || !y.allFinite()) return;
+        for (int k = 0; k < unknowns; ++k) x[nz + k] = y[k];
+        // Δp_u ∝ e^z，缩放后缓存的响应同比缩放
+        double u = normalizeScale(x);
+        if (u != 1.0)
+            for (double& v : m_pairResponse) v /= u;
+    }
+
+    // 所有非零产量都参与校正时，产量乘以 u、z 与 w 减去 ln u 不改变压力与曲率项，
+    // 只改变产量先验，u 可直接取先验最优值
+    double normalizeScale(Eigen::VectorXd& x) const
+    {
+        const int n = m_pb.nodes;
+        const int M = m_pb.q.size();
+        for (int j = 0; j < M; ++j)
+            if (m_rateColumn[j] < 0 && m_pb.q[j] != 0.0) return 1.0;
+        double num = 0, den = 0;
+        for (int j = 0; j < M; ++j) {
+            int col = m_rateColumn[j];
+            if (col < 0) continue;
+            double w = 1.0 / (m_rateError * m_pb.q[j] * m_rateError * m_pb.q[j]);
+            num += w * x[col] * m_pb.q[j];
+            den += w * x[col] * x[col];
+        }
+        if (!(num > 0 && den > 0)) return 1.0;
+        double u = num / den;
+        for (int j = 0; j < M; ++j)
+            if (m_rateColumn[j] >= 0) x[m_rateColumn[j]] *= u;
+        for (int k = 0; k <= n; ++k) x[k] -= std::log(u);
+        return u;
+    }
+
+    // 返回 ½‖r‖²；A、g 非空时同时累积法方程 JᵀJ 与 Jᵀr（压力行按块做对称秩更新）。
+    // reuseResponse 表示 x 的 z 刚由 refineRates 处理过，可直接使用其缓存的各点单位响应
+    double evaluate(const Eigen::VectorXd& x, Eigen::MatrixXd* A, Eigen::VectorXd* g, bool reuseResponse = false)
+    {
+        const int n = m_pb.nodes;
+        const int M = m_pb.q.size();
+        const int np = m_pb.t.size();
+        m_response.setNodes(x.data());
+        const double p0 = x[n + 1];
+        QVector<double> rates = m_pb.q;
+        for (int j = 0; j < M; ++j)
+            if (m_rateColumn[j] >= 0) rates[j] = x[m_rateColumn[j]];
+
+        const bool jac = (A != nullptr);
+        const int blockRows = 256;
+        Eigen::MatrixXd block;
+        Eigen::VectorXd blockResidual;
+        if (jac) {
+            A->setZero(m_params, m_params);
+            g->setZero(m_params);
+            block.resize(blockRows, m_params);
+            blockResidual.resize(blockRows);
+        }
+        QVector<double> gj(M), weights(n);
+        QVector<int> segs(M), i0(M), i1(M);
+        QVector<double> d0(M), d1(M);
+
+        auto flush = [&](int rows) {
+            if (rows == 0) return;
+            A->selfadjointView<Eigen::Lower>().rankUpdate(block.topRows(rows).transpose());
+            g->noalias() += block.topRows(rows).transpose() * blockResidual.head(rows);
+        };
+
+        double ss = 0;
+        int rowInBlock = 0;
+        const double inv = 1.0 / m_pb.noise;
+        for (int i = 0; i < np; ++i) {
+            int a = m_pb.active[i];
+            const int off = m_pb.offset[i];
+            double model = p0;
+            for (int j = 0; j <= a; ++j) {
+                if (jac) gj[j] = m_response.evaluate(m_pb.lnTau[off + j], segs[j], i0[j], d0[j], i1[j], d1[j]);
+                else gj[j] = reuseResponse ? m_pairResponse[off + j] : m_response.value(m_pb.lnTau[off + j]);
+                double dq = rates[j] - (j > 0 ? rates[j - 1] : 0.0);
+                model -= dq * gj[j];
+            }
+            double r = (model - m_pb.p[i]) * inv;
+            ss += r * r;
+            if (!jac) continue;
+
+            auto row = block.row(rowInBlock);
+            row.setZero();
+            // z：前缀部分按段位置直方图的后缀和一次求出，段内部分逐项累加
+            std::fill(weights.begin(), weights.end(), 0.0);
+            double prefixWeight = 0;
+            for (int j = 0; j <= a; ++j) {
+                double w = -(rates[j] - (j > 0 ? rates[j - 1] : 0.0)) * inv;
+                if (segs[j] >= 0) { weights[segs[j]] += w; prefixWeight += w; }
+                row(i0[j]) += w * d0[j];
+                if (i1[j] >= 0) row(i1[j]) += w * d1[j];
+            }
+            double above = 0;
+            for (int m = n - 1; m >= 0; --m) {
+                row(m) += m_response.full(m) * above + m_response.edge(m) * weights[m];
+                above += weights[m];
+            }
+            row(n) += m_response.tail() * prefixWeight;
+            row(n + 1) = inv;
+            for (int j = 0; j <= a; ++j) {
+                int col = m_rateColumn[j];
+                if (col >= 0) row(col) = -(gj[j] - (j < a ? gj[j + 1] : 0.0)) * inv;
+            }
+            blockResidual[rowInBlock] = r;
+            if (++rowInBlock == blockRows) { flush(rowInBlock); rowInBlock = 0; }
+        }
+        if (jac) flush(rowInBlock);
+        m_pressureSS = ss;
+
+        // 产量校正项
+        for (int j = 0; j < M; ++j) {
+            int col = m_rateColumn[j];
+            if (col < 0) continue;
+            double sigma = m_rateError * std::abs(m_pb.q[j]);
+            double r = (rates[j] - m_pb.q[j]) / sigma;
+            ss += r * r;
+            if (jac) {
+                (*A)(col, col) += 1.0 / (sigma * sigma);
+                (*g)[col] += r / sigma;
+            }
+        }
+        // z 的曲率惩罚（带状）
+        for (int k = 1; k + 1 < n; ++k) {
+            double r = m_regWeight * (x[k - 1] - 2.0 * x[k] + x[k + 1]);
+            ss += r * r;
+            if (!jac) continue;
+            const int idx[3] = {k - 1, k, k + 1};
+            const double c[3] = {m_regWeight, -2.0 * m_regWeight, m_regWeight};
+            for (int u = 0; u < 3; ++u) {
+                (*g)[idx[u]] += c[u] * r;
+                for (int v = 0; v <= u; ++v) (*A)(idx[u], idx[v]) += c[u] * c[v];
+            }
+        }
+        if (jac) {
+            Eigen::MatrixXd full = A->selfadjointView<Eigen::Lower>();
+            *A = full;
+        }
+        return 0.5 * ss;
+    }
+
+    const DeconvolutionProblem& m_pb;
+    double m_lambda;
+    double m_rateError;
+    NodalResponse m_response;
+    QVector<int> m_rateColumn;
+    int m_params;
+    double m_regWeight;
+    double m_pressureSS = 0;
+    QVector<double> m_pairResponse;     // refineRates 计算的 Δp_u(t_i − T_j)，布局同 lnTau
+};
+
+// 由二阶差分的中位数绝对值估计压力噪声（不受压力趋势影响）
+double estimatePressureNoise(const QVector<double>& p)
+{
+    QVector<double> e;
+    e.reserve(p.size());
+    for (int i = 1; i + 1 < p.size(); ++i) e.append(std::abs(p[i + 1] - 2.0 * p[i] + p[i - 1]));
+    double range = 0;
+    if (!p.isEmpty()) {
+        auto mm = std::minmax_element(p.begin(), p.end());
+        range = *mm.second - *mm.first;
+    }
+    double sigma = 0;
+    if (!e.isEmpty()) {
+        std::nth_element(e.begin(), e.begin() + e.size() / 2, e.end());
+        sigma = 1.4826 * e[e.size() / 2] / std::sqrt(6.0);
+    }
+    return qMax(sigma, qMax(1e-6 * range, 1e-12));
+}
+}
+
+double PressureDeconvolution::unitResponse(const QVector<double>& nodeTime, const QVector<double>& nodeZ,
+                                           double initialResponse, double tau, double* derivative)
+{
+    if (derivative) *derivative = 0;
+    int n = qMin(nodeTime.size(), nodeZ.size());
+    if (tau <= 0 || n < 2 || !(initialResponse > 0)) return 0.0;
+    double sigma0 = std::log(nodeTime[0]);
+    NodalResponse response(sigma0, (std::log(nodeTime[n - 1]) - sigma0) / (n - 1), n);
+    QVector<double> z = nodeZ.mid(0, n);
+    z.append(std::log(initialResponse));
+    response.setNodes(z.constData());
+    return response.value(std::log(tau), derivative);
+}
+
+DeconvolutionResult PressureDeconvolution::run(const QVector<double>& t, const QVector<double>& p,
+                                               const RateSchedule& rates, const DeconvolutionConfig& config,
+                                               const CancellationToken* cancel)
+{
+    DeconvolutionResult result;
+    int M = qMin(rates.startTime.size(), rates.rate.size());
+    if (M == 0) { result.errorMessage = "产量历史为空。"; return result; }
+    for (int j = 0; j < M; ++j) {
+        if (!std::isfinite(rates.startTime[j]) || !std::isfinite(rates.rate[j]) ||
+            (j > 0 && rates.startTime[j] <= rates.startTime[j - 1])) {
+            result.errorMessage = "产量历史的起始时间必须严格递增。";
+            return result;
+        }
+    }
+
+    // 1. 有效压力点，按时间排序
+    QVector<int> order;
+    int nAll = qMin(t.size(), p.size());
+    order.reserve(nAll);
+    bool sorted = true;
+    for (int i = 0; i < nAll; ++i) {
+        if (!std::isfinite(t[i]) || !std::isfinite(p[i])) continue;
+        if (!order.isEmpty() && t[i] < t[order.last()]) sorted = false;
+        order.append(i);
+    }
+    if (!sorted) std::sort(order.begin(), order.end(), [&t](int a, int b) { return t[a] < t[b]; });
+
+    DeconvolutionProblem pb;
+    pb.T = rates.startTime.mid(0, M);
+    pb.q = rates.rate.mid(0, M);
+    QVector<double> sortedT, sortedP;
+    QVector<int> sortedActive;
+    sortedT.reserve(order.size()); sortedP.reserve(order.size()); sortedActive.reserve(order.size());
+    double tauMin = std::numeric_limits<double>::infinity();
+    int a = -1;
+    for (int i : order) {
+        while (a + 1 < M && pb.T[a + 1] < t[i]) ++a;
+        sortedT.append(t[i]); sortedP.append(p[i]); sortedActive.append(a);
+        if (a >= 0) tauMin = qMin(tauMin, t[i] - pb.T[a]);
+    }
+    if (sortedT.isEmpty() || sortedActive.last() < 0) {
+        result.errorMessage = "没有开始生产之后的压力数据。";
+        return result;
+    }
+
+    // 2. 节点：覆盖最短流动段内时间到整个历史长度
+    double tauMax = sortedT.last() - pb.T[0];
+    double sigmaEnd = std::log(tauMax);
+    double sigma0 = std::log(qMax(tauMin, tauMax * 1e-8));
+    if (sigmaEnd - sigma0 < 0.5) { result.errorMessage = "压力数据的时间跨度太短。"; return result; }
+    double decades = (sigmaEnd - sigma0) / std::log(10.0);
+    pb.nodes = qBound(6, (int)std::ceil(decades * config.nodesPerDecade) + 1, 150);
+    pb.sigma0 = sigma0;
+    pb.h = (sigmaEnd - sigma0) / (pb.nodes - 1);
+    pb.noise = estimatePressureNoise(sortedP);
+    result.noiseLevel = pb.noise;
+
+    // 3. 拟合点：点数过多时各流动段内按对数时间抽稀（段首、段尾总保留）
+    int groups = 0;
+    for (int i = 0; i < sortedT.size(); ++i)
+        if (i == 0 || sortedActive[i] != sortedActive[i - 1]) ++groups;
+    bool decimate = sortedT.size() > config.maxFitPoints;
+    int perGroup = qBound(4, config.maxFitPoints / qMax(1, groups), 64);
+    for (int first = 0; first < sortedT.size();) {
+        int last = first;
+        while (last + 1 < sortedT.size() && sortedActive[last + 1] == sortedActive[first]) ++last;
+        int g = sortedActive[first];
+        int count = last - first + 1;
+        if (!decimate || count <= perGroup) {
+            for (int i = first; i <= last; ++i) {
+                pb.t.append(sortedT[i]); pb.p.append(sortedP[i]); pb.active.append(sortedActive[i]);
+            }
+        } else if (g < 0) {
+            int stride = (count + perGroup - 1) / perGroup;
+            for (int i = first; i <= last; i += stride) {
+                pb.t.append(sortedT[i]); pb.p.append(sortedP[i]); pb.active.append(g);
+            }
+        } else {
+            double lnFirst = std::log(sortedT[first] - pb.T[g]);
+            double step = (std::log(sortedT[last] - pb.T[g]) - lnFirst) / (perGroup - 1);
+            double next = lnFirst;
+            for (int i = first; i <= last; ++i) {
+                double lnTau = std::log(sortedT[i] - pb.T[g]);
+                if (lnTau < next - 1e-12 && i != last) continue;
+                pb.t.append(sortedT[i]); pb.p.append(sortedP[i]); pb.active.append(g);
+                next = lnTau + step;
+            }
+        }
+        first = last + 1;
+    }
+    result.fitPoints = pb.t.size();
+    pb.offset.reserve(pb.t.size());
+    for (int i = 0; i < pb.t.size(); ++i) {
+        pb.offset.append(pb.lnTau.size());
+        for (int j = 0; j <= pb.active[i]; ++j) pb.lnTau.append(std::log(pb.t[i] - pb.T[j]));
+    }
+
+    // 4. 初值：先取常数 z，p = p0 − e^z·G(t) 对 (p0, e^z) 线性回归（斜率为负说明产量符号相反），
+    //    再解 f = e^z 的线性最小二乘
+    NodalResponse flat(pb.sigma0, pb.h, pb.nodes);
+    QVector<double> zeros(pb.nodes + 1, 0.0);
+    flat.setNodes(zeros.constData());
+    int nf = pb.t.size();
+    double sG = 0, sP = 0, sGG = 0, sGP = 0;
+    for (int i = 0; i < nf; ++i) {
+        double G = 0;
+        for (int j = 0; j <= pb.active[i]; ++j)
+            G += (pb.q[j] - (j > 0 ? pb.q[j - 1] : 0.0)) * flat.value(pb.lnTau[pb.offset[i] + j]);
+        sG += G; sP += pb.p[i]; sGG += G * G; sGP += G * pb.p[i];
+    }
+    double varG = sGG - sG * sG / nf;
+    if (!(varG > 0)) { result.errorMessage = "产量历史没有引起可辨识的压力变化。"; return result; }
+    double slope = -(sGP - sG * sP / nf) / varG;
+    double sign = 1.0;
+    if (slope < 0) {
+        sign = -1.0;
+        slope = -slope;
+        for (double& q : pb.q) q = -q;
+        sG = -sG;
+    }
+    double level = qMax(slope, 1e-300);
+    double p00 = (sP + level * sG) / nf;
+    QVector<double> z0(pb.nodes + 1, std::log(level));
+    linearInitialGuess(pb, pb.q, level, config.lambdas.isEmpty() ? 0.01 : config.lambdas.last(), z0, p00);
+
+    // 5. 并行求解各误差模型：先对每个产量误差以最大的 λ 冷启动求解，
+    //    其余 λ 再从同一产量误差的解热启动并行求解，只需少量迭代
+    QVector<double> lambdas = config.lambdas;
+    QVector<double> rateErrors = config.rateErrors;
+    if (lambdas.isEmpty()) lambdas.append(0.01);
+    if (rateErrors.isEmpty()) rateErrors.append(0.0);
+    std::sort(lambdas.begin(), lambdas.end(), std::greater<double>());
+    struct ModelSpec { double lambda; double rateError; int warm; };
+    QVector<ModelSpec> firstStage, secondStage;
+    for (int e = 0; e < rateErrors.size(); ++e) {
+        firstStage.append(ModelSpec{lambdas[0], rateErrors[e], -1});
+        for (int l = 1; l < lambdas.size(); ++l) secondStage.append(ModelSpec{lambdas[l], rateErrors[e], e});
+    }
+    CandidateSolution initial;
+    initial.z = z0;
+    initial.p0 = p00;
+    initial.rates = pb.q;
+    QVector<CandidateSolution> solutions;
+    auto solveModel = [&](const ModelSpec& m) {
+        CandidateSolver solver(pb, m.lambda, m.rateError);
+        bool warm = m.warm >= 0;
+        return solver.solve(warm ? solutions[m.warm] : initial, warm, level, config.maxIterations, cancel);
+    };
+    solutions = QtConcurrent::blockingMapped<QVector<CandidateSolution>>(firstStage, solveModel);
+    solutions.append(QtConcurrent::blockingMapped<QVector<CandidateSolution>>(secondStage, solveModel));
+    if (CancellationToken::isCancelled(cancel)) { result.errorMessage = "计算已取消。"; return result; }
+
+    // 6. 选择：压力残差与噪声相符的解中取最平滑者（λ 最大），同等 λ 时优先信任产量
+    double bestChi2 = std::numeric_limits<double>::infinity();
+    for (const auto& s : solutions)
+        if (std::isfinite(s.info.pressureChi2)) bestChi2 = qMin(bestChi2, s.info.pressureChi2);
+    if (!std::isfinite(bestChi2)) { result.errorMessage = "反褶积未能收敛。"; return result; }
+    double threshold = qMax(1.5, 1.5 * bestChi2);
+    int chosen = -1;
+    for (int k = 0; k < solutions.size(); ++k) {
+        const auto& c = solutions[k].info;
+        result.candidates.append(c);
+        if (!(c.pressureChi2 <= threshold)) continue;
+        if (chosen < 0) { chosen = k; continue; }
+        const auto& b = solutions[chosen].info;
+        if (c.lambda > b.lambda || (c.lambda == b.lambda && c.rateError < b.rateError)) chosen = k;
+    }
+    result.selectedCandidate = chosen;
+    const CandidateSolution& best = solutions[chosen];
+
+    // 7. 输出
+    NodalResponse response(pb.sigma0, pb.h, pb.nodes);
+    response.setNodes(best.z.constData());
+    for (int k = 0; k < pb.nodes; ++k) {
+        result.nodeTime.append(std::exp(pb.sigma0 + k * pb.h));
+        result.nodeZ.append(best.z[k]);
+    }
+    result.initialResponse = std::exp(best.z[pb.nodes]);
+    result.initialPressure = best.p0;
+    result.correctedRates.resize(M);
+    double refRate = 0;
+    for (int j = 0; j < M; ++j) {
+        result.correctedRates[j] = sign * best.rates[j];
+        refRate = qMax(refRate, std::abs(best.rates[j]));
+    }
+    result.referenceRate = refRate;
+
+    const int perDecade = 20;
+    int gridCount = qMax(2, (int)std::ceil(decades * perDecade) + 1);
+    for (int k = 0; k < gridCount; ++k) {
+        double sigma = pb.sigma0 + (sigmaEnd - pb.sigma0) * k / (gridCount - 1);
+        double d = 0;
+        double g = response.value(sigma, &d);
+        result.time.append(std::exp(sigma));
+        result.unitResponse.append(g);
+        result.unitDerivative.append(d);
+        result.pressureDrop.append(refRate * g);
+        result.derivative.append(refRate * d);
+    }
+
+    // 全部压力点的重构（分块并行，O(点数 × 流动段数)）
+    int n = sortedT.size();
+    QVector<double> model(n);
+    QVector<int> starts;
+    const int chunk = 4096;
+    for (int c0 = 0; c0 < n; c0 += chunk) starts.append(c0);
+    QtConcurrent::blockingMap(starts, [&](int c0) {
+        int c1 = qMin(n, c0 + chunk);
+        for (int i = c0; i < c1; ++i) {
+            double m = best.p0;
+            for (int j = 0; j <= sortedActive[i]; ++j)
+                m -= (best.rates[j] - (j > 0 ? best.rates[j - 1] : 0.0)) * response.value(std::log(sortedT[i] - pb.T[j]));
+            model[i] = m;
+        }
+    });
+    result.modelPressure.resize(nAll);
+    std::fill(result.modelPressure.begin(), result.modelPressure.end(), std::numeric_limits<double>::quiet_NaN());
+    double ss = 0;
+    for (int k = 0; k < n; ++k) {
+        result.modelPressure[order[k]] = model[k];
+        ss += (model[k] - sortedP[k]) * (model[k] - sortedP[k]);
+    }
+    result.pressureRms = std::sqrt(ss / n);
+    result.success = true;
+    return result;
+}
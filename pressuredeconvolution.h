@@ -0,0 +1,100 @@
+#ifndef PRESSUREDECONVOLUTION_H
+#define PRESSUREDECONVOLUTION_H
+
+#include <QVector>
+#include <QString>
+#include "modelsuperposition.h"
+
+class CancellationToken;
+
+// 反褶积设置
+struct DeconvolutionConfig {
+    int nodesPerDecade;             // z(σ) 节点密度（每个对数周期）
+    int maxFitPoints;               // 参与拟合的压力点上限（超出时各流动段内按对数时间抽稀）
+    int maxIterations;              // 每个误差模型的 Levenberg-Marquardt 迭代上限
+    QVector<double> lambdas;        // 候选正则化系数（z 曲率惩罚）
+    QVector<double> rateErrors;     // 候选产量相对误差，0 表示产量精确、不参与校正
+
+    DeconvolutionConfig() :
+        nodesPerDecade(8),
+        maxFitPoints(3000),
+        maxIterations(100),
+        lambdas({1e-3, 3e-3, 1e-2, 3e-2, 0.1, 0.3}),
+        rateErrors({0.0, 0.02, 0.05}) {}
+};
+
+// 一个误差模型（λ, 产量误差）的拟合结果
+struct DeconvolutionCandidate {
+    double lambda;
+    double rateError;
+    double pressureChi2;    // 归一化压力残差平方均值（以估计的压力噪声为单位）
+    double roughness;       // z 的二阶差分平方和
+    int iterations;
+    bool converged;
+};
+
+// 反褶积结果
+struct DeconvolutionResult {
+    bool success;
+    QString errorMessage;
+
+    QVector<double> nodeTime;       // 节点时间 exp(σ_k)
+    QVector<double> nodeZ;          // z(σ_k) = ln(d Δp_u / d ln t)
+    double initialResponse;         // 首节点处的单位产量压降 Δp_u(nodeTime[0])
+    double initialPressure;         // 反演的原始地层压力 p0
+    QVector<double> correctedRates; // 校正后的各段产量（产量精确时与输入相同）
+
+    // 单位产量响应在对数时间网格上的采样
+    QVector<double> time;
+    QVector<double> unitResponse;   // Δp_u(t)
+    QVector<double> unitDerivative; // dΔp_u/dln t
+
+    // 换算到参考产量的压降与导数，可直接作为观测数据拟合
+    double referenceRate;
+    QVector<double> pressureDrop;
+    QVector<double> derivative;
+
+    QVector<double> modelPressure;  // 对全部输入压力点的重构
+    double pressureRms;             // 全部点的压力拟合均方根误差
+    double noiseLevel;              // 估计的压力噪声标准差
+    int fitPoints;
+
+    QVector<DeconvolutionCandidate> candidates;
+    int selectedCandidate;
+
+    DeconvolutionResult() : success(false), initialResponse(0), initialPressure(0), referenceRate(0),
+        pressureRms(0), noiseLevel(0), fitPoints(0), selectedCandidate(-1) {}
+};
+
+/**
+ * @brief 压力-产量反褶积（von Schroeter / Levitan 方法）
+ *
+ * 把变产量压力历史表示为单位产量响应的叠加：
+ *     p(t) = p0 − Σ_j (q_j − q_{j−1}) · Δp_u(t − T_j)，
+ *     Δp_u(τ) = ∫_{−∞}^{ln τ} exp(z(σ)) dσ，
+ * z(σ) 在等距对数时间节点上分段线性，首节点处的压降 Δp_u(τ_0) 作为独立参数反演
+ * （最短流动段内的首个数据点未必已处于井筒储集段），末节点之后沿最后一段斜率外推，
+ * 因而 Δp_u 及其对各参数的导数都有解析式，
+ * 每个压力点的 Jacobian 行借助节点前缀和 O(段数 + 节点数) 求得。
+ *
+ * 目标函数为总体最小二乘：压力残差 + 产量校正量（按相对误差加权）+ λ·z 的曲率，
+ * 用 Levenberg-Marquardt 求解。p0 与产量对压力是线性的，校正产量时每步按变量投影消去，
+ * 迭代只在节点值上进行，法方程仅含 节点数 + 2 + 校正产量数 个未知量。
+ * 各候选误差模型并行求解，取压力残差与噪声水平相符（χ² ≤ 1.5 或最优值的 1.5 倍）的
+ * 最平滑解，同等平滑时优先信任产量。
+ * 压力点很多时，各流动段内按对数时间抽稀后参与拟合，最终对全部点重构压力。
+ */
+class PressureDeconvolution
+{
+public:
+    static DeconvolutionResult run(const QVector<double>& t, const QVector<double>& p,
+                                   const RateSchedule& rates,
+                                   const DeconvolutionConfig& config = DeconvolutionConfig(),
+                                   const CancellationToken* cancel = nullptr);
+
+    // 由节点值与首节点压降求 Δp_u(τ) 与 dΔp_u/dln τ（τ ≤ 0 时返回 0）
+    static double unitResponse(const QVector<double>& nodeTime, const QVector<double>& nodeZ,
+                               double initialResponse, double tau, double* derivative = nullptr);
+};
+
+#endif // PRESSUREDECONVOLUTION_H
@@ -2,7 +2,84 @@
 #include <QStandardItem>
 #include <QRegularExpression>
 #include <QDebug>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QSlider>
+#include <QLabel>
+#include <QPushButton>
+#include <QComboBox>
+#include <QApplication>
+#include <QtConcurrent>
+#include "qcustomplot.h"
+#include "timetransform.h"
+#include <Eigen/Dense>
 #include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace {
+// 求解 (W + λP) f = W·y，W 为对角权重，P 为五对角对称矩阵（主对角线 p0、次对角线 p1、p2）。
+// LDLᵀ 分解 O(n)；trace 非空时用带状选择求逆 (Takahashi 递推) 返回帽子矩阵的迹 tr((W + λP)⁻¹W)，同样 O(n)
+bool solvePentadiagonal(const QVector<double>& w, const QVector<double>& p0, const QVector<double>& p1,
+                        const QVector<double>& p2, const QVector<double>& y, double lambda,
+                        QVector<double>& f, double* trace)
+{
+    int n = y.size();
+    QVector<double> D(n), l1(n, 0.0), l2(n, 0.0);
+    for (int i = 0; i < n; ++i) {
+        double b0 = w[i] + lambda * p0[i];
+        double b1 = (i + 1 < n) ? lambda * p1[i] : 0.0;
+        double b2 = (i + 2 < n) ? lambda * p2[i] : 0.0;
+        double d = b0;
+        if (i >= 1) d -= l1[i - 1] * l1[i - 1] * D[i - 1];
+        if (i >= 2) d -= l2[i - 2] * l2[i - 2] * D[i - 2];
+        if (!(d > 0)) return false;
+        D[i] = d;
+        if (i >= 1) b1 -= l2[i - 1] * l1[i - 1] * D[i - 1];
+        l1[i] = b1 / d;
+        l2[i] = b2 / d;
+    }
+
+    f.resize(n);
+    for (int i = 0; i < n; ++i) {
+        double z = w[i] * y[i];
+        if (i >= 1) z -= l1[i - 1] * f[i - 1];
+        if (i >= 2) z -= l2[i - 2] * f[i - 2];
+        f[i] = z;
+    }
+    for (int i = 0; i < n; ++i) f[i] /= D[i];
+    for (int i = n - 1; i >= 0; --i) {
+        if (i + 1 < n) f[i] -= l1[i] * f[i + 1];
+        if (i + 2 < n) f[i] -= l2[i] * f[i + 2];
+    }
+
+    if (trace) {
+        // Z = (LDLᵀ)⁻¹ 只需带宽 2 以内的元素：z0 为对角线，z1、z2 为上方第 1、2 条对角线
+        QVector<double> z0(n), z1(n, 0.0), z2(n, 0.0);
+        double sum = 0.0;
+        for (int i = n - 1; i >= 0; --i) {
+            double a1 = (i + 1 < n) ? l1[i] : 0.0;
+            double a2 = (i + 2 < n) ? l2[i] : 0.0;
+            double zi1 = 0.0, zi2 = 0.0;
+            if (i + 1 < n) zi1 = -a1 * z0[i + 1] - ((i + 2 < n) ? a2 * z1[i + 1] : 0.0);
+            if (i + 2 < n) zi2 = -a1 * z1[i + 1] - a2 * z0[i + 2];
+            z1[i] = zi1;
+            z2[i] = zi2;
+            z0[i] = 1.0 / D[i] - a1 * zi1 - a2 * zi2;
+            sum += w[i] * z0[i];
+        }
+        *trace = sum;
+    }
+    return true;
+}
+
+double residualSumOfSquares(const QVector<double>& w, const QVector<double>& y, const QVector<double>& f)
+{
+    double rss = 0.0;
+    for (int i = 0; i < y.size(); ++i) rss += w[i] * (y[i] - f[i]) * (y[i] - f[i]);
+    return rss;
+}
+}
 
 PressureDerivativeCalculator::PressureDerivativeCalculator(QObject *parent)
     : QObject(parent)
@@ -21,37 +98,64 @@ PressureDerivativeResult PressureDerivativeCalculator::calculatePressureDerivati
     result.addedColumnIndex = -1;
     result.processedRows = 0;
 
+    // 检查L-Spacing参数
+    if (config.lSpacing <= 0) {
+        result.errorMessage = "L-Spacing参数必须大于0";
+        return result;
+    }
+
+    emit progressUpdated(10, "正在读取数据...");
+
+    QVector<double> adjustedTimeData;
+    QVector<double> pressureDropData;
+    if (!readSeries(model, config, adjustedTimeData, pressureDropData, &result.errorMessage)) {
+        return result;
+    }
+
+    emit progressUpdated(50, "正在计算Bourdet导数（L-Spacing平滑）...");
+
+    // 调用静态统一算法
+    QVector<double> derivativeData = calculateBourdetDerivative(adjustedTimeData, pressureDropData, config.lSpacing);
+
+    emit progressUpdated(80, "正在写入结果...");
+
+    result = insertDerivativeColumn(model, config, derivativeData);
+    if (!result.success) return result;
+
+    emit progressUpdated(100, "计算完成");
+    emit calculationCompleted(result);
+
+    return result;
+}
+
+bool PressureDerivativeCalculator::readSeries(QStandardItemModel* model, const PressureDerivativeConfig& config,
+                                              QVector<double>& adjustedTimeData, QVector<double>& pressureDropData,
+                                              QString* error)
+{
+    auto fail = [error](const QString& message) {
+        if (error) *error = message;
+        return false;
+    };
+
     // 检查数据模型
     if (!model) {
-        result.errorMessage = "数据模型不存在";
-        return result;
+        return fail("数据模型不存在");
     }
 
     int rowCount = model->rowCount();
     if (rowCount < 3) {
-        result.errorMessage = "数据行数不足（至少需要3行）";
-        return result;
+        return fail("数据行数不足（至少需要3行）");
     }
 
     // 检查列索引
     if (config.pressureColumnIndex < 0 || config.pressureColumnIndex >= model->columnCount()) {
-        result.errorMessage = "压力列索引无效";
-        return result;
+        return fail("压力列索引无效");
     }
 
     if (config.timeColumnIndex < 0 || config.timeColumnIndex >= model->columnCount()) {
-        result.errorMessage = "时间列索引无效";
-        return result;
+        return fail("时间列索引无效");
     }
 
-    // 检查L-Spacing参数
-    if (config.lSpacing <= 0) {
-        result.errorMessage = "L-Spacing参数必须大于0";
-        return result;
-    }
-
-    emit progressUpdated(10, "正在读取数据...");
-
     // 读取时间和压力数据 (使用 QVector 提高性能)
     QVector<double> timeData;
     QVector<double> pressureData;
@@ -74,8 +178,7 @@ PressureDerivativeResult PressureDerivativeCalculator::calculatePressureDerivati
 
         // 检查时间值有效性（允许从0开始）
         if (timeValue < 0) {
-            result.errorMessage = QString("检测到无效时间值（行 %1），时间不能为负数").arg(row + 1);
-            return result;
+            return fail(QString("检测到无效时间值（行 %1），时间不能为负数").arg(row + 1));
         }
 
         timeData.append(timeValue);
@@ -115,16 +218,14 @@ PressureDerivativeResult PressureDerivativeCalculator::calculatePressureDerivati
     }
 
     // 应用时间偏移
-    QVector<double> adjustedTimeData;
+    adjustedTimeData.clear();
     adjustedTimeData.reserve(rowCount);
     for (double t : timeData) {
         adjustedTimeData.append(t + actualTimeOffset);
     }
 
-    emit progressUpdated(30, "正在计算压降...");
-
     // 计算压降 (初始压力 - 当前压力，假定是压降测试)
-    QVector<double> pressureDropData;
+    pressureDropData.clear();
     pressureDropData.reserve(rowCount);
     double initialPressure = pressureData.isEmpty() ? 0.0 : pressureData[0];
 
@@ -132,19 +233,19 @@ PressureDerivativeResult PressureDerivativeCalculator::calculatePressureDerivati
         double pressureDrop = initialPressure - pressureData[i];
         pressureDropData.append(pressureDrop);
     }
+    return true;
+}
 
-    emit progressUpdated(50, "正在计算Bourdet导数（L-Spacing平滑）...");
-
-    // 调用静态统一算法
-    QVector<double> derivativeData = calculateBourdetDerivative(adjustedTimeData, pressureDropData, config.lSpacing);
-
-    if (derivativeData.size() != rowCount) {
+PressureDerivativeResult PressureDerivativeCalculator::insertDerivativeColumn(
+    QStandardItemModel* model, const PressureDerivativeConfig& config, const QVector<double>& derivativeData)
+{
+    PressureDerivativeResult result;
+    int rowCount = model ? model->rowCount() : 0;
+    if (!model || derivativeData.size() != rowCount) {
         result.errorMessage = "导数计算结果数量不匹配";
         return result;
     }
 
-    emit progressUpdated(80, "正在写入结果...");
-
     // 在压力列后面插入新列
     int newColumnIndex = config.pressureColumnIndex + 1;
     model->insertColumn(newColumnIndex);
@@ -163,15 +264,10 @@ PressureDerivativeResult PressureDerivativeCalculator::calculatePressureDerivati
         result.processedRows++;
     }
 
-    emit progressUpdated(100, "计算完成");
-
     // 设置返回结果
     result.success = true;
     result.addedColumnIndex = newColumnIndex;
     result.columnName = columnName;
-
-    emit calculationCompleted(result);
-
     return result;
 }
 
@@ -181,135 +277,436 @@ QVector<double> PressureDerivativeCalculator::calculateBourdetDerivative(
     const QVector<double>& pressureDropData,
     double lSpacing)
 {
-    QVector<double> derivativeData;
+    if (timeData.isEmpty()) return QVector<double>();
+    return calculateBourdetSweep(timeData, pressureDropData, QVector<double>{lSpacing}).first();
+}
+
+QVector<QVector<double>> PressureDerivativeCalculator::calculateBourdetSweep(
+    const QVector<double>& timeData,
+    const QVector<double>& pressureDropData,
+    const QVector<double>& lValues)
+{
+    QVector<QVector<double>> sweep(lValues.size());
     int n = timeData.size();
-    derivativeData.reserve(n);
+    if (n == 0) return sweep;
 
-    if (n == 0) return derivativeData;
+    // ln(t) 只计算一次；非正时间记为 NaN，不参与左右点搜索
+    QVector<double> lnT(n);
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (int i = 0; i < n; ++i)
+        lnT[i] = timeData[i] > 0 ? std::log(timeData[i]) : nan;
 
-    for (int i = 0; i < n; ++i) {
-        double derivative = 0.0;
-        double ti = timeData[i];
-        double pi = pressureDropData[i];
+    // 左右点 j、k：ln(ti) - ln(tj) ≥ L，ln(tk) - ln(ti) ≥ L
+    QVector<QVector<int>> left, right;
+    findLogWindows(lnT, lValues, left, right);
+
+    for (int m = 0; m < lValues.size(); ++m)
+        sweep[m] = derivativeFromWindows(lnT, pressureDropData, left[m], right[m]);
+    return sweep;
+}
 
-        // 寻找左侧点j：ln(ti) - ln(tj) ≥ L
-        int leftIndex = findLeftPoint(timeData, i, lSpacing);
+QVector<double> PressureDerivativeCalculator::defaultSweepValues()
+{
+    QVector<double> values;
+    // L ≤ 0 不是有效的 L-Spacing（calculatePressureDerivative 会拒绝），从 0.05 起
+    for (int k = 1; k <= 10; ++k) values.append(0.05 * k);
+    return values;
+}
 
-        // 寻找右侧点k：ln(tk) - ln(ti) ≥ L
-        int rightIndex = findRightPoint(timeData, i, lSpacing);
+QVector<double> PressureDerivativeCalculator::calculateDerivative(const QVector<double>& timeData,
+                                                                  const QVector<double>& pressureDropData,
+                                                                  const DerivativeOptions& options,
+                                                                  double* usedLambda)
+{
+    if (usedLambda) *usedLambda = 0.0;
+    int n = qMin(timeData.size(), pressureDropData.size());
+    if (options.method == DerivativeMethod::Bourdet || n < 5)
+        return calculateBourdetDerivative(timeData, pressureDropData, options.lSpacing);
+
+    // 有效点（t > 0）按时间排序后在 ln(t) 上计算，非正时间的导数记为 0
+    QVector<int> order;
+    order.reserve(n);
+    bool sorted = true;
+    for (int i = 0; i < n; ++i) {
+        if (!(timeData[i] > 0 && std::isfinite(timeData[i]) && std::isfinite(pressureDropData[i]))) continue;
+        if (!order.isEmpty() && timeData[i] < timeData[order.last()]) sorted = false;
+        order.append(i);
+    }
+    if (order.size() < 5)
+        return calculateBourdetDerivative(timeData, pressureDropData, options.lSpacing);
+    if (!sorted)
+        std::stable_sort(order.begin(), order.end(), [&timeData](int a, int b) { return timeData[a] < timeData[b]; });
+
+    QVector<double> x(order.size()), y(order.size());
+    for (int k = 0; k < order.size(); ++k) {
+        x[k] = std::log(timeData[order[k]]);
+        y[k] = pressureDropData[order[k]];
+    }
+    QVector<double> dv = (options.method == DerivativeMethod::SavitzkyGolay)
+                             ? savitzkyGolay(x, y, options.window, options.polyOrder)
+                             : penalizedDerivative(x, y, options.method, options.lambda, usedLambda);
 
-        // 1. 如果找到左右两个点，使用加权平均法 (Bourdet Standard)
-        if (leftIndex >= 0 && rightIndex >= 0) {
-            double tj = timeData[leftIndex];
-            double pj = pressureDropData[leftIndex];
-            double tk = timeData[rightIndex];
-            double pk = pressureDropData[rightIndex];
+    QVector<double> derivativeData(timeData.size(), 0.0);
+    for (int k = 0; k < order.size(); ++k) derivativeData[order[k]] = dv[k];
+    return derivativeData;
+}
 
-            // 计算对数差值
-            double deltaXL = std::log(ti) - std::log(tj);  // ΔXL = ln(ti) - ln(tj)
-            double deltaXR = std::log(tk) - std::log(ti);  // ΔXR = ln(tk) - ln(ti)
+QString PressureDerivativeCalculator::methodName(DerivativeMethod method)
+{
+    switch (method) {
+    case DerivativeMethod::SavitzkyGolay: return "Savitzky-Golay";
+    case DerivativeMethod::SmoothingSpline: return "平滑样条";
+    case DerivativeMethod::Tikhonov: return "Tikhonov 正则化";
+    default: return "Bourdet";
+    }
+}
 
-            // 计算左导数和右导数
-            double mL = calculateDerivativeValue(ti, tj, pi, pj);  // 左导数 slope
-            double mR = calculateDerivativeValue(tk, ti, pk, pi);  // 右导数 slope
+QVector<double> PressureDerivativeCalculator::savitzkyGolay(const QVector<double>& x, const QVector<double>& y,
+                                                            double window, int polyOrder)
+{
+    // 对每个点取 |ln(tj) - ln(ti)| ≤ h 的窗口做 k 阶最小二乘多项式拟合，导数为一次项系数。
+    // 窗口内的矩 Σu^r、Σu^r·y (u = (ln tj - ln ti)/h) 随中心移动按二项式平移并增删进出窗口的点，
+    // 移动步数达到窗口点数（至少 64）时重算一次以限制舍入误差累积，均摊仍为 O(1)；
+    // 各数据段独立计算，并行执行
+    const int m = x.size();
+    const int k = qBound(1, polyOrder, 4);
+    const double h = window > 0 ? window : 0.2;
+    QVector<double> out(m, 0.0);
+
+    // 窗口内点数不足时退回同尺度的 Bourdet 导数
+    QVector<QVector<int>> left, right;
+    findLogWindows(x, QVector<double>{h}, left, right);
+    const QVector<double> fallback = derivativeFromWindows(x, y, left[0], right[0]);
+
+    double binom[9][9] = {};
+    for (int r = 0; r <= 8; ++r) {
+        binom[r][0] = 1.0;
+        for (int c = 1; c <= r; ++c) binom[r][c] = binom[r - 1][c - 1] + (c < r ? binom[r - 1][c] : 0.0);
+    }
 
-            // 加权平均公式：P' = (mL * ΔXR + mR * ΔXL) / (ΔXL + ΔXR)
-            if (deltaXL + deltaXR > 1e-12) {
-                derivative = (mL * deltaXR + mR * deltaXL) / (deltaXL + deltaXR);
-            } else {
-                derivative = 0.0;
+    const int chunk = 16384;
+    QVector<int> starts;
+    for (int c0 = 0; c0 < m; c0 += chunk) starts.append(c0);
+
+    QtConcurrent::blockingMap(starts, [&](int c0) {
+        const int c1 = qMin(c0 + chunk, m);
+        const double yRef = y[c0];   // 常数偏移只影响零次项，减去后矩的量级更小
+        double M[9], N[5];
+        int lo = int(std::lower_bound(x.constBegin(), x.constBegin() + c0, x[c0] - h) - x.constBegin());
+        int hi = c0;
+        int lastRebuild = c0;
+
+        auto accumulate = [&](int j, int centre, double sign) {
+            double u = (x[j] - x[centre]) / h;
+            double yj = y[j] - yRef;
+            double pw = 1.0;
+            for (int r = 0; r <= 2 * k; ++r) {
+                M[r] += sign * pw;
+                if (r <= k) N[r] += sign * pw * yj;
+                pw *= u;
+            }
+        };
+
+        for (int i = c0; i < c1; ++i) {
+            bool rebuild = (i == c0) || (i - lastRebuild >= qMax(64, hi - lo));
+            if (!rebuild) {
+                // 中心右移 d：Σ(u - d)^r = Σ_s C(r,s)·Σu^s·(-d)^(r-s)
+                double d = (x[i] - x[i - 1]) / h;
+                if (d != 0.0) {
+                    double negPow[9];
+                    negPow[0] = 1.0;
+                    for (int r = 1; r <= 2 * k; ++r) negPow[r] = negPow[r - 1] * (-d);
+                    double M2[9], N2[5];
+                    for (int r = 0; r <= 2 * k; ++r) {
+                        M2[r] = 0.0;
+                        for (int q = 0; q <= r; ++q) M2[r] += binom[r][q] * M[q] * negPow[r - q];
+                    }
+                    for (int r = 0; r <= k; ++r) {
+                        N2[r] = 0.0;
+                        for (int q = 0; q <= r; ++q) N2[r] += binom[r][q] * N[q] * negPow[r - q];
+                    }
+                    std::copy(M2, M2 + 2 * k + 1, M);
+                    std::copy(N2, N2 + k + 1, N);
+                }
+            }
+            while (hi < m && x[hi] <= x[i] + h) { if (!rebuild) accumulate(hi, i, 1.0); ++hi; }
+            while (lo < hi && x[lo] < x[i] - h) { if (!rebuild) accumulate(lo, i, -1.0); ++lo; }
+            if (rebuild) {
+                lastRebuild = i;
+                std::fill(M, M + 9, 0.0);
+                std::fill(N, N + 5, 0.0);
+                for (int j = lo; j < hi; ++j) accumulate(j, i, 1.0);
+            }
+
+            double derivative = fallback[i];
+            if (hi - lo >= k + 2) {
+                Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, 5, 5> G(k + 1, k + 1);
+                Eigen::Matrix<double, Eigen::Dynamic, 1, 0, 5, 1> rhs(k + 1);
+                for (int a = 0; a <= k; ++a) {
+                    rhs(a) = N[a];
+                    for (int b = 0; b <= k; ++b) G(a, b) = M[a + b];
+                }
+                Eigen::LDLT<Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, 5, 5>> ldlt(G);
+                if (ldlt.info() == Eigen::Success && ldlt.isPositive()) {
+                    double b1 = ldlt.solve(rhs)(1) / h;
+                    if (std::isfinite(b1)) derivative = b1;
+                }
             }
+            out[i] = derivative;
         }
-        // 2. 边界情况：只找到左侧点 (曲线末端)
-        else if (leftIndex >= 0 && rightIndex < 0) {
-            double tj = timeData[leftIndex];
-            double pj = pressureDropData[leftIndex];
-            derivative = calculateDerivativeValue(ti, tj, pi, pj);
+    });
+    return out;
+}
+
+QVector<double> PressureDerivativeCalculator::penalizedDerivative(const QVector<double>& x, const QVector<double>& y,
+                                                                  DerivativeMethod method, double lambda,
+                                                                  double* usedLambda)
+{
+    const int m = x.size();
+
+    // 噪声水平：各点与相邻两点线性插值之差的中位数绝对值（偏差原则使用）
+    double sigma = 0.0;
+    {
+        QVector<double> e;
+        for (int r = 1; r + 1 < m; ++r) {
+            double span = x[r + 1] - x[r - 1];
+            if (!(span > 0)) continue;
+            double w0 = (x[r + 1] - x[r]) / span;
+            double w1 = 1.0 - w0;
+            e.append(std::abs(y[r] - w0 * y[r - 1] - w1 * y[r + 1]) / std::sqrt(1.0 + w0 * w0 + w1 * w1));
         }
-        // 3. 边界情况：只找到右侧点 (曲线开端)
-        else if (leftIndex < 0 && rightIndex >= 0) {
-            double tk = timeData[rightIndex];
-            double pk = pressureDropData[rightIndex];
-            derivative = calculateDerivativeValue(tk, ti, pk, pi);
+        if (!e.isEmpty()) {
+            std::nth_element(e.begin(), e.begin() + e.size() / 2, e.end());
+            sigma = 1.4826 * e[e.size() / 2];
+        }
+    }
+
+    // 宽度小于全程 1/20000 的相邻点合并为一个节点（权重为点数），
+    // 否则晚期密集数据的 ln(t) 间距过小，λP 与 W 量级相差过大，带状分解失去精度
+    const double minSpacing = qMax(1e-12, (x.last() - x.first()) / 20000.0);
+    QVector<double> ux, uy, w;
+    QVector<int> map(m);
+    double withinSS = 0.0, sumY2 = 0.0, binStart = 0.0;
+    for (int j = 0; j < m; ++j) {
+        if (ux.isEmpty() || x[j] - binStart > minSpacing) {
+            if (!ux.isEmpty()) withinSS += sumY2 - uy.last() * uy.last() / w.last();
+            ux.append(0.0); uy.append(0.0); w.append(0.0);
+            sumY2 = 0.0;
+            binStart = x[j];
         }
-        // 4. L-Spacing 范围内点不足 (通常是数据极少或 L 设置过大)
-        else {
-            // 使用简单的相邻点差分作为保底
-            if (i > 0) {
-                double t_prev = timeData[i-1];
-                double p_prev = pressureDropData[i-1];
-                derivative = calculateDerivativeValue(ti, t_prev, pi, p_prev);
-            } else if (i < n - 1) {
-                double t_next = timeData[i+1];
-                double p_next = pressureDropData[i+1];
-                derivative = calculateDerivativeValue(t_next, ti, p_next, pi);
+        ux.last() += x[j]; uy.last() += y[j]; w.last() += 1.0;
+        sumY2 += y[j] * y[j];
+        map[j] = ux.size() - 1;
+    }
+    withinSS += sumY2 - uy.last() * uy.last() / w.last();
+    for (int i = 0; i < ux.size(); ++i) { ux[i] /= w[i]; uy[i] /= w[i]; }
+    const int n = ux.size();
+
+    QVector<int> left(n), right(n);
+    for (int i = 0; i < n; ++i) { left[i] = i - 1; right[i] = (i + 1 < n) ? i + 1 : -1; }
+    QVector<double> smooth = uy;
+
+    if (n >= 5) {
+        // 惩罚项 Σ (s_r·f)²，s_r 为作用于 (f_{r-1}, f_r, f_{r+1}) 的三点模板：
+        //   平滑样条：非均匀二阶差分（≈ f''），权重为区间长度，近似 ∫f''² d(ln t)
+        //   Tikhonov：相邻区间导数之差 u_r - u_{r-1}，即对导数的一阶正则化
+        QVector<double> p0(n, 0.0), p1(n, 0.0), p2(n, 0.0);
+        for (int r = 1; r + 1 < n; ++r) {
+            double h0 = ux[r] - ux[r - 1];
+            double h1 = ux[r + 1] - ux[r];
+            double c[3];
+            if (method == DerivativeMethod::SmoothingSpline) {
+                double sw = std::sqrt(0.5 * (h0 + h1));
+                c[0] = sw * 2.0 / (h0 * (h0 + h1));
+                c[1] = -sw * 2.0 / (h0 * h1);
+                c[2] = sw * 2.0 / (h1 * (h0 + h1));
             } else {
-                derivative = 0.0;
+                c[0] = 1.0 / h0;
+                c[1] = -(1.0 / h0 + 1.0 / h1);
+                c[2] = 1.0 / h1;
+            }
+            for (int a = 0; a < 3; ++a) {
+                p0[r - 1 + a] += c[a] * c[a];
+                if (a < 2) p1[r - 1 + a] += c[a] * c[a + 1];
+            }
+            p2[r - 1] += c[0] * c[2];
+        }
+
+        // 返回全部原始点的残差平方和（节点内部的离散度为常数项），分解失败时返回 -1
+        auto evaluate = [&](double logLambda, QVector<double>& f, double* trace) {
+            if (!solvePentadiagonal(w, p0, p1, p2, uy, std::pow(10.0, logLambda), f, trace)) return -1.0;
+            return residualSumOfSquares(w, uy, f) + qMax(0.0, withinSS);
+        };
+
+        double logLambda = -12.0;
+        if (lambda > 0) {
+            logLambda = std::log10(lambda);
+        } else if (method == DerivativeMethod::SmoothingSpline) {
+            // GCV(λ) = m·RSS / (m - tr H)²：先在对数网格上并行求值，再黄金分割细化
+            auto gcv = [&](double ll) {
+                QVector<double> f;
+                double trace = 0.0;
+                double rss = evaluate(ll, f, &trace);
+                if (rss < 0 || m - trace < 1e-9) return std::numeric_limits<double>::infinity();
+                return m * rss / ((m - trace) * (m - trace));
+            };
+            QVector<double> grid;
+            for (double ll = -12.0; ll <= 8.0 + 1e-9; ll += 1.0) grid.append(ll);
+            QVector<double> scores = QtConcurrent::blockingMapped<QVector<double>>(grid, gcv);
+            int best = int(std::min_element(scores.begin(), scores.end()) - scores.begin());
+            double a = grid[qMax(0, best - 1)], b = grid[qMin(grid.size() - 1, best + 1)];
+            const double g = 0.5 * (std::sqrt(5.0) - 1.0);
+            double c = b - g * (b - a), d = a + g * (b - a);
+            double fc = gcv(c), fd = gcv(d);
+            for (int it = 0; it < 25; ++it) {
+                if (fc < fd) { b = d; d = c; fd = fc; c = b - g * (b - a); fc = gcv(c); }
+                else { a = c; c = d; fc = fd; d = a + g * (b - a); fd = gcv(d); }
+            }
+            logLambda = 0.5 * (a + b);
+        } else {
+            // 偏差原则：RSS(λ) 随 λ 单调增加，二分求 RSS = m·σ²；分解失败视为 λ 过大
+            double target = m * sigma * sigma;
+            double lo = -12.0, hi = 8.0;
+            QVector<double> f;
+            for (int it = 0; it < 40; ++it) {
+                double mid = 0.5 * (lo + hi);
+                double rss = evaluate(mid, f, nullptr);
+                if (rss < 0 || rss > target) hi = mid;
+                else lo = mid;
             }
+            logLambda = lo;
         }
 
-        derivativeData.append(derivative);
+        QVector<double> f;
+        if (evaluate(logLambda, f, nullptr) >= 0) smooth = f;
+        if (usedLambda) *usedLambda = std::pow(10.0, logLambda);
     }
 
-    return derivativeData;
+    // 平滑后的曲线在节点上用相邻点加权差分求导，原始点按 ln(t) 在相邻节点间线性插值
+    QVector<double> du = derivativeFromWindows(ux, smooth, left, right);
+    QVector<double> out(m);
+    for (int j = 0; j < m; ++j) {
+        int i = map[j];
+        int k = (x[j] >= ux[i]) ? i + 1 : i - 1;
+        if (k < 0 || k >= n || ux[k] == ux[i]) { out[j] = du[i]; continue; }
+        double s = (x[j] - ux[i]) / (ux[k] - ux[i]);
+        out[j] = du[i] + s * (du[k] - du[i]);
+    }
+    return out;
 }
 
-int PressureDerivativeCalculator::findLeftPoint(const QVector<double>& timeData, int currentIndex, double lSpacing)
+QVector<double> PressureDerivativeCalculator::derivativeFromWindows(const QVector<double>& lnT,
+                                                                    const QVector<double>& pressureDropData,
+                                                                    const QVector<int>& left,
+                                                                    const QVector<int>& right)
 {
-    if (currentIndex <= 0 || timeData.isEmpty()) return -1;
-
-    double ti = timeData[currentIndex];
-    if (ti <= 0) return -1;
-    double lnTi = std::log(ti);
+    // 逐点求导（只有连续数组上的算术运算）
+    int n = lnT.size();
+    QVector<double> derivativeData(n);
+    const double* x = lnT.constData();
+    const double* p = pressureDropData.constData();
+    const int* jl = left.constData();
+    const int* kr = right.constData();
+    double* out = derivativeData.data();
+    for (int i = 0; i < n; ++i) {
+        int j = jl[i];
+        int k = kr[i];
+        double derivative = 0.0;
 
-    // 从当前点向左搜索，找到第一个满足距离 >= L 的点
-    for (int j = currentIndex - 1; j >= 0; --j) {
-        double tj = timeData[j];
-        if (tj <= 0) continue;
+        // 1. 如果找到左右两个点，使用加权平均法 (Bourdet Standard)
+        if (j >= 0 && k >= 0) {
+            double deltaXL = x[i] - x[j];  // ΔXL = ln(ti) - ln(tj)
+            double deltaXR = x[k] - x[i];  // ΔXR = ln(tk) - ln(ti)
+            double mL = logSlope(x[i], x[j], p[i], p[j]);  // 左导数 slope
+            double mR = logSlope(x[k], x[i], p[k], p[i]);  // 右导数 slope
 
-        double lnTj = std::log(tj);
-        if ((lnTi - lnTj) >= lSpacing) {
-            return j;
+            // 加权平均公式：P' = (mL * ΔXR + mR * ΔXL) / (ΔXL + ΔXR)
+            if (deltaXL + deltaXR > 1e-12)
+                derivative = (mL * deltaXR + mR * deltaXL) / (deltaXL + deltaXR);
+        }
+        // 2. 边界情况：只找到左侧点 (曲线末端)
+        else if (j >= 0) {
+            derivative = logSlope(x[i], x[j], p[i], p[j]);
+        }
+        // 3. 边界情况：只找到右侧点 (曲线开端)
+        else if (k >= 0) {
+            derivative = logSlope(x[k], x[i], p[k], p[i]);
+        }
+        // 4. L-Spacing 范围内点不足 (通常是数据极少或 L 设置过大)，使用简单的相邻点差分作为保底
+        else if (i > 0) {
+            derivative = logSlope(x[i], x[i - 1], p[i], p[i - 1]);
+        } else if (i < n - 1) {
+            derivative = logSlope(x[i + 1], x[i], p[i + 1], p[i]);
         }
+        out[i] = derivative;
     }
-    return -1;
+    return derivativeData;
 }
 
-int PressureDerivativeCalculator::findRightPoint(const QVector<double>& timeData, int currentIndex, double lSpacing)
+void PressureDerivativeCalculator::findLogWindows(const QVector<double>& lnT, const QVector<double>& lValues,
+                                                  QVector<QVector<int>>& left, QVector<QVector<int>>& right)
 {
-    int n = timeData.size();
-    if (currentIndex >= n - 1 || timeData.isEmpty()) return -1;
+    int n = lnT.size();
+    int count = lValues.size();
+    left = QVector<QVector<int>>(count, QVector<int>(n, -1));
+    right = QVector<QVector<int>>(count, QVector<int>(n, -1));
+
+    // 压力计数据的时间通常单调不减：满足条件的左侧点是有效点的前缀，右侧点是后缀，
+    // 且随 i 增大只会右移，每个 L 的两个指针在同一遍扫描中推进 (O(n·L 个数))
+    bool monotone = true;
+    double last = -std::numeric_limits<double>::infinity();
+    for (int i = 0; i < n && monotone; ++i) {
+        if (std::isnan(lnT[i])) continue;
+        if (lnT[i] < last) monotone = false;
+        last = lnT[i];
+    }
 
-    double ti = timeData[currentIndex];
-    if (ti <= 0) return -1;
-    double lnTi = std::log(ti);
+    if (monotone) {
+        QVector<int> a(count, 0);          // [0, a) 中的有效点均满足左侧条件
+        QVector<int> lastLeft(count, -1);  // 其中最靠右的有效点
+        QVector<int> b(count, 0);
+        for (int i = 0; i < n; ++i) {
+            double xi = lnT[i];
+            if (std::isnan(xi)) continue;
+            for (int m = 0; m < count; ++m) {
+                double lSpacing = lValues[m];
+                int& am = a[m];
+                while (am < i && (std::isnan(lnT[am]) || (xi - lnT[am]) >= lSpacing)) {
+                    if (!std::isnan(lnT[am])) lastLeft[m] = am;
+                    ++am;
+                }
+                left[m][i] = lastLeft[m];
 
-    // 从当前点向右搜索，找到第一个满足距离 >= L 的点
-    for (int k = currentIndex + 1; k < n; ++k) {
-        double tk = timeData[k];
-        if (tk <= 0) continue;
+                int& bm = b[m];
+                if (bm <= i) bm = i + 1;
+                while (bm < n && (std::isnan(lnT[bm]) || (lnT[bm] - xi) < lSpacing)) ++bm;
+                right[m][i] = (bm < n) ? bm : -1;
+            }
+        }
+        return;
+    }
 
-        double lnTk = std::log(tk);
-        if ((lnTk - lnTi) >= lSpacing) {
-            return k;
+    // 时间乱序（如拼接的多段数据）：逐点向两侧搜索最近的满足条件的点
+    for (int m = 0; m < count; ++m) {
+        double lSpacing = lValues[m];
+        for (int i = 0; i < n; ++i) {
+            double xi = lnT[i];
+            if (std::isnan(xi)) continue;
+            for (int j = i - 1; j >= 0; --j) {
+                if (!std::isnan(lnT[j]) && (xi - lnT[j]) >= lSpacing) { left[m][i] = j; break; }
+            }
+            for (int k = i + 1; k < n; ++k) {
+                if (!std::isnan(lnT[k]) && (lnT[k] - xi) >= lSpacing) { right[m][i] = k; break; }
+            }
         }
     }
-    return -1;
 }
 
-double PressureDerivativeCalculator::calculateDerivativeValue(double t1, double t2, double p1, double p2)
+double PressureDerivativeCalculator::logSlope(double lnT1, double lnT2, double p1, double p2)
 {
-    // 计算单边导数：dP/d(ln t) = (p1 - p2) / (ln(t1) - ln(t2))
-    if (t1 <= 0 || t2 <= 0) return 0.0;
-
-    double lnT1 = std::log(t1);
-    double lnT2 = std::log(t2);
+    // 计算单边导数：dP/d(ln t) = (p1 - p2) / (ln(t1) - ln(t2))，非正时间 (NaN) 记为 0
     double deltaLnT = lnT1 - lnT2;
-
-    if (std::abs(deltaLnT) < 1e-10) {
-        return 0.0;
-    }
-
+    if (!(std::abs(deltaLnT) >= 1e-10)) return 0.0;
     return (p1 - p2) / deltaLnT;
 }
 
@@ -381,3 +778,310 @@ QString PressureDerivativeCalculator::formatValue(double value, int precision)
     if (std::isnan(value) || std::isinf(value)) return "0";
     return QString::number(value, 'g', precision);
 }
+
+// ============================================================================
+// 流式 Bourdet 导数
+// ============================================================================
+
+StreamingBourdetDerivative::StreamingBourdetDerivative(double lSpacing)
+    : m_lSpacing(lSpacing)
+{
+    reset();
+}
+
+void StreamingBourdetDerivative::reset()
+{
+    m_pending.clear();
+    m_history.clear();
+    m_last = Sample{std::numeric_limits<double>::quiet_NaN(), 0.0};
+    m_lastValidLnT = -std::numeric_limits<double>::infinity();
+    m_sampleCount = 0;
+    m_emittedCount = 0;
+    m_rejectedCount = 0;
+}
+
+QVector<StreamingDerivativePoint> StreamingBourdetDerivative::append(double t, double p)
+{
+    QVector<StreamingDerivativePoint> done;
+    const bool valid = t > 0 && std::isfinite(t);
+    const Sample sample{valid ? std::log(t) : std::numeric_limits<double>::quiet_NaN(), p};
+    if (valid && sample.lnT < m_lastValidLnT) {
+        ++m_rejectedCount;
+        return done;
+    }
+    const qint64 index = m_sampleCount++;
+
+    auto emitPoint = [&](const PendingPoint& point, double d) {
+        done.append(StreamingDerivativePoint{point.index, point.t, point.self.p, d});
+        ++m_emittedCount;
+    };
+
+    // 第一个样本在左右点都没有时用后一个样本差分
+    if (!m_pending.empty() && m_pending.back().index == index - 1) {
+        m_pending.back().next = sample;
+        m_pending.back().hasNext = true;
+    }
+
+    // 新样本是 ln(t) 距离达到 L 的待定点的右侧点（时间单调，待定点按时间先后依次确定）
+    while (!m_pending.empty()) {
+        const PendingPoint& front = m_pending.front();
+        if (std::isnan(front.self.lnT)) {
+            emitPoint(front, 0.0);
+        } else if (valid && (sample.lnT - front.self.lnT) >= m_lSpacing) {
+            emitPoint(front, finalValue(front, &sample));
+        } else {
+            break;
+        }
+        m_pending.pop_front();
+    }
+
+    PendingPoint point{index, t, sample, Sample(), false, m_last, index > 0, Sample(), false};
+    if (valid) {
+        // 左侧点：满足 ln(ti) - ln(tj) ≥ L 的最后一个有效样本；更早的样本以后不会再用到
+        while (m_history.size() >= 2 && (sample.lnT - m_history[1].lnT) >= m_lSpacing) m_history.pop_front();
+        if (!m_history.empty() && (sample.lnT - m_history.front().lnT) >= m_lSpacing) {
+            point.left = m_history.front();
+            point.hasLeft = true;
+        }
+        m_history.push_back(sample);
+        m_lastValidLnT = sample.lnT;
+        m_pending.push_back(point);
+    } else if (m_pending.empty()) {
+        emitPoint(point, 0.0);
+    } else {
+        m_pending.push_back(point);
+    }
+    m_last = sample;
+    return done;
+}
+
+QVector<StreamingDerivativePoint> StreamingBourdetDerivative::append(const QVector<double>& t, const QVector<double>& p)
+{
+    QVector<StreamingDerivativePoint> done;
+    for (int i = 0; i < t.size() && i < p.size(); ++i) done.append(append(t[i], p[i]));
+    return done;
+}
+
+QVector<double> StreamingBourdetDerivative::provisional() const
+{
+    QVector<double> values;
+    values.reserve(int(m_pending.size()));
+    for (const PendingPoint& point : m_pending) values.append(finalValue(point, nullptr));
+    return values;
+}
+
+QVector<StreamingDerivativePoint> StreamingBourdetDerivative::finish()
+{
+    QVector<StreamingDerivativePoint> done;
+    for (const PendingPoint& point : m_pending) {
+        done.append(StreamingDerivativePoint{point.index, point.t, point.self.p, finalValue(point, nullptr)});
+        ++m_emittedCount;
+    }
+    m_pending.clear();
+    return done;
+}
+
+double StreamingBourdetDerivative::finalValue(const PendingPoint& point, const Sample* right) const
+{
+    // 与 calculateBourdetDerivative 的四种情况一一对应
+    const Sample& self = point.self;
+    if (std::isnan(self.lnT)) return 0.0;
+    if (point.hasLeft && right) {
+        double deltaXL = self.lnT - point.left.lnT;
+        double deltaXR = right->lnT - self.lnT;
+        double mL = PressureDerivativeCalculator::logSlope(self.lnT, point.left.lnT, self.p, point.left.p);
+        double mR = PressureDerivativeCalculator::logSlope(right->lnT, self.lnT, right->p, self.p);
+        return (deltaXL + deltaXR > 1e-12) ? (mL * deltaXR + mR * deltaXL) / (deltaXL + deltaXR) : 0.0;
+    }
+    if (point.hasLeft) return PressureDerivativeCalculator::logSlope(self.lnT, point.left.lnT, self.p, point.left.p);
+    if (right) return PressureDerivativeCalculator::logSlope(right->lnT, self.lnT, right->p, self.p);
+    if (point.hasPrev) return PressureDerivativeCalculator::logSlope(self.lnT, point.prev.lnT, self.p, point.prev.p);
+    if (point.hasNext) return PressureDerivativeCalculator::logSlope(point.next.lnT, self.lnT, point.next.p, self.p);
+    return 0.0;
+}
+
+// ============================================================================
+// 压力导数计算对话框
+// ============================================================================
+
+PressureDerivativeDialog::PressureDerivativeDialog(const QVector<double>& timeData,
+                                                   const QVector<double>& pressureDropData,
+                                                   double initialLSpacing, const RateSchedule& schedule,
+                                                   QWidget* parent)
+    : QDialog(parent),
+      m_time(timeData),
+      m_pressureDrop(pressureDropData),
+      m_schedule(schedule),
+      m_superposition(TimeTransform::periodCount(schedule) >= 2),
+      m_lValues(PressureDerivativeCalculator::defaultSweepValues()),
+      m_cache(4, QVector<QVector<double>>(m_lValues.size())),
+      m_lambdas(4, 0.0)
+{
+    // Bourdet 的全部 L 一次扫描算出（叠加导数按流动段分别计算，仍逐个 L 延迟计算）
+    if (!m_superposition)
+        m_cache[int(DerivativeMethod::Bourdet)] =
+            PressureDerivativeCalculator::calculateBourdetSweep(m_time, m_pressureDrop, m_lValues);
+
+    int initialIndex = 0;
+    for (int k = 1; k < m_lValues.size(); ++k)
+        if (std::abs(m_lValues[k] - initialLSpacing) < std::abs(m_lValues[initialIndex] - initialLSpacing))
+            initialIndex = k;
+    setupUI(initialIndex);
+}
+
+void PressureDerivativeDialog::setupUI(int initialIndex)
+{
+    setWindowTitle(m_superposition ? "压力导数计算（叠加导数）" : "压力导数计算");
+    setModal(true);
+    resize(720, 580);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout(this);
+
+    m_plot = new QCustomPlot(this);
+    m_plot->setBackground(Qt::white);
+    QSharedPointer<QCPAxisTickerLog> logTicker(new QCPAxisTickerLog);
+    m_plot->xAxis->setScaleType(QCPAxis::stLogarithmic); m_plot->xAxis->setTicker(logTicker);
+    m_plot->yAxis->setScaleType(QCPAxis::stLogarithmic); m_plot->yAxis->setTicker(logTicker);
+    m_plot->xAxis->setNumberFormat("eb"); m_plot->xAxis->setNumberPrecision(0);
+    m_plot->yAxis->setNumberFormat("eb"); m_plot->yAxis->setNumberPrecision(0);
+    m_plot->xAxis->setLabel("时间 Time");
+    m_plot->yAxis->setLabel("压差 & 导数");
+    m_plot->xAxis->grid()->setSubGridVisible(true); m_plot->yAxis->grid()->setSubGridVisible(true);
+    m_plot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+
+    // 压差只画一次，导数随滑块切换（双对数坐标下取绝对值）
+    QVector<double> tp, pp;
+    for (int i = 0; i < m_time.size() && i < m_pressureDrop.size(); ++i) {
+        if (m_time[i] > 0 && std::abs(m_pressureDrop[i]) > 0) { tp << m_time[i]; pp << std::abs(m_pressureDrop[i]); }
+    }
+    m_plot->addGraph(); m_plot->graph(0)->setPen(Qt::NoPen);
+    m_plot->graph(0)->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, QColor(0, 100, 0), 4));
+    m_plot->graph(0)->setName("压差");
+    m_plot->graph(0)->setData(tp, pp);
+    m_plot->addGraph(); m_plot->graph(1)->setPen(Qt::NoPen);
+    m_plot->graph(1)->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssTriangle, Qt::magenta, 4));
+    m_plot->graph(1)->setName("导数");
+    m_plot->legend->setVisible(true);
+    mainLayout->addWidget(m_plot, 1);
+
+    QHBoxLayout* methodLayout = new QHBoxLayout;
+    methodLayout->addWidget(new QLabel("导数算法:"));
+    m_methodCombo = new QComboBox;
+    for (DerivativeMethod method : {DerivativeMethod::Bourdet, DerivativeMethod::SavitzkyGolay,
+                                    DerivativeMethod::SmoothingSpline, DerivativeMethod::Tikhonov})
+        m_methodCombo->addItem(PressureDerivativeCalculator::methodName(method));
+    methodLayout->addWidget(m_methodCombo);
+    methodLayout->addStretch();
+    mainLayout->addLayout(methodLayout);
+
+    QHBoxLayout* sliderLayout = new QHBoxLayout;
+    sliderLayout->addWidget(new QLabel("平滑:"));
+    m_slider = new QSlider(Qt::Horizontal);
+    m_slider->setRange(0, m_lValues.size() - 1);
+    m_slider->setPageStep(1);
+    m_slider->setTickPosition(QSlider::TicksBelow);
+    sliderLayout->addWidget(m_slider, 1);
+    m_valueLabel = new QLabel;
+    m_valueLabel->setMinimumWidth(120);
+    sliderLayout->addWidget(m_valueLabel);
+    mainLayout->addLayout(sliderLayout);
+
+    QHBoxLayout* buttonLayout = new QHBoxLayout;
+    buttonLayout->addStretch();
+    QPushButton* okBtn = new QPushButton("写入导数列");
+    connect(okBtn, &QPushButton::clicked, this, &QDialog::accept);
+    buttonLayout->addWidget(okBtn);
+    QPushButton* cancelBtn = new QPushButton("取消");
+    connect(cancelBtn, &QPushButton::clicked, this, &QDialog::reject);
+    buttonLayout->addWidget(cancelBtn);
+    mainLayout->addLayout(buttonLayout);
+
+    connect(m_methodCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &PressureDerivativeDialog::onMethodChanged);
+    connect(m_slider, &QSlider::valueChanged, this, &PressureDerivativeDialog::onSliderChanged);
+    m_slider->setValue(initialIndex);
+    onSliderChanged(initialIndex);
+    m_plot->rescaleAxes();
+    m_plot->replot();
+}
+
+DerivativeMethod PressureDerivativeDialog::currentMethod() const
+{
+    return DerivativeMethod(m_methodCombo->currentIndex());
+}
+
+const QVector<double>& PressureDerivativeDialog::derivativeFor(DerivativeMethod method, int index) const
+{
+    // 样条与 Tikhonov 的 λ 自动选取，与滑块无关，只缓存一份
+    bool automatic = (method == DerivativeMethod::SmoothingSpline || method == DerivativeMethod::Tikhonov);
+    int slot = automatic ? 0 : index;
+    QVector<double>& cached = m_cache[int(method)][slot];
+    if (cached.isEmpty()) {
+        DerivativeOptions options;
+        options.method = method;
+        options.lSpacing = m_lValues[index];
+        options.window = m_lValues[index];
+        double lambda = 0.0;
+        if (m_superposition)
+            cached = TimeTransform::superpositionDerivative(m_time, m_pressureDrop, m_schedule, options);
+        else
+            cached = PressureDerivativeCalculator::calculateDerivative(m_time, m_pressureDrop, options, &lambda);
+        m_lambdas[int(method)] = lambda;
+    }
+    return cached;
+}
+
+void PressureDerivativeDialog::onMethodChanged(int)
+{
+    DerivativeMethod method = currentMethod();
+    bool automatic = (method == DerivativeMethod::SmoothingSpline || method == DerivativeMethod::Tikhonov);
+    m_slider->setEnabled(!automatic);
+    // S-G 窗口半宽不能为 0
+    m_slider->setMinimum(method == DerivativeMethod::SavitzkyGolay ? 1 : 0);
+    onSliderChanged(m_slider->value());
+}
+
+void PressureDerivativeDialog::onSliderChanged(int index)
+{
+    if (index < 0 || index >= m_lValues.size()) return;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    const QVector<double>& d = derivativeFor(currentMethod(), index);
+    QApplication::restoreOverrideCursor();
+    m_valueLabel->setText(selectedDescription());
+
+    QVector<double> td, dd;
+    for (int i = 0; i < m_time.size() && i < d.size(); ++i) {
+        if (m_time[i] > 0 && std::abs(d[i]) > 0) { td << m_time[i]; dd << std::abs(d[i]); }
+    }
+    m_plot->graph(1)->setData(td, dd);
+    m_plot->replot(QCustomPlot::rpQueuedReplot);
+}
+
+DerivativeOptions PressureDerivativeDialog::selectedOptions() const
+{
+    DerivativeOptions options;
+    options.method = currentMethod();
+    options.lSpacing = m_lValues.value(m_slider->value());
+    options.window = m_lValues.value(m_slider->value());
+    if (options.method == DerivativeMethod::SmoothingSpline || options.method == DerivativeMethod::Tikhonov)
+        options.lambda = m_lambdas[int(options.method)];
+    return options;
+}
+
+QVector<double> PressureDerivativeDialog::selectedDerivative() const
+{
+    return derivativeFor(currentMethod(), m_slider->value());
+}
+
+QString PressureDerivativeDialog::selectedDescription() const
+{
+    DerivativeOptions options = selectedOptions();
+    switch (options.method) {
+    case DerivativeMethod::Bourdet: return QString("L = %1").arg(options.lSpacing, 0, 'f', 2);
+    case DerivativeMethod::SavitzkyGolay: return QString("窗口 ±%1").arg(options.window, 0, 'f', 2);
+    default:
+        // 叠加导数的 λ 在各流动段内分别选取
+        if (m_superposition) return QString("λ 按流动段自动");
+        return QString("λ = %1").arg(options.lambda, 0, 'g', 3);
+    }
+}
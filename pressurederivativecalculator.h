@@ -2,9 +2,17 @@
 #define PRESSUREDERIVATIVECALCULATOR_H
 
 #include <QObject>
+#include <QDialog>
 #include <QString>
 #include <QVector>
 #include <QStandardItemModel>
+#include <deque>
+#include "rateschedule.h"
+
+class QCustomPlot;
+class QSlider;
+class QLabel;
+class QComboBox;
 
 // 压力导数计算结果结构
 struct PressureDerivativeResult {
@@ -40,6 +48,30 @@ struct PressureDerivativeConfig {
         autoTimeOffset(true) {}// 默认自动添加偏移
 };
 
+// 导数算法
+enum class DerivativeMethod {
+    Bourdet,          // L-Spacing 加权差分
+    SavitzkyGolay,    // 对数时间上的滑动多项式拟合
+    SmoothingSpline,  // 惩罚样条平滑（GCV 选取 λ）后差分
+    Tikhonov          // 对导数做一阶 Tikhonov 正则化（偏差原则选取 λ）
+};
+
+// 导数算法参数（时间窗口均以 ln(t) 为单位，与 L-Spacing 相同）
+struct DerivativeOptions {
+    DerivativeMethod method;
+    double lSpacing;      // Bourdet
+    double window;        // Savitzky-Golay 窗口半宽
+    int polyOrder;        // Savitzky-Golay 多项式阶数 (1~4)
+    double lambda;        // 样条 / Tikhonov 正则化系数，<=0 时自动选取
+
+    DerivativeOptions() :
+        method(DerivativeMethod::Bourdet),
+        lSpacing(0.15),
+        window(0.2),
+        polyOrder(2),
+        lambda(-1.0) {}
+};
+
 /**
  * @brief 压力导数计算器类
  *
@@ -65,6 +97,19 @@ public:
     PressureDerivativeResult calculatePressureDerivative(QStandardItemModel* model,
                                                          const PressureDerivativeConfig& config);
 
+    /**
+     * @brief 从表格读取时间（含自动时间偏移）与压降，供导数预览使用
+     * @return 失败时返回 false 并给出错误信息
+     */
+    bool readSeries(QStandardItemModel* model, const PressureDerivativeConfig& config,
+                    QVector<double>& timeData, QVector<double>& pressureDropData, QString* error = nullptr);
+
+    /**
+     * @brief 将已算好的导数写入压力列之后的新列
+     */
+    PressureDerivativeResult insertDerivativeColumn(QStandardItemModel* model, const PressureDerivativeConfig& config,
+                                                    const QVector<double>& derivativeData);
+
     /**
      * @brief 自动检测压力列和时间列
      * @param model 数据模型
@@ -87,15 +132,52 @@ public:
                                                       const QVector<double>& pressureDropData,
                                                       double lSpacing);
 
+    /**
+     * @brief 一次计算多个 L-Spacing 的 Bourdet 导数
+     *
+     * ln(t) 只计算一次，各 L 的左右点指针在同一遍扫描中推进，结果与逐个调用
+     * calculateBourdetDerivative 相同。
+     * @return 与 lValues 一一对应的导数数据
+     */
+    static QVector<QVector<double>> calculateBourdetSweep(const QVector<double>& timeData,
+                                                          const QVector<double>& pressureDropData,
+                                                          const QVector<double>& lValues);
+
+    // 默认扫描的 L-Spacing：0.05 ~ 0.5，步长 0.05
+    static QVector<double> defaultSweepValues();
+
+    /**
+     * @brief 按所选算法计算导数（拟合、绘图、数据编辑器共用的统一入口）
+     *
+     * 各算法均为线性复杂度：Savitzky-Golay 用滑动窗口矩递推并按数据段并行；
+     * 样条与 Tikhonov 在五对角带状矩阵上做 LDLᵀ 分解，候选 λ 并行求值。
+     * @param usedLambda 返回样条 / Tikhonov 实际使用的 λ
+     */
+    static QVector<double> calculateDerivative(const QVector<double>& timeData,
+                                               const QVector<double>& pressureDropData,
+                                               const DerivativeOptions& options,
+                                               double* usedLambda = nullptr);
+
+    static QString methodName(DerivativeMethod method);
+
 signals:
     void progressUpdated(int progress, const QString& message);
     void calculationCompleted(const PressureDerivativeResult& result);
 
 private:
+    friend class StreamingBourdetDerivative;
+
     // 内部静态辅助函数
-    static int findLeftPoint(const QVector<double>& timeData, int currentIndex, double lSpacing);
-    static int findRightPoint(const QVector<double>& timeData, int currentIndex, double lSpacing);
-    static double calculateDerivativeValue(double t1, double t2, double p1, double p2);
+    // 由 ln(t)（非正时间为 NaN）求每个点的左右 L-Spacing 点索引，找不到为 -1
+    static void findLogWindows(const QVector<double>& lnT, const QVector<double>& lValues,
+                               QVector<QVector<int>>& left, QVector<QVector<int>>& right);
+    static QVector<double> derivativeFromWindows(const QVector<double>& lnT, const QVector<double>& pressureDropData,
+                                                 const QVector<int>& left, const QVector<int>& right);
+    static double logSlope(double lnT1, double lnT2, double p1, double p2);
+    static QVector<double> savitzkyGolay(const QVector<double>& x, const QVector<double>& y,
+                                         double window, int polyOrder);
+    static QVector<double> penalizedDerivative(const QVector<double>& x, const QVector<double>& y,
+                                               DerivativeMethod method, double lambda, double* usedLambda);
 
     int findPressureColumn(QStandardItemModel* model);
     int findTimeColumn(QStandardItemModel* model);
@@ -103,4 +185,115 @@ private:
     QString formatValue(double value, int precision = 6);
 };
 
+// 流式导数输出的一个点
+struct StreamingDerivativePoint {
+    qint64 index;   // 样本序号（从 0 开始）
+    double t;
+    double p;
+    double d;
+};
+
+/**
+ * @brief 流式 Bourdet 导数
+ *
+ * 样本逐个或成批追加，某点右侧 L-Spacing 点一到达即输出其最终导数，
+ * 结果与对完整数据调用 calculateBourdetDerivative 相同。
+ * 只保留 ln(t) 在最新样本 L 以内的待定点和一个左侧点，内存为 O(窗口)。
+ * 时间须单调不减（非正时间允许，导数记为 0），倒退的样本被忽略。
+ */
+class StreamingBourdetDerivative
+{
+public:
+    explicit StreamingBourdetDerivative(double lSpacing = 0.15);
+
+    // 返回本次追加后按序号顺序新确定的点
+    QVector<StreamingDerivativePoint> append(double t, double p);
+    QVector<StreamingDerivativePoint> append(const QVector<double>& t, const QVector<double>& p);
+
+    // 假定数据到此结束时，尚未确定的点的导数（不改变状态）
+    QVector<double> provisional() const;
+    // 数据结束：按 provisional() 输出剩余的点
+    QVector<StreamingDerivativePoint> finish();
+
+    void reset();
+    double lSpacing() const { return m_lSpacing; }
+    qint64 sampleCount() const { return m_sampleCount; }
+    qint64 emittedCount() const { return m_emittedCount; }
+    qint64 rejectedCount() const { return m_rejectedCount; }
+
+private:
+    struct Sample {
+        double lnT;       // 非正时间为 NaN
+        double p;
+    };
+    struct PendingPoint {
+        qint64 index;
+        double t;
+        Sample self;
+        Sample left;      // 左侧 L-Spacing 点，hasLeft 为 false 时无效
+        bool hasLeft;
+        Sample prev;      // 前一个样本（左右点都没有时的保底差分）
+        bool hasPrev;
+        Sample next;      // 后一个样本（仅第一个样本使用）
+        bool hasNext;
+    };
+
+    double finalValue(const PendingPoint& point, const Sample* right) const;
+
+    double m_lSpacing;
+    std::deque<PendingPoint> m_pending;   // 尚未确定的点（按序号）
+    std::deque<Sample> m_history;         // 供以后的点查找左侧点的有效样本
+    Sample m_last;
+    double m_lastValidLnT;
+    qint64 m_sampleCount;
+    qint64 m_emittedCount;
+    qint64 m_rejectedCount;
+};
+
+/**
+ * @brief 压力导数计算对话框
+ *
+ * 打开时一次算出全部候选 L-Spacing 的导数并保存在内存中，拖动滑块即时切换
+ * 双对数预览曲线，确定后只将选中的导数写入表格。
+ * 也可改用 Savitzky-Golay（滑块选窗口半宽）、平滑样条或 Tikhonov（λ 自动选取），
+ * 各算法的结果首次使用时计算并缓存。
+ * 给出含两个以上流动段的产量历史时，改为计算叠加导数（TimeTransform::superpositionDerivative），
+ * 滑块与算法选择的含义不变。
+ */
+class PressureDerivativeDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    PressureDerivativeDialog(const QVector<double>& timeData, const QVector<double>& pressureDropData,
+                             double initialLSpacing, const RateSchedule& schedule = RateSchedule(),
+                             QWidget* parent = nullptr);
+
+    DerivativeOptions selectedOptions() const;
+    QVector<double> selectedDerivative() const;
+    QString selectedDescription() const;
+
+private slots:
+    void onMethodChanged(int index);
+    void onSliderChanged(int index);
+
+private:
+    void setupUI(int initialIndex);
+    DerivativeMethod currentMethod() const;
+    const QVector<double>& derivativeFor(DerivativeMethod method, int index) const;
+
+    QVector<double> m_time;
+    QVector<double> m_pressureDrop;
+    RateSchedule m_schedule;
+    bool m_superposition;                             // 多流动段：按叠加导数计算
+    QVector<double> m_lValues;                        // 滑块取值：Bourdet 的 L / S-G 的窗口半宽
+    mutable QVector<QVector<QVector<double>>> m_cache; // [算法][滑块位置]
+    mutable QVector<double> m_lambdas;                // 样条 / Tikhonov 选取的 λ
+
+    QComboBox* m_methodCombo;
+    QSlider* m_slider;
+    QLabel* m_valueLabel;
+    QCustomPlot* m_plot;
+};
+
 #endif // PRESSUREDERIVATIVECALCULATOR_H
@@ -0,0 +1,14 @@
+#ifndef RATESCHEDULE_H
+#define RATESCHEDULE_H
+
+#include <QVector>
+
+// 产量历史：第 j 个流动段自 startTime[j] 起以 rate[j] 生产，直到下一段开始（时间与压力数据同一时钟）
+struct RateSchedule {
+    QVector<double> startTime;
+    QVector<double> rate;
+
+    bool isEmpty() const { return startTime.isEmpty() || rate.isEmpty(); }
+};
+
+#endif // RATESCHEDULE_H
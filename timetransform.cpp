@@ -0,0 +1,169 @@
+#include "timetransform.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace {
+// ln(D + Δt) 在 D ≥ kRatio·Δt 时按 Δt/D 展开，在 D ≤ Δt/kRatio 时按 D/Δt 展开
+const double kRatio = 4.0;
+const int kSeriesTerms = 20;     // 4^−21 / 21 < 1e-14
+
+// 当前流动段 n 的预计算：D_j = T_n − T_j（随 j 递减），c_k = (−1)^{k+1}/k
+//   far[k][J]   = Σ_{j<J} Δq_j·c_k·D_j^{−k}（k = 0 时为 Σ Δq_j·ln D_j）
+//   close[k][J] = Σ_{J≤j<n} Δq_j·c_k·D_j^k（k = 0 时为 Σ Δq_j）
+struct PeriodSums {
+    int period = -1;
+    QVector<double> D;
+    QVector<QVector<double>> far, close;
+
+    void prepare(int n, const QVector<double>& T, const QVector<double>& dq)
+    {
+        period = n;
+        D.resize(n);
+        far.fill(QVector<double>(n + 1, 0.0), kSeriesTerms + 1);
+        close.fill(QVector<double>(n + 1, 0.0), kSeriesTerms + 1);
+        for (int j = 0; j < n; ++j) {
+            D[j] = T[n] - T[j];
+            double inv = 1.0 / D[j], pw = 1.0;
+            far[0][j + 1] = far[0][j] + dq[j] * std::log(D[j]);
+            for (int k = 1; k <= kSeriesTerms; ++k) {
+                pw *= inv;
+                far[k][j + 1] = far[k][j] + dq[j] * ((k % 2) ? 1.0 : -1.0) * pw / k;
+            }
+        }
+        for (int j = n - 1; j >= 0; --j) {
+            double pw = 1.0;
+            close[0][j] = close[0][j + 1] + dq[j];
+            for (int k = 1; k <= kSeriesTerms; ++k) {
+                pw *= D[j];
+                close[k][j] = close[k][j + 1] + dq[j] * ((k % 2) ? 1.0 : -1.0) * pw / k;
+            }
+        }
+    }
+};
+}
+
+int TimeTransform::periodCount(const RateSchedule& schedule)
+{
+    QVector<double> T, q;
+    ModelSuperposition::normalizedSchedule(schedule, T, q);
+    return T.size();
+}
+
+TimeTransformResult TimeTransform::compute(const QVector<double>& time, const RateSchedule& schedule)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const int count = time.size();
+    TimeTransformResult r;
+    r.period.fill(-1, count);
+    r.elapsed.fill(nan, count);
+    r.equivalent.fill(nan, count);
+    r.superposition.fill(nan, count);
+    r.horner.fill(nan, count);
+
+    QVector<double> T, q;
+    ModelSuperposition::normalizedSchedule(schedule, T, q);
+    const int M = T.size();
+    if (M == 0 || count == 0) return r;
+    QVector<double> dq(M), cumulative(M, 0.0);
+    for (int j = 0; j < M; ++j) {
+        dq[j] = q[j] - (j > 0 ? q[j - 1] : 0.0);
+        if (j > 0) cumulative[j] = cumulative[j - 1] + q[j - 1] * (T[j] - T[j - 1]);
+    }
+
+    // 按时间顺序处理（数据通常已排序，此时不做排序）
+    QVector<int> order;
+    order.reserve(count);
+    bool sorted = true;
+    for (int i = 0; i < count; ++i) {
+        if (!std::isfinite(time[i])) continue;
+        if (!order.isEmpty() && time[i] < time[order.last()]) sorted = false;
+        order.append(i);
+    }
+    if (!sorted) std::stable_sort(order.begin(), order.end(), [&time](int a, int b) { return time[a] < time[b]; });
+
+    PeriodSums sums;
+    int a = -1;
+    int far = 0, close = 0;     // 本段中 j < far 与 close ≤ j < n 的流动段按级数合并
+    for (int i : order) {
+        double t = time[i];
+        while (a + 1 < M && T[a + 1] < t) ++a;
+        if (a < 0) continue;
+        if (sums.period != a) { sums.prepare(a, T, dq); far = a; close = a; }
+        double dt = t - T[a];
+        r.period[i] = a;
+        r.elapsed[i] = dt;
+        if (!(dt > 0)) continue;
+
+        // Σ_{j<n} Δq_j·[ln(D_j + Δt) − ln D_j]，只有 D_j 与 Δt 相近的流动段逐项计算
+        while (far > 0 && sums.D[far - 1] < kRatio * dt) --far;
+        while (close > far && sums.D[close - 1] <= dt / kRatio) --close;
+        double lnDt = std::log(dt);
+        double shift = lnDt * sums.close[0][close] - (sums.far[0][a] - sums.far[0][far]);
+        double up = 1.0, down = 1.0, inv = 1.0 / dt;
+        for (int k = 1; k <= kSeriesTerms; ++k) {
+            up *= dt; down *= inv;
+            shift += up * sums.far[k][far] + down * sums.close[k][close];
+        }
+        for (int j = far; j < close; ++j) shift += dq[j] * std::log(sums.D[j] + dt);
+
+        r.equivalent[i] = std::exp(lnDt + shift / dq[a]);
+        r.superposition[i] = lnDt + (sums.far[0][a] + shift) / dq[a];
+        if (a > 0 && q[a - 1] != 0.0) {
+            double tp = cumulative[a] / q[a - 1];
+            if (tp > 0) r.horner[i] = (tp + dt) / dt;
+        }
+    }
+    return r;
+}
+
+RateSchedule TimeTransform::scheduleFromRates(const QVector<double>& time, const QVector<double>& rate, double relTol)
+{
+    RateSchedule schedule;
+    int n = qMin(time.size(), rate.size());
+    double scale = 0;
+    for (int i = 0; i < n; ++i)
+        if (std::isfinite(rate[i])) scale = qMax(scale, std::abs(rate[i]));
+    double tol = relTol * scale;
+    double current = 0.0;
+    double lastTime = std::numeric_limits<double>::quiet_NaN();
+    for (int i = 0; i < n; ++i) {
+        if (!std::isfinite(time[i]) || !std::isfinite(rate[i])) continue;
+        if (std::abs(rate[i] - current) > tol) {
+            // 产量在上一行之后改变；首行即变化时取首行时间
+            schedule.startTime.append(std::isfinite(lastTime) ? lastTime : time[i]);
+            schedule.rate.append(rate[i]);
+            current = rate[i];
+        }
+        lastTime = time[i];
+    }
+    return schedule;
+}
+
+QVector<double> TimeTransform::superpositionDerivative(const QVector<double>& time, const QVector<double>& pressureDrop,
+                                                       const RateSchedule& schedule, const DerivativeOptions& options)
+{
+    int n = qMin(time.size(), pressureDrop.size());
+    QVector<double> derivative(n, 0.0);
+    QVector<double> T, q;
+    ModelSuperposition::normalizedSchedule(schedule, T, q);
+    if (T.isEmpty()) return derivative;
+    TimeTransformResult tr = compute(time.mid(0, n), schedule);
+
+    // 按流动段分组（保持原有顺序），各段以等效时间为横轴
+    QVector<QVector<int>> groups(T.size());
+    for (int i = 0; i < n; ++i)
+        if (tr.period[i] >= 0 && tr.equivalent[i] > 0) groups[tr.period[i]].append(i);
+    for (int a = 0; a < groups.size(); ++a) {
+        const QVector<int>& rows = groups[a];
+        if (rows.size() < 2) continue;
+        QVector<double> te, dp;
+        te.reserve(rows.size()); dp.reserve(rows.size());
+        for (int i : rows) { te.append(tr.equivalent[i]); dp.append(pressureDrop[i]); }
+        QVector<double> d = PressureDerivativeCalculator::calculateDerivative(te, dp, options);
+        double sign = (q[a] - (a > 0 ? q[a - 1] : 0.0)) < 0 ? -1.0 : 1.0;
+        for (int k = 0; k < rows.size() && k < d.size(); ++k) derivative[rows[k]] = sign * d[k];
+    }
+    return derivative;
+}
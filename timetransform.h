@@ -0,0 +1,55 @@
+#ifndef TIMETRANSFORM_H
+#define TIMETRANSFORM_H
+
+#include <QVector>
+#include "modelsuperposition.h"
+#include "pressurederivativecalculator.h"
+
+// 各时刻的时间变换结果；尚未开始生产或不适用的位置为 NaN
+struct TimeTransformResult {
+    QVector<int> period;            // 所在流动段（归一化产量历史中的序号），−1 表示尚未生产
+    QVector<double> elapsed;        // 段内时间 Δt = t − T_n
+    QVector<double> equivalent;     // Agarwal 等效时间 Δte（首段即 Δt）
+    QVector<double> superposition;  // 叠加时间 Σ_j (Δq_j/Δq_n)·ln(t − T_j)
+    QVector<double> horner;         // Horner 时间比 (tp + Δt)/Δt，tp = 累产/前一段产量
+};
+
+/**
+ * @brief 试井时间变换（多流动段）
+ *
+ * 由产量历史求恢复/变产量段的时间函数：
+ *   叠加时间 X = Σ_{j≤n} (Δq_j/Δq_n)·ln(t − T_j)，在径向流中与压力成线性；
+ *   等效时间 ln Δte = X − Σ_{j<n} (Δq_j/Δq_n)·ln(T_n − T_j)，Δt → 0 时 Δte → Δt，
+ *   单次开井后关井时即 Agarwal 的 tp·Δt/(tp + Δt)；
+ *   Horner 时间比 (tp + Δt)/Δt，tp 取累产与关井前产量之比。
+ * 时间按顺序处理，流动段指针单调推进。ln(D + Δt)（D = T_n − T_j）在 D ≥ 4Δt 时按 Δt/D、
+ * 在 D ≤ Δt/4 时按 D/Δt 展开，系数按段预先累加，每点只对 D 与 Δt 相近的流动段逐项求对数。
+ *
+ * 叠加导数 dΔp/dX 对各流动段分别计算，与 ModelSuperposition 的理论导数口径一致，
+ * 恢复段的导数与同一产量变化量下的压降导数可直接对比。
+ */
+class TimeTransform
+{
+public:
+    static TimeTransformResult compute(const QVector<double>& time, const RateSchedule& schedule);
+
+    /**
+     * @brief 由逐行的时间与产量列提取产量历史
+     * 产量变化（超过最大产量的 relTol 倍）处开始新流动段，起点取变化前最后一行的时间。
+     */
+    static RateSchedule scheduleFromRates(const QVector<double>& time, const QVector<double>& rate,
+                                          double relTol = 1e-6);
+
+    /**
+     * @brief 叠加导数：各流动段以等效时间为横轴、按所选算法求导，并乘以 sign(Δq_n)，
+     * 使压降与恢复段都为正；只有一个流动段时等价于对 t − T_0 的普通导数。
+     * 尚未生产的点导数为 0。
+     */
+    static QVector<double> superpositionDerivative(const QVector<double>& time, const QVector<double>& pressureDrop,
+                                                   const RateSchedule& schedule, const DerivativeOptions& options);
+
+    // 归一化产量历史中的流动段数
+    static int periodCount(const RateSchedule& schedule);
+};
+
+#endif // TIMETRANSFORM_H